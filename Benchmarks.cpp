@@ -0,0 +1,754 @@
+#include"Benchmarks.h"
+#include"ClusteredLights.h"
+#include"FramePipeline.h"
+#include"FrustumCuller.h"
+#include"GLExtensions.h"
+#include"HeadlessContext.h"
+#include"JobSystem.h"
+#include"MicroBenchmark.h"
+#include"Model.h"
+#include"OcclusionCuller.h"
+#include"SceneBVH.h"
+
+#include<glm/gtc/matrix_transform.hpp>
+#include<algorithm>
+#include<chrono>
+#include<cstdio>
+#include<cstdlib>
+#include<cstring>
+#include<iostream>
+#include<random>
+#include<string>
+#include<thread>
+
+void RunFrustumCullingBenchmark(unsigned int boundsCount, unsigned int iterations) {
+	// Fixed seed so runs are comparable between commits
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> size(0.01f, 2.0f);
+
+	FrustumCuller culler;
+	culler.minProjectedSize = 2.0f;
+	for (unsigned int i = 0; i < boundsCount; i++) {
+		glm::vec3 center(position(rng), position(rng) * 0.1f, position(rng));
+		glm::vec3 extent(size(rng), size(rng), size(rng));
+		culler.AddWorldBounds(center - extent, center + extent);
+	}
+
+	// Same camera setup as Main.cpp
+	glm::vec3 cameraPosition(7.0f, 1.7f, 7.0f);
+	glm::mat4 view = glm::lookAt(cameraPosition, cameraPosition + glm::vec3(-1.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1366.0f / 768.0f, 0.1f, 100.0f);
+	culler.ExtractPlanes(projection * view);
+	float projectionScale = 768.0f * 0.5f / glm::tan(glm::radians(45.0f) * 0.5f);
+
+	// Reference result
+	culler.CullScalar(cameraPosition, projectionScale);
+	std::vector<unsigned char> reference = culler.visible;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (unsigned int i = 0; i < iterations; i++)
+		culler.CullScalar(cameraPosition, projectionScale);
+	auto mid = std::chrono::high_resolution_clock::now();
+	for (unsigned int i = 0; i < iterations; i++)
+		culler.Cull(cameraPosition, projectionScale);
+	auto end = std::chrono::high_resolution_clock::now();
+
+	double scalarMs = std::chrono::duration<double, std::milli>(mid - start).count() / iterations;
+	double simdMs = std::chrono::duration<double, std::milli>(end - mid).count() / iterations;
+	bool matches = reference == culler.visible;
+
+	std::cout << "Frustum culling, " << boundsCount << " bounds, " << iterations << " iterations" << std::endl;
+	std::cout << "  visible: " << culler.visibleCount << " frustum culled: " << culler.frustumCulledCount
+		<< " small culled: " << culler.smallCulledCount << std::endl;
+	std::cout << "  scalar: " << scalarMs << " ms (" << scalarMs * 1e6 / boundsCount << " ns/bounds)" << std::endl;
+	std::cout << "  simd:   " << simdMs << " ms (" << simdMs * 1e6 / boundsCount << " ns/bounds)" << std::endl;
+	std::cout << "  speedup: " << scalarMs / simdMs << "x, results " << (matches ? "match" : "DIFFER") << std::endl;
+}
+
+// Milliseconds elapsed since 'start'
+static double millisecondsSince(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void RunSceneBVHBenchmark() {
+	const unsigned int instanceCounts[] = {100, 1000, 10000, 100000, 1000000};
+	const unsigned int queryCount = 1000;
+
+	std::cout << "Scene BVH (times in ms, queries are per " << queryCount << " queries)" << std::endl;
+	std::cout << "  instances    build    refit1%  refitAll  frustum   rays   radius  linearRays" << std::endl;
+
+	for (unsigned int instanceCount : instanceCounts) {
+		std::mt19937 rng(42);
+		// Keep density constant so query results stay comparable as the scene grows
+		float worldSize = 10.0f * glm::sqrt((float) instanceCount);
+		std::uniform_real_distribution<float> position(-worldSize, worldSize);
+		std::uniform_real_distribution<float> size(0.2f, 3.0f);
+
+		std::vector<glm::vec3> minBounds(instanceCount), maxBounds(instanceCount);
+		for (unsigned int i = 0; i < instanceCount; i++) {
+			glm::vec3 center(position(rng), size(rng), position(rng));
+			glm::vec3 extent(size(rng), size(rng), size(rng));
+			minBounds[i] = center - extent;
+			maxBounds[i] = center + extent;
+		}
+
+		SceneBVH bvh;
+		auto start = std::chrono::high_resolution_clock::now();
+		bvh.Build(minBounds, maxBounds);
+		double buildMs = millisecondsSince(start);
+
+		// Move 1% of the instances a little, like animated models do every frame
+		std::uniform_int_distribution<unsigned int> pick(0, instanceCount - 1);
+		unsigned int moved = std::max(1u, instanceCount / 100);
+		start = std::chrono::high_resolution_clock::now();
+		for (unsigned int i = 0; i < moved; i++) {
+			unsigned int item = pick(rng);
+			glm::vec3 offset(0.1f, 0.0f, 0.05f);
+			bvh.UpdateItem(item, bvh.itemMin[item] + offset, bvh.itemMax[item] + offset);
+		}
+		double refitMs = millisecondsSince(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		bvh.Refit();
+		double refitAllMs = millisecondsSince(start);
+
+		// Camera looking across the scene from its edge
+		glm::vec3 eye(-worldSize, 2.0f, -worldSize);
+		glm::mat4 view = glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1366.0f / 768.0f, 0.1f, 100.0f);
+		FrustumCuller frustum;
+		frustum.ExtractPlanes(projection * view);
+		std::vector<unsigned int> result;
+		start = std::chrono::high_resolution_clock::now();
+		for (unsigned int q = 0; q < queryCount; q++) {
+			result.clear();
+			bvh.QueryFrustum(frustum.planes, result);
+		}
+		double frustumMs = millisecondsSince(start);
+
+		// Short horizontal rays like the collision probes in Camera::CheckCollisionRayCast
+		std::vector<glm::vec3> rayOrigins(queryCount), rayDirections(queryCount);
+		std::uniform_real_distribution<float> angle(0.0f, 2.0f * glm::pi<float>());
+		for (unsigned int q = 0; q < queryCount; q++) {
+			rayOrigins[q] = glm::vec3(position(rng), 1.0f, position(rng));
+			float a = angle(rng);
+			rayDirections[q] = glm::vec3(glm::cos(a), 0.0f, glm::sin(a));
+		}
+		unsigned int bvhHits = 0;
+		start = std::chrono::high_resolution_clock::now();
+		for (unsigned int q = 0; q < queryCount; q++) {
+			if (bvh.RayCast(rayOrigins[q], rayDirections[q], 5.0f, [](unsigned int) { return true; }))
+				bvhHits++;
+		}
+		double raysMs = millisecondsSince(start);
+
+		start = std::chrono::high_resolution_clock::now();
+		for (unsigned int q = 0; q < queryCount; q++) {
+			result.clear();
+			bvh.QueryRadius(rayOrigins[q], 2.0f, result);
+		}
+		double radiusMs = millisecondsSince(start);
+
+		// What the flat instance vector costs for the same rays
+		unsigned int linearHits = 0;
+		start = std::chrono::high_resolution_clock::now();
+		for (unsigned int q = 0; q < queryCount; q++) {
+			glm::vec3 invDirection = 1.0f / glm::vec3(
+				rayDirections[q].x != 0.0f ? rayDirections[q].x : 1e-20f, 1e-20f,
+				rayDirections[q].z != 0.0f ? rayDirections[q].z : 1e-20f);
+			for (unsigned int i = 0; i < instanceCount; i++) {
+				glm::vec3 t1 = (bvh.itemMin[i] - rayOrigins[q]) * invDirection;
+				glm::vec3 t2 = (bvh.itemMax[i] - rayOrigins[q]) * invDirection;
+				glm::vec3 tMin = glm::min(t1, t2);
+				glm::vec3 tMax = glm::max(t1, t2);
+				float tNear = glm::max(glm::max(tMin.x, tMin.y), glm::max(tMin.z, 0.0f));
+				float tFar = glm::min(glm::min(tMax.x, tMax.y), glm::min(tMax.z, 5.0f));
+				if (tNear <= tFar) {
+					linearHits++;
+					break;
+				}
+			}
+		}
+		double linearMs = millisecondsSince(start);
+
+		std::printf("  %9u %8.3f %9.4f %9.3f %8.3f %7.3f %8.3f %10.3f%s\n", instanceCount, buildMs, refitMs, refitAllMs,
+					frustumMs, raysMs, radiusMs, linearMs, bvhHits == linearHits ? "" : "  (ray hit count mismatch)");
+	}
+}
+
+void RunOcclusionCullingBenchmark(unsigned int boxCount, unsigned int iterations) {
+	// A wall of 200x100 quads at z = -10 covering about half the view, seen from the origin looking down -z
+	const int quadsX = 200, quadsY = 100;
+	const float wallZ = -10.0f, wallHalfWidth = 4.0f, wallHalfHeight = 2.0f;
+	std::vector<glm::vec3> positions;
+	std::vector<unsigned int> indices;
+	for (int y = 0; y <= quadsY; y++) {
+		for (int x = 0; x <= quadsX; x++) {
+			positions.push_back(glm::vec3(-wallHalfWidth + 2.0f * wallHalfWidth * x / quadsX,
+										  -wallHalfHeight + 2.0f * wallHalfHeight * y / quadsY, wallZ));
+		}
+	}
+	for (int y = 0; y < quadsY; y++) {
+		for (int x = 0; x < quadsX; x++) {
+			unsigned int corner = y * (quadsX + 1) + x;
+			unsigned int quad[6] = {corner, corner + 1, corner + quadsX + 2, corner, corner + quadsX + 2, corner + quadsX + 1};
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1366.0f / 768.0f, 0.1f, 100.0f);
+	glm::mat4 viewProjection = projection * view;
+
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> size(0.05f, 0.5f);
+	std::vector<glm::vec3> boxMin, boxMax;
+	for (unsigned int i = 0; i < boxCount; i++) {
+		// Spread over the view so some boxes are in front of the wall, some behind it and some beside it
+		float z = -2.0f - (position(rng) * 0.5f + 0.5f) * 40.0f;
+		glm::vec3 center(position(rng) * -z * 0.7f, position(rng) * -z * 0.4f, z);
+		glm::vec3 extent(size(rng));
+		boxMin.push_back(center - extent);
+		boxMax.push_back(center + extent);
+	}
+
+	std::cout << "Occlusion culling, " << indices.size() / 3 << " occluder triangles, " << boxCount << " boxes, "
+		<< iterations << " iterations" << std::endl;
+
+	unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::printf("  %8s %10s %10s %10s %10s %10s\n", "workers", "render ms", "test ms", "occluded", "hidden", "errors");
+	for (unsigned int workers = 1; workers <= hardwareThreads; workers *= 2) {
+		OcclusionCuller culler(320, 192, workers);
+		culler.AddOccluder(positions, indices, glm::mat4(1.0f));
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (unsigned int i = 0; i < iterations; i++)
+			culler.Render(viewProjection);
+		double renderMs = millisecondsSince(start) / iterations;
+
+		unsigned int occluded = 0, hidden = 0, errors = 0;
+		start = std::chrono::high_resolution_clock::now();
+		for (unsigned int i = 0; i < boxCount; i++) {
+			bool visible = culler.IsVisible(boxMin[i], boxMax[i]);
+			occluded += visible ? 0 : 1;
+			// Anything reaching in front of the wall, or past its sides as seen from the camera, must stay visible
+			bool inFront = boxMax[i].z > wallZ;
+			bool besideWall = false;
+			for (int corner = 0; corner < 8 && !inFront; corner++) {
+				glm::vec3 p((corner & 1) ? boxMax[i].x : boxMin[i].x, (corner & 2) ? boxMax[i].y : boxMin[i].y,
+							(corner & 4) ? boxMax[i].z : boxMin[i].z);
+				glm::vec2 onWall = glm::vec2(p) * (wallZ / p.z);
+				besideWall = besideWall || glm::abs(onWall.x) > wallHalfWidth || glm::abs(onWall.y) > wallHalfHeight;
+			}
+			if (!visible && (inFront || besideWall))
+				errors++;
+			hidden += (inFront || besideWall) ? 0 : 1;
+		}
+		double testMs = millisecondsSince(start);
+
+		std::printf("  %8u %10.3f %10.3f %10u %10u %10u\n", culler.WorkerCount(), renderMs, testMs, occluded, hidden, errors);
+	}
+}
+
+void RunClusteredLightingBenchmark(unsigned int iterations) {
+	// Same camera and projection as Main.cpp, lights spread over the building
+	glm::vec3 cameraPosition(7.0f, 1.7f, 7.0f);
+	glm::mat4 view = glm::lookAt(cameraPosition, cameraPosition + glm::vec3(-1.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1366.0f / 768.0f, 0.1f, 100.0f);
+
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> unitRandom(0.0f, 1.0f);
+	ClusteredLights clustered(false);
+	unsigned int clusterCount = clustered.tilesX * clustered.tilesY * clustered.depthSlices;
+
+	std::cout << "Clustered lighting, " << clustered.tilesX << "x" << clustered.tilesY << "x" << clustered.depthSlices
+		<< " clusters, " << iterations << " iterations" << std::endl;
+	std::printf("  %6s %12s %12s %10s %14s %12s\n", "lights", "1 thread ms", "all jobs ms", "entries", "avg / cluster", "max / cluster");
+	for (unsigned int lightCount = 1; lightCount <= 1024; lightCount *= 2) {
+		clustered.ClearLights();
+		for (unsigned int i = 0; i < lightCount; i++) {
+			glm::vec3 position(unitRandom(rng) * 20.0f - 10.0f, 0.3f + unitRandom(rng) * 2.5f, unitRandom(rng) * 20.0f - 10.0f);
+			clustered.AddLight(position, 1.5f + unitRandom(rng) * 2.0f, glm::vec3(1.0f));
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (unsigned int i = 0; i < iterations; i++)
+			clustered.Build(view, projection, 0.1f, 100.0f, 1);
+		double singleMs = millisecondsSince(start) / iterations;
+		start = std::chrono::high_resolution_clock::now();
+		for (unsigned int i = 0; i < iterations; i++)
+			clustered.Build(view, projection, 0.1f, 100.0f);
+		double parallelMs = millisecondsSince(start) / iterations;
+
+		// Without clusters every fragment would evaluate all 'lightCount' lights
+		std::printf("  %6u %12.4f %12.4f %10u %14.3f %12u\n", lightCount, singleMs, parallelMs, clustered.lightIndexCount,
+					(double) clustered.lightIndexCount / clusterCount, clustered.maxLightsPerCluster);
+	}
+}
+
+// Splits [begin, end) in halves down to 'grainSize', queueing one half as a job each time, so the work
+// starts in one worker's deque and only spreads out through stealing
+static void splitRange(unsigned int begin, unsigned int end, unsigned int grainSize, JobCounter& counter,
+					   std::vector<float>& results) {
+	while (end - begin > grainSize) {
+		unsigned int middle = begin + (end - begin) / 2;
+		jobSystem.Run([middle, end, grainSize, &counter, &results]() { splitRange(middle, end, grainSize, counter, results); }, &counter);
+		end = middle;
+	}
+	for (unsigned int i = begin; i < end; i++)
+		results[i] = glm::sqrt((float) i) * glm::sin((float) i);
+}
+
+void RunJobSystemBenchmark(unsigned int jobCount) {
+	unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<float> results(1 << 22);
+
+	std::cout << "Job system, " << hardwareThreads << " hardware threads" << std::endl;
+	std::printf("  %8s %12s %12s %10s %12s %10s\n", "workers", "spawn ns", "split ms", "stolen %", "for ms", "scaling");
+	double serialForMs = 0.0;
+	for (unsigned int workers = 0; workers < hardwareThreads; workers = workers == 0 ? 1 : workers * 2) {
+		if (workers == 0)
+			jobSystem.Stop();
+		else
+			jobSystem.Start(workers);
+
+		// Spawn overhead: empty jobs queued from this thread, then waited for
+		JobCounter counter;
+		auto start = std::chrono::high_resolution_clock::now();
+		for (unsigned int i = 0; i < jobCount; i++)
+			jobSystem.Run([]() {}, &counter);
+		jobSystem.Wait(counter);
+		double spawnNs = millisecondsSince(start) * 1e6 / jobCount;
+
+		// Steal rate: recursive splitting from a single job
+		jobSystem.ResetStatistics();
+		JobCounter splitCounter;
+		start = std::chrono::high_resolution_clock::now();
+		jobSystem.Run([&]() { splitRange(0, (unsigned int) results.size(), 4096, splitCounter, results); }, &splitCounter);
+		jobSystem.Wait(splitCounter);
+		double splitMs = millisecondsSince(start);
+		double stolenPercent = 100.0 * jobSystem.jobsStolen / std::max(1ull, jobSystem.jobsExecuted.load());
+
+		// Scaling: the same loop through ParallelFor
+		start = std::chrono::high_resolution_clock::now();
+		jobSystem.ParallelFor((unsigned int) results.size(), 16384, [&results](unsigned int begin, unsigned int end) {
+			for (unsigned int i = begin; i < end; i++)
+				results[i] = glm::sqrt((float) i) * glm::sin((float) i);
+		});
+		double forMs = millisecondsSince(start);
+		if (workers == 0)
+			serialForMs = forMs;
+
+		std::printf("  %8u %12.1f %12.3f %10.1f %12.3f %9.2fx\n", jobSystem.WorkerCount(), spawnNs, splitMs, stolenPercent,
+					forMs, serialForMs / forMs);
+	}
+	jobSystem.Start();
+}
+
+void RunFramePipelineBenchmark(unsigned int iterations) {
+	// A handful of models with 1 to 16 meshes each, instanced over a field around the camera
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> unitRandom(0.0f, 1.0f);
+	std::vector<std::vector<FramePipeline::MeshSource>> models(16);
+	for (unsigned int m = 0; m < models.size(); m++) {
+		unsigned int meshCount = 1 + m;
+		for (unsigned int i = 0; i < meshCount; i++) {
+			glm::vec3 center(unitRandom(rng) - 0.5f, unitRandom(rng), unitRandom(rng) - 0.5f);
+			glm::vec3 extent(0.05f + unitRandom(rng) * 0.3f);
+			models[m].push_back({center - extent, center + extent, glm::mat4(1.0f), (m + i) % 3});
+		}
+	}
+
+	glm::vec3 cameraPosition(7.0f, 1.7f, 7.0f);
+	glm::mat4 view = glm::lookAt(cameraPosition, cameraPosition + glm::vec3(-1.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1366.0f / 768.0f, 0.1f, 100.0f);
+	float projectionScale = 768.0f * 0.5f / glm::tan(glm::radians(45.0f) * 0.5f);
+	unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	std::cout << "Frame pipeline (ms per frame, " << iterations << " iterations)" << std::endl;
+	std::printf("  %9s %8s %8s %10s %10s %10s %10s %10s %8s\n", "instances", "meshes", "workers", "transform", "cull", "keys",
+				"sort", "total", "result");
+	for (unsigned int instanceCount = 1000; instanceCount <= 100000; instanceCount *= 10) {
+		std::vector<FramePipeline::Instance> instances;
+		std::vector<unsigned int> visibleInstances;
+		float fieldSize = glm::sqrt((float) instanceCount) * 1.5f;
+		for (unsigned int i = 0; i < instanceCount; i++) {
+			unsigned int model = (unsigned int) (unitRandom(rng) * models.size()) % models.size();
+			glm::mat4 matrix = glm::translate(glm::mat4(1.0f), glm::vec3((unitRandom(rng) - 0.5f) * fieldSize, 0.0f,
+																		 (unitRandom(rng) - 0.5f) * fieldSize));
+			matrix = glm::rotate(matrix, unitRandom(rng) * 6.28f, glm::vec3(0.0f, 1.0f, 0.0f));
+			instances.push_back({&models[model], matrix, model});
+			visibleInstances.push_back(i);
+		}
+
+		std::vector<uint64_t> referenceKeys;
+		for (unsigned int workers = 0; workers < hardwareThreads; workers = workers == 0 ? 1 : workers * 2) {
+			if (workers == 0)
+				jobSystem.Stop();
+			else
+				jobSystem.Start(workers);
+
+			FramePipeline pipeline;
+			pipeline.culler.minProjectedSize = 2.0f;
+			pipeline.culler.ExtractPlanes(projection * view);
+			FramePipeline::Timings total = {0.0, 0.0, 0.0, 0.0};
+			for (unsigned int i = 0; i < iterations; i++) {
+				pipeline.Transform(instances, visibleInstances);
+				pipeline.Cull(cameraPosition, projectionScale);
+				pipeline.BuildDrawList(cameraPosition);
+				total.transform += pipeline.timings.transform / iterations;
+				total.cull += pipeline.timings.cull / iterations;
+				total.keys += pipeline.timings.keys / iterations;
+				total.sort += pipeline.timings.sort / iterations;
+			}
+
+			// Every worker count must produce the serial draw list
+			std::vector<uint64_t> keys;
+			for (const FramePipeline::DrawItem& item : pipeline.drawList)
+				keys.push_back(item.key);
+			if (workers == 0)
+				referenceKeys = keys;
+			std::printf("  %9u %8u %8u %10.3f %10.3f %10.3f %10.3f %10.3f %8s\n", instanceCount, pipeline.culler.Size(),
+						jobSystem.WorkerCount(), total.transform, total.cull, total.keys, total.sort,
+						total.transform + total.cull + total.keys + total.sort, keys == referenceKeys ? "match" : "DIFFER");
+		}
+	}
+	jobSystem.Start();
+}
+
+// Generated glTF content for the loader benchmarks: appends to a buffer and describes it
+static unsigned int addBufferView(json& gltf, std::vector<unsigned char>& data, const void* bytes, size_t size, unsigned int stride) {
+	json view = {{"buffer", 0}, {"byteOffset", data.size()}, {"byteLength", size}};
+	if (stride > 0)
+		view["byteStride"] = stride;
+	data.insert(data.end(), (const unsigned char*) bytes, (const unsigned char*) bytes + size);
+	gltf["bufferViews"].push_back(view);
+	return (unsigned int) gltf["bufferViews"].size() - 1;
+}
+
+static unsigned int addAccessor(json& gltf, unsigned int bufferView, unsigned int byteOffset, unsigned int componentType,
+								unsigned int count, const char* type) {
+	gltf["accessors"].push_back({{"bufferView", bufferView}, {"byteOffset", byteOffset}, {"componentType", componentType},
+								 {"count", count}, {"type", type}});
+	return (unsigned int) gltf["accessors"].size() - 1;
+}
+
+// Node tree of the given branching and depth, every node with a translation, rotation and scale
+static void addNodes(json& gltf, std::mt19937& rng, unsigned int branching, unsigned int depth) {
+	std::uniform_real_distribution<float> unitRandom(-1.0f, 1.0f);
+	unsigned int index = (unsigned int) gltf["nodes"].size();
+	// Unit quaternion, stored x, y, z, w as in glTF
+	glm::vec4 rotation = glm::normalize(glm::vec4(unitRandom(rng), unitRandom(rng), unitRandom(rng), unitRandom(rng)) + glm::vec4(0.0f, 0.0f, 0.0f, 0.01f));
+	gltf["nodes"].push_back({
+		{"translation", {unitRandom(rng), unitRandom(rng), unitRandom(rng)}},
+		{"rotation", {rotation.x, rotation.y, rotation.z, rotation.w}},
+		{"scale", {1.0f + 0.1f * unitRandom(rng), 1.0f, 1.0f}}
+	});
+	if (depth == 0)
+		return;
+	json children = json::array();
+	for (unsigned int i = 0; i < branching; i++) {
+		children.push_back(gltf["nodes"].size());
+		addNodes(gltf, rng, branching, depth - 1);
+	}
+	gltf["nodes"][index]["children"] = children;
+}
+
+// Grid of quads in the XZ plane with 'vertexCount' vertices (rounded down to a square)
+static void generateGrid(unsigned int vertexCount, std::vector<glm::vec3>& positions, std::vector<glm::vec3>& normals,
+						 std::vector<glm::vec2>& texUVs, std::vector<GLuint>& indices) {
+	unsigned int side = std::max(2u, (unsigned int) glm::sqrt((float) vertexCount));
+	for (unsigned int z = 0; z < side; z++) {
+		for (unsigned int x = 0; x < side; x++) {
+			positions.push_back(glm::vec3((float) x / (side - 1) - 0.5f, 0.05f * glm::sin(x * 0.7f + z * 0.3f), (float) z / (side - 1) - 0.5f));
+			normals.push_back(glm::vec3(0.0f, 1.0f, 0.0f));
+			texUVs.push_back(glm::vec2((float) x / (side - 1), (float) z / (side - 1)));
+		}
+	}
+	for (unsigned int z = 0; z + 1 < side; z++) {
+		for (unsigned int x = 0; x + 1 < side; x++) {
+			GLuint corner = z * side + x;
+			GLuint quad[6] = {corner, corner + side, corner + 1, corner + 1, corner + side, corner + side + 1};
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+}
+
+void RunMicroBenchmarks(MicroBenchmark& benchmark) {
+	std::mt19937 rng(7);
+
+	// Loader: one generated mesh in a glTF buffer, attributes both in separate views and interleaved
+	const unsigned int vertexCounts[] = {1024, 65536};
+	for (unsigned int requestedCount : vertexCounts) {
+		std::vector<glm::vec3> positions, normals;
+		std::vector<glm::vec2> texUVs;
+		std::vector<GLuint> indices;
+		generateGrid(requestedCount, positions, normals, texUVs, indices);
+		unsigned int vertexCount = (unsigned int) positions.size();
+		unsigned int indexCount = (unsigned int) indices.size();
+		std::vector<unsigned short> shortIndices(indices.begin(), indices.end());
+		struct InterleavedVertex {
+			glm::vec3 position;
+			glm::vec3 normal;
+			glm::vec2 texUV;
+		};
+		std::vector<InterleavedVertex> interleaved;
+		for (unsigned int i = 0; i < vertexCount; i++)
+			interleaved.push_back({positions[i], normals[i], texUVs[i]});
+
+		Model model;
+		json& gltf = model.JSON;
+		gltf["bufferViews"] = json::array();
+		gltf["accessors"] = json::array();
+		unsigned int positionAccessor = addAccessor(gltf, addBufferView(gltf, model.data, positions.data(), vertexCount * sizeof(glm::vec3), 0),
+													0, 5126, vertexCount, "VEC3");
+		unsigned int uvAccessor = addAccessor(gltf, addBufferView(gltf, model.data, texUVs.data(), vertexCount * sizeof(glm::vec2), 0),
+											  0, 5126, vertexCount, "VEC2");
+		unsigned int interleavedView = addBufferView(gltf, model.data, interleaved.data(), vertexCount * sizeof(InterleavedVertex), sizeof(InterleavedVertex));
+		unsigned int interleavedAccessor = addAccessor(gltf, interleavedView, 12, 5126, vertexCount, "VEC3");
+		unsigned int indexAccessor = addAccessor(gltf, addBufferView(gltf, model.data, indices.data(), indexCount * sizeof(GLuint), 0),
+												 0, 5125, indexCount, "SCALAR");
+		unsigned int shortAccessor = addAccessor(gltf, addBufferView(gltf, model.data, shortIndices.data(), indexCount * sizeof(unsigned short), 0),
+												 0, 5123, indexCount, "SCALAR");
+		std::string size = "/" + std::to_string(vertexCount);
+
+		auto floatsBenchmark = [&](unsigned int accessor, unsigned int components) {
+			return [&model, accessor, components, vertexCount](MicroBenchmark::State& state) {
+				state.SetItemsPerIteration(vertexCount * components);
+				while (state.KeepRunning())
+					MicroBenchmark::DoNotOptimize(model.getFloats(model.JSON["accessors"][accessor]));
+			};
+		};
+		benchmark.Run("getFloats/vec3" + size, floatsBenchmark(positionAccessor, 3));
+		benchmark.Run("getFloats/vec2" + size, floatsBenchmark(uvAccessor, 2));
+		benchmark.Run("getFloats/vec3_interleaved" + size, floatsBenchmark(interleavedAccessor, 3));
+		auto indicesBenchmark = [&](unsigned int accessor) {
+			return [&model, accessor, indexCount](MicroBenchmark::State& state) {
+				state.SetItemsPerIteration(indexCount);
+				while (state.KeepRunning())
+					MicroBenchmark::DoNotOptimize(model.getIndices(model.JSON["accessors"][accessor]));
+			};
+		};
+		benchmark.Run("getIndices/uint32" + size, indicesBenchmark(indexAccessor));
+		benchmark.Run("getIndices/uint16" + size, indicesBenchmark(shortAccessor));
+		benchmark.Run("groupFloatsVec3" + size, [&](MicroBenchmark::State& state) {
+			std::vector<float> floats = model.getFloats(model.JSON["accessors"][positionAccessor]);
+			state.SetItemsPerIteration(vertexCount);
+			while (state.KeepRunning())
+				MicroBenchmark::DoNotOptimize(model.groupFloatsVec3(floats));
+		});
+		benchmark.Run("assembleVertices" + size, [&](MicroBenchmark::State& state) {
+			state.SetItemsPerIteration(vertexCount);
+			while (state.KeepRunning())
+				MicroBenchmark::DoNotOptimize(model.assembleVertices(positions, normals, texUVs));
+		});
+	}
+
+	// Transform composition over node trees without meshes: traverseNode reads every node from the
+	// JSON, TRS alone is the matrix math it does per node
+	const unsigned int treeDepths[] = {3, 6};
+	for (unsigned int depth : treeDepths) {
+		Model model;
+		model.JSON["nodes"] = json::array();
+		addNodes(model.JSON, rng, 4, depth);
+		unsigned int nodeCount = (unsigned int) model.JSON["nodes"].size();
+		benchmark.Run("traverseNode/" + std::to_string(nodeCount), [&](MicroBenchmark::State& state) {
+			state.SetItemsPerIteration(nodeCount);
+			while (state.KeepRunning())
+				model.traverseNode(0);
+		});
+
+		std::vector<glm::vec3> translations;
+		std::vector<glm::quat> rotations;
+		std::vector<glm::vec3> scales;
+		std::vector<int> parents;
+		for (unsigned int i = 0; i < nodeCount; i++) {
+			const json& node = model.JSON["nodes"][i];
+			const json& t = node["translation"];
+			const json& r = node["rotation"];
+			const json& s = node["scale"];
+			translations.push_back(glm::vec3(t[0].get<float>(), t[1].get<float>(), t[2].get<float>()));
+			rotations.push_back(glm::quat(r[3].get<float>(), r[0].get<float>(), r[1].get<float>(), r[2].get<float>()));
+			scales.push_back(glm::vec3(s[0].get<float>(), s[1].get<float>(), s[2].get<float>()));
+			parents.push_back(-1);
+		}
+		for (unsigned int i = 0; i < nodeCount; i++) {
+			if (model.JSON["nodes"][i].contains("children")) {
+				for (unsigned int child : model.JSON["nodes"][i]["children"])
+					parents[child] = (int) i;
+			}
+		}
+		std::vector<glm::mat4> world(nodeCount);
+		benchmark.Run("composeTRS/" + std::to_string(nodeCount), [&](MicroBenchmark::State& state) {
+			state.SetItemsPerIteration(nodeCount);
+			while (state.KeepRunning()) {
+				// Parents come before their children in the generated order
+				for (unsigned int i = 0; i < nodeCount; i++) {
+					glm::mat4 local = glm::translate(glm::mat4(1.0f), translations[i]) * glm::mat4_cast(rotations[i]) *
+						glm::scale(glm::mat4(1.0f), scales[i]);
+					world[i] = parents[i] >= 0 ? world[parents[i]] * local : local;
+				}
+				MicroBenchmark::DoNotOptimize(world);
+			}
+		});
+	}
+
+	// Ray against box tests, with rays aimed across a field of boxes
+	{
+		const unsigned int rayCount = 4096;
+		std::uniform_real_distribution<float> position(-20.0f, 20.0f);
+		std::uniform_real_distribution<float> size(0.2f, 2.0f);
+		std::vector<glm::vec3> origins(rayCount), directions(rayCount), boxMin(rayCount), boxMax(rayCount);
+		for (unsigned int i = 0; i < rayCount; i++) {
+			glm::vec3 center(position(rng), 1.0f, position(rng));
+			glm::vec3 extent(size(rng), size(rng), size(rng));
+			boxMin[i] = center - extent;
+			boxMax[i] = center + extent;
+			origins[i] = glm::vec3(position(rng), 1.0f, position(rng));
+			// Half the rays point at their box
+			glm::vec3 target = i % 2 ? center : glm::vec3(position(rng), 1.0f, position(rng));
+			directions[i] = glm::normalize(target - origins[i] + glm::vec3(0.001f));
+		}
+		Camera camera(1366, 768, glm::vec3(0.0f));
+		Model model;
+		benchmark.Run("RayIntersectsAABB/Camera", [&](MicroBenchmark::State& state) {
+			state.SetItemsPerIteration(rayCount);
+			while (state.KeepRunning()) {
+				unsigned int hits = 0;
+				for (unsigned int i = 0; i < rayCount; i++) {
+					float distance;
+					hits += camera.RayIntersectsAABB(origins[i], directions[i], boxMin[i], boxMax[i], distance);
+				}
+				MicroBenchmark::DoNotOptimize(hits);
+			}
+		});
+		benchmark.Run("RayIntersectsAABB/Model", [&](MicroBenchmark::State& state) {
+			state.SetItemsPerIteration(rayCount);
+			while (state.KeepRunning()) {
+				unsigned int hits = 0;
+				for (unsigned int i = 0; i < rayCount; i++) {
+					float distance;
+					hits += model.RayIntersectsAABB(origins[i], directions[i], boxMin[i], boxMax[i], distance);
+				}
+				MicroBenchmark::DoNotOptimize(hits);
+			}
+		});
+	}
+
+	// The rest needs meshes, which need a GL context for their buffers
+	HeadlessContext context;
+	if (!context.Create(3, 3)) {
+		std::cout << "  (no headless GL context, skipping CalculateBoundingBox and CheckCollisionRayCast)" << std::endl;
+		return;
+	}
+	context.MakeCurrent();
+	gladLoadGLLoader((GLADloadproc) HeadlessContext::GetProcAddress);
+	LoadGLExtensions((GLADloadproc) HeadlessContext::GetProcAddress);
+	{
+		// Meshes of a grid model, as the loader would have made them
+		auto buildModel = [](Model& model, unsigned int meshCount, unsigned int verticesPerMesh) {
+			for (unsigned int i = 0; i < meshCount; i++) {
+				std::vector<glm::vec3> positions, normals;
+				std::vector<glm::vec2> texUVs;
+				std::vector<GLuint> indices;
+				generateGrid(verticesPerMesh, positions, normals, texUVs, indices);
+				std::vector<Vertex> vertices = model.assembleVertices(positions, normals, texUVs);
+				std::vector<Texture> textures;
+				model.meshes.push_back(Mesh(vertices, indices, textures));
+				model.matricesMeshes.push_back(glm::translate(glm::mat4(1.0f), glm::vec3((float) i, 0.0f, 0.0f)));
+			}
+			model.CalculateBoundingBox();
+		};
+
+		Model gridModel;
+		buildModel(gridModel, 16, 4096);
+		unsigned int gridVertices = 0;
+		for (const Mesh& mesh : gridModel.meshes)
+			gridVertices += (unsigned int) mesh.vertices.size();
+		benchmark.Run("CalculateBoundingBox/" + std::to_string(gridVertices), [&](MicroBenchmark::State& state) {
+			state.SetItemsPerIteration(gridVertices);
+			while (state.KeepRunning())
+				gridModel.CalculateBoundingBox();
+		});
+
+		// Player-sized probes walking through a square field of instances 3 units apart, as in
+		// Camera::Inputs. Half the probes stand right next to an instance.
+		Model boxModel;
+		buildModel(boxModel, 1, 64);
+		boxModel.minBounds = glm::vec3(-0.5f, 0.0f, -0.5f);
+		boxModel.maxBounds = glm::vec3(0.5f, 2.0f, 0.5f);
+		const unsigned int instanceCounts[] = {10, 100, 1000, 10000};
+		const unsigned int probeCount = 64;
+		for (unsigned int instanceCount : instanceCounts) {
+			Camera camera(1366, 768, glm::vec3(0.0f, 1.7f, 0.0f));
+			unsigned int side = (unsigned int) glm::ceil(glm::sqrt((float) instanceCount));
+			for (unsigned int i = 0; i < instanceCount; i++)
+				camera.AddModelInstance(&boxModel, glm::translate(glm::mat4(1.0f), glm::vec3((i % side) * 3.0f, 0.0f, (i / side) * 3.0f)));
+			camera.BuildInstanceBVH();
+			std::uniform_real_distribution<float> field(0.0f, side * 3.0f);
+			std::vector<glm::vec3> probes;
+			for (unsigned int i = 0; i < probeCount; i++) {
+				glm::vec3 probe(field(rng), 1.7f, field(rng));
+				if (i % 2)
+					probe = glm::vec3((i % side) * 3.0f + 0.9f, 1.7f, ((i / 2) % side) * 3.0f);
+				probes.push_back(probe);
+			}
+			benchmark.Run("CheckCollisionRayCast/" + std::to_string(instanceCount), [&](MicroBenchmark::State& state) {
+				state.SetItemsPerIteration(probeCount);
+				while (state.KeepRunning()) {
+					unsigned int hits = 0;
+					for (const glm::vec3& probe : probes) {
+						camera.Position = probe - glm::vec3(0.05f, 0.0f, 0.0f);
+						hits += camera.CheckCollisionRayCast(probe);
+					}
+					MicroBenchmark::DoNotOptimize(hits);
+				}
+			});
+		}
+	}
+	context.Destroy();
+}
+
+int RunBenchmarks(int argc, char** argv) {
+	// Optional filter after --benchmark, e.g. "--benchmark culling". The micro-benchmarks take
+	// further options: --filter <part of a name>, --json <file>, --min-time <seconds>, --repetitions <n>
+	std::string filter = argc > 2 ? argv[2] : "";
+	MicroBenchmark microBenchmark;
+	const char* jsonFile = NULL;
+	for (int i = 3; i + 1 < argc; i += 2) {
+		if (std::strcmp(argv[i], "--filter") == 0)
+			microBenchmark.filter = argv[i + 1];
+		else if (std::strcmp(argv[i], "--json") == 0)
+			jsonFile = argv[i + 1];
+		else if (std::strcmp(argv[i], "--min-time") == 0)
+			microBenchmark.minSeconds = std::atof(argv[i + 1]);
+		else if (std::strcmp(argv[i], "--repetitions") == 0)
+			microBenchmark.repetitions = (unsigned int) std::max(std::atoi(argv[i + 1]), 1);
+	}
+	jobSystem.Start();
+
+	if (filter.empty() || filter == "culling")
+		RunFrustumCullingBenchmark();
+	if (filter.empty() || filter == "bvh")
+		RunSceneBVHBenchmark();
+	if (filter.empty() || filter == "occlusion")
+		RunOcclusionCullingBenchmark();
+	if (filter.empty() || filter == "lights")
+		RunClusteredLightingBenchmark();
+	if (filter.empty() || filter == "jobs")
+		RunJobSystemBenchmark();
+	if (filter.empty() || filter == "pipeline")
+		RunFramePipelineBenchmark();
+	if (filter.empty() || filter == "micro") {
+		std::cout << "Micro-benchmarks (median of " << microBenchmark.repetitions << " runs of at least "
+			<< microBenchmark.minSeconds << " s, CV = stddev / mean)" << std::endl;
+		RunMicroBenchmarks(microBenchmark);
+		if (jsonFile != NULL && microBenchmark.WriteJson(jsonFile))
+			std::cout << "Micro-benchmarks: wrote " << jsonFile << std::endl;
+	}
+
+	jobSystem.Stop();
+	return 0;
+}
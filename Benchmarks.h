@@ -0,0 +1,36 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+// Measures FrustumCuller over randomly generated world bounds (scalar vs. SIMD path)
+void RunFrustumCullingBenchmark(unsigned int boundsCount = 100000, unsigned int iterations = 200);
+
+// Measures SceneBVH build, refit and query times for growing instance counts
+void RunSceneBVHBenchmark();
+
+// Rasterizes a synthetic occluder wall with OcclusionCuller and tests random boxes against it,
+// checking that nothing in front of the wall is reported as occluded
+void RunOcclusionCullingBenchmark(unsigned int boxCount = 100000, unsigned int iterations = 50);
+
+// Builds the clustered light lists for 1 to 1024 random lights, single threaded and split over the job system.
+// GPU frame time against light count is measured in the application (L cycles the test lights).
+void RunClusteredLightingBenchmark(unsigned int iterations = 100);
+
+// Measures the job system with 0 to hardware threads - 1 workers: cost of spawning and waiting for
+// empty jobs, share of stolen jobs when work is split recursively from one job, and ParallelFor scaling
+void RunJobSystemBenchmark(unsigned int jobCount = 100000);
+
+// Runs FramePipeline over 1000 to 100000 random instances with 0 to hardware threads - 1 workers,
+// reporting each stage and checking the draw list against the serial one
+void RunFramePipelineBenchmark(unsigned int iterations = 20);
+
+class MicroBenchmark;
+
+// Loader, collision and math hot paths on generated data: getFloats/getIndices, assembleVertices,
+// traverseNode, CalculateBoundingBox, RayIntersectsAABB and CheckCollisionRayCast with 10 to 10000
+// instances. The mesh based ones need a headless GL context and are skipped without one.
+void RunMicroBenchmarks(MicroBenchmark& benchmark);
+
+// Runs all benchmarks, selected from the command line with --benchmark
+int RunBenchmarks(int argc, char** argv);
+
+#endif
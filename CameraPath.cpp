@@ -0,0 +1,126 @@
+#include"CameraPath.h"
+
+#include<algorithm>
+#include<fstream>
+#include<iostream>
+#include<sstream>
+#include<glm/gtc/constants.hpp>
+#include<json/json.h>
+
+using json = nlohmann::json;
+
+static bool isVec3(const json& value) {
+	return value.is_array() && value.size() >= 3 && value[0].is_number() && value[1].is_number() && value[2].is_number();
+}
+
+static glm::vec3 readVec3(const json& value) {
+	return glm::vec3(value[0].get<float>(), value[1].get<float>(), value[2].get<float>());
+}
+
+bool CameraPath::Load(const char* file) {
+	std::ifstream in(file, std::ios::binary);
+	if (!in)
+		return false;
+	std::stringstream contents;
+	contents << in.rdbuf();
+	json data = json::parse(contents.str(), nullptr, false);
+	if (data.is_discarded() || !data.is_object() || !data.contains("keyframes") || !data["keyframes"].is_array()) {
+		std::cout << "CameraPath: could not parse " << file << std::endl;
+		return false;
+	}
+
+	// Read into a separate list, so a bad file leaves the current path as it was
+	std::vector<Keyframe> loaded;
+	for (const json& keyframe : data["keyframes"]) {
+		if (!keyframe.is_object() || !keyframe.contains("time") || !keyframe["time"].is_number() ||
+			!keyframe.contains("position") || !isVec3(keyframe["position"]) ||
+			!keyframe.contains("orientation") || !isVec3(keyframe["orientation"])) {
+			std::cout << "CameraPath: keyframe " << loaded.size() << " in " << file
+				<< " needs \"time\" as a number and \"position\" and \"orientation\" as [x, y, z]" << std::endl;
+			return false;
+		}
+		loaded.push_back({keyframe["time"].get<float>(), readVec3(keyframe["position"]), readVec3(keyframe["orientation"])});
+	}
+	if (loaded.empty()) {
+		std::cout << "CameraPath: no keyframes in " << file << std::endl;
+		return false;
+	}
+	std::stable_sort(loaded.begin(), loaded.end(), [](const Keyframe& a, const Keyframe& b) {
+		return a.time < b.time;
+	});
+	keyframes = std::move(loaded);
+	return true;
+}
+
+bool CameraPath::Save(const char* file) const {
+	json data;
+	data["keyframes"] = json::array();
+	for (const Keyframe& keyframe : keyframes) {
+		data["keyframes"].push_back({
+			{"time", keyframe.time},
+			{"position", {keyframe.position.x, keyframe.position.y, keyframe.position.z}},
+			{"orientation", {keyframe.orientation.x, keyframe.orientation.y, keyframe.orientation.z}}
+		});
+	}
+	std::ofstream out(file);
+	if (!out) {
+		std::cout << "CameraPath: could not write " << file << std::endl;
+		return false;
+	}
+	out << data.dump(1) << std::endl;
+	return true;
+}
+
+void CameraPath::AddKeyframe(float time, const glm::vec3& position, const glm::vec3& orientation) {
+	keyframes.push_back({time, position, orientation});
+}
+
+float CameraPath::Duration() const {
+	return keyframes.empty() ? 0.0f : keyframes.back().time - keyframes.front().time;
+}
+
+void CameraPath::Sample(float time, glm::vec3& position, glm::vec3& orientation) const {
+	if (keyframes.empty())
+		return;
+	if (time <= keyframes.front().time || keyframes.size() == 1) {
+		position = keyframes.front().position;
+		orientation = keyframes.front().orientation;
+		return;
+	}
+	if (time >= keyframes.back().time) {
+		position = keyframes.back().position;
+		orientation = keyframes.back().orientation;
+		return;
+	}
+
+	// Segment [i, i + 1] containing 'time', with its neighbours for the tangents
+	size_t i = std::upper_bound(keyframes.begin(), keyframes.end(), time, [](float t, const Keyframe& keyframe) {
+		return t < keyframe.time;
+	}) - keyframes.begin() - 1;
+	const Keyframe& a = keyframes[i];
+	const Keyframe& b = keyframes[i + 1];
+	const glm::vec3& before = keyframes[i > 0 ? i - 1 : i].position;
+	const glm::vec3& after = keyframes[std::min(i + 2, keyframes.size() - 1)].position;
+	float span = b.time - a.time;
+	float t = span > 0.0f ? (time - a.time) / span : 0.0f;
+
+	float t2 = t * t;
+	float t3 = t2 * t;
+	position = 0.5f * ((2.0f * a.position) + (b.position - before) * t +
+		(2.0f * before - 5.0f * a.position + 4.0f * b.position - after) * t2 +
+		(3.0f * a.position - before - 3.0f * b.position + after) * t3);
+	glm::vec3 direction = glm::mix(a.orientation, b.orientation, t);
+	orientation = glm::length(direction) > 0.0f ? glm::normalize(direction) : a.orientation;
+}
+
+CameraPath CameraPath::Orbit(const glm::vec3& center, float radius, float duration, unsigned int keyframeCount) {
+	CameraPath path;
+	keyframeCount = std::max(keyframeCount, 2u);
+	for (unsigned int i = 0; i < keyframeCount; i++) {
+		float t = (float) i / (keyframeCount - 1);
+		float angle = t * 2.0f * glm::pi<float>();
+		glm::vec3 position = center + radius * glm::vec3(glm::cos(angle), 0.0f, glm::sin(angle));
+		path.AddKeyframe(t * duration, position, glm::normalize(center - position));
+	}
+	return path;
+}
@@ -0,0 +1,35 @@
+#ifndef CAMERA_PATH_CLASS_H
+#define CAMERA_PATH_CLASS_H
+
+#include<glm/glm.hpp>
+#include<vector>
+
+// Camera position and view direction over time, so a run can be repeated exactly (benchmarks).
+// Paths are scripted by hand or recorded from a session, and stored as JSON:
+//   { "keyframes": [ { "time": 0.0, "position": [x, y, z], "orientation": [x, y, z] }, ... ] }
+// Positions follow a Catmull-Rom spline through the keyframes, orientations are blended linearly.
+class CameraPath {
+public:
+	struct Keyframe {
+		float time;
+		glm::vec3 position;
+		glm::vec3 orientation;
+	};
+
+	// Sorted by time
+	std::vector<Keyframe> keyframes;
+
+	// Returns false if the file is missing, has no keyframes or a malformed one
+	bool Load(const char* file);
+	bool Save(const char* file) const;
+
+	// Appends a keyframe, 'time' must not be before the last one
+	void AddKeyframe(float time, const glm::vec3& position, const glm::vec3& orientation);
+	float Duration() const;
+	// Camera at 'time', clamped to the ends of the path
+	void Sample(float time, glm::vec3& position, glm::vec3& orientation) const;
+
+	// Scripted path: one loop around 'center' at its height, looking inward, over 'duration' seconds
+	static CameraPath Orbit(const glm::vec3& center, float radius, float duration, unsigned int keyframeCount = 16);
+};
+#endif
@@ -0,0 +1,226 @@
+#include"ClusteredLights.h"
+
+#include<algorithm>
+#include<cmath>
+#include<iostream>
+
+#include"JobSystem.h"
+
+ClusteredLights::ClusteredLights(bool createBuffers) {
+	if (!createBuffers)
+		return;
+
+	hasBuffers = true;
+	glGenBuffers(1, &lightBuffer);
+	glGenBuffers(1, &clusterBuffer);
+	glGenBuffers(1, &indexBuffer);
+	glGenTextures(1, &lightTexture);
+	glGenTextures(1, &clusterTexture);
+	glGenTextures(1, &indexTexture);
+}
+
+void ClusteredLights::ClearLights() {
+	lights.clear();
+}
+
+unsigned int ClusteredLights::AddLight(const glm::vec3& position, float radius, const glm::vec3& color, float ambient) {
+	Light light;
+	light.position = position;
+	light.radius = radius;
+	light.color = color;
+	light.ambient = ambient;
+	lights.push_back(light);
+	return (unsigned int) lights.size() - 1;
+}
+
+float ClusteredLights::sliceDepth(int slice) const {
+	// Exponential slices keep the clusters roughly cube shaped
+	return nearPlane * std::pow(farPlane / nearPlane, (float) slice / depthSlices);
+}
+
+void ClusteredLights::Build(const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane,
+							unsigned int threadCount) {
+	ClusteredLights::nearPlane = nearPlane;
+	ClusteredLights::farPlane = farPlane;
+	projectionX = projection[0][0];
+	projectionY = projection[1][1];
+
+	// Only the first maxLights lights have an index, the rest would wrap around to other lights
+	size_t lightCount = std::min(lights.size(), (size_t) maxLights);
+	if (lightCount < lights.size() && !warnedLightCount) {
+		std::cerr << "ClusteredLights: " << lights.size() << " lights, only the first " << maxLights << " are shaded" << std::endl;
+		warnedLightCount = true;
+	}
+	viewPositions.resize(lightCount);
+	for (size_t i = 0; i < lightCount; i++)
+		viewPositions[i] = glm::vec3(view * glm::vec4(lights[i].position, 1.0f));
+
+	sliceClusters.resize(depthSlices);
+	sliceIndices.resize(depthSlices);
+
+	// Every slice is independent, so slices are split into jobs. Not worth it for a handful of lights.
+	if (threadCount == 0)
+		threadCount = jobSystem.WorkerCount() + 1;
+	threadCount = std::min(threadCount, (unsigned int) depthSlices);
+	if (lightCount < 32)
+		threadCount = 1;
+
+	unsigned int slicesPerJob = (depthSlices + threadCount - 1) / threadCount;
+	jobSystem.ParallelFor(depthSlices, slicesPerJob, [this](unsigned int begin, unsigned int end) {
+		buildSlices((int) begin, (int) end);
+	});
+
+	// Merge the per-slice lists into one index list
+	int tileCount = tilesX * tilesY;
+	clusters.resize(tileCount * depthSlices);
+	clusterLightIndices.clear();
+	maxLightsPerCluster = 0;
+	for (int slice = 0; slice < depthSlices; slice++) {
+		unsigned int base = (unsigned int) clusterLightIndices.size();
+		for (int tile = 0; tile < tileCount; tile++) {
+			glm::uvec2 cluster = sliceClusters[slice][tile];
+			clusters[slice * tileCount + tile] = glm::uvec2(base + cluster.x, cluster.y);
+			maxLightsPerCluster = std::max(maxLightsPerCluster, cluster.y);
+		}
+		clusterLightIndices.insert(clusterLightIndices.end(), sliceIndices[slice].begin(), sliceIndices[slice].end());
+	}
+	lightIndexCount = (unsigned int) clusterLightIndices.size();
+}
+
+void ClusteredLights::buildSlices(int firstSlice, int endSlice) {
+	// Screen tiles a light covers within one slice
+	struct Coverage {
+		unsigned short light;
+		short minX, maxX, minY, maxY;
+	};
+	std::vector<Coverage> covered;
+	int tileCount = tilesX * tilesY;
+
+	for (int slice = firstSlice; slice < endSlice; slice++) {
+		float sliceNear = sliceDepth(slice);
+		float sliceFar = sliceDepth(slice + 1);
+		covered.clear();
+
+		for (size_t i = 0; i < viewPositions.size(); i++) {
+			const glm::vec3& position = viewPositions[i];
+			float radius = lights[i].radius;
+			float depth = -position.z;
+			if (depth + radius < sliceNear || depth - radius > sliceFar)
+				continue;
+
+			// Project the light's view-space box over the part of the slice it overlaps.
+			// x / z is monotonic in both, so the extremes are at the corners.
+			float nearDepth = std::max(sliceNear, depth - radius);
+			float farDepth = std::min(sliceFar, depth + radius);
+			float minX = std::min((position.x - radius) / nearDepth, (position.x - radius) / farDepth) * projectionX;
+			float maxX = std::max((position.x + radius) / nearDepth, (position.x + radius) / farDepth) * projectionX;
+			float minY = std::min((position.y - radius) / nearDepth, (position.y - radius) / farDepth) * projectionY;
+			float maxY = std::max((position.y + radius) / nearDepth, (position.y + radius) / farDepth) * projectionY;
+			if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f)
+				continue;
+
+			Coverage coverage;
+			coverage.light = (unsigned short) i;
+			coverage.minX = (short) glm::clamp((int) std::floor((minX * 0.5f + 0.5f) * tilesX), 0, tilesX - 1);
+			coverage.maxX = (short) glm::clamp((int) std::floor((maxX * 0.5f + 0.5f) * tilesX), 0, tilesX - 1);
+			coverage.minY = (short) glm::clamp((int) std::floor((minY * 0.5f + 0.5f) * tilesY), 0, tilesY - 1);
+			coverage.maxY = (short) glm::clamp((int) std::floor((maxY * 0.5f + 0.5f) * tilesY), 0, tilesY - 1);
+			covered.push_back(coverage);
+		}
+
+		// Count, prefix sum, then fill, so each cluster's lights are contiguous
+		std::vector<glm::uvec2>& tiles = sliceClusters[slice];
+		tiles.assign(tileCount, glm::uvec2(0));
+		for (const Coverage& coverage : covered) {
+			for (int y = coverage.minY; y <= coverage.maxY; y++) {
+				for (int x = coverage.minX; x <= coverage.maxX; x++)
+					tiles[y * tilesX + x].y++;
+			}
+		}
+		unsigned int offset = 0;
+		for (int tile = 0; tile < tileCount; tile++) {
+			tiles[tile].x = offset;
+			offset += tiles[tile].y;
+			tiles[tile].y = 0;
+		}
+		std::vector<unsigned short>& indices = sliceIndices[slice];
+		indices.resize(offset);
+		for (const Coverage& coverage : covered) {
+			for (int y = coverage.minY; y <= coverage.maxY; y++) {
+				for (int x = coverage.minX; x <= coverage.maxX; x++) {
+					glm::uvec2& tile = tiles[y * tilesX + x];
+					indices[tile.x + tile.y++] = coverage.light;
+				}
+			}
+		}
+	}
+}
+
+void ClusteredLights::Upload() {
+	if (!hasBuffers)
+		return;
+
+	// Two RGBA32F texels per light: (position, radius), (color, ambient)
+	std::vector<glm::vec4> lightTexels;
+	for (const Light& light : lights) {
+		lightTexels.push_back(glm::vec4(light.position, light.radius));
+		lightTexels.push_back(glm::vec4(light.color, light.ambient));
+	}
+	// Buffer textures cannot be empty
+	if (lightTexels.empty())
+		lightTexels.push_back(glm::vec4(0.0f));
+	std::vector<unsigned short> indices = clusterLightIndices;
+	if (indices.empty())
+		indices.push_back(0);
+
+	glBindBuffer(GL_TEXTURE_BUFFER, lightBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, lightTexels.size() * sizeof(glm::vec4), lightTexels.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, clusterBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, clusters.size() * sizeof(glm::uvec2), clusters.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, indexBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	glBindTexture(GL_TEXTURE_BUFFER, lightTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, lightBuffer);
+	glBindTexture(GL_TEXTURE_BUFFER, clusterTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, clusterBuffer);
+	glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_R16UI, indexBuffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void ClusteredLights::Bind(Shader& shader, GLuint firstUnit, float screenWidth, float screenHeight) {
+	if (!hasBuffers)
+		return;
+
+	shader.Activate();
+	glActiveTexture(GL_TEXTURE0 + firstUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, lightTexture);
+	glActiveTexture(GL_TEXTURE0 + firstUnit + 1);
+	glBindTexture(GL_TEXTURE_BUFFER, clusterTexture);
+	glActiveTexture(GL_TEXTURE0 + firstUnit + 2);
+	glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+	glActiveTexture(GL_TEXTURE0);
+
+	glUniform1i(glGetUniformLocation(shader.ID, "lightData"), firstUnit);
+	glUniform1i(glGetUniformLocation(shader.ID, "clusterGrid"), firstUnit + 1);
+	glUniform1i(glGetUniformLocation(shader.ID, "clusterLightIndices"), firstUnit + 2);
+	glUniform3i(glGetUniformLocation(shader.ID, "clusterCount"), tilesX, tilesY, depthSlices);
+	glUniform2f(glGetUniformLocation(shader.ID, "screenSize"), screenWidth, screenHeight);
+	glUniform1f(glGetUniformLocation(shader.ID, "clusterNear"), nearPlane);
+	glUniform1f(glGetUniformLocation(shader.ID, "clusterFar"), farPlane);
+}
+
+void ClusteredLights::Delete() {
+	if (!hasBuffers)
+		return;
+
+	glDeleteTextures(1, &lightTexture);
+	glDeleteTextures(1, &clusterTexture);
+	glDeleteTextures(1, &indexTexture);
+	glDeleteBuffers(1, &lightBuffer);
+	glDeleteBuffers(1, &clusterBuffer);
+	glDeleteBuffers(1, &indexBuffer);
+	hasBuffers = false;
+}
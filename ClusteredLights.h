@@ -0,0 +1,89 @@
+#ifndef CLUSTERED_LIGHTS_CLASS_H
+#define CLUSTERED_LIGHTS_CLASS_H
+
+#include<glad/glad.h>
+#include<glm/glm.hpp>
+#include<vector>
+
+#include"shaderClass.h"
+
+// Clustered forward lighting. The view frustum is split into tilesX * tilesY screen tiles and
+// depthSlices exponential depth slices; every cluster gets the list of point lights whose range
+// reaches it. The lists are built on the CPU (slices in parallel on the job system) and passed to default.frag in
+// texture buffers, so each fragment only loops over the lights of its own cluster.
+class ClusteredLights {
+public:
+	struct Light {
+		glm::vec3 position;
+		// Distance at which the light fades out completely, used for the cluster assignment
+		float radius;
+		glm::vec3 color;
+		// Fraction of 'color' added as ambient light
+		float ambient;
+	};
+
+	// Cluster grid, must match the uniforms set in Bind
+	int tilesX = 16;
+	int tilesY = 9;
+	int depthSlices = 24;
+
+	std::vector<Light> lights;
+	// Light indices are 16 bit (R16UI), lights past this many are left out of the clusters
+	static const unsigned int maxLights = 65536;
+
+	// Statistics of the last Build call
+	unsigned int lightIndexCount = 0;
+	unsigned int maxLightsPerCluster = 0;
+
+	// Creates the GL buffers when 'createBuffers' is true, false keeps it CPU-only (benchmarks)
+	ClusteredLights(bool createBuffers = true);
+
+	void ClearLights();
+	unsigned int AddLight(const glm::vec3& position, float radius, const glm::vec3& color, float ambient = 0.0625f);
+
+	// Assigns the lights to the clusters of a camera, split into up to 'threadCount' jobs (0 = one per job system thread)
+	void Build(const glm::mat4& view, const glm::mat4& projection, float nearPlane, float farPlane, unsigned int threadCount = 0);
+	// Uploads the lists of the last Build into the texture buffers
+	void Upload();
+	// Binds the texture buffers to units firstUnit..firstUnit+2 and sets the cluster uniforms of 'shader'
+	void Bind(Shader& shader, GLuint firstUnit, float screenWidth, float screenHeight);
+	void Delete();
+
+	// Per cluster (offset into clusterLightIndices, light count), cluster index = (slice * tilesY + y) * tilesX + x
+	const std::vector<glm::uvec2>& GetClusters() const {
+		return clusters;
+	}
+	const std::vector<unsigned short>& GetClusterLightIndices() const {
+		return clusterLightIndices;
+	}
+
+private:
+	std::vector<glm::uvec2> clusters;
+	std::vector<unsigned short> clusterLightIndices;
+
+	// Per-slice results, merged into 'clusters' and 'clusterLightIndices' after the parallel part
+	std::vector<std::vector<glm::uvec2>> sliceClusters;
+	std::vector<std::vector<unsigned short>> sliceIndices;
+
+	// View-space light positions and the projection terms of the last Build
+	std::vector<glm::vec3> viewPositions;
+	float projectionX = 1.0f;
+	float projectionY = 1.0f;
+	float nearPlane = 0.1f;
+	float farPlane = 100.0f;
+
+	bool hasBuffers = false;
+	bool warnedLightCount = false;
+	GLuint lightBuffer = 0;
+	GLuint lightTexture = 0;
+	GLuint clusterBuffer = 0;
+	GLuint clusterTexture = 0;
+	GLuint indexBuffer = 0;
+	GLuint indexTexture = 0;
+
+	// Fills sliceClusters/sliceIndices for slices [firstSlice, endSlice)
+	void buildSlices(int firstSlice, int endSlice);
+	// Depth (positive distance along -z in view space) where a slice starts
+	float sliceDepth(int slice) const;
+};
+#endif
@@ -0,0 +1,196 @@
+#include"DeferredRenderer.h"
+#include"GLDebug.h"
+#include"ShaderVariants.h"
+#include"TextureTable.h"
+
+#include<glm/gtc/type_ptr.hpp>
+#include<iostream>
+
+DeferredRenderer::DeferredRenderer(int width, int height)
+	: geometryProgram("default.vert", "gbuffer.frag", ShaderVariants::Defines(textureTable.UsesHandles() ? (unsigned int) SHADER_TEXTURE_HANDLES : 0u)),
+	  lightingProgram("deferred.vert", "deferred_light.frag"),
+	  pointLightProgram("deferred_point.vert", "deferred_point.frag") {
+	DeferredRenderer::width = width;
+	DeferredRenderer::height = height;
+	renderWidth = width;
+	renderHeight = height;
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+	glGenTextures(1, &albedoTexture);
+	glBindTexture(GL_TEXTURE_2D, albedoTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, albedoTexture, 0);
+
+	glGenTextures(1, &normalTexture);
+	glBindTexture(GL_TEXTURE_2D, normalTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB10_A2, width, height, 0, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normalTexture, 0);
+
+	// Same format as the usual default framebuffer, so the depth can be blitted over
+	glGenTextures(1, &depthTexture);
+	glBindTexture(GL_TEXTURE_2D, depthTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+
+	GLenum attachments[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+	glDrawBuffers(2, attachments);
+	glDebug.Label(GL_FRAMEBUFFER, framebuffer, "G-buffer");
+	glDebug.Label(GL_TEXTURE, albedoTexture, "G-buffer albedo");
+	glDebug.Label(GL_TEXTURE, normalTexture, "G-buffer normals");
+	glDebug.Label(GL_TEXTURE, depthTexture, "G-buffer depth");
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "DeferredRenderer: G-buffer framebuffer is incomplete" << std::endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenVertexArrays(1, &screenVAO);
+
+	// Icosahedron, scaled by circumradius / inradius so its faces stay outside the unit sphere
+	const float t = 1.6180340f;
+	const float scale = 1.2584086f / glm::length(glm::vec2(1.0f, t));
+	std::vector<glm::vec3> vertices = {
+		{-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0},
+		{0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t},
+		{t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1}
+	};
+	for (glm::vec3& vertex : vertices)
+		vertex *= scale;
+	std::vector<GLuint> indices = {
+		0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11,
+		1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+		3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9,
+		4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1
+	};
+	sphereIndexCount = (GLsizei) indices.size();
+
+	glGenVertexArrays(1, &sphereVAO);
+	glGenBuffers(1, &sphereVBO);
+	glGenBuffers(1, &sphereEBO);
+	glGenBuffers(1, &instanceVBO);
+	glBindVertexArray(sphereVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, sphereVBO);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*) 0);
+	glEnableVertexAttribArray(0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphereEBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+
+	// Per-instance light data, laid out like ClusteredLights::Light
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ClusteredLights::Light), (void*) 0);
+	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(ClusteredLights::Light), (void*) (4 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+	glVertexAttribDivisor(1, 1);
+	glVertexAttribDivisor(2, 1);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void DeferredRenderer::SetRenderSize(int renderWidth, int renderHeight) {
+	DeferredRenderer::renderWidth = renderWidth;
+	DeferredRenderer::renderHeight = renderHeight;
+}
+
+void DeferredRenderer::BeginGeometryPass() {
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void DeferredRenderer::EndGeometryPass() {
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFramebuffer);
+	glBlitFramebuffer(0, 0, renderWidth, renderHeight, 0, 0, renderWidth, renderHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+}
+
+void DeferredRenderer::bindGBuffer(Shader& shader, const glm::mat4& viewProjection, const glm::vec3& cameraPosition) {
+	shader.Activate();
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, albedoTexture);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, normalTexture);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, depthTexture);
+	glActiveTexture(GL_TEXTURE0);
+
+	glUniform1i(glGetUniformLocation(shader.ID, "gAlbedoSpecular"), 0);
+	glUniform1i(glGetUniformLocation(shader.ID, "gNormalShininess"), 1);
+	glUniform1i(glGetUniformLocation(shader.ID, "gDepth"), 2);
+	glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+	glUniformMatrix4fv(glGetUniformLocation(shader.ID, "inverseViewProjection"), 1, GL_FALSE, glm::value_ptr(inverseViewProjection));
+	glUniform3fv(glGetUniformLocation(shader.ID, "viewPos"), 1, glm::value_ptr(cameraPosition));
+	// The output shares the G-buffer's pixel grid, so gl_FragCoord / texture size addresses the G-buffer.
+	// Only renderWidth x renderHeight of it is filled, that part is the NDC range of the camera.
+	glUniform2f(glGetUniformLocation(shader.ID, "screenSize"), (float) width, (float) height);
+	glUniform2f(glGetUniformLocation(shader.ID, "renderSize"), (float) renderWidth, (float) renderHeight);
+}
+
+void DeferredRenderer::LightingPass(const glm::mat4& viewProjection, const glm::vec3& cameraPosition) {
+	bindGBuffer(lightingProgram, viewProjection, cameraPosition);
+
+	// Pixels without geometry are discarded in the shader and keep the clear color
+	glDisable(GL_DEPTH_TEST);
+	glBindVertexArray(screenVAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+	glEnable(GL_DEPTH_TEST);
+}
+
+void DeferredRenderer::DrawPointLights(const std::vector<ClusteredLights::Light>& lights, const glm::mat4& viewProjection,
+									   const glm::vec3& cameraPosition, float linear, float quadratic) {
+	if (lights.empty())
+		return;
+
+	bindGBuffer(pointLightProgram, viewProjection, cameraPosition);
+	glUniformMatrix4fv(glGetUniformLocation(pointLightProgram.ID, "viewProjection"), 1, GL_FALSE, glm::value_ptr(viewProjection));
+	glUniform1f(glGetUniformLocation(pointLightProgram.ID, "pointLightLinear"), linear);
+	glUniform1f(glGetUniformLocation(pointLightProgram.ID, "pointLightQuadratic"), quadratic);
+
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, lights.size() * sizeof(ClusteredLights::Light), lights.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// Back faces with a greater-or-equal depth test: a pixel is lit when its surface is inside the
+	// sphere's depth range, which also works with the camera inside the sphere
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+	glEnable(GL_CULL_FACE);
+	glCullFace(GL_FRONT);
+	glDepthFunc(GL_GEQUAL);
+	glDepthMask(GL_FALSE);
+
+	glBindVertexArray(sphereVAO);
+	glDrawElementsInstanced(GL_TRIANGLES, sphereIndexCount, GL_UNSIGNED_INT, 0, (GLsizei) lights.size());
+	glBindVertexArray(0);
+
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+	glCullFace(GL_BACK);
+	glDisable(GL_CULL_FACE);
+	glDisable(GL_BLEND);
+}
+
+void DeferredRenderer::Delete() {
+	geometryProgram.Delete();
+	lightingProgram.Delete();
+	pointLightProgram.Delete();
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteTextures(1, &albedoTexture);
+	glDeleteTextures(1, &normalTexture);
+	glDeleteTextures(1, &depthTexture);
+	glDeleteVertexArrays(1, &screenVAO);
+	glDeleteVertexArrays(1, &sphereVAO);
+	glDeleteBuffers(1, &sphereVBO);
+	glDeleteBuffers(1, &sphereEBO);
+	glDeleteBuffers(1, &instanceVBO);
+}
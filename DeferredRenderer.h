@@ -0,0 +1,70 @@
+#ifndef DEFERRED_RENDERER_CLASS_H
+#define DEFERRED_RENDERER_CLASS_H
+
+#include<glad/glad.h>
+#include<glm/glm.hpp>
+#include<vector>
+
+#include"ClusteredLights.h"
+#include"shaderClass.h"
+
+// Deferred shading path. The geometry pass writes a compact G-buffer (8 bytes per pixel plus depth):
+//   albedoTexture  RGBA8     albedo, specular intensity
+//   normalTexture  RGB10_A2  octahedral normal, shininess / 256
+//   depthTexture   DEPTH24_STENCIL8
+// Lighting then runs once per pixel: directional and spot light in a full-screen pass,
+// point lights as instanced spheres that only cover the pixels in their range.
+class DeferredRenderer {
+public:
+	// Size of the G-buffer textures
+	int width;
+	int height;
+	// Region actually rendered (lower left), smaller than the textures under dynamic resolution
+	int renderWidth;
+	int renderHeight;
+	// Where EndGeometryPass copies the depth to and the lighting passes draw into
+	GLuint outputFramebuffer = 0;
+
+	GLuint framebuffer = 0;
+	GLuint albedoTexture = 0;
+	GLuint normalTexture = 0;
+	GLuint depthTexture = 0;
+
+	// default.vert + gbuffer.frag (with TEXTURE_HANDLES when textureTable uses them), draw the scene
+	// with it between Begin/EndGeometryPass
+	Shader geometryProgram;
+	// Full-screen pass for the directional and spot light, takes the same light uniforms as default.frag
+	Shader lightingProgram;
+	// Point light volumes
+	Shader pointLightProgram;
+
+	DeferredRenderer(int width, int height);
+
+	// Sets the rendered region for the next frames, at most width x height
+	void SetRenderSize(int renderWidth, int renderHeight);
+
+	// Binds and clears the G-buffer
+	void BeginGeometryPass();
+	// Copies the G-buffer depth into the output framebuffer and binds it
+	void EndGeometryPass();
+	// Lights every covered pixel with the directional and spot light (uniforms set by the caller)
+	void LightingPass(const glm::mat4& viewProjection, const glm::vec3& cameraPosition);
+	// Adds the point lights, each drawn as a sphere of its radius
+	void DrawPointLights(const std::vector<ClusteredLights::Light>& lights, const glm::mat4& viewProjection,
+						 const glm::vec3& cameraPosition, float linear, float quadratic);
+
+	void Delete();
+
+private:
+	// Empty VAO for the full-screen triangle (core profile needs one bound)
+	GLuint screenVAO = 0;
+	GLuint sphereVAO = 0;
+	GLuint sphereVBO = 0;
+	GLuint sphereEBO = 0;
+	GLuint instanceVBO = 0;
+	GLsizei sphereIndexCount = 0;
+
+	// Binds the G-buffer textures to units 0-2 and sets the uniforms shared by both lighting programs
+	void bindGBuffer(Shader& shader, const glm::mat4& viewProjection, const glm::vec3& cameraPosition);
+};
+#endif
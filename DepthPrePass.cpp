@@ -0,0 +1,94 @@
+#include"DepthPrePass.h"
+#include"GLExtensions.h"
+#include"ShaderVariants.h"
+#include"TextureTable.h"
+
+#include<glm/gtc/type_ptr.hpp>
+
+DepthPrePass::DepthPrePass()
+	: program("depth_prepass.vert", "depth_prepass.frag"),
+	  maskedProgram("depth_prepass.vert", "depth_prepass.frag",
+					ShaderVariants::Defines(SHADER_ALPHA_MASK | (textureTable.UsesHandles() ? (unsigned int) SHADER_TEXTURE_HANDLES : 0u))) {
+	if (glFeatures.pipelineStatistics)
+		glGenQueries(queryFrames * 2, &queries[0][0]);
+}
+
+void DepthPrePass::BeginPrePass(Camera& camera) {
+	if (glFeatures.pipelineStatistics) {
+		glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB, queries[frame][PrePassQuery]);
+		queryIssued[frame][PrePassQuery] = true;
+	}
+	prePassActive = true;
+
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthFunc(GL_LESS);
+	glDepthMask(GL_TRUE);
+
+	Shader* programs[] = {&maskedProgram, &program};
+	for (Shader* shader : programs) {
+		shader->Activate();
+		glUniformMatrix4fv(glGetUniformLocation(shader->ID, "view"), 1, GL_FALSE, glm::value_ptr(camera.GetViewMatrix()));
+		glUniformMatrix4fv(glGetUniformLocation(shader->ID, "projection"), 1, GL_FALSE, glm::value_ptr(camera.GetProjectionMatrix()));
+	}
+}
+
+Shader& DepthPrePass::ProgramFor(unsigned int shaderFeatures) {
+	return (shaderFeatures & SHADER_ALPHA_MASK) ? maskedProgram : program;
+}
+
+void DepthPrePass::EndPrePass() {
+	if (glFeatures.pipelineStatistics)
+		glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB);
+
+	// Only the nearest fragment of each pixel passes, the depth is already final
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glDepthFunc(GL_EQUAL);
+	glDepthMask(GL_FALSE);
+}
+
+void DepthPrePass::BeginColorPass() {
+	if (!prePassActive)
+		queryIssued[frame][PrePassQuery] = false;
+	if (glFeatures.pipelineStatistics) {
+		glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB, queries[frame][ColorPassQuery]);
+		queryIssued[frame][ColorPassQuery] = true;
+	}
+}
+
+void DepthPrePass::EndColorPass() {
+	if (glFeatures.pipelineStatistics)
+		glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS_ARB);
+	if (prePassActive) {
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_TRUE);
+		prePassActive = false;
+	}
+
+	// The next slot was last used queryFrames - 1 frames ago, read it before it is reused
+	frame = (frame + 1) % queryFrames;
+	readResults(frame);
+}
+
+void DepthPrePass::readResults(int readFrame) {
+	if (!glFeatures.pipelineStatistics || !queryIssued[readFrame][ColorPassQuery])
+		return;
+
+	GLuint available = 0;
+	glGetQueryObjectuiv(queries[readFrame][ColorPassQuery], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return;
+	glGetQueryObjectui64v(queries[readFrame][ColorPassQuery], GL_QUERY_RESULT, &colorPassInvocations);
+	// Queries finish in order, so the pre-pass of the same frame is done too
+	prePassInvocations = 0;
+	if (queryIssued[readFrame][PrePassQuery])
+		glGetQueryObjectui64v(queries[readFrame][PrePassQuery], GL_QUERY_RESULT, &prePassInvocations);
+	queryIssued[readFrame][PrePassQuery] = false;
+	queryIssued[readFrame][ColorPassQuery] = false;
+}
+
+void DepthPrePass::Delete() {
+	program.Delete();
+	maskedProgram.Delete();
+	if (glFeatures.pipelineStatistics)
+		glDeleteQueries(queryFrames * 2, &queries[0][0]);
+}
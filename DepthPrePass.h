@@ -0,0 +1,56 @@
+#ifndef DEPTH_PRE_PASS_CLASS_H
+#define DEPTH_PRE_PASS_CLASS_H
+
+#include<glad/glad.h>
+
+#include"Camera.h"
+#include"shaderClass.h"
+
+// Optional depth pre-pass for the forward path. The scene is first drawn from the meshes' position-only
+// streams (Mesh::depthVAO) without color writes, then the color pass draws it again with GL_EQUAL and
+// depth writes off, so default.frag runs at most once per pixel instead of once per overdrawn fragment.
+//
+// Meshes with alpha-tested materials (SHADER_ALPHA_MASK) are drawn with maskedProgram, which discards
+// like the color pass does; the discard would turn off early depth testing for everything else.
+//
+// With GL_ARB_pipeline_statistics_query the fragment shader invocations of both passes are counted.
+// The queries go through a small ring and are only read once available, so they never stall the frame.
+class DepthPrePass {
+public:
+	// depth_prepass.vert + depth_prepass.frag, and the same with ALPHA_MASK
+	Shader program;
+	Shader maskedProgram;
+
+	// Fragment shader invocations of the newest frame with results, 0 without pipeline statistics
+	GLuint64 prePassInvocations = 0;
+	GLuint64 colorPassInvocations = 0;
+
+	DepthPrePass();
+
+	// Program for a mesh with these shader features
+	Shader& ProgramFor(unsigned int shaderFeatures);
+
+	// Depth-only state, with the camera's view and projection set on both programs. Draw the scene
+	// with Model::DrawDepth / DrawDepthIndirect until EndPrePass.
+	void BeginPrePass(Camera& camera);
+	// Color writes back on, GL_EQUAL without depth writes for the color pass
+	void EndPrePass();
+	// Bracket the color pass (with or without a pre-pass) to count its fragment shader invocations.
+	// EndColorPass restores the usual GL_LESS depth test with depth writes.
+	void BeginColorPass();
+	void EndColorPass();
+
+	void Delete();
+
+private:
+	static const int queryFrames = 4;
+	enum { PrePassQuery, ColorPassQuery };
+	GLuint queries[queryFrames][2] = {};
+	bool queryIssued[queryFrames][2] = {};
+	int frame = 0;
+	bool prePassActive = false;
+
+	// Reads the results of the oldest frame in the ring if the GPU is done with it
+	void readResults(int readFrame);
+};
+#endif
@@ -0,0 +1,166 @@
+#include"DynamicResolution.h"
+#include"GLDebug.h"
+
+#include<algorithm>
+#include<cmath>
+#include<iostream>
+
+DynamicResolution::DynamicResolution(int width, int height) {
+	DynamicResolution::width = width;
+	DynamicResolution::height = height;
+	renderWidth = width;
+	renderHeight = height;
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+	// Linear filtering is what the upscale blit uses
+	glGenTextures(1, &colorTexture);
+	glBindTexture(GL_TEXTURE_2D, colorTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+
+	// Same format as the G-buffer and visibility buffer depth, so theirs can be blitted over
+	glGenTextures(1, &depthTexture);
+	glBindTexture(GL_TEXTURE_2D, depthTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+
+	glDebug.Label(GL_FRAMEBUFFER, framebuffer, "Dynamic resolution target");
+	glDebug.Label(GL_TEXTURE, colorTexture, "Dynamic resolution color");
+	glDebug.Label(GL_TEXTURE, depthTexture, "Dynamic resolution depth");
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "DynamicResolution: offscreen framebuffer is incomplete" << std::endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenQueries(queryFrames, queries);
+}
+
+void DynamicResolution::applyScale() {
+	float wanted = enabled ? std::min(std::max(scale, minScale), maxScale) : maxScale;
+	if (wanted != scale) {
+		scale = wanted;
+		samplesAtScale = 0;
+	}
+	renderWidth = std::max(1, (int) std::lround(width * scale));
+	renderHeight = std::max(1, (int) std::lround(height * scale));
+}
+
+void DynamicResolution::BeginFrame() {
+	// The next slot was last used queryFrames - 1 frames ago, read it before it is reused
+	frame = (frame + 1) % queryFrames;
+	readResult(frame);
+	applyScale();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, renderWidth, renderHeight);
+
+	glBeginQuery(GL_TIME_ELAPSED, queries[frame]);
+	queryIssued[frame] = true;
+	queryScale[frame] = scale;
+}
+
+void DynamicResolution::EndFrame() {
+	glEndQuery(GL_TIME_ELAPSED);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, presentFramebuffer);
+	glBlitFramebuffer(0, 0, renderWidth, renderHeight, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	glBindFramebuffer(GL_FRAMEBUFFER, presentFramebuffer);
+	glViewport(0, 0, width, height);
+}
+
+void DynamicResolution::readResult(int readFrame) {
+	if (!queryIssued[readFrame])
+		return;
+	queryIssued[readFrame] = false;
+
+	// Still running on the GPU: drop it rather than wait, the slot is reused now
+	GLuint available = 0;
+	glGetQueryObjectuiv(queries[readFrame], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+		return;
+	GLuint64 nanoseconds = 0;
+	glGetQueryObjectui64v(queries[readFrame], GL_QUERY_RESULT, &nanoseconds);
+
+	// Frames started before the last scale change do not say anything about the current one
+	if (queryScale[readFrame] == scale)
+		updateController(nanoseconds / 1.0e6);
+}
+
+void DynamicResolution::updateController(double milliseconds) {
+	// The first frame pays for shader compiles and uploads (and some drivers report nonsense for it)
+	if (state == Warmup) {
+		state = enabled ? Holding : Disabled;
+		return;
+	}
+	samplesAtScale++;
+	smoothedMilliseconds = samplesAtScale == 1 ? milliseconds : smoothedMilliseconds * 0.8 + milliseconds * 0.2;
+	if (!enabled) {
+		state = Disabled;
+		return;
+	}
+	if (state == Disabled)
+		state = Holding;
+	// A couple of results at the new size before judging it
+	if (samplesAtScale < 2)
+		return;
+
+	// Inside the band nothing changes, otherwise aim between the raise threshold and the target
+	if (smoothedMilliseconds <= targetMilliseconds && smoothedMilliseconds >= targetMilliseconds * raiseThreshold) {
+		state = Holding;
+		return;
+	}
+	double aim = targetMilliseconds * (1.0 + raiseThreshold) * 0.5;
+	float wanted = scale * (float) std::sqrt(aim / std::max(smoothedMilliseconds, 0.001));
+	wanted = std::min(std::max(wanted, scale - maxStep), scale + maxStep);
+	wanted = std::min(std::max(wanted, minScale), maxScale);
+	if (std::fabs(wanted - scale) < 0.01f) {
+		// Already at the limit
+		state = Holding;
+		return;
+	}
+
+	state = wanted < scale ? ScalingDown : ScalingUp;
+	scale = wanted;
+	samplesAtScale = 0;
+}
+
+DynamicResolution::Telemetry DynamicResolution::GetTelemetry() const {
+	Telemetry telemetry;
+	telemetry.scale = scale;
+	telemetry.renderWidth = renderWidth;
+	telemetry.renderHeight = renderHeight;
+	telemetry.gpuMilliseconds = smoothedMilliseconds;
+	telemetry.targetMilliseconds = targetMilliseconds;
+	telemetry.state = enabled ? state : Disabled;
+	return telemetry;
+}
+
+const char* DynamicResolution::StateName(State state) {
+	switch (state) {
+	case Disabled:
+		return "off";
+	case Warmup:
+		return "warming up";
+	case Holding:
+		return "holding";
+	case ScalingDown:
+		return "scaling down";
+	case ScalingUp:
+		return "scaling up";
+	}
+	return "";
+}
+
+void DynamicResolution::Delete() {
+	glDeleteQueries(queryFrames, queries);
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteTextures(1, &colorTexture);
+	glDeleteTextures(1, &depthTexture);
+}
@@ -0,0 +1,92 @@
+#ifndef DYNAMIC_RESOLUTION_CLASS_H
+#define DYNAMIC_RESOLUTION_CLASS_H
+
+#include<glad/glad.h>
+
+// Renders the frame offscreen at a variable internal resolution and scales it up to the window.
+// The offscreen framebuffer is allocated at the window size once; a frame at scale s only uses its
+// lower-left renderWidth x renderHeight region, so changing the scale never reallocates anything.
+//
+// Each frame's GPU time is measured with GL_TIME_ELAPSED queries in a small ring, read only once
+// available. A controller turns them into the scale of the next frames: GPU time is roughly
+// proportional to the pixel count, so the scale moves by sqrt(target / measured), limited per step,
+// and waits for results at the new size before it moves again.
+class DynamicResolution {
+public:
+	enum State {
+		// Scale held at maxScale, GPU time still measured
+		Disabled,
+		// No timer results yet
+		Warmup,
+		// GPU time within the band around the target
+		Holding,
+		ScalingDown,
+		ScalingUp
+	};
+	// Current state for the window title and telemetry
+	struct Telemetry {
+		float scale;
+		int renderWidth;
+		int renderHeight;
+		// Smoothed GPU time of the frames measured at the current scale
+		double gpuMilliseconds;
+		double targetMilliseconds;
+		State state;
+	};
+
+	// Window size, also the size of the offscreen buffers
+	int width;
+	int height;
+	// Size the frame is rendered at
+	int renderWidth;
+	int renderHeight;
+
+	GLuint framebuffer = 0;
+	GLuint colorTexture = 0;
+	GLuint depthTexture = 0;
+	// What EndFrame scales up into, the window's default framebuffer unless there is no window
+	GLuint presentFramebuffer = 0;
+
+	bool enabled = true;
+	float scale = 1.0f;
+	float minScale = 0.5f;
+	float maxScale = 1.0f;
+	// GPU time to hold, and the fraction of it below which the scale goes back up
+	double targetMilliseconds = 16.0;
+	double raiseThreshold = 0.8;
+	// Largest scale change per step
+	float maxStep = 0.1f;
+
+	DynamicResolution(int width, int height);
+
+	// Applies the newest timer results, then binds the offscreen framebuffer with a viewport of the
+	// current render size and starts timing the frame
+	void BeginFrame();
+	// Stops the timer and scales the rendered region up to presentFramebuffer (linear filter)
+	void EndFrame();
+
+	Telemetry GetTelemetry() const;
+	static const char* StateName(State state);
+
+	void Delete();
+
+private:
+	static const int queryFrames = 4;
+	GLuint queries[queryFrames] = {};
+	bool queryIssued[queryFrames] = {};
+	// Scale each query was measured at, results from before a change are ignored
+	float queryScale[queryFrames] = {};
+	int frame = 0;
+
+	State state = Warmup;
+	double smoothedMilliseconds = 0.0;
+	// Results at the current scale since it last changed
+	unsigned int samplesAtScale = 0;
+
+	// Reads the oldest query of the ring if the GPU is done with it
+	void readResult(int readFrame);
+	// Picks the next scale from a new GPU time
+	void updateController(double milliseconds);
+	void applyScale();
+};
+#endif
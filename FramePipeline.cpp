@@ -0,0 +1,137 @@
+#include"FramePipeline.h"
+
+#include<algorithm>
+#include<chrono>
+#include<climits>
+#include<cstring>
+
+#include"JobSystem.h"
+
+// Milliseconds elapsed since 'start'
+static double millisecondsSince(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void FramePipeline::Transform(const std::vector<Instance>& instances, const std::vector<unsigned int>& visibleInstances) {
+	auto start = std::chrono::high_resolution_clock::now();
+	FramePipeline::instances = &instances;
+
+	// Prefix sum of the mesh counts places every instance's meshes, then instances are transformed in parallel
+	firstBounds.assign(instances.size(), UINT_MAX);
+	unsigned int boundsCount = 0;
+	for (unsigned int index : visibleInstances) {
+		firstBounds[index] = boundsCount;
+		boundsCount += (unsigned int) instances[index].meshes->size();
+	}
+	culler.Resize(boundsCount);
+	boundsSource.resize(boundsCount);
+	worldMatrices.resize(boundsCount);
+
+	unsigned int instanceGrain = std::max(1u, grainSize / 8);
+	jobSystem.ParallelFor((unsigned int) visibleInstances.size(), instanceGrain, [&](unsigned int begin, unsigned int end) {
+		for (unsigned int i = begin; i < end; i++) {
+			unsigned int index = visibleInstances[i];
+			const Instance& instance = instances[index];
+			unsigned int first = firstBounds[index];
+			for (unsigned int mesh = 0; mesh < instance.meshes->size(); mesh++) {
+				const MeshSource& source = (*instance.meshes)[mesh];
+				worldMatrices[first + mesh] = instance.matrix * source.matrix;
+				boundsSource[first + mesh] = glm::uvec2(index, mesh);
+				culler.SetBounds(first + mesh, source.minBounds, source.maxBounds, worldMatrices[first + mesh]);
+			}
+		}
+	});
+	timings.transform = millisecondsSince(start);
+}
+
+void FramePipeline::Cull(const glm::vec3& cameraPosition, float projectionScale) {
+	auto start = std::chrono::high_resolution_clock::now();
+	unsigned int count = culler.Size();
+	culler.visible.resize(count);
+
+	// Each range counts into its own slot, summed afterwards
+	rangeCounts.assign((count + grainSize - 1) / grainSize, FrustumCuller::CullCounts());
+	jobSystem.ParallelFor(count, grainSize, [&](unsigned int begin, unsigned int end) {
+		culler.CullRange(begin, end, cameraPosition, projectionScale, rangeCounts[begin / grainSize]);
+	});
+
+	culler.visibleCount = 0;
+	culler.frustumCulledCount = 0;
+	culler.smallCulledCount = 0;
+	for (const FrustumCuller::CullCounts& counts : rangeCounts) {
+		culler.visibleCount += counts.visible;
+		culler.frustumCulledCount += counts.frustumCulled;
+		culler.smallCulledCount += counts.smallCulled;
+	}
+	timings.cull = millisecondsSince(start);
+}
+
+void FramePipeline::BuildDrawList(const glm::vec3& cameraPosition) {
+	auto start = std::chrono::high_resolution_clock::now();
+	unsigned int count = culler.Size();
+	unsigned int bucketCount = std::max(1u, (count + grainSize - 1) / grainSize);
+	// Never shrunk, so the buckets keep their memory from frame to frame
+	if (buckets.size() < bucketCount)
+		buckets.resize(bucketCount);
+	buckets[0].clear();
+
+	// Key, high to low: shader features (8 bits), model id (10) and mesh (14) so state changes are rare
+	// and instances of a mesh follow each other, then the distance (float bits, monotonic when positive)
+	// so each group is drawn front to back for early depth rejection
+	jobSystem.ParallelFor(count, grainSize, [&](unsigned int begin, unsigned int end) {
+		std::vector<DrawItem>& bucket = buckets[begin / grainSize];
+		bucket.clear();
+		for (unsigned int i = begin; i < end; i++) {
+			if (!culler.visible[i])
+				continue;
+			glm::uvec2 source = boundsSource[i];
+			const Instance& instance = (*instances)[source.x];
+			float distance = glm::length(glm::vec3(culler.centerX[i], culler.centerY[i], culler.centerZ[i]) - cameraPosition);
+			uint32_t depthBits;
+			std::memcpy(&depthBits, &distance, sizeof(depthBits));
+
+			uint64_t features = (*instance.meshes)[source.y].shaderFeatures & 0xFF;
+			uint64_t meshId = ((instance.modelId & 0x3FF) << 14) | (source.y & 0x3FFF);
+			DrawItem item;
+			item.key = (features << 56) | (meshId << 32) | depthBits;
+			item.instance = source.x;
+			item.mesh = source.y;
+			item.matrix = worldMatrices[i];
+			bucket.push_back(item);
+		}
+	});
+	timings.keys = millisecondsSince(start);
+
+	// Sort every bucket in its own job, then merge pairs of buckets until one is left
+	start = std::chrono::high_resolution_clock::now();
+	auto byKey = [](const DrawItem& a, const DrawItem& b) { return a.key < b.key; };
+	jobSystem.ParallelFor(bucketCount, 1, [&](unsigned int begin, unsigned int end) {
+		for (unsigned int i = begin; i < end; i++)
+			std::sort(buckets[i].begin(), buckets[i].end(), byKey);
+	});
+	unsigned int activeBuckets = bucketCount;
+	while (activeBuckets > 1) {
+		unsigned int pairCount = (activeBuckets + 1) / 2;
+		if (mergedBuckets.size() < pairCount)
+			mergedBuckets.resize(pairCount);
+		jobSystem.ParallelFor(pairCount, 1, [&](unsigned int begin, unsigned int end) {
+			for (unsigned int pair = begin; pair < end; pair++) {
+				std::vector<DrawItem>& merged = mergedBuckets[pair];
+				std::vector<DrawItem>& first = buckets[pair * 2];
+				if (pair * 2 + 1 == activeBuckets) {
+					merged.swap(first);
+					continue;
+				}
+				std::vector<DrawItem>& second = buckets[pair * 2 + 1];
+				merged.resize(first.size() + second.size());
+				std::merge(first.begin(), first.end(), second.begin(), second.end(), merged.begin(), byKey);
+			}
+		});
+		for (unsigned int pair = 0; pair < pairCount; pair++)
+			buckets[pair].swap(mergedBuckets[pair]);
+		activeBuckets = pairCount;
+	}
+	// Swapping keeps the old list's memory for the next frame's buckets
+	drawList.swap(buckets[0]);
+	timings.sort = millisecondsSince(start);
+}
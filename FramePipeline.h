@@ -0,0 +1,75 @@
+#ifndef FRAME_PIPELINE_CLASS_H
+#define FRAME_PIPELINE_CLASS_H
+
+#include<glm/glm.hpp>
+#include<cstdint>
+#include<vector>
+
+#include"FrustumCuller.h"
+
+// Builds the CPU draw list of a frame on the job system, once the camera matrix is up to date:
+//   Transform      world matrix and world bounds of every mesh of the instances left after the BVH query
+//   Cull           frustum and small-object test of those bounds, range by range
+//   (the caller can reject more here, e.g. portals and occlusion, by clearing entries of culler.visible)
+//   BuildDrawList  a 64-bit sort key per visible mesh (shader features, model and mesh, then front to
+//                  back), written to one bucket per job, then the buckets are sorted and merged pairwise
+// Each job only writes its own range or bucket and bucket sizes are combined afterwards, so nothing is locked.
+class FramePipeline {
+public:
+	// A mesh as the pipeline sees it, see Model::GetMeshSources
+	struct MeshSource {
+		glm::vec3 minBounds;
+		glm::vec3 maxBounds;
+		// Node transform of the mesh within its model
+		glm::mat4 matrix;
+		unsigned int shaderFeatures;
+	};
+	struct Instance {
+		const std::vector<MeshSource>* meshes;
+		glm::mat4 matrix;
+		// Instances with the same id (below 1024) share their meshes, so their draws are sorted together
+		unsigned int modelId;
+	};
+	struct DrawItem {
+		uint64_t key;
+		unsigned int instance;
+		unsigned int mesh;
+		// Instance matrix times the mesh's node matrix
+		glm::mat4 matrix;
+	};
+	// Milliseconds spent in each stage by the last frame
+	struct Timings {
+		double transform;
+		double cull;
+		double keys;
+		double sort;
+	};
+
+	// Bounds of the meshes of all instances passed to Transform, and their visibility after Cull
+	FrustumCuller culler;
+	// Per instance, index of its first mesh in 'culler', or UINT_MAX when it was not transformed
+	std::vector<unsigned int> firstBounds;
+	// Visible meshes in key order, the result of BuildDrawList
+	std::vector<DrawItem> drawList;
+	Timings timings = {0.0, 0.0, 0.0, 0.0};
+	// Bounds handled per job
+	unsigned int grainSize = 256;
+
+	// Computes the world matrices and bounds of the meshes of 'visibleInstances' (indices into 'instances')
+	void Transform(const std::vector<Instance>& instances, const std::vector<unsigned int>& visibleInstances);
+	// Frustum and small-object culling of the transformed meshes, statistics end up in 'culler'
+	void Cull(const glm::vec3& cameraPosition, float projectionScale);
+	// Fills 'drawList' with the meshes still visible in culler.visible
+	void BuildDrawList(const glm::vec3& cameraPosition);
+
+private:
+	const std::vector<Instance>* instances = nullptr;
+	// Per bounds in 'culler': instance, mesh within it, and world matrix
+	std::vector<glm::uvec2> boundsSource;
+	std::vector<glm::mat4> worldMatrices;
+	// One bucket per job, reused between frames
+	std::vector<std::vector<DrawItem>> buckets;
+	std::vector<std::vector<DrawItem>> mergedBuckets;
+	std::vector<FrustumCuller::CullCounts> rangeCounts;
+};
+#endif
@@ -0,0 +1,288 @@
+#include"FrustumCuller.h"
+
+#include<bitset>
+
+#if defined(__AVX__)
+#include<immintrin.h>
+#define FRUSTUM_CULLER_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include<emmintrin.h>
+#define FRUSTUM_CULLER_SSE
+#endif
+
+void FrustumCuller::ExtractPlanes(const glm::mat4& viewProjection) {
+	// Gribb/Hartmann: each plane is the last row plus or minus one of the other rows (glm is column-major)
+	glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+	planes[0] = row3 + row0; // Left
+	planes[1] = row3 - row0; // Right
+	planes[2] = row3 + row1; // Bottom
+	planes[3] = row3 - row1; // Top
+	planes[4] = row3 + row2; // Near
+	planes[5] = row3 - row2; // Far
+
+	// Normalize so plane distances are in world units
+	for (int i = 0; i < 6; i++) {
+		float length = glm::length(glm::vec3(planes[i]));
+		if (length > 0.0f)
+			planes[i] /= length;
+	}
+}
+
+void FrustumCuller::Clear() {
+	centerX.clear();
+	centerY.clear();
+	centerZ.clear();
+	extentX.clear();
+	extentY.clear();
+	extentZ.clear();
+	radius.clear();
+}
+
+unsigned int FrustumCuller::AddBounds(const glm::vec3& minBounds, const glm::vec3& maxBounds, const glm::mat4& transform) {
+	glm::vec3 worldMin, worldMax;
+	TransformAABB(minBounds, maxBounds, transform, worldMin, worldMax);
+	return AddWorldBounds(worldMin, worldMax);
+}
+
+unsigned int FrustumCuller::AddWorldBounds(const glm::vec3& minBounds, const glm::vec3& maxBounds) {
+	glm::vec3 center = (minBounds + maxBounds) * 0.5f;
+	glm::vec3 extent = (maxBounds - minBounds) * 0.5f;
+
+	centerX.push_back(center.x);
+	centerY.push_back(center.y);
+	centerZ.push_back(center.z);
+	extentX.push_back(extent.x);
+	extentY.push_back(extent.y);
+	extentZ.push_back(extent.z);
+	// Bounding sphere of the box, used for the projected size test
+	radius.push_back(glm::length(extent));
+
+	return (unsigned int) centerX.size() - 1;
+}
+
+void FrustumCuller::Resize(unsigned int count) {
+	centerX.resize(count);
+	centerY.resize(count);
+	centerZ.resize(count);
+	extentX.resize(count);
+	extentY.resize(count);
+	extentZ.resize(count);
+	radius.resize(count);
+}
+
+void FrustumCuller::SetBounds(unsigned int index, const glm::vec3& minBounds, const glm::vec3& maxBounds, const glm::mat4& transform) {
+	glm::vec3 worldMin, worldMax;
+	TransformAABB(minBounds, maxBounds, transform, worldMin, worldMax);
+	glm::vec3 center = (worldMin + worldMax) * 0.5f;
+	glm::vec3 extent = (worldMax - worldMin) * 0.5f;
+
+	centerX[index] = center.x;
+	centerY[index] = center.y;
+	centerZ[index] = center.z;
+	extentX[index] = extent.x;
+	extentY[index] = extent.y;
+	extentZ[index] = extent.z;
+	radius[index] = glm::length(extent);
+}
+
+void FrustumCuller::TransformAABB(const glm::vec3& minBounds, const glm::vec3& maxBounds, const glm::mat4& transform,
+								  glm::vec3& outMin, glm::vec3& outMax) {
+	// Arvo's method: transform the center, and project the extents onto each world axis
+	glm::vec3 center = (minBounds + maxBounds) * 0.5f;
+	glm::vec3 extent = (maxBounds - minBounds) * 0.5f;
+
+	glm::vec3 worldCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+	glm::vec3 worldExtent;
+	for (int i = 0; i < 3; i++) {
+		worldExtent[i] = glm::abs(transform[0][i]) * extent.x +
+			glm::abs(transform[1][i]) * extent.y +
+			glm::abs(transform[2][i]) * extent.z;
+	}
+
+	outMin = worldCenter - worldExtent;
+	outMax = worldCenter + worldExtent;
+}
+
+void FrustumCuller::Cull(const glm::vec3& cameraPosition, float projectionScale) {
+	visible.resize(Size());
+	CullCounts counts;
+	CullRange(0, Size(), cameraPosition, projectionScale, counts);
+	visibleCount = counts.visible;
+	frustumCulledCount = counts.frustumCulled;
+	smallCulledCount = counts.smallCulled;
+}
+
+void FrustumCuller::CullRange(unsigned int begin, unsigned int end, const glm::vec3& cameraPosition, float projectionScale,
+							  CullCounts& counts) {
+	// Objects are too small when (2r * projectionScale / distance) < minProjectedSize.
+	// Squared and rearranged to avoid the square root: r^2 * smallFactor < distance^2
+	bool testSmall = minProjectedSize > 0.0f;
+	float smallFactor = testSmall ? 4.0f * projectionScale * projectionScale / (minProjectedSize * minProjectedSize) : 0.0f;
+
+	unsigned int i = begin;
+
+#if defined(FRUSTUM_CULLER_AVX)
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+	__m256 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+	for (int p = 0; p < 6; p++) {
+		planeX[p] = _mm256_set1_ps(planes[p].x);
+		planeY[p] = _mm256_set1_ps(planes[p].y);
+		planeZ[p] = _mm256_set1_ps(planes[p].z);
+		planeW[p] = _mm256_set1_ps(planes[p].w);
+		absX[p] = _mm256_andnot_ps(signMask, planeX[p]);
+		absY[p] = _mm256_andnot_ps(signMask, planeY[p]);
+		absZ[p] = _mm256_andnot_ps(signMask, planeZ[p]);
+	}
+	const __m256 camX = _mm256_set1_ps(cameraPosition.x);
+	const __m256 camY = _mm256_set1_ps(cameraPosition.y);
+	const __m256 camZ = _mm256_set1_ps(cameraPosition.z);
+	const __m256 smallK = _mm256_set1_ps(smallFactor);
+	const __m256 zero = _mm256_setzero_ps();
+
+	for (; i + 8 <= end; i += 8) {
+		__m256 cx = _mm256_loadu_ps(&centerX[i]);
+		__m256 cy = _mm256_loadu_ps(&centerY[i]);
+		__m256 cz = _mm256_loadu_ps(&centerZ[i]);
+		__m256 ex = _mm256_loadu_ps(&extentX[i]);
+		__m256 ey = _mm256_loadu_ps(&extentY[i]);
+		__m256 ez = _mm256_loadu_ps(&extentZ[i]);
+
+		// A box is outside when (distance to plane + projected extent) < 0 for any plane
+		__m256 outside = zero;
+		for (int p = 0; p < 6; p++) {
+			__m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planeX[p], cx), _mm256_mul_ps(planeY[p], cy)),
+									 _mm256_add_ps(_mm256_mul_ps(planeZ[p], cz), planeW[p]));
+			__m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absX[p], ex), _mm256_mul_ps(absY[p], ey)),
+									 _mm256_mul_ps(absZ[p], ez));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(d, r), zero, _CMP_LT_OQ));
+		}
+		int outsideMask = _mm256_movemask_ps(outside);
+
+		int smallMask = 0;
+		if (testSmall) {
+			__m256 dx = _mm256_sub_ps(cx, camX);
+			__m256 dy = _mm256_sub_ps(cy, camY);
+			__m256 dz = _mm256_sub_ps(cz, camZ);
+			__m256 dist2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+			__m256 r = _mm256_loadu_ps(&radius[i]);
+			__m256 size2 = _mm256_mul_ps(_mm256_mul_ps(r, r), smallK);
+			smallMask = _mm256_movemask_ps(_mm256_cmp_ps(size2, dist2, _CMP_LT_OQ)) & ~outsideMask;
+		}
+
+		int visibleMask = ~(outsideMask | smallMask) & 0xFF;
+		for (int lane = 0; lane < 8; lane++)
+			visible[i + lane] = (unsigned char) ((visibleMask >> lane) & 1);
+
+		counts.visible += (unsigned int) std::bitset<8>(visibleMask).count();
+		counts.frustumCulled += (unsigned int) std::bitset<8>(outsideMask).count();
+		counts.smallCulled += (unsigned int) std::bitset<8>(smallMask).count();
+	}
+#elif defined(FRUSTUM_CULLER_SSE)
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	__m128 planeX[6], planeY[6], planeZ[6], planeW[6], absX[6], absY[6], absZ[6];
+	for (int p = 0; p < 6; p++) {
+		planeX[p] = _mm_set1_ps(planes[p].x);
+		planeY[p] = _mm_set1_ps(planes[p].y);
+		planeZ[p] = _mm_set1_ps(planes[p].z);
+		planeW[p] = _mm_set1_ps(planes[p].w);
+		absX[p] = _mm_andnot_ps(signMask, planeX[p]);
+		absY[p] = _mm_andnot_ps(signMask, planeY[p]);
+		absZ[p] = _mm_andnot_ps(signMask, planeZ[p]);
+	}
+	const __m128 camX = _mm_set1_ps(cameraPosition.x);
+	const __m128 camY = _mm_set1_ps(cameraPosition.y);
+	const __m128 camZ = _mm_set1_ps(cameraPosition.z);
+	const __m128 smallK = _mm_set1_ps(smallFactor);
+	const __m128 zero = _mm_setzero_ps();
+
+	for (; i + 4 <= end; i += 4) {
+		__m128 cx = _mm_loadu_ps(&centerX[i]);
+		__m128 cy = _mm_loadu_ps(&centerY[i]);
+		__m128 cz = _mm_loadu_ps(&centerZ[i]);
+		__m128 ex = _mm_loadu_ps(&extentX[i]);
+		__m128 ey = _mm_loadu_ps(&extentY[i]);
+		__m128 ez = _mm_loadu_ps(&extentZ[i]);
+
+		// A box is outside when (distance to plane + projected extent) < 0 for any plane
+		__m128 outside = zero;
+		for (int p = 0; p < 6; p++) {
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], cx), _mm_mul_ps(planeY[p], cy)),
+								  _mm_add_ps(_mm_mul_ps(planeZ[p], cz), planeW[p]));
+			__m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absX[p], ex), _mm_mul_ps(absY[p], ey)),
+								  _mm_mul_ps(absZ[p], ez));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), zero));
+		}
+		int outsideMask = _mm_movemask_ps(outside);
+
+		int smallMask = 0;
+		if (testSmall) {
+			__m128 dx = _mm_sub_ps(cx, camX);
+			__m128 dy = _mm_sub_ps(cy, camY);
+			__m128 dz = _mm_sub_ps(cz, camZ);
+			__m128 dist2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+			__m128 r = _mm_loadu_ps(&radius[i]);
+			__m128 size2 = _mm_mul_ps(_mm_mul_ps(r, r), smallK);
+			smallMask = _mm_movemask_ps(_mm_cmplt_ps(size2, dist2)) & ~outsideMask;
+		}
+
+		int visibleMask = ~(outsideMask | smallMask) & 0xF;
+		for (int lane = 0; lane < 4; lane++)
+			visible[i + lane] = (unsigned char) ((visibleMask >> lane) & 1);
+
+		counts.visible += (unsigned int) std::bitset<4>(visibleMask).count();
+		counts.frustumCulled += (unsigned int) std::bitset<4>(outsideMask).count();
+		counts.smallCulled += (unsigned int) std::bitset<4>(smallMask).count();
+	}
+#endif
+
+	// Whatever did not fill a full SIMD register (or everything, without SIMD support)
+	cullRange(i, end, cameraPosition, projectionScale, counts);
+}
+
+void FrustumCuller::CullScalar(const glm::vec3& cameraPosition, float projectionScale) {
+	visible.resize(Size());
+	CullCounts counts;
+	cullRange(0, Size(), cameraPosition, projectionScale, counts);
+	visibleCount = counts.visible;
+	frustumCulledCount = counts.frustumCulled;
+	smallCulledCount = counts.smallCulled;
+}
+
+void FrustumCuller::cullRange(unsigned int begin, unsigned int end, const glm::vec3& cameraPosition, float projectionScale,
+							  CullCounts& counts) {
+	bool testSmall = minProjectedSize > 0.0f;
+	float smallFactor = testSmall ? 4.0f * projectionScale * projectionScale / (minProjectedSize * minProjectedSize) : 0.0f;
+
+	for (unsigned int i = begin; i < end; i++) {
+		bool outside = false;
+		for (int p = 0; p < 6 && !outside; p++) {
+			float d = planes[p].x * centerX[i] + planes[p].y * centerY[i] + planes[p].z * centerZ[i] + planes[p].w;
+			float r = glm::abs(planes[p].x) * extentX[i] + glm::abs(planes[p].y) * extentY[i] + glm::abs(planes[p].z) * extentZ[i];
+			outside = d + r < 0.0f;
+		}
+		if (outside) {
+			visible[i] = 0;
+			counts.frustumCulled++;
+			continue;
+		}
+
+		if (testSmall) {
+			float dx = centerX[i] - cameraPosition.x;
+			float dy = centerY[i] - cameraPosition.y;
+			float dz = centerZ[i] - cameraPosition.z;
+			float dist2 = dx * dx + dy * dy + dz * dz;
+			if (radius[i] * radius[i] * smallFactor < dist2) {
+				visible[i] = 0;
+				counts.smallCulled++;
+				continue;
+			}
+		}
+
+		visible[i] = 1;
+		counts.visible++;
+	}
+}
@@ -0,0 +1,74 @@
+#ifndef FRUSTUM_CULLER_CLASS_H
+#define FRUSTUM_CULLER_CLASS_H
+
+#include<glm/glm.hpp>
+#include<vector>
+
+class FrustumCuller {
+public:
+	// Results of culling a range of bounds
+	struct CullCounts {
+		unsigned int visible = 0;
+		unsigned int frustumCulled = 0;
+		unsigned int smallCulled = 0;
+	};
+
+	// World-space bounds stored as structure-of-arrays so SSE/AVX can test 4 or 8 boxes at once
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> extentX;
+	std::vector<float> extentY;
+	std::vector<float> extentZ;
+	std::vector<float> radius;
+
+	// Result of the last Cull call, one entry per bounds (1 = visible)
+	std::vector<unsigned char> visible;
+
+	// Frustum planes as (normal, distance) with normals pointing into the frustum
+	glm::vec4 planes[6];
+
+	// Objects whose projected diameter is below this many pixels are rejected (0 disables the test)
+	float minProjectedSize = 0.0f;
+
+	// Statistics of the last Cull call
+	unsigned int visibleCount = 0;
+	unsigned int frustumCulledCount = 0;
+	unsigned int smallCulledCount = 0;
+
+	// Extracts the six frustum planes from a projection * view matrix (e.g. Camera::cameraMatrix)
+	void ExtractPlanes(const glm::mat4& viewProjection);
+
+	// Removes all bounds
+	void Clear();
+	// Adds a local-space AABB transformed by 'transform' and returns its index
+	unsigned int AddBounds(const glm::vec3& minBounds, const glm::vec3& maxBounds, const glm::mat4& transform);
+	// Adds an AABB that is already in world space and returns its index
+	unsigned int AddWorldBounds(const glm::vec3& minBounds, const glm::vec3& maxBounds);
+	// Sets the number of bounds, so SetBounds can fill them from several threads
+	void Resize(unsigned int count);
+	// Replaces bounds 'index' with a local-space AABB transformed by 'transform'
+	void SetBounds(unsigned int index, const glm::vec3& minBounds, const glm::vec3& maxBounds, const glm::mat4& transform);
+	// Number of bounds currently stored
+	unsigned int Size() const {
+		return (unsigned int) centerX.size();
+	}
+
+	// Tests every bounds against the frustum and the small object threshold, filling 'visible'.
+	// projectionScale is (viewport height / 2) / tan(fov / 2), which converts size/distance into pixels.
+	void Cull(const glm::vec3& cameraPosition, float projectionScale);
+	// Reference implementation without SIMD, used by the benchmark to validate the vector paths
+	void CullScalar(const glm::vec3& cameraPosition, float projectionScale);
+	// Tests bounds [begin, end) into 'visible' (sized to Size() beforehand) and adds to 'counts' instead of
+	// the statistics above, so disjoint ranges can be culled in parallel
+	void CullRange(unsigned int begin, unsigned int end, const glm::vec3& cameraPosition, float projectionScale, CullCounts& counts);
+
+	// Transforms a local AABB into a world AABB that encloses it
+	static void TransformAABB(const glm::vec3& minBounds, const glm::vec3& maxBounds, const glm::mat4& transform,
+							  glm::vec3& outMin, glm::vec3& outMax);
+
+private:
+	// Tests bounds [begin, end) one at a time, used for the tail left over by the SIMD loops
+	void cullRange(unsigned int begin, unsigned int end, const glm::vec3& cameraPosition, float projectionScale, CullCounts& counts);
+};
+#endif
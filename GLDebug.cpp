@@ -0,0 +1,200 @@
+#include"GLDebug.h"
+
+#include<algorithm>
+#include<cstdio>
+#include<cstring>
+#include<iostream>
+#include<vector>
+
+GLDebug glDebug;
+
+static const char* sourceName(GLenum source) {
+	switch (source) {
+	case GL_DEBUG_SOURCE_API: return "API";
+	case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "window system";
+	case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+	case GL_DEBUG_SOURCE_THIRD_PARTY: return "third party";
+	case GL_DEBUG_SOURCE_APPLICATION: return "application";
+	default: return "other";
+	}
+}
+
+static const char* typeName(GLenum type) {
+	switch (type) {
+	case GL_DEBUG_TYPE_ERROR: return "error";
+	case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+	case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined behavior";
+	case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+	case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+	case GL_DEBUG_TYPE_MARKER: return "marker";
+	default: return "other";
+	}
+}
+
+static const char* severityName(GLenum severity) {
+	switch (severity) {
+	case GL_DEBUG_SEVERITY_HIGH: return "high";
+	case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+	case GL_DEBUG_SEVERITY_LOW: return "low";
+	default: return "notification";
+	}
+}
+
+// FNV-1a over the fields that make two messages the same
+static unsigned long long messageKey(const GLDebug::Message& message) {
+	unsigned long long hash = 14695981039346656037ull;
+	auto mix = [&hash](const void* bytes, size_t size) {
+		for (size_t i = 0; i < size; i++) {
+			hash ^= ((const unsigned char*) bytes)[i];
+			hash *= 1099511628211ull;
+		}
+	};
+	mix(&message.source, sizeof(message.source));
+	mix(&message.type, sizeof(message.type));
+	mix(&message.id, sizeof(message.id));
+	mix(message.text, strlen(message.text));
+	return hash;
+}
+
+static void printMessage(const GLDebug::Message& message, unsigned long long count) {
+	if (count > 1)
+		printf("GL %s %s (%s, id %u, %llu times): %s\n", severityName(message.severity), typeName(message.type),
+			sourceName(message.source), message.id, count, message.text);
+	else
+		printf("GL %s %s (%s, id %u): %s\n", severityName(message.severity), typeName(message.type),
+			sourceName(message.source), message.id, message.text);
+}
+
+GLDebug::GLDebug() {
+	for (unsigned int i = 0; i < ringSize; i++)
+		ring[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool GLDebug::Start(bool synchronous) {
+	groups = glFeatures.debugOutput;
+	if (!glFeatures.debugOutput)
+		return false;
+
+	// Everything off, then the wanted severities back on (our own group pushes are notifications)
+	glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, NULL, GL_FALSE);
+	const GLenum severities[] = {GL_DEBUG_SEVERITY_HIGH, GL_DEBUG_SEVERITY_MEDIUM, GL_DEBUG_SEVERITY_LOW, GL_DEBUG_SEVERITY_NOTIFICATION};
+	for (GLenum severity : severities) {
+		glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, severity, 0, NULL, GL_TRUE);
+		if (severity == minimumSeverity)
+			break;
+	}
+	glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_PUSH_GROUP, GL_DONT_CARE, 0, NULL, GL_FALSE);
+	glDebugMessageControl(GL_DONT_CARE, GL_DEBUG_TYPE_POP_GROUP, GL_DONT_CARE, 0, NULL, GL_FALSE);
+
+	glDebugMessageCallback(callback, this);
+	glEnable(GL_DEBUG_OUTPUT);
+	if (synchronous)
+		glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	else
+		glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	active = true;
+
+	GLint flags = 0;
+	glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+	std::cout << "GL debug output: " << (flags & GL_CONTEXT_FLAG_DEBUG_BIT ? "debug context" : "non-debug context")
+		<< ", " << (synchronous ? "synchronous" : "asynchronous") << ", down to " << severityName(minimumSeverity) << " severity" << std::endl;
+	return true;
+}
+
+void GLDebug::Ignore(GLenum source, GLenum type, GLuint id) {
+	if (active)
+		glDebugMessageControl(source, type, GL_DONT_CARE, 1, &id, GL_FALSE);
+}
+
+void APIENTRY GLDebug::callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+								const GLchar* message, const void* userParam) {
+	((GLDebug*) userParam)->push(source, type, id, severity, length, message);
+}
+
+void GLDebug::push(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* text) {
+	// Bounded multi-producer queue: claim a slot whose sequence says it was read, fill it, publish it
+	unsigned int position = writeIndex.load(std::memory_order_relaxed);
+	Slot* slot;
+	for (;;) {
+		slot = &ring[position & (ringSize - 1)];
+		int difference = (int) (slot->sequence.load(std::memory_order_acquire) - position);
+		if (difference == 0) {
+			if (writeIndex.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				break;
+		} else if (difference < 0) {
+			// Full: Drain has not caught up, rather lose the message than block the driver
+			droppedMessages.fetch_add(1, std::memory_order_relaxed);
+			return;
+		} else {
+			position = writeIndex.load(std::memory_order_relaxed);
+		}
+	}
+
+	Message& message = slot->message;
+	message.source = source;
+	message.type = type;
+	message.id = id;
+	message.severity = severity;
+	size_t size = length >= 0 ? (size_t) length : strlen(text);
+	size = std::min(size, (size_t) maxMessageLength - 1);
+	memcpy(message.text, text, size);
+	message.text[size] = 0;
+	// Drivers tend to end messages with a newline
+	while (size > 0 && (message.text[size - 1] == '\n' || message.text[size - 1] == '\r'))
+		message.text[--size] = 0;
+	slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+void GLDebug::Drain() {
+	for (;;) {
+		Slot& slot = ring[readIndex & (ringSize - 1)];
+		if (slot.sequence.load(std::memory_order_acquire) != readIndex + 1)
+			break;
+		Message message = slot.message;
+		slot.sequence.store(readIndex + ringSize, std::memory_order_release);
+		readIndex++;
+
+		Seen& entry = seen[messageKey(message)];
+		if (entry.count == 0)
+			entry.message = message;
+		entry.count++;
+		// First time, then at 10, 100, 1000... repeats
+		unsigned long long count = entry.count;
+		while (count % 10 == 0)
+			count /= 10;
+		if (count == 1)
+			printMessage(message, entry.count);
+	}
+}
+
+void GLDebug::PrintSummary() const {
+	std::vector<const Seen*> repeated;
+	for (const auto& entry : seen) {
+		if (entry.second.count > 1)
+			repeated.push_back(&entry.second);
+	}
+	std::sort(repeated.begin(), repeated.end(), [](const Seen* a, const Seen* b) {
+		return a->count > b->count;
+	});
+	if (!repeated.empty())
+		std::cout << "GL debug output: " << seen.size() << " distinct messages, repeated ones:" << std::endl;
+	for (const Seen* entry : repeated)
+		printMessage(entry->message, entry->count);
+	unsigned int dropped = droppedMessages.load(std::memory_order_relaxed);
+	if (dropped > 0)
+		std::cout << "GL debug output: " << dropped << " messages dropped, the ring was full" << std::endl;
+}
+
+void GLDebug::Label(GLenum identifier, GLuint name, const std::string& label) {
+	// GL_MAX_LABEL_LENGTH is at least 256
+	if (groups && name != 0)
+		glObjectLabel(identifier, name, (GLsizei) std::min(label.size(), (size_t) 255), label.c_str());
+}
+
+void GLDebug::CheckErrors(const char* operation) {
+	if (active)
+		return;
+	GLenum error;
+	while ((error = glGetError()) != GL_NO_ERROR)
+		std::cout << "OpenGL error " << error << " during " << operation << std::endl;
+}
@@ -0,0 +1,121 @@
+#ifndef GL_DEBUG_CLASS_H
+#define GL_DEBUG_CLASS_H
+
+#include<glad/glad.h>
+#include<atomic>
+#include<string>
+#include<unordered_map>
+
+#include"GLExtensions.h"
+
+// Driver diagnostics through KHR_debug (core in GL 4.3) instead of glGetError polling, which can
+// make the driver synchronize with its worker thread on every call.
+//
+// The driver reports errors, performance warnings and the like through a callback, which may run on
+// any of its threads. The callback only copies the message into a lock-free ring; Drain, called once a
+// frame by the update thread, prints what came in. Each distinct message (source, type, id and text)
+// is printed the first time and then again at 10, 100, 1000... repeats, so a message sent every draw
+// does not flood the log. Messages below minimumSeverity are filtered by the driver itself.
+//
+// PushGroup/PopGroup (used by PROFILE_GPU_ZONE) and Label name passes and objects in GPU captures.
+// All of it does nothing when the context lacks KHR_debug.
+class GLDebug {
+public:
+	// Messages that fit between two Drain calls, a power of two
+	static const unsigned int ringSize = 256;
+	static const unsigned int maxMessageLength = 256;
+
+	struct Message {
+		GLenum source;
+		GLenum type;
+		GLuint id;
+		GLenum severity;
+		char text[maxMessageLength];
+	};
+
+	// GL_DEBUG_SEVERITY_HIGH, _MEDIUM, _LOW or _NOTIFICATION, set before Start
+	GLenum minimumSeverity = GL_DEBUG_SEVERITY_LOW;
+
+	GLDebug();
+
+	// Enables debug output on the current context. With 'synchronous' the callback runs inside the
+	// GL call that caused the message, so a breakpoint in it shows the culprit (and costs speed).
+	// Returns false when the context has no KHR_debug.
+	bool Start(bool synchronous);
+	bool Active() const {
+		return active;
+	}
+	// Stops the driver from sending a message, e.g. known chatter. Needs the context.
+	void Ignore(GLenum source, GLenum type, GLuint id);
+
+	// Prints the messages received since the last call. Only ever call it from one thread, it
+	// needs no GL context.
+	void Drain();
+	// Messages that repeated, with their total counts, and how many were lost to a full ring
+	void PrintSummary() const;
+
+	// Debug groups and object labels, on the thread owning the context
+	void PushGroup(const char* name) {
+		if (groups)
+			glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+	}
+	void PopGroup() {
+		if (groups)
+			glPopDebugGroup();
+	}
+	// 'identifier' is the object's namespace: GL_BUFFER, GL_TEXTURE, GL_PROGRAM, GL_VERTEX_ARRAY, GL_FRAMEBUFFER...
+	void Label(GLenum identifier, GLuint name, const std::string& label);
+
+	// glGetError loop for contexts without debug output, see GL_CHECK_ERRORS
+	void CheckErrors(const char* operation);
+
+private:
+	struct Slot {
+		// Written index + 1 once the message is complete, index + ringSize once it was read
+		std::atomic<unsigned int> sequence;
+		Message message;
+	};
+	struct Seen {
+		unsigned long long count;
+		Message message;
+	};
+
+	Slot ring[ringSize];
+	std::atomic<unsigned int> writeIndex{0};
+	unsigned int readIndex = 0;
+	std::atomic<unsigned int> droppedMessages{0};
+	// Keyed by a hash of the message, consumer side only
+	std::unordered_map<unsigned long long, Seen> seen;
+	bool active = false;
+	// Groups and labels work without debug output being enabled
+	bool groups = false;
+
+	static void APIENTRY callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length,
+								  const GLchar* message, const void* userParam);
+	void push(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* text);
+};
+
+// Engine-wide debug output of the main context
+extern GLDebug glDebug;
+
+// Scoped debug group, see PROFILE_GPU_ZONE
+class GLDebugGroup {
+public:
+	explicit GLDebugGroup(const char* name) {
+		glDebug.PushGroup(name);
+	}
+	~GLDebugGroup() {
+		glDebug.PopGroup();
+	}
+	GLDebugGroup(const GLDebugGroup&) = delete;
+	GLDebugGroup& operator=(const GLDebugGroup&) = delete;
+};
+
+// Error check after GL calls that are worth checking. Debug builds fall back to glGetError when the
+// context has no debug output; release builds never call glGetError from here.
+#if defined(NDEBUG)
+#define GL_CHECK_ERRORS(operation) ((void) 0)
+#else
+#define GL_CHECK_ERRORS(operation) glDebug.CheckErrors(operation)
+#endif
+#endif
@@ -0,0 +1,100 @@
+#include"GLExtensions.h"
+
+#include<cstring>
+#include<iostream>
+
+PFNGLEXTDISPATCHCOMPUTEPROC glext_glDispatchCompute = NULL;
+PFNGLEXTMEMORYBARRIERPROC glext_glMemoryBarrier = NULL;
+PFNGLEXTBINDIMAGETEXTUREPROC glext_glBindImageTexture = NULL;
+PFNGLEXTDRAWELEMENTSINDIRECTPROC glext_glDrawElementsIndirect = NULL;
+PFNGLEXTGETPROGRAMBINARYPROC glext_glGetProgramBinary = NULL;
+PFNGLEXTPROGRAMBINARYPROC glext_glProgramBinary = NULL;
+PFNGLEXTPROGRAMPARAMETERIPROC glext_glProgramParameteri = NULL;
+PFNGLEXTMAXSHADERCOMPILERTHREADSPROC glext_glMaxShaderCompilerThreads = NULL;
+PFNGLEXTBUFFERSTORAGEPROC glext_glBufferStorage = NULL;
+PFNGLEXTDEBUGMESSAGECALLBACKPROC glext_glDebugMessageCallback = NULL;
+PFNGLEXTDEBUGMESSAGECONTROLPROC glext_glDebugMessageControl = NULL;
+PFNGLEXTPUSHDEBUGGROUPPROC glext_glPushDebugGroup = NULL;
+PFNGLEXTPOPDEBUGGROUPPROC glext_glPopDebugGroup = NULL;
+PFNGLEXTOBJECTLABELPROC glext_glObjectLabel = NULL;
+PFNGLEXTGETTEXTUREHANDLEPROC glext_glGetTextureHandleARB = NULL;
+PFNGLEXTMAKETEXTUREHANDLERESIDENTPROC glext_glMakeTextureHandleResidentARB = NULL;
+PFNGLEXTMAKETEXTUREHANDLENONRESIDENTPROC glext_glMakeTextureHandleNonResidentARB = NULL;
+
+GLFeatures glFeatures;
+
+bool HasGLVersion(int major, int minor) {
+	return glFeatures.majorVersion > major || (glFeatures.majorVersion == major && glFeatures.minorVersion >= minor);
+}
+
+bool HasGLExtension(const char* name) {
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; i++) {
+		const char* extension = (const char*) glGetStringi(GL_EXTENSIONS, i);
+		if (extension != NULL && std::strcmp(extension, name) == 0)
+			return true;
+	}
+	return false;
+}
+
+void LoadGLExtensions(GLADloadproc load) {
+	glGetIntegerv(GL_MAJOR_VERSION, &glFeatures.majorVersion);
+	glGetIntegerv(GL_MINOR_VERSION, &glFeatures.minorVersion);
+
+	glext_glDispatchCompute = (PFNGLEXTDISPATCHCOMPUTEPROC) load("glDispatchCompute");
+	glext_glMemoryBarrier = (PFNGLEXTMEMORYBARRIERPROC) load("glMemoryBarrier");
+	glext_glBindImageTexture = (PFNGLEXTBINDIMAGETEXTUREPROC) load("glBindImageTexture");
+	glext_glDrawElementsIndirect = (PFNGLEXTDRAWELEMENTSINDIRECTPROC) load("glDrawElementsIndirect");
+	glext_glGetProgramBinary = (PFNGLEXTGETPROGRAMBINARYPROC) load("glGetProgramBinary");
+	glext_glProgramBinary = (PFNGLEXTPROGRAMBINARYPROC) load("glProgramBinary");
+	glext_glProgramParameteri = (PFNGLEXTPROGRAMPARAMETERIPROC) load("glProgramParameteri");
+	glext_glBufferStorage = (PFNGLEXTBUFFERSTORAGEPROC) load("glBufferStorage");
+	glext_glDebugMessageCallback = (PFNGLEXTDEBUGMESSAGECALLBACKPROC) load("glDebugMessageCallback");
+	glext_glDebugMessageControl = (PFNGLEXTDEBUGMESSAGECONTROLPROC) load("glDebugMessageControl");
+	glext_glPushDebugGroup = (PFNGLEXTPUSHDEBUGGROUPPROC) load("glPushDebugGroup");
+	glext_glPopDebugGroup = (PFNGLEXTPOPDEBUGGROUPPROC) load("glPopDebugGroup");
+	glext_glObjectLabel = (PFNGLEXTOBJECTLABELPROC) load("glObjectLabel");
+	glext_glGetTextureHandleARB = (PFNGLEXTGETTEXTUREHANDLEPROC) load("glGetTextureHandleARB");
+	glext_glMakeTextureHandleResidentARB = (PFNGLEXTMAKETEXTUREHANDLERESIDENTPROC) load("glMakeTextureHandleResidentARB");
+	glext_glMakeTextureHandleNonResidentARB = (PFNGLEXTMAKETEXTUREHANDLENONRESIDENTPROC) load("glMakeTextureHandleNonResidentARB");
+	bool parallelKHR = HasGLExtension("GL_KHR_parallel_shader_compile");
+	bool parallelARB = HasGLExtension("GL_ARB_parallel_shader_compile");
+	if (parallelKHR)
+		glext_glMaxShaderCompilerThreads = (PFNGLEXTMAXSHADERCOMPILERTHREADSPROC) load("glMaxShaderCompilerThreadsKHR");
+	else if (parallelARB)
+		glext_glMaxShaderCompilerThreads = (PFNGLEXTMAXSHADERCOMPILERTHREADSPROC) load("glMaxShaderCompilerThreadsARB");
+
+	// A non-NULL pointer alone is not enough, some loaders return stubs for unsupported functions
+	glFeatures.computeShaders = (HasGLVersion(4, 3) ||
+		(HasGLExtension("GL_ARB_compute_shader") && HasGLExtension("GL_ARB_shader_storage_buffer_object") &&
+		 HasGLExtension("GL_ARB_shader_image_load_store"))) &&
+		glext_glDispatchCompute != NULL && glext_glMemoryBarrier != NULL && glext_glBindImageTexture != NULL;
+	glFeatures.drawIndirect = (HasGLVersion(4, 0) || HasGLExtension("GL_ARB_draw_indirect")) &&
+		glext_glDrawElementsIndirect != NULL;
+	glFeatures.programBinary = (HasGLVersion(4, 1) || HasGLExtension("GL_ARB_get_program_binary")) &&
+		glext_glGetProgramBinary != NULL && glext_glProgramBinary != NULL && glext_glProgramParameteri != NULL;
+	glFeatures.parallelShaderCompile = (parallelKHR || parallelARB) && glext_glMaxShaderCompilerThreads != NULL;
+	glFeatures.bufferStorage = (HasGLVersion(4, 4) || HasGLExtension("GL_ARB_buffer_storage")) && glext_glBufferStorage != NULL;
+	glFeatures.pipelineStatistics = HasGLVersion(4, 6) || HasGLExtension("GL_ARB_pipeline_statistics_query");
+	glFeatures.debugOutput = (HasGLVersion(4, 3) || HasGLExtension("GL_KHR_debug")) && glext_glDebugMessageCallback != NULL &&
+		glext_glDebugMessageControl != NULL && glext_glPushDebugGroup != NULL && glext_glPopDebugGroup != NULL && glext_glObjectLabel != NULL;
+	glFeatures.bindlessTextures = HasGLExtension("GL_ARB_bindless_texture") && glext_glGetTextureHandleARB != NULL &&
+		glext_glMakeTextureHandleResidentARB != NULL && glext_glMakeTextureHandleNonResidentARB != NULL;
+	if (glFeatures.programBinary) {
+		// Drivers may support the entry points but no format at all
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		glFeatures.programBinary = formats > 0;
+	}
+
+	std::cout << "OpenGL " << glFeatures.majorVersion << "." << glFeatures.minorVersion
+		<< " - compute shaders: " << (glFeatures.computeShaders ? "yes" : "no")
+		<< ", indirect draws: " << (glFeatures.drawIndirect ? "yes" : "no")
+		<< ", program binaries: " << (glFeatures.programBinary ? "yes" : "no")
+		<< ", parallel shader compile: " << (glFeatures.parallelShaderCompile ? "yes" : "no")
+		<< ", buffer storage: " << (glFeatures.bufferStorage ? "yes" : "no")
+		<< ", pipeline statistics: " << (glFeatures.pipelineStatistics ? "yes" : "no")
+		<< ", debug output: " << (glFeatures.debugOutput ? "yes" : "no")
+		<< ", bindless textures: " << (glFeatures.bindlessTextures ? "yes" : "no") << std::endl;
+}
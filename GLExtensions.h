@@ -0,0 +1,187 @@
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+// glad.c is generated for core GL 3.3 only. Entry points and enums of newer versions
+// used by the optional render paths are loaded here, in the same style as glad.
+#include<glad/glad.h>
+
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#endif
+#ifndef GL_TEXTURE_FETCH_BARRIER_BIT
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#endif
+#ifndef GL_COMMAND_BARRIER_BIT
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#endif
+#ifndef GL_BUFFER_UPDATE_BARRIER_BIT
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#endif
+#ifndef GL_SHADER_STORAGE_BARRIER_BIT
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#endif
+#ifndef GL_READ_ONLY
+#define GL_READ_ONLY 0x88B8
+#endif
+#ifndef GL_WRITE_ONLY
+#define GL_WRITE_ONLY 0x88B9
+#endif
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_FRAGMENT_SHADER_INVOCATIONS_ARB
+#define GL_FRAGMENT_SHADER_INVOCATIONS_ARB 0x82F4
+#endif
+#ifndef GL_DEBUG_OUTPUT
+#define GL_DEBUG_OUTPUT 0x92E0
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#define GL_CONTEXT_FLAG_DEBUG_BIT 0x00000002
+#define GL_DEBUG_SOURCE_API 0x8246
+#define GL_DEBUG_SOURCE_WINDOW_SYSTEM 0x8247
+#define GL_DEBUG_SOURCE_SHADER_COMPILER 0x8248
+#define GL_DEBUG_SOURCE_THIRD_PARTY 0x8249
+#define GL_DEBUG_SOURCE_APPLICATION 0x824A
+#define GL_DEBUG_SOURCE_OTHER 0x824B
+#define GL_DEBUG_TYPE_ERROR 0x824C
+#define GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR 0x824D
+#define GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR 0x824E
+#define GL_DEBUG_TYPE_PORTABILITY 0x824F
+#define GL_DEBUG_TYPE_PERFORMANCE 0x8250
+#define GL_DEBUG_TYPE_OTHER 0x8251
+#define GL_DEBUG_TYPE_MARKER 0x8268
+#define GL_DEBUG_TYPE_PUSH_GROUP 0x8269
+#define GL_DEBUG_TYPE_POP_GROUP 0x826A
+#define GL_DEBUG_SEVERITY_HIGH 0x9146
+#define GL_DEBUG_SEVERITY_MEDIUM 0x9147
+#define GL_DEBUG_SEVERITY_LOW 0x9148
+#define GL_DEBUG_SEVERITY_NOTIFICATION 0x826B
+#define GL_BUFFER 0x82E0
+#define GL_SHADER 0x82E1
+#define GL_PROGRAM 0x82E2
+#define GL_VERTEX_ARRAY 0x8074
+#define GL_QUERY 0x82E3
+#define GL_SAMPLER 0x82E6
+#endif
+#ifndef GL_TEXTURE_2D_ARRAY
+#define GL_TEXTURE_2D_ARRAY 0x8C1A
+#endif
+#ifndef GL_MAX_ARRAY_TEXTURE_LAYERS
+#define GL_MAX_ARRAY_TEXTURE_LAYERS 0x88FF
+#endif
+
+typedef void (APIENTRYP PFNGLEXTDISPATCHCOMPUTEPROC)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+typedef void (APIENTRYP PFNGLEXTMEMORYBARRIERPROC)(GLbitfield barriers);
+typedef void (APIENTRYP PFNGLEXTBINDIMAGETEXTUREPROC)(GLuint unit, GLuint texture, GLint level, GLboolean layered,
+													  GLint layer, GLenum access, GLenum format);
+typedef void (APIENTRYP PFNGLEXTDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect);
+typedef void (APIENTRYP PFNGLEXTGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLEXTPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLEXTPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+typedef void (APIENTRYP PFNGLEXTMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+typedef void (APIENTRYP PFNGLEXTBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+typedef void (APIENTRYP PFNGLEXTDEBUGMESSAGECALLBACKPROC)(GLDEBUGPROC callback, const void* userParam);
+typedef void (APIENTRYP PFNGLEXTDEBUGMESSAGECONTROLPROC)(GLenum source, GLenum type, GLenum severity, GLsizei count,
+														 const GLuint* ids, GLboolean enabled);
+typedef void (APIENTRYP PFNGLEXTPUSHDEBUGGROUPPROC)(GLenum source, GLuint id, GLsizei length, const GLchar* message);
+typedef void (APIENTRYP PFNGLEXTPOPDEBUGGROUPPROC)(void);
+typedef void (APIENTRYP PFNGLEXTOBJECTLABELPROC)(GLenum identifier, GLuint name, GLsizei length, const GLchar* label);
+typedef GLuint64 (APIENTRYP PFNGLEXTGETTEXTUREHANDLEPROC)(GLuint texture);
+typedef void (APIENTRYP PFNGLEXTMAKETEXTUREHANDLERESIDENTPROC)(GLuint64 handle);
+typedef void (APIENTRYP PFNGLEXTMAKETEXTUREHANDLENONRESIDENTPROC)(GLuint64 handle);
+
+extern PFNGLEXTDISPATCHCOMPUTEPROC glext_glDispatchCompute;
+extern PFNGLEXTMEMORYBARRIERPROC glext_glMemoryBarrier;
+extern PFNGLEXTBINDIMAGETEXTUREPROC glext_glBindImageTexture;
+extern PFNGLEXTDRAWELEMENTSINDIRECTPROC glext_glDrawElementsIndirect;
+extern PFNGLEXTGETPROGRAMBINARYPROC glext_glGetProgramBinary;
+extern PFNGLEXTPROGRAMBINARYPROC glext_glProgramBinary;
+extern PFNGLEXTPROGRAMPARAMETERIPROC glext_glProgramParameteri;
+// KHR or ARB entry point, whichever the driver has
+extern PFNGLEXTMAXSHADERCOMPILERTHREADSPROC glext_glMaxShaderCompilerThreads;
+extern PFNGLEXTBUFFERSTORAGEPROC glext_glBufferStorage;
+extern PFNGLEXTDEBUGMESSAGECALLBACKPROC glext_glDebugMessageCallback;
+extern PFNGLEXTDEBUGMESSAGECONTROLPROC glext_glDebugMessageControl;
+extern PFNGLEXTPUSHDEBUGGROUPPROC glext_glPushDebugGroup;
+extern PFNGLEXTPOPDEBUGGROUPPROC glext_glPopDebugGroup;
+extern PFNGLEXTOBJECTLABELPROC glext_glObjectLabel;
+extern PFNGLEXTGETTEXTUREHANDLEPROC glext_glGetTextureHandleARB;
+extern PFNGLEXTMAKETEXTUREHANDLERESIDENTPROC glext_glMakeTextureHandleResidentARB;
+extern PFNGLEXTMAKETEXTUREHANDLENONRESIDENTPROC glext_glMakeTextureHandleNonResidentARB;
+
+#define glDispatchCompute glext_glDispatchCompute
+#define glMemoryBarrier glext_glMemoryBarrier
+#define glBindImageTexture glext_glBindImageTexture
+#define glDrawElementsIndirect glext_glDrawElementsIndirect
+#define glGetProgramBinary glext_glGetProgramBinary
+#define glProgramBinary glext_glProgramBinary
+#define glProgramParameteri glext_glProgramParameteri
+#define glMaxShaderCompilerThreads glext_glMaxShaderCompilerThreads
+#define glBufferStorage glext_glBufferStorage
+#define glDebugMessageCallback glext_glDebugMessageCallback
+#define glDebugMessageControl glext_glDebugMessageControl
+#define glPushDebugGroup glext_glPushDebugGroup
+#define glPopDebugGroup glext_glPopDebugGroup
+#define glObjectLabel glext_glObjectLabel
+#define glGetTextureHandleARB glext_glGetTextureHandleARB
+#define glMakeTextureHandleResidentARB glext_glMakeTextureHandleResidentARB
+#define glMakeTextureHandleNonResidentARB glext_glMakeTextureHandleNonResidentARB
+
+// What the current context supports beyond core 3.3
+struct GLFeatures {
+	int majorVersion = 3;
+	int minorVersion = 3;
+	// GL 4.3 or ARB_compute_shader + ARB_shader_storage_buffer_object + ARB_shader_image_load_store
+	bool computeShaders = false;
+	// GL 4.0 or ARB_draw_indirect
+	bool drawIndirect = false;
+	// GL 4.1 or ARB_get_program_binary, with at least one binary format
+	bool programBinary = false;
+	// KHR_parallel_shader_compile or ARB_parallel_shader_compile: compiles run in driver threads
+	// and GL_COMPLETION_STATUS_KHR can be polled without blocking
+	bool parallelShaderCompile = false;
+	// GL 4.4 or ARB_buffer_storage: immutable buffers that can stay mapped while the GPU uses them
+	bool bufferStorage = false;
+	// GL 4.6 or ARB_pipeline_statistics_query: queries for e.g. GL_FRAGMENT_SHADER_INVOCATIONS_ARB
+	bool pipelineStatistics = false;
+	// GL 4.3 or KHR_debug: debug message callback, debug groups and object labels (see GLDebug)
+	bool debugOutput = false;
+	// ARB_bindless_texture: shaders sample textures through 64-bit handles instead of units (see TextureTable)
+	bool bindlessTextures = false;
+};
+extern GLFeatures glFeatures;
+
+// Loads the entry points above and fills glFeatures. Call once after gladLoadGLLoader.
+void LoadGLExtensions(GLADloadproc load);
+// Checks the extension string list of the current context
+bool HasGLExtension(const char* name);
+// Checks whether the context version is at least major.minor
+bool HasGLVersion(int major, int minor);
+
+#endif
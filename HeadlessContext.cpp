@@ -0,0 +1,133 @@
+#include"HeadlessContext.h"
+#include"GLDebug.h"
+
+#include<cstring>
+#include<iostream>
+// Only the surfaceless platform is used, keep Xlib's macros out
+#define EGL_NO_X11
+#include<EGL/egl.h>
+#include<EGL/eglext.h>
+
+static bool hasExtension(const char* extensions, const char* name) {
+	if (extensions == NULL)
+		return false;
+	size_t length = strlen(name);
+	for (const char* found = strstr(extensions, name); found != NULL; found = strstr(found + length, name)) {
+		if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == 0))
+			return true;
+	}
+	return false;
+}
+
+bool HeadlessContext::Create(int major, int minor, HeadlessContext* share) {
+	EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+	if (share != nullptr) {
+		eglDisplay = (EGLDisplay) share->display;
+	} else {
+		// The surfaceless platform needs neither X11 nor Wayland nor a DRM device
+		const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (getPlatformDisplay != NULL && hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+			eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		if (eglDisplay == EGL_NO_DISPLAY)
+			eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		EGLint eglMajor = 0;
+		EGLint eglMinor = 0;
+		if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &eglMajor, &eglMinor)) {
+			std::cout << "HeadlessContext: no EGL display" << std::endl;
+			return false;
+		}
+		ownsDisplay = true;
+	}
+	display = eglDisplay;
+
+	if (!eglBindAPI(EGL_OPENGL_API)) {
+		std::cout << "HeadlessContext: EGL cannot create OpenGL contexts" << std::endl;
+		return false;
+	}
+	// Nothing is ever drawn to a surface, so no config is needed where EGL allows leaving it out
+	const char* extensions = eglQueryString(eglDisplay, EGL_EXTENSIONS);
+	if (!hasExtension(extensions, "EGL_KHR_surfaceless_context")) {
+		std::cout << "HeadlessContext: EGL_KHR_surfaceless_context is not supported" << std::endl;
+		return false;
+	}
+	EGLConfig config = EGL_NO_CONFIG_KHR;
+	if (!hasExtension(extensions, "EGL_KHR_no_config_context")) {
+		EGLint configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+		EGLint configCount = 0;
+		if (!eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configCount) || configCount == 0) {
+			std::cout << "HeadlessContext: no EGL config for OpenGL" << std::endl;
+			return false;
+		}
+	}
+
+	EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, major,
+		EGL_CONTEXT_MINOR_VERSION, minor,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		// EGL_CONTEXT_OPENGL_DEBUG is new in EGL 1.5, EGL 1.4 rejects it, so it is only asked for when wanted
+		debug ? EGL_CONTEXT_OPENGL_DEBUG : EGL_NONE, EGL_TRUE,
+		EGL_NONE
+	};
+	EGLContext shareContext = share != nullptr ? (EGLContext) share->context : EGL_NO_CONTEXT;
+	EGLContext eglContext = eglCreateContext(eglDisplay, config, shareContext, contextAttributes);
+	// An EGL 1.4 driver: retry without it, GLDebug then reports a non-debug context
+	if (eglContext == EGL_NO_CONTEXT && debug) {
+		contextAttributes[6] = EGL_NONE;
+		eglContext = eglCreateContext(eglDisplay, config, shareContext, contextAttributes);
+	}
+	if (eglContext == EGL_NO_CONTEXT)
+		return false;
+	context = eglContext;
+	return true;
+}
+
+void HeadlessContext::CreateFramebuffer(int width, int height) {
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glGenRenderbuffers(1, &colorRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRenderbuffer);
+	// Same format as a usual default framebuffer
+	glGenRenderbuffers(1, &depthRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthRenderbuffer);
+	glDebug.Label(GL_FRAMEBUFFER, framebuffer, "Headless default framebuffer");
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "HeadlessContext: framebuffer is incomplete" << std::endl;
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+}
+
+void HeadlessContext::MakeCurrent() {
+	eglMakeCurrent((EGLDisplay) display, EGL_NO_SURFACE, EGL_NO_SURFACE, (EGLContext) context);
+}
+
+void HeadlessContext::Release() {
+	eglMakeCurrent((EGLDisplay) display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+void HeadlessContext::Destroy() {
+	if (framebuffer != 0) {
+		glDeleteFramebuffers(1, &framebuffer);
+		glDeleteRenderbuffers(1, &colorRenderbuffer);
+		glDeleteRenderbuffers(1, &depthRenderbuffer);
+		framebuffer = 0;
+	}
+	if (context != nullptr) {
+		if (eglGetCurrentContext() == (EGLContext) context)
+			Release();
+		eglDestroyContext((EGLDisplay) display, (EGLContext) context);
+		context = nullptr;
+	}
+	if (ownsDisplay)
+		eglTerminate((EGLDisplay) display);
+	display = nullptr;
+	ownsDisplay = false;
+}
+
+void* HeadlessContext::GetProcAddress(const char* name) {
+	return (void*) eglGetProcAddress(name);
+}
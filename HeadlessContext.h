@@ -0,0 +1,38 @@
+#ifndef HEADLESS_CONTEXT_CLASS_H
+#define HEADLESS_CONTEXT_CLASS_H
+
+#include<glad/glad.h>
+
+// OpenGL context without a window, for machines without a display or GPU (CI, llvmpipe). Made with
+// EGL on Mesa's surfaceless platform (or the default EGL display) and never given a surface, so it
+// has no default framebuffer: 'framebuffer' is a window-sized FBO that takes its place.
+class HeadlessContext {
+public:
+	// Stands in for the default framebuffer, created by CreateFramebuffer
+	GLuint framebuffer = 0;
+	GLuint colorRenderbuffer = 0;
+	GLuint depthRenderbuffer = 0;
+	// Asks for a debug context in Create, dropped again if EGL cannot make one
+	bool debug = false;
+
+	// Creates a core profile context of version major.minor, sharing objects with 'share' if given.
+	// Returns false when EGL has no display or the version is not available.
+	bool Create(int major, int minor, HeadlessContext* share = nullptr);
+	// Allocates 'framebuffer', call with the context current and GL loaded
+	void CreateFramebuffer(int width, int height);
+
+	void MakeCurrent();
+	// Detaches the context from the calling thread
+	void Release();
+	void Destroy();
+
+	// Loader for gladLoadGLLoader and LoadGLExtensions
+	static void* GetProcAddress(const char* name);
+
+private:
+	// EGLDisplay and EGLContext, kept opaque so EGL's headers stay out of everything including this one
+	void* display = nullptr;
+	void* context = nullptr;
+	bool ownsDisplay = false;
+};
+#endif
@@ -0,0 +1,206 @@
+#include"HiZCuller.h"
+#include"GLDebug.h"
+
+#include<glm/gtc/type_ptr.hpp>
+#include<algorithm>
+
+// Work group sizes, must match local_size in the compute shaders
+static const GLuint pyramidGroupSize = 8;
+static const GLuint cullGroupSize = 64;
+
+HiZCuller::HiZCuller(int width, int height) {
+	HiZCuller::width = width;
+	HiZCuller::height = height;
+	pyramidLevels = 1;
+	while ((std::max(width, height) >> pyramidLevels) > 0)
+		pyramidLevels++;
+
+	supported = glFeatures.computeShaders && glFeatures.drawIndirect;
+	if (!supported) {
+		std::cout << "HiZCuller: GL 4.3 compute shaders and indirect draws are required, GPU culling disabled" << std::endl;
+		return;
+	}
+
+	copyProgram = new Shader("hiz_copy.comp");
+	downsampleProgram = new Shader("hiz_downsample.comp");
+	cullProgram = new Shader("hiz_cull.comp");
+
+	// Depth of the previous frame, blitted from the frame's framebuffer (whose depth format it matches)
+	glGenTextures(1, &depthTexture);
+	glBindTexture(GL_TEXTURE_2D, depthTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+	glGenFramebuffers(1, &captureFramebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, captureFramebuffer);
+	glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+	glDrawBuffer(GL_NONE);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glDebug.Label(GL_TEXTURE, depthTexture, "HiZ previous depth");
+	glDebug.Label(GL_FRAMEBUFFER, captureFramebuffer, "HiZ depth capture");
+
+	// Max-depth pyramid, level 0 has the framebuffer's size
+	glGenTextures(1, &pyramidTexture);
+	glBindTexture(GL_TEXTURE_2D, pyramidTexture);
+	for (int level = 0; level < pyramidLevels; level++) {
+		glTexImage2D(GL_TEXTURE_2D, level, GL_R32F, std::max(1, width >> level), std::max(1, height >> level), 0,
+					 GL_RED, GL_FLOAT, NULL);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, pyramidLevels - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDebug.Label(GL_TEXTURE, pyramidTexture, "HiZ depth pyramid");
+
+	glGenBuffers(1, &recordBuffer);
+	glGenBuffers(1, &commandBuffer);
+	glGenBuffers(1, &debugBuffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, debugBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(DebugCounters), NULL, GL_DYNAMIC_READ);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glDebug.Label(GL_BUFFER, debugBuffer, "HiZ debug counters");
+}
+
+void HiZCuller::ClearDraws() {
+	records.clear();
+}
+
+unsigned int HiZCuller::AddDraw(const glm::vec3& minBounds, const glm::vec3& maxBounds, GLuint indexCount) {
+	DrawRecord record;
+	record.minBounds = glm::vec4(minBounds, 1.0f);
+	record.maxBounds = glm::vec4(maxBounds, 1.0f);
+	record.indexCount = indexCount;
+	record.padding[0] = record.padding[1] = record.padding[2] = 0;
+	records.push_back(record);
+	return (unsigned int) records.size() - 1;
+}
+
+void HiZCuller::Cull(const glm::mat4& viewProjection) {
+	if (!supported || records.empty())
+		return;
+
+	// Grow the buffers when needed, otherwise just replace their contents
+	if (records.size() > recordCapacity) {
+		recordCapacity = records.size() * 2;
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, recordBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, recordCapacity * sizeof(DrawRecord), NULL, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, recordCapacity * sizeof(DrawCommand), NULL, GL_DYNAMIC_DRAW);
+	}
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, recordBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, records.size() * sizeof(DrawRecord), records.data());
+
+	DebugCounters zero = {0, 0, 0, 0};
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, debugBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(DebugCounters), &zero);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	cullProgram->Activate();
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, recordBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, commandBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, debugBuffer);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, pyramidTexture);
+
+	glUniform1ui(glGetUniformLocation(cullProgram->ID, "drawCount"), (GLuint) records.size());
+	glUniformMatrix4fv(glGetUniformLocation(cullProgram->ID, "viewProjection"), 1, GL_FALSE, glm::value_ptr(viewProjection));
+	glUniformMatrix4fv(glGetUniformLocation(cullProgram->ID, "pyramidViewProjection"), 1, GL_FALSE,
+					   glm::value_ptr(pyramidViewProjection));
+	glUniform1i(glGetUniformLocation(cullProgram->ID, "hasPyramid"), hasPyramid ? 1 : 0);
+	glUniform1i(glGetUniformLocation(cullProgram->ID, "pyramidLevels"), pyramidLevels);
+	glUniform2f(glGetUniformLocation(cullProgram->ID, "pyramidSize"), (float) width, (float) height);
+	glUniform1i(glGetUniformLocation(cullProgram->ID, "pyramid"), 0);
+
+	glDispatchCompute(((GLuint) records.size() + cullGroupSize - 1) / cullGroupSize, 1, 1);
+
+	// The commands are consumed as indirect arguments, the counters may be read back
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void HiZCuller::BindCommands() {
+	if (supported)
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+}
+
+void HiZCuller::UnbindCommands() {
+	if (supported)
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void HiZCuller::CaptureDepth(const glm::mat4& viewProjection, int sourceWidth, int sourceHeight) {
+	if (!supported)
+		return;
+
+	// Copy the depth of the frame; depth blits only filter with GL_NEAREST, which keeps every value a real depth
+	GLint readFramebuffer = 0;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, captureFramebuffer);
+	glBlitFramebuffer(0, 0, sourceWidth, sourceHeight, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, readFramebuffer);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, depthTexture);
+
+	// Level 0: depth texture -> R32F image
+	copyProgram->Activate();
+	glUniform1i(glGetUniformLocation(copyProgram->ID, "depthTexture"), 0);
+	glBindImageTexture(0, pyramidTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+	glDispatchCompute((width + pyramidGroupSize - 1) / pyramidGroupSize, (height + pyramidGroupSize - 1) / pyramidGroupSize, 1);
+	glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// Every further level keeps the farthest depth of the texels it covers
+	downsampleProgram->Activate();
+	for (int level = 1; level < pyramidLevels; level++) {
+		int levelWidth = std::max(1, width >> level);
+		int levelHeight = std::max(1, height >> level);
+		glBindImageTexture(0, pyramidTexture, level - 1, GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+		glBindImageTexture(1, pyramidTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+		glUniform2i(glGetUniformLocation(downsampleProgram->ID, "sourceSize"), std::max(1, width >> (level - 1)),
+					std::max(1, height >> (level - 1)));
+		glDispatchCompute((levelWidth + pyramidGroupSize - 1) / pyramidGroupSize,
+						  (levelHeight + pyramidGroupSize - 1) / pyramidGroupSize, 1);
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+	}
+
+	// The next Cull samples the pyramid through texelFetch
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+	pyramidViewProjection = viewProjection;
+	hasPyramid = true;
+}
+
+HiZCuller::DebugCounters HiZCuller::ReadDebugCounters() {
+	DebugCounters counters = {0, 0, 0, 0};
+	if (!supported)
+		return counters;
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, debugBuffer);
+	glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(DebugCounters), &counters);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	return counters;
+}
+
+void HiZCuller::Delete() {
+	if (!supported)
+		return;
+
+	copyProgram->Delete();
+	downsampleProgram->Delete();
+	cullProgram->Delete();
+	delete copyProgram;
+	delete downsampleProgram;
+	delete cullProgram;
+	copyProgram = downsampleProgram = cullProgram = NULL;
+
+	glDeleteTextures(1, &depthTexture);
+	glDeleteFramebuffers(1, &captureFramebuffer);
+	glDeleteTextures(1, &pyramidTexture);
+	glDeleteBuffers(1, &recordBuffer);
+	glDeleteBuffers(1, &commandBuffer);
+	glDeleteBuffers(1, &debugBuffer);
+	supported = false;
+}
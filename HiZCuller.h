@@ -0,0 +1,95 @@
+#ifndef HIZ_CULLER_CLASS_H
+#define HIZ_CULLER_CLASS_H
+
+#include<glm/glm.hpp>
+#include<vector>
+
+#include"GLExtensions.h"
+#include"shaderClass.h"
+
+// GPU occlusion culling (GL 4.3): a max-depth pyramid is built from the previous frame's depth buffer,
+// then a compute shader tests every draw's world bounds against it and writes the indirect draw commands.
+// Nothing is read back on the CPU except the optional debug counters.
+class HiZCuller {
+public:
+	// Per-draw input, laid out to match the std430 struct in hiz_cull.comp
+	struct DrawRecord {
+		glm::vec4 minBounds;
+		glm::vec4 maxBounds;
+		GLuint indexCount;
+		GLuint padding[3];
+	};
+	// Layout required by glDrawElementsIndirect
+	struct DrawCommand {
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+	// Written by the culling shader, read back with ReadDebugCounters
+	struct DebugCounters {
+		GLuint tested;
+		GLuint visible;
+		GLuint frustumCulled;
+		GLuint occlusionCulled;
+	};
+
+	// False when the context lacks compute shaders or indirect draws; every other call is then a no-op
+	bool supported = false;
+	// Whether a pyramid from an earlier frame exists, without one only the frustum test runs
+	bool hasPyramid = false;
+
+	int width;
+	int height;
+	int pyramidLevels;
+
+	GLuint depthTexture = 0;
+	// Framebuffer around depthTexture, the frame's depth is blitted into it
+	GLuint captureFramebuffer = 0;
+	GLuint pyramidTexture = 0;
+	GLuint recordBuffer = 0;
+	GLuint commandBuffer = 0;
+	GLuint debugBuffer = 0;
+
+	// Creates the textures, buffers and compute programs for a framebuffer of the given size
+	HiZCuller(int width, int height);
+
+	// Removes all draws
+	void ClearDraws();
+	// Adds a draw with its world bounds and returns its index
+	unsigned int AddDraw(const glm::vec3& minBounds, const glm::vec3& maxBounds, GLuint indexCount);
+	unsigned int DrawCount() const {
+		return (unsigned int) records.size();
+	}
+	// Byte offset of a draw's command inside commandBuffer
+	static GLintptr CommandOffset(unsigned int draw) {
+		return (GLintptr) (draw * sizeof(DrawCommand));
+	}
+
+	// Uploads the draws and runs the culling shader. viewProjection is the current camera matrix.
+	void Cull(const glm::mat4& viewProjection);
+	// Binds commandBuffer as GL_DRAW_INDIRECT_BUFFER for Mesh::DrawIndirect
+	void BindCommands();
+	void UnbindCommands();
+	// Copies the depth of the frame just drawn from the bound read framebuffer and builds the pyramid
+	// used by the next Cull. A frame rendered at another size (dynamic resolution) is scaled to the pyramid's.
+	void CaptureDepth(const glm::mat4& viewProjection, int sourceWidth, int sourceHeight);
+	// Reads the counters of the last Cull. This waits for the GPU, so only call it occasionally.
+	DebugCounters ReadDebugCounters();
+
+	// Deletes all GL objects
+	void Delete();
+
+private:
+	std::vector<DrawRecord> records;
+	size_t recordCapacity = 0;
+	// Camera matrix of the frame the pyramid was built from
+	glm::mat4 pyramidViewProjection;
+
+	// Only created when the context supports compute shaders
+	Shader* copyProgram = NULL;
+	Shader* downsampleProgram = NULL;
+	Shader* cullProgram = NULL;
+};
+#endif
@@ -0,0 +1,36 @@
+#include"InputRecorder.h"
+
+#include<iostream>
+
+static_assert(sizeof(InputRecorder::Record) == 20, "input records are written as they are in memory");
+
+InputRecorder::InputRecorder(InputSource& source) : source(source) {
+}
+
+bool InputRecorder::Open(const char* file) {
+	out.open(file, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		std::cout << "InputRecorder: could not write " << file << std::endl;
+		return false;
+	}
+	Header header = {fileMagic, fileVersion, InputFrame::trackedKeyCount};
+	out.write((const char*) &header, sizeof(header));
+	frameCount = 0;
+	return true;
+}
+
+bool InputRecorder::Poll(InputFrame& frame) {
+	bool more = source.Poll(frame);
+	if (more && out.is_open()) {
+		Record record = {frame.deltaTime, frame.keys, frame.mouseDeltaX, frame.mouseDeltaY, frame.scroll};
+		out.write((const char*) &record, sizeof(record));
+		if (++frameCount % flushInterval == 0)
+			out.flush();
+	}
+	return more;
+}
+
+void InputRecorder::Close() {
+	if (out.is_open())
+		out.close();
+}
@@ -0,0 +1,44 @@
+#ifndef INPUT_RECORDER_CLASS_H
+#define INPUT_RECORDER_CLASS_H
+
+#include<fstream>
+
+#include"InputSource.h"
+
+// Passes the frames of another source through and logs each one to a file for InputReplay.
+//
+// The file is a Header followed by one Record per frame, written as they come (and flushed every
+// flushInterval frames, so a crash keeps almost all of the session). Floats are stored bit for bit.
+class InputRecorder : public InputSource {
+public:
+	static const unsigned int fileMagic = 0x52494343; // "CCIR"
+	static const unsigned int fileVersion = 1;
+	static const unsigned int flushInterval = 64;
+
+	struct Header {
+		unsigned int magic;
+		unsigned int version;
+		// Number of entries in InputFrame::trackedKeys when recorded
+		unsigned int keyCount;
+	};
+	struct Record {
+		float deltaTime;
+		unsigned int keys;
+		float mouseDeltaX;
+		float mouseDeltaY;
+		float scroll;
+	};
+
+	unsigned int frameCount = 0;
+
+	InputRecorder(InputSource& source);
+	// Starts a new recording, false if the file cannot be written
+	bool Open(const char* file);
+	bool Poll(InputFrame& frame) override;
+	void Close();
+
+private:
+	InputSource& source;
+	std::ofstream out;
+};
+#endif
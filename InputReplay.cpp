@@ -0,0 +1,38 @@
+#include"InputReplay.h"
+
+#include<fstream>
+#include<iostream>
+
+bool InputReplay::Open(const char* file) {
+	records.clear();
+	next = 0;
+	std::ifstream in(file, std::ios::binary);
+	if (!in)
+		return false;
+	InputRecorder::Header header;
+	if (!in.read((char*) &header, sizeof(header)) || header.magic != InputRecorder::fileMagic) {
+		std::cout << "InputReplay: " << file << " is not an input recording" << std::endl;
+		return false;
+	}
+	if (header.version != InputRecorder::fileVersion || header.keyCount > InputFrame::trackedKeyCount) {
+		std::cout << "InputReplay: " << file << " was recorded by an incompatible version" << std::endl;
+		return false;
+	}
+	// A truncated last record (the recording was cut short) is dropped
+	InputRecorder::Record record;
+	while (in.read((char*) &record, sizeof(record)))
+		records.push_back(record);
+	return true;
+}
+
+bool InputReplay::Poll(InputFrame& frame) {
+	if (next >= records.size())
+		return false;
+	const InputRecorder::Record& record = records[next++];
+	frame.deltaTime = record.deltaTime;
+	frame.keys = record.keys;
+	frame.mouseDeltaX = record.mouseDeltaX;
+	frame.mouseDeltaY = record.mouseDeltaY;
+	frame.scroll = record.scroll;
+	return true;
+}
@@ -0,0 +1,32 @@
+#ifndef INPUT_REPLAY_CLASS_H
+#define INPUT_REPLAY_CLASS_H
+
+#include<vector>
+
+#include"InputRecorder.h"
+
+// Plays back a file written by InputRecorder, one recorded frame per Poll whatever the real time,
+// each with the time step it was recorded with. Fed the same frames from the same starting state,
+// camera movement and collision come out bit-identical: nothing it does reads a clock, and the
+// collision rays only combine into an "any hit" result, so worker scheduling does not matter.
+// Across builds that holds as long as float math is not reordered (no -ffast-math, and the same
+// FMA contraction setting).
+class InputReplay : public InputSource {
+public:
+	// Reads the whole recording, false if it is missing or not a recording
+	bool Open(const char* file);
+	bool Poll(InputFrame& frame) override;
+
+	unsigned int FrameCount() const {
+		return (unsigned int) records.size();
+	}
+	// Frames handed out so far
+	unsigned int Position() const {
+		return next;
+	}
+
+private:
+	std::vector<InputRecorder::Record> records;
+	unsigned int next = 0;
+};
+#endif
@@ -0,0 +1,35 @@
+#include"InputSource.h"
+
+#include<GLFW/glfw3.h>
+
+// Recordings store the bit index, so keys are only ever appended here
+const int InputFrame::trackedKeys[] = {
+	GLFW_KEY_W, GLFW_KEY_A, GLFW_KEY_S, GLFW_KEY_D,
+	GLFW_KEY_UP, GLFW_KEY_DOWN, GLFW_KEY_LEFT, GLFW_KEY_RIGHT,
+	GLFW_KEY_LEFT_SHIFT, GLFW_KEY_ESCAPE,
+	GLFW_KEY_G, GLFW_KEY_O, GLFW_KEY_L, GLFW_KEY_F, GLFW_KEY_V, GLFW_KEY_R, GLFW_KEY_X, GLFW_KEY_P, GLFW_KEY_C
+};
+const unsigned int InputFrame::trackedKeyCount = sizeof(InputFrame::trackedKeys) / sizeof(InputFrame::trackedKeys[0]);
+
+static int keyBit(int key) {
+	for (unsigned int i = 0; i < InputFrame::trackedKeyCount; i++) {
+		if (InputFrame::trackedKeys[i] == key)
+			return (int) i;
+	}
+	return -1;
+}
+
+bool InputFrame::KeyDown(int key) const {
+	int bit = keyBit(key);
+	return bit >= 0 && (keys & (1u << bit)) != 0;
+}
+
+void InputFrame::SetKey(int key, bool down) {
+	int bit = keyBit(key);
+	if (bit < 0)
+		return;
+	if (down)
+		keys |= 1u << bit;
+	else
+		keys &= ~(1u << bit);
+}
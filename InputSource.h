@@ -0,0 +1,32 @@
+#ifndef INPUT_SOURCE_CLASS_H
+#define INPUT_SOURCE_CLASS_H
+
+// Everything the update loop reads from the user in one frame. Camera::Inputs and the key toggles in
+// Main only look at this, so a frame can come from the window, from a recording or from a test.
+struct InputFrame {
+	// Keys the application reacts to, one bit each in 'keys' (in this order)
+	static const int trackedKeys[];
+	static const unsigned int trackedKeyCount;
+
+	// Seconds since the previous frame, before Camera::Inputs clamps it
+	float deltaTime = 0.0f;
+	unsigned int keys = 0;
+	// Cursor movement in pixels since the previous frame (y grows downwards, as on screen)
+	float mouseDeltaX = 0.0f;
+	float mouseDeltaY = 0.0f;
+	// Scroll wheel steps since the previous frame
+	float scroll = 0.0f;
+
+	// GLFW key codes, keys that are not tracked are never down
+	bool KeyDown(int key) const;
+	void SetKey(int key, bool down);
+};
+
+// Where the frames come from. Poll fills the next frame and returns false once there are no more
+// (the end of a replay), after which the application should stop.
+class InputSource {
+public:
+	virtual ~InputSource() {}
+	virtual bool Poll(InputFrame& frame) = 0;
+};
+#endif
@@ -0,0 +1,233 @@
+#include"JobSystem.h"
+
+#include<algorithm>
+#include<string>
+
+#include"Profiler.h"
+
+JobSystem jobSystem;
+
+// Worker index of the current thread, -1 on threads that are not workers
+static thread_local int workerIndex = -1;
+
+JobSystem::JobSystem() {
+	queues.push_back(std::unique_ptr<Queue>(new Queue()));
+	mainThread = std::this_thread::get_id();
+}
+
+JobSystem::~JobSystem() {
+	Stop();
+}
+
+void JobSystem::Start(unsigned int workerCount) {
+	Stop();
+	if (workerCount == 0)
+		workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+	mainThread = std::this_thread::get_id();
+
+	// Jobs still queued in the shared queue stay there
+	std::unique_ptr<Queue> shared = std::move(queues.back());
+	queues.clear();
+	for (unsigned int i = 0; i < workerCount; i++)
+		queues.push_back(std::unique_ptr<Queue>(new Queue()));
+	queues.push_back(std::move(shared));
+
+	stopping = false;
+	for (unsigned int i = 0; i < workerCount; i++)
+		workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+}
+
+void JobSystem::Stop() {
+	if (workers.empty())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+	workers.clear();
+
+	// Whatever the workers left behind moves to the shared queue
+	Queue& shared = *queues.back();
+	for (size_t i = 0; i + 1 < queues.size(); i++) {
+		for (Job& job : queues[i]->jobs)
+			shared.jobs.push_back(std::move(job));
+	}
+	std::unique_ptr<Queue> sharedQueue = std::move(queues.back());
+	queues.clear();
+	queues.push_back(std::move(sharedQueue));
+}
+
+unsigned int JobSystem::queueIndex() const {
+	return workerIndex >= 0 ? (unsigned int) workerIndex : (unsigned int) queues.size() - 1;
+}
+
+void JobSystem::push(Job job) {
+	Queue& queue = *queues[queueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(std::move(job));
+	}
+	queuedJobs.fetch_add(1);
+	// Only pay for the wake-up when somebody sleeps
+	if (sleepingWorkers.load() > 0) {
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+		}
+		wake.notify_one();
+	}
+}
+
+void JobSystem::Run(std::function<void()> function, JobCounter* counter, JobCounter* dependency) {
+	if (counter != nullptr)
+		counter->pending.fetch_add(1);
+
+	if (dependency != nullptr) {
+		std::lock_guard<std::mutex> lock(dependency->mutex);
+		if (!dependency->Done()) {
+			dependency->continuations.push_back({std::move(function), counter});
+			return;
+		}
+	}
+	push({std::move(function), counter});
+}
+
+void JobSystem::SetMainThread() {
+	mainThread = std::this_thread::get_id();
+}
+
+void JobSystem::RunOnMainThread(std::function<void()> function, JobCounter* counter) {
+	if (counter != nullptr)
+		counter->pending.fetch_add(1);
+	std::lock_guard<std::mutex> lock(mainThreadQueue.mutex);
+	mainThreadQueue.jobs.push_back({std::move(function), counter});
+}
+
+unsigned int JobSystem::ExecuteMainThreadJobs() {
+	unsigned int executed = 0;
+	while (true) {
+		Job job;
+		{
+			std::lock_guard<std::mutex> lock(mainThreadQueue.mutex);
+			if (mainThreadQueue.jobs.empty())
+				break;
+			job = std::move(mainThreadQueue.jobs.front());
+			mainThreadQueue.jobs.pop_front();
+		}
+		execute(job);
+		executed++;
+	}
+	return executed;
+}
+
+bool JobSystem::takeJob(unsigned int ownQueue, Job& job) {
+	if (queuedJobs.load() == 0)
+		return false;
+
+	{
+		Queue& queue = *queues[ownQueue];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty()) {
+			job = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+			queuedJobs.fetch_sub(1);
+			return true;
+		}
+	}
+
+	// Steal the oldest job of another queue, starting after our own so thieves spread out
+	unsigned int queueCount = (unsigned int) queues.size();
+	for (unsigned int offset = 1; offset < queueCount; offset++) {
+		Queue& queue = *queues[(ownQueue + offset) % queueCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty()) {
+			job = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+			queuedJobs.fetch_sub(1);
+			jobsStolen.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::execute(Job& job) {
+	job.function();
+	jobsExecuted.fetch_add(1, std::memory_order_relaxed);
+	finish(job.counter);
+}
+
+void JobSystem::finish(JobCounter* counter) {
+	if (counter == nullptr)
+		return;
+
+	// Decremented under the lock so Wait can tell when this thread is done with the counter
+	std::vector<JobCounter::Continuation> continuations;
+	{
+		std::lock_guard<std::mutex> lock(counter->mutex);
+		if (counter->pending.fetch_sub(1) == 1)
+			continuations.swap(counter->continuations);
+	}
+	// Last job of the group: start the ones that waited for it
+	for (JobCounter::Continuation& continuation : continuations)
+		push({std::move(continuation.function), continuation.counter});
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+	unsigned int ownQueue = queueIndex();
+	bool onMainThread = std::this_thread::get_id() == mainThread;
+	while (!counter.Done()) {
+		Job job;
+		if (takeJob(ownQueue, job))
+			execute(job);
+		else if (!(onMainThread && ExecuteMainThreadJobs() > 0))
+			std::this_thread::yield();
+	}
+	// The job that finished the counter may still hold its lock, after this the caller can destroy it
+	std::lock_guard<std::mutex> lock(counter.mutex);
+}
+
+void JobSystem::ParallelFor(unsigned int count, unsigned int grainSize, const std::function<void(unsigned int, unsigned int)>& function) {
+	grainSize = std::max(1u, grainSize);
+	if (workers.empty() || count <= grainSize) {
+		if (count > 0)
+			function(0, count);
+		return;
+	}
+
+	JobCounter counter;
+	// The calling thread takes the first chunk itself
+	for (unsigned int begin = grainSize; begin < count; begin += grainSize) {
+		unsigned int end = std::min(count, begin + grainSize);
+		Run([&function, begin, end]() { function(begin, end); }, &counter);
+	}
+	function(0, grainSize);
+	Wait(counter);
+}
+
+void JobSystem::ResetStatistics() {
+	jobsExecuted = 0;
+	jobsStolen = 0;
+}
+
+void JobSystem::workerLoop(unsigned int index) {
+	workerIndex = (int) index;
+	profiler.SetThreadName(("Worker " + std::to_string(index + 1)).c_str());
+	while (true) {
+		Job job;
+		if (takeJob(index, job)) {
+			execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepingWorkers.fetch_add(1);
+		wake.wait(lock, [this]() { return queuedJobs.load() > 0 || stopping; });
+		sleepingWorkers.fetch_sub(1);
+		if (stopping)
+			break;
+	}
+	workerIndex = -1;
+}
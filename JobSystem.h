@@ -0,0 +1,114 @@
+#ifndef JOB_SYSTEM_CLASS_H
+#define JOB_SYSTEM_CLASS_H
+
+#include<atomic>
+#include<condition_variable>
+#include<deque>
+#include<functional>
+#include<memory>
+#include<mutex>
+#include<thread>
+#include<vector>
+
+// Counts the unfinished jobs of a group. Jobs submitted with a counter increment it and decrement it
+// when they finish; jobs can also wait for a counter to reach zero before they start (dependencies).
+// Only destroy a counter after JobSystem::Wait returned for it.
+class JobCounter {
+public:
+	JobCounter() = default;
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+	bool Done() const {
+		return pending.load(std::memory_order_acquire) == 0;
+	}
+
+private:
+	friend class JobSystem;
+	struct Continuation {
+		std::function<void()> function;
+		JobCounter* counter;
+	};
+	std::atomic<int> pending{0};
+	// Jobs waiting for this counter, started when it reaches zero
+	std::mutex mutex;
+	std::vector<Continuation> continuations;
+};
+
+// Work-stealing job scheduler shared by the engine (loading, culling, collision, benchmarks).
+// Every worker has its own deque: it pushes and pops its own jobs at the back (newest first, still
+// warm in its cache) and steals from the front of the others' deques when it runs dry. Threads that
+// are not workers (main, render) submit into one shared deque that all workers steal from.
+//
+// Waiting on a counter never blocks a thread: it runs other jobs until the counter is done. Jobs
+// that need the GL context are queued with RunOnMainThread and run by the thread that owns the
+// context when it calls ExecuteMainThreadJobs or waits. Without workers every job runs in Wait.
+class JobSystem {
+public:
+	// Statistics since the last ResetStatistics
+	std::atomic<unsigned long long> jobsExecuted{0};
+	std::atomic<unsigned long long> jobsStolen{0};
+
+	JobSystem();
+	~JobSystem();
+
+	// Starts 'workerCount' workers (0 = one per hardware thread besides the calling one). The calling
+	// thread becomes the main thread, which runs the RunOnMainThread jobs. Restarting is allowed.
+	void Start(unsigned int workerCount = 0);
+	void Stop();
+	unsigned int WorkerCount() const {
+		return (unsigned int) workers.size();
+	}
+
+	// Queues a job. 'counter' (optional) tracks it; with 'dependency' it only starts once that counter is done.
+	void Run(std::function<void()> function, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+	// Makes the calling thread the main thread, e.g. when the GL context moves to the render thread
+	void SetMainThread();
+	// Queues a job that must run on the main thread (GL work)
+	void RunOnMainThread(std::function<void()> function, JobCounter* counter = nullptr);
+	// Runs the queued main-thread jobs, call from the main thread. Returns how many ran.
+	unsigned int ExecuteMainThreadJobs();
+	// Runs jobs until 'counter' is done
+	void Wait(JobCounter& counter);
+
+	// Calls function(begin, end) over [0, count) in chunks of about 'grainSize' and waits for all of them
+	void ParallelFor(unsigned int count, unsigned int grainSize, const std::function<void(unsigned int, unsigned int)>& function);
+
+	void ResetStatistics();
+
+private:
+	struct Job {
+		std::function<void()> function;
+		JobCounter* counter;
+	};
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	// One queue per worker, then the shared queue of the other threads
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> workers;
+	Queue mainThreadQueue;
+	std::atomic<std::thread::id> mainThread;
+
+	// Jobs in any queue, and workers sleeping until it is non-zero
+	std::atomic<int> queuedJobs{0};
+	std::atomic<int> sleepingWorkers{0};
+	std::atomic<bool> stopping{false};
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+
+	void workerLoop(unsigned int index);
+	// Index of the calling thread's queue
+	unsigned int queueIndex() const;
+	void push(Job job);
+	// Pops from the caller's own queue, else steals from the others
+	bool takeJob(unsigned int ownQueue, Job& job);
+	void execute(Job& job);
+	void finish(JobCounter* counter);
+};
+
+// Engine-wide scheduler, started by Main and the benchmarks
+extern JobSystem jobSystem;
+#endif
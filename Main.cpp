@@ -1,283 +1,1187 @@
-﻿#include "Model.h" // Assumes Model.h includes necessary headers like Camera.h, Shader.h, glad, glfw, glm, stb_image, etc.
-
-// Window dimensions
-const unsigned int width = 1366;
-const unsigned int height = 768;
-
-// It's good practice to declare stb_image implementation in one .cpp file (e.g., main.cpp or a dedicated .cpp)
-// If it's not already in Model.cpp or another included file.
-// #define STB_IMAGE_IMPLEMENTATION // Only if not defined elsewhere
-// #include "stb_image.h" // Make sure this is included if Texture.cpp or Model.cpp doesn't handle it globally
-
-void checkGLError(const char* operation) {
-    GLenum err;
-    while ((err = glGetError()) != GL_NO_ERROR) {
-        std::cout << "OpenGL error " << err << " during " << operation << std::endl;
-    }
-}
-
-int main() {
-    // At the top of your file, after the includes
-    float lastFrame = 0.0f; // Time of last frame
-    float rotationAngle = 0.0f; // Current rotation angle
-
-    // Initialize GLFW
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-
-    GLFWwindow* window = glfwCreateWindow(width, height, "OpenGL Project - Imported Model", NULL, NULL);
-    if (window == NULL) {
-        std::cout << "Failed to create GLFW window" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-    glfwMakeContextCurrent(window);
-
-    // Load GLAD
-    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
-    glViewport(0, 0, width, height);
-
-    // Load Shader
-    Shader shaderProgram("default.vert", "default.frag"); // Ensure these shader files exist and are correct
-
-    Camera camera(width, height, glm::vec3(7.0f, 1.7f, 7.0f)); // Start in an open area
-    camera.Position = glm::vec3(7.0f, 1.7f, 7.0f); // Typical human eye height
-    camera.Orientation = glm::vec3(-1.0f, 0.0f, -1.0f); // Looking toward the scene
-    
-    // First, adjust the transformation matrices to position the models properly
-    glm::mat4 buildingModelMatrix = glm::mat4(1.0f);
-	// = glm::scale(buildingModelMatrix, glm::vec3(10.0f)); // Scale the building model
-
-    glm::mat4 dogModelMatrix = glm::mat4(1.0f);
-    dogModelMatrix = glm::translate(dogModelMatrix, glm::vec3(3.0f, 0.0f, 2.0f));
-    dogModelMatrix = glm::rotate(dogModelMatrix, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-    dogModelMatrix = glm::scale(dogModelMatrix, glm::vec3(0.5f));
-
-    glm::mat4 dogModelMatrix2 = glm::mat4(1.0f);
-    dogModelMatrix2 = glm::translate(dogModelMatrix2, glm::vec3(4.0f, 0.0f, 1.0f));
-    dogModelMatrix2 = glm::rotate(dogModelMatrix2, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-    dogModelMatrix2 = glm::scale(dogModelMatrix2, glm::vec3(1.3f));
-    
-    glm::mat4 dogModelMatrix3 = glm::mat4(1.0f);
-    dogModelMatrix3 = glm::translate(dogModelMatrix3, glm::vec3(1.0f, 0.0f, 3.0f));
-    dogModelMatrix3 = glm::rotate(dogModelMatrix3, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-    dogModelMatrix3 = glm::scale(dogModelMatrix3, glm::vec3(2.0f));
-
-    glm::mat4 dogModelMatrix4 = glm::mat4(1.0f);
-    dogModelMatrix4 = glm::translate(dogModelMatrix4, glm::vec3(0.0f, 0.0f, 3.0f));
-    dogModelMatrix4 = glm::rotate(dogModelMatrix4, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-    
-
-    glm::mat4 maleHumanMatrix = glm::mat4(1.0f);
-    maleHumanMatrix = glm::translate(maleHumanMatrix, glm::vec3(2.5f, 0.0f, 0.0f));
-    //maleHumanMatrix = glm::rotate(maleHumanMatrix, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-    //maleHumanMatrix = glm::rotate(maleHumanMatrix, glm::radians(-90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
-
-    glm::mat4 femaleHumanMatrix = glm::mat4(1.0f);
-    femaleHumanMatrix = glm::translate(femaleHumanMatrix, glm::vec3(1.0f, 0.0f, -2.0f));
-
-    // Load models
-	Model model_building("models/building/scene.gltf"); // building model
-	Model model_female_human("models/female_human/scene.gltf"); // female human model
-	Model model_male_human("models/male_human/scene.gltf"); // male human model
-	Model model_dog("models/dog/scene.gltf"); // dog model
-
-    // Register models for collision detection
-    // After loading models in Main.cpp:
-    model_building.CalculateBoundingBox();
-    model_female_human.CalculateBoundingBox();
-    model_male_human.CalculateBoundingBox();
-    model_dog.CalculateBoundingBox();
-
-    // Register model instances with their transforms
-    camera.AddModelInstance(&model_building, buildingModelMatrix);
-    camera.AddModelInstance(&model_female_human, femaleHumanMatrix);
-    camera.AddModelInstance(&model_male_human, maleHumanMatrix);
-    camera.AddModelInstance(&model_dog, dogModelMatrix);
-    camera.AddModelInstance(&model_dog, dogModelMatrix2);
-    camera.AddModelInstance(&model_dog, dogModelMatrix3);
-    camera.AddModelInstance(&model_dog, dogModelMatrix4);
-    
-    // Then register the models for collision (as you already do)
-    camera.AddCollidableModel(&model_building);
-    camera.AddCollidableModel(&model_female_human);
-    camera.AddCollidableModel(&model_male_human);
-    camera.AddCollidableModel(&model_dog);
-
-    // Light settings
-    glm::vec4 lightColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f); // White light
-    //glm::vec3 dirLightDir = glm::normalize(glm::vec3(0.5f, -1.0f, -0.5f)); // Adjusted for better visibility
-    glm::vec3 dirLightDir = glm::normalize(glm::vec3(0.0f, -1.0f, 0.0f)); // Straight down light
-    glm::vec3 pointLightPos = glm::vec3(0.0f, 2.0f, 2.0f); // Adjusted point light position
-    // spotLightPos and spotLightDir will be updated in the loop based on camera
-
-    std::vector<glm::vec3> roomLightPositions = {
-        glm::vec3(0.0f, 2.5f, 0.0f),   // Center room
-        glm::vec3(5.0f, 2.5f, 0.0f),   // Right room
-        glm::vec3(-5.0f, 2.5f, 0.0f),  // Left room
-        glm::vec3(0.0f, 2.5f, 5.0f),   // Back room
-        glm::vec3(0.0f, 2.5f, -5.0f)   // Front room
-    };
-
-	glfwSwapInterval(0); // Disable vsync for maximum FPS (optional, can be set to 1 for vsync)
-    unsigned int fps = 0; // Frame counter for FPS calculation
-    double lastTime = glfwGetTime();
-    int nbFrames = 0;
-
-    glDisable(GL_CULL_FACE);
-    glFrontFace(GL_CW); // or GL_CCW, depending on your model
-    // Enable depth testing
-    glEnable(GL_DEPTH_TEST);
-
-    // Main loop
-    while (!glfwWindowShouldClose(window)) {
-
-        float currentFrame = glfwGetTime(); // Get current time
-        float deltaTime = currentFrame - lastFrame; // Calculate time since last frame
-        lastFrame = currentFrame;
-		
-
-        float rotationSpeed = 0.0005f; // Adjust this value for faster/slower rotation
-        rotationAngle += rotationSpeed * deltaTime;
-
-        if (rotationAngle > 2.0f * glm::pi<float>()) {
-            rotationAngle -= 2.0f * glm::pi<float>();
-        }
-        /*
-        static float testTimer = 0.0f;
-        testTimer += deltaTime;
-        if (testTimer > 5.0f) { // Test every 5 seconds
-            testTimer = 0.0f;
-            
-        }
-        */
-        // Inside the main loop, add occasional tests :
-        //camera.TestDirectCollision(camera.Position);
-
-        // Inside your rendering loop, before drawing the models:
-
-        // Update the third dog's transformation matrix for animation
-        // Position the third dog
-        // Apply continuous rotation around the Y axis
-        dogModelMatrix3 = glm::rotate(dogModelMatrix3, rotationAngle, glm::vec3(0.0f, 0.0f, 1.0f));
-
-
-        // Input
-        camera.Inputs(window); // Handles keyboard and mouse input for camera
-
-        // Update camera matrix
-        camera.updateMatrix(camera.fov, 0.1f, 100.0f);
-
-
-
-        // Render
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // Activate shader program
-        shaderProgram.Activate();
-        checkGLError("shader activation");
-
-        // Instead of individual uniforms:
-        glUniform1f(glGetUniformLocation(shaderProgram.ID, "material.shininess"), 32.0f);
-        glUniform1f(glGetUniformLocation(shaderProgram.ID, "material.specularStrength"), 0.5f);
-        glUniform1f(glGetUniformLocation(shaderProgram.ID, "material.diffuseStrength"), 1.0f);
-        glUniform1f(glGetUniformLocation(shaderProgram.ID, "material.ambientStrength"), 0.2f);
-        glUniform1f(glGetUniformLocation(shaderProgram.ID, "material.textureBlendFactor"), 0.0f);
-
-        // And for the texture samplers:
-        glUniform1i(glGetUniformLocation(shaderProgram.ID, "material.diffuse0"), 0);
-        glUniform1i(glGetUniformLocation(shaderProgram.ID, "material.diffuse1"), 1);
-        glUniform1i(glGetUniformLocation(shaderProgram.ID, "material.specularMap"), 2);
-
-		checkGLError("set shader uniforms");
-
-
-        // Set Light uniforms
-        glUniform4fv(glGetUniformLocation(shaderProgram.ID, "lightColor"), 1, glm::value_ptr(lightColor));
-        glUniform3fv(glGetUniformLocation(shaderProgram.ID, "viewPos"), 1, glm::value_ptr(camera.Position)); // Shader might use viewPos or camPos
-		checkGLError("set light uniforms");
-
-        glUniform3fv(glGetUniformLocation(shaderProgram.ID, "dirLight.ambient"), 1, glm::value_ptr(glm::vec3(0.3f)));
-        glUniform3fv(glGetUniformLocation(shaderProgram.ID, "dirLight.diffuse"), 1, glm::value_ptr(glm::vec3(1.0f)));
-
-
-        // Directional light
-        glUniform3fv(glGetUniformLocation(shaderProgram.ID, "dirLight.direction"), 1, glm::value_ptr(dirLightDir));
-        glUniform3fv(glGetUniformLocation(shaderProgram.ID, "dirLight.specular"), 1, glm::value_ptr(glm::vec3(0.5f))); // Moderate specular
-		checkGLError("set directional light uniforms");
-
-        // Set up multiple point lights for interior
-        for (int i = 0; i < std::min(3, (int) roomLightPositions.size()); i++) { // Support at least 3 lights
-            std::string uniformName = "pointLights[" + std::to_string(i) + "].";
-
-            glUniform3fv(glGetUniformLocation(shaderProgram.ID, (uniformName + "position").c_str()),
-                         1, glm::value_ptr(roomLightPositions[i]));
-            glUniform3fv(glGetUniformLocation(shaderProgram.ID, (uniformName + "ambient").c_str()),
-                         1, glm::value_ptr(glm::vec3(0.05f)));
-            glUniform3fv(glGetUniformLocation(shaderProgram.ID, (uniformName + "diffuse").c_str()),
-                         1, glm::value_ptr(glm::vec3(0.8f)));
-            glUniform3fv(glGetUniformLocation(shaderProgram.ID, (uniformName + "specular").c_str()),
-                         1, glm::value_ptr(glm::vec3(1.0f)));
-            glUniform1f(glGetUniformLocation(shaderProgram.ID, (uniformName + "constant").c_str()), 1.0f);
-            glUniform1f(glGetUniformLocation(shaderProgram.ID, (uniformName + "linear").c_str()), 0.09f);
-            glUniform1f(glGetUniformLocation(shaderProgram.ID, (uniformName + "quadratic").c_str()), 0.032f);
-        }
-		checkGLError("set point light uniforms");
-
-        // SpotLight (camera-based)
-        glUniform3fv(glGetUniformLocation(shaderProgram.ID, "spotLight.position"), 1, glm::value_ptr(camera.Position));
-        glUniform3fv(glGetUniformLocation(shaderProgram.ID, "spotLight.direction"), 1, glm::value_ptr(camera.Orientation));
-        glUniform3fv(glGetUniformLocation(shaderProgram.ID, "spotLight.ambient"), 1, glm::value_ptr(glm::vec3(0.0f)));
-        glUniform3fv(glGetUniformLocation(shaderProgram.ID, "spotLight.diffuse"), 1, glm::value_ptr(glm::vec3(1.0f)));
-        glUniform3fv(glGetUniformLocation(shaderProgram.ID, "spotLight.specular"), 1, glm::value_ptr(glm::vec3(1.0f)));
-        glUniform1f(glGetUniformLocation(shaderProgram.ID, "spotLight.constant"), 1.0f);
-        glUniform1f(glGetUniformLocation(shaderProgram.ID, "spotLight.linear"), 0.09f);
-        glUniform1f(glGetUniformLocation(shaderProgram.ID, "spotLight.quadratic"), 0.032f);
-        glUniform1f(glGetUniformLocation(shaderProgram.ID, "spotLight.cutOff"), glm::cos(glm::radians(12.5f)));
-        glUniform1f(glGetUniformLocation(shaderProgram.ID, "spotLight.outerCutOff"), glm::cos(glm::radians(15.0f))); // Slightly wider outer
-		checkGLError("set spot light uniforms");
-
-        model_building.Draw(shaderProgram, camera, buildingModelMatrix);// Building uses identity matrix
-        model_dog.Draw(shaderProgram, camera, dogModelMatrix); // Pass dog's matrix
-		model_dog.Draw(shaderProgram, camera, dogModelMatrix2); // Pass second dog's matrix
-		model_dog.Draw(shaderProgram, camera, dogModelMatrix3); // Pass third dog's matrix
-		model_dog.Draw(shaderProgram, camera, dogModelMatrix4); // Pass fourth dog's matrix
-
-        model_female_human.Draw(shaderProgram, camera, femaleHumanMatrix); // Pass female's matrix  
-        model_male_human.Draw(shaderProgram, camera, maleHumanMatrix); // Pass male's matrix
-
-        checkGLError("draw call");
-
-        GLenum err;
-        while ((err = glGetError()) != GL_NO_ERROR) {
-            std::cout << "OpenGL error: " << err << std::endl;
-        }
-
-		nbFrames++;
-		// Calculate and print FPS every second
-		if (currentFrame - lastTime >= 1.0) { // If a second has passed
-			char title[256];
-			snprintf(title, sizeof(title), "OpenGL Project - Imported Model - FPS: %d", nbFrames);
-			glfwSetWindowTitle(window, title);
-			nbFrames = 0; // Reset frame count
-			lastTime += 1.0; // Increment last time by 1 second
-		}
-
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-    }
-
-    // Cleanup
-    // Model's resources (VAOs, VBOs, Textures) should be deleted
-    shaderProgram.Delete(); // Shader class should have a destructor or Delete method
-    glfwDestroyWindow(window);
-    glfwTerminate();
-    return 0;
+﻿#include "Model.h" // Assumes Model.h includes necessary headers like Camera.h, Shader.h, glad, glfw, glm, stb_image, etc.
+#include "Benchmarks.h"
+#include "PortalSystem.h"
+#include "ClusteredLights.h"
+#include "DeferredRenderer.h"
+#include "VisibilityBuffer.h"
+#include "DepthPrePass.h"
+#include "DynamicResolution.h"
+#include "StreamBuffer.h"
+#include "FramePipeline.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "RenderThread.h"
+#include "ShaderVariants.h"
+#include "ProgramCache.h"
+#include "ShaderCompiler.h"
+#include "ShaderWatcher.h"
+#include "HeadlessContext.h"
+#include "CameraPath.h"
+#include "SceneBenchmark.h"
+#include "WindowInput.h"
+#include "InputRecorder.h"
+#include "InputReplay.h"
+#include "SceneGenerator.h"
+#include "GLDebug.h"
+#include "TextureTable.h"
+#include "MaterialTable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+
+// Window dimensions
+const unsigned int width = 1366;
+const unsigned int height = 768;
+
+// It's good practice to declare stb_image implementation in one .cpp file (e.g., main.cpp or a dedicated .cpp)
+// If it's not already in Model.cpp or another included file.
+// #define STB_IMAGE_IMPLEMENTATION // Only if not defined elsewhere
+// #include "stb_image.h" // Make sure this is included if Texture.cpp or Model.cpp doesn't handle it globally
+
+int main(int argc, char** argv) {
+    // Run the CPU benchmarks instead of the application when asked to
+    if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+        return RunBenchmarks(argc, argv);
+    }
+    // Or write a synthetic scene (see SceneGenerator) and exit
+    if (argc > 1 && std::string(argv[1]) == "--generate-scene") {
+        return RunSceneGenerator(argc, argv);
+    }
+    // Rendering runs on its own thread unless asked not to (to compare against the serial loop).
+    // --target-ms sets the GPU frame time dynamic resolution holds.
+    // --profile [frames] captures loading and the first frames (300 by default) and writes the results.
+    // --bench [path.json] flies a camera path without a window and reports frame time percentiles
+    // (see SceneBenchmark), with --frames and --warmup per run and --report for the JSON file.
+    // Without a path file the camera orbits the scene. --record-path file saves the camera's path
+    // while flying around, to replay it with --bench.
+    // --record-input file logs every frame of input, --replay-input file plays such a log back
+    // instead of the keyboard and mouse (and ends the session with it).
+    // --scene file.gltf|file.glb adds a scene (e.g. from --generate-scene) next to the built-in models.
+    // --gl-debug asks for a debug context (the default in debug builds), --gl-debug-sync also makes
+    // the driver report from inside the failing call (see GLDebug).
+    // --texture-arrays keeps material textures in texture arrays even when bindless handles are
+    // available (see TextureTable).
+    auto loadStart = std::chrono::high_resolution_clock::now();
+    bool threadedRendering = true;
+    double targetFrameMilliseconds = 16.0;
+    unsigned int profileFrames = 0;
+    bool benchmarking = false;
+    const char* benchPathFile = NULL;
+    const char* benchReportFile = "bench_report.json";
+    unsigned int benchFrames = 300;
+    unsigned int benchWarmupFrames = 30;
+    const char* recordPathFile = NULL;
+    const char* recordInputFile = NULL;
+    const char* replayInputFile = NULL;
+    const char* sceneFile = NULL;
+#if defined(NDEBUG)
+    bool debugContext = false;
+#else
+    bool debugContext = true;
+#endif
+    bool debugSynchronous = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--single-thread")
+            threadedRendering = false;
+        else if (std::string(argv[i]) == "--target-ms" && i + 1 < argc)
+            targetFrameMilliseconds = std::atof(argv[++i]);
+        else if (std::string(argv[i]) == "--profile") {
+            profileFrames = 300;
+            if (i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+                profileFrames = (unsigned int) std::atoi(argv[++i]);
+        }
+        else if (std::string(argv[i]) == "--bench") {
+            benchmarking = true;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0)
+                benchPathFile = argv[++i];
+        }
+        else if (std::string(argv[i]) == "--frames" && i + 1 < argc)
+            benchFrames = (unsigned int) std::max(std::atoi(argv[++i]), 1);
+        else if (std::string(argv[i]) == "--warmup" && i + 1 < argc)
+            benchWarmupFrames = (unsigned int) std::max(std::atoi(argv[++i]), 0);
+        else if (std::string(argv[i]) == "--report" && i + 1 < argc)
+            benchReportFile = argv[++i];
+        else if (std::string(argv[i]) == "--record-path" && i + 1 < argc)
+            recordPathFile = argv[++i];
+        else if (std::string(argv[i]) == "--record-input" && i + 1 < argc)
+            recordInputFile = argv[++i];
+        else if (std::string(argv[i]) == "--replay-input" && i + 1 < argc)
+            replayInputFile = argv[++i];
+        else if (std::string(argv[i]) == "--scene" && i + 1 < argc)
+            sceneFile = argv[++i];
+        else if (std::string(argv[i]) == "--gl-debug")
+            debugContext = true;
+        else if (std::string(argv[i]) == "--gl-debug-sync")
+            debugContext = debugSynchronous = true;
+        else if (std::string(argv[i]) == "--texture-arrays")
+            textureTable.allowHandles = false;
+    }
+    profiler.SetThreadName("Main");
+    if (profileFrames > 0)
+        profiler.StartCapture();
+    // Workers for loading, culling and collision, on the hardware threads left next to this one
+    jobSystem.Start();
+    std::cout << "Job system: " << jobSystem.WorkerCount() << " workers" << std::endl;
+
+    // At the top of your file, after the includes
+    float lastFrame = 0.0f; // Time of last frame
+    float rotationAngle = 0.0f; // Current rotation angle
+
+    // The benchmark runs without a window (and without GLFW, which needs a display): its context
+    // comes from EGL and renders into a window-sized offscreen framebuffer
+    GLFWwindow* window = NULL;
+    HeadlessContext headlessContext;
+    GLADloadproc loadProc = (GLADloadproc) glfwGetProcAddress;
+    if (benchmarking) {
+        headlessContext.debug = debugContext;
+        if (!headlessContext.Create(4, 3) && !headlessContext.Create(3, 3)) {
+            std::cout << "Failed to create a headless OpenGL context" << std::endl;
+            return -1;
+        }
+        headlessContext.MakeCurrent();
+        loadProc = (GLADloadproc) HeadlessContext::GetProcAddress;
+    } else {
+        // Initialize GLFW
+        glfwInit();
+        // Ask for 4.3 so the GPU culling path is available, fall back to 3.3 otherwise
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, debugContext ? GLFW_TRUE : GLFW_FALSE);
+
+        window = glfwCreateWindow(width, height, "OpenGL Project - Imported Model", NULL, NULL);
+        if (window == NULL) {
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+            window = glfwCreateWindow(width, height, "OpenGL Project - Imported Model", NULL, NULL);
+        }
+        if (window == NULL) {
+            std::cout << "Failed to create GLFW window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        glfwMakeContextCurrent(window);
+    }
+
+    // Load GLAD
+    if (!gladLoadGLLoader(loadProc)) {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        if (window != NULL)
+            glfwTerminate();
+        headlessContext.Destroy();
+        return -1;
+    }
+    LoadGLExtensions(loadProc);
+    // Driver errors and warnings arrive through the debug callback and are printed by the update loop
+    glDebug.Start(debugSynchronous);
+    if (benchmarking)
+        headlessContext.CreateFramebuffer(width, height);
+    // Seconds since startup, from GLFW's clock when it is there
+    auto startTime = std::chrono::steady_clock::now();
+    auto clockSeconds = [window, startTime]() -> double {
+        if (window != NULL)
+            return glfwGetTime();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    };
+    // The context moves between threads, through GLFW or EGL
+    auto makeContextCurrent = [window, &headlessContext]() {
+        if (window != NULL)
+            glfwMakeContextCurrent(window);
+        else
+            headlessContext.MakeCurrent();
+    };
+    auto releaseContext = [window, &headlessContext]() {
+        if (window != NULL)
+            glfwMakeContextCurrent(NULL);
+        else
+            headlessContext.Release();
+    };
+    // Linked programs from earlier runs, so only new or changed shaders are compiled
+    programCache.Open("shader_cache.bin");
+    // Shader variants build in the background: in driver threads with the parallel compile extension,
+    // otherwise on a thread with a hidden window (or headless context) whose context shares objects with this one
+    GLFWwindow* compileWindow = NULL;
+    HeadlessContext compileContext;
+    bool compileContextCreated = false;
+    if (!glFeatures.parallelShaderCompile) {
+        if (window != NULL) {
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+            compileWindow = glfwCreateWindow(1, 1, "Shader compiler", NULL, window);
+            glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+        } else {
+            compileContextCreated = compileContext.Create(4, 3, &headlessContext) || compileContext.Create(3, 3, &headlessContext);
+        }
+    }
+    if (compileWindow != NULL)
+        shaderCompiler.Start([compileWindow]() { glfwMakeContextCurrent(compileWindow); });
+    else if (compileContextCreated)
+        shaderCompiler.Start([&compileContext]() { compileContext.MakeCurrent(); });
+    else
+        shaderCompiler.Start(nullptr);
+    // Saved shader files are rebuilt while running
+    ShaderWatcher shaderWatcher;
+    shaderWatcher.Watch(".");
+    glViewport(0, 0, width, height);
+
+    // Load Shader, the forward shader is compiled per feature set on first use. The usual scene
+    // variant is built up front and draws in place of the others until they are ready.
+    // Every variant samples the material textures the way textureTable stores them.
+    const unsigned int textureFeatures = textureTable.UsesHandles() ? (unsigned int) SHADER_TEXTURE_HANDLES : 0u;
+    ShaderVariants forwardShaders("default.vert", "default.frag", SHADER_SPOT_LIGHT | SHADER_POINT_LIGHTS | textureFeatures);
+
+    Camera camera(width, height, glm::vec3(7.0f, 1.7f, 7.0f)); // Start in an open area
+    camera.Position = glm::vec3(7.0f, 1.7f, 7.0f); // Typical human eye height
+    camera.Orientation = glm::vec3(-1.0f, 0.0f, -1.0f); // Looking toward the scene
+    
+    // First, adjust the transformation matrices to position the models properly
+    glm::mat4 buildingModelMatrix = glm::mat4(1.0f);
+	// = glm::scale(buildingModelMatrix, glm::vec3(10.0f)); // Scale the building model
+
+    glm::mat4 dogModelMatrix = glm::mat4(1.0f);
+    dogModelMatrix = glm::translate(dogModelMatrix, glm::vec3(3.0f, 0.0f, 2.0f));
+    dogModelMatrix = glm::rotate(dogModelMatrix, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+    dogModelMatrix = glm::scale(dogModelMatrix, glm::vec3(0.5f));
+
+    glm::mat4 dogModelMatrix2 = glm::mat4(1.0f);
+    dogModelMatrix2 = glm::translate(dogModelMatrix2, glm::vec3(4.0f, 0.0f, 1.0f));
+    dogModelMatrix2 = glm::rotate(dogModelMatrix2, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+    dogModelMatrix2 = glm::scale(dogModelMatrix2, glm::vec3(1.3f));
+    
+    glm::mat4 dogModelMatrix3 = glm::mat4(1.0f);
+    dogModelMatrix3 = glm::translate(dogModelMatrix3, glm::vec3(1.0f, 0.0f, 3.0f));
+    dogModelMatrix3 = glm::rotate(dogModelMatrix3, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+    dogModelMatrix3 = glm::scale(dogModelMatrix3, glm::vec3(2.0f));
+
+    glm::mat4 dogModelMatrix4 = glm::mat4(1.0f);
+    dogModelMatrix4 = glm::translate(dogModelMatrix4, glm::vec3(0.0f, 0.0f, 3.0f));
+    dogModelMatrix4 = glm::rotate(dogModelMatrix4, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+    
+
+    glm::mat4 maleHumanMatrix = glm::mat4(1.0f);
+    maleHumanMatrix = glm::translate(maleHumanMatrix, glm::vec3(2.5f, 0.0f, 0.0f));
+    //maleHumanMatrix = glm::rotate(maleHumanMatrix, glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f));
+    //maleHumanMatrix = glm::rotate(maleHumanMatrix, glm::radians(-90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+
+    glm::mat4 femaleHumanMatrix = glm::mat4(1.0f);
+    femaleHumanMatrix = glm::translate(femaleHumanMatrix, glm::vec3(1.0f, 0.0f, -2.0f));
+
+    // Load models
+	Model model_building("models/building/scene.gltf"); // building model
+	Model model_female_human("models/female_human/scene.gltf"); // female human model
+	Model model_male_human("models/male_human/scene.gltf"); // male human model
+	Model model_dog("models/dog/scene.gltf"); // dog model
+    // Extra scene at the origin, for scaling tests
+    std::unique_ptr<Model> model_scene;
+    glm::mat4 sceneModelMatrix = glm::mat4(1.0f);
+    if (sceneFile != NULL)
+        model_scene.reset(new Model(sceneFile));
+    // The meshes have added their textures and materials, draws no longer bind them one by one
+    textureTable.Build();
+    textureTable.PrintSummary();
+    materialTable.Upload();
+    std::cout << "Material table: " << materialTable.Count() << " materials" << std::endl;
+
+    // Register models for collision detection
+    // After loading models in Main.cpp:
+    model_building.CalculateBoundingBox();
+    model_female_human.CalculateBoundingBox();
+    model_male_human.CalculateBoundingBox();
+    model_dog.CalculateBoundingBox();
+    if (model_scene)
+        model_scene->CalculateBoundingBox();
+
+    // Then register the models for collision (as you already do)
+    camera.AddCollidableModel(&model_building);
+    camera.AddCollidableModel(&model_female_human);
+    camera.AddCollidableModel(&model_male_human);
+    camera.AddCollidableModel(&model_dog);
+    if (model_scene)
+        camera.AddCollidableModel(model_scene.get());
+
+    // Everything drawn each frame, pointing at the matrices so animated ones stay current
+    struct SceneDraw {
+        Model* model;
+        glm::mat4* matrix;
+    };
+    std::vector<SceneDraw> sceneDraws = {
+        {&model_building, &buildingModelMatrix},
+        {&model_dog, &dogModelMatrix},
+        {&model_dog, &dogModelMatrix2},
+        {&model_dog, &dogModelMatrix3},
+        {&model_dog, &dogModelMatrix4},
+        {&model_female_human, &femaleHumanMatrix},
+        {&model_male_human, &maleHumanMatrix}
+    };
+    if (model_scene)
+        sceneDraws.push_back({model_scene.get(), &sceneModelMatrix});
+
+    // Register model instances with their transforms, in the same order as sceneDraws
+    // so an instance index from the camera's BVH is also an index into sceneDraws
+    for (const SceneDraw& draw : sceneDraws) {
+        camera.AddModelInstance(draw.model, *draw.matrix);
+    }
+    camera.BuildInstanceBVH();
+    std::vector<unsigned int> visibleInstances;
+
+    // Per-draw transforms are streamed through a triple-buffered ring, sized for every mesh
+    // being drawn twice a frame (depth pre-pass and color pass)
+    unsigned int sceneMeshCount = 0;
+    for (const SceneDraw& draw : sceneDraws)
+        sceneMeshCount += (unsigned int) draw.model->GetMeshes().size();
+    drawStream.Create(GL_UNIFORM_BUFFER, std::max<GLsizeiptr>(64 * 1024, sceneMeshCount * 2 * 256));
+    glDebug.Label(GL_BUFFER, drawStream.ID, "Draw data stream");
+
+    // Per-mesh transforms, culling and the sorted draw list are built in parallel on the job system.
+    // Its culler does the frustum culling and also drops meshes smaller than a couple of pixels.
+    FramePipeline framePipeline;
+    FrustumCuller& frustumCuller = framePipeline.culler;
+    frustumCuller.minProjectedSize = 2.0f;
+    // Same order as sceneDraws, instances of one model share an id so their draws sort together
+    std::vector<FramePipeline::Instance> pipelineInstances;
+    std::vector<Model*> pipelineModels;
+    for (const SceneDraw& draw : sceneDraws) {
+        unsigned int modelId = (unsigned int) (std::find(pipelineModels.begin(), pipelineModels.end(), draw.model) - pipelineModels.begin());
+        if (modelId == pipelineModels.size())
+            pipelineModels.push_back(draw.model);
+        pipelineInstances.push_back({&draw.model->GetMeshSources(), *draw.matrix, modelId});
+    }
+
+    // GPU culling against the previous frame's depth pyramid, toggled with G when the context supports it
+    HiZCuller hiZCuller(width, height);
+    bool gpuCulling = false;
+    bool gpuCullingKeyDown = false;
+
+    // CPU occlusion culling with the large building meshes as occluders, toggled with O.
+    // The occluders are rasterized on worker threads while the camera handles input.
+    OcclusionCuller occlusionCuller;
+    unsigned int occluderCount = model_building.AddOccluders(occlusionCuller, buildingModelMatrix, 3.0f);
+    std::cout << "Occlusion culling: " << occluderCount << " occluder meshes, " << occlusionCuller.WorkerCount()
+        << " worker threads" << std::endl;
+    bool cpuOcclusion = false;
+    bool cpuOcclusionKeyDown = false;
+
+    // Rooms of the building and the portals between them, authored in the glTF extras or in a side file.
+    // Without them nothing is rejected.
+    PortalSystem portalSystem;
+    if (!portalSystem.LoadFromGLTF("models/building/scene.gltf") && !portalSystem.LoadFromFile("models/building/cells.json"))
+        std::cout << "No cells/portals found for the building, portal culling disabled" << std::endl;
+
+    // Light settings
+    glm::vec4 lightColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f); // White light
+    //glm::vec3 dirLightDir = glm::normalize(glm::vec3(0.5f, -1.0f, -0.5f)); // Adjusted for better visibility
+    glm::vec3 dirLightDir = glm::normalize(glm::vec3(0.0f, -1.0f, 0.0f)); // Straight down light
+    glm::vec3 pointLightPos = glm::vec3(0.0f, 2.0f, 2.0f); // Adjusted point light position
+    // spotLightPos and spotLightDir will be updated in the loop based on camera
+
+    std::vector<glm::vec3> roomLightPositions = {
+        glm::vec3(0.0f, 2.5f, 0.0f),   // Center room
+        glm::vec3(5.0f, 2.5f, 0.0f),   // Right room
+        glm::vec3(-5.0f, 2.5f, 0.0f),  // Left room
+        glm::vec3(0.0f, 2.5f, 5.0f),   // Back room
+        glm::vec3(0.0f, 2.5f, -5.0f)   // Front room
+    };
+    std::vector<glm::vec3> visibleRoomLights;
+
+    // Clustered point lights. L cycles through sets of random test lights to measure frame time against light count.
+    ClusteredLights clusteredLights;
+    std::vector<ClusteredLights::Light> testLights;
+    std::mt19937 lightRng(1234);
+    std::uniform_real_distribution<float> unitRandom(0.0f, 1.0f);
+    for (int i = 0; i < 1024; i++) {
+        ClusteredLights::Light light;
+        light.position = glm::vec3(unitRandom(lightRng) * 20.0f - 10.0f, 0.3f + unitRandom(lightRng) * 2.5f, unitRandom(lightRng) * 20.0f - 10.0f);
+        light.radius = 1.5f + unitRandom(lightRng) * 2.0f;
+        light.color = glm::vec3(unitRandom(lightRng), unitRandom(lightRng), unitRandom(lightRng));
+        light.ambient = 0.0f;
+        testLights.push_back(light);
+    }
+    const unsigned int testLightSteps[] = {0, 1, 4, 16, 64, 256, 1024};
+    unsigned int testLightStep = 0;
+    unsigned int testLightCount = 0;
+    bool testLightKeyDown = false;
+
+    // Deferred shading and visibility buffer paths, R cycles through them and the forward shader
+    enum RenderPath { ForwardPath, DeferredPath, VisibilityPath, RenderPathCount };
+    const char* renderPathNames[RenderPathCount] = {"forward", "deferred", "visibility"};
+    DeferredRenderer deferredRenderer(width, height);
+    VisibilityBuffer visibilityBuffer(width, height);
+    RenderPath renderPath = ForwardPath;
+    bool renderPathKeyDown = false;
+
+    // Every path renders offscreen at a scale that holds the target GPU time, then is scaled up to
+    // the window. X switches the scaling off (full resolution, still offscreen).
+    DynamicResolution dynamicResolution(width, height);
+    dynamicResolution.targetMilliseconds = targetFrameMilliseconds;
+    deferredRenderer.outputFramebuffer = dynamicResolution.framebuffer;
+    visibilityBuffer.outputFramebuffer = dynamicResolution.framebuffer;
+    // The window, or the framebuffer standing in for it
+    dynamicResolution.presentFramebuffer = headlessContext.framebuffer;
+    bool dynamicResolutionEnabled = true;
+    bool dynamicResolutionKeyDown = false;
+
+    // P toggles a depth pre-pass in front of the forward color pass
+    DepthPrePass depthPrePass;
+    bool depthPrePassEnabled = false;
+    bool depthPrePassKeyDown = false;
+
+    if (window != NULL)
+        glfwSwapInterval(0); // Disable vsync for maximum FPS (optional, can be set to 1 for vsync)
+    unsigned int fps = 0; // Frame counter for FPS calculation
+    double lastTime = clockSeconds();
+    int nbFrames = 0;
+
+    // F toggles the camera spotlight, V cycles the debug views
+    bool flashlight = true;
+    bool flashlightKeyDown = false;
+    const unsigned int debugViews[] = {0, SHADER_DEBUG_NORMALS, SHADER_DEBUG_TEXCOORDS, SHADER_DEBUG_ALBEDO};
+    unsigned int debugView = 0;
+    bool debugViewKeyDown = false;
+
+    // Render thread state: its own copy of the camera and settings, set from each frame packet
+    Camera renderCamera(width, height, camera.Position);
+    bool renderFlashlight = flashlight;
+    struct RenderStats {
+        HiZCuller::DebugCounters gpuCounters = {0, 0, 0, 0};
+        unsigned int maxLightsPerCluster = 0;
+        GLuint64 colorPassInvocations = 0;
+        GLuint64 prePassInvocations = 0;
+        DynamicResolution::Telemetry resolution = {1.0f, 0, 0, 0.0, 0.0, DynamicResolution::Warmup};
+    };
+
+    // Scalar material terms of the deferred lighting passes. The forward, G-buffer and visibility
+    // resolve shaders read each draw's material from materialTable instead (see bindMaterials).
+    auto setMaterialUniforms = [&](Shader& shader) {
+        PROFILE_ZONE("Uniforms: material");
+        shader.Activate();
+        glUniform1f(glGetUniformLocation(shader.ID, "material.shininess"), 32.0f);
+        glUniform1f(glGetUniformLocation(shader.ID, "material.specularStrength"), 0.5f);
+        glUniform1f(glGetUniformLocation(shader.ID, "material.diffuseStrength"), 1.0f);
+        glUniform1f(glGetUniformLocation(shader.ID, "material.ambientStrength"), 0.2f);
+        glUniform1f(glGetUniformLocation(shader.ID, "material.textureBlendFactor"), 0.0f);
+
+        // And for the texture samplers:
+        glUniform1i(glGetUniformLocation(shader.ID, "material.diffuse0"), 0);
+        glUniform1i(glGetUniformLocation(shader.ID, "material.diffuse1"), 1);
+        glUniform1i(glGetUniformLocation(shader.ID, "material.specularMap"), 2);
+		GL_CHECK_ERRORS("set shader uniforms");
+    };
+    // Texture and material tables, selected by each draw's DrawData::material
+    auto bindMaterials = [&](Shader& shader) {
+        PROFILE_ZONE("Uniforms: material tables");
+        textureTable.Bind(shader);
+        materialTable.Bind(shader);
+		GL_CHECK_ERRORS("bind material tables");
+    };
+    auto setLightUniforms = [&](Shader& shader) {
+        PROFILE_ZONE("Uniforms: lights");
+        shader.Activate();
+        glUniform4fv(glGetUniformLocation(shader.ID, "lightColor"), 1, glm::value_ptr(lightColor));
+        glUniform3fv(glGetUniformLocation(shader.ID, "viewPos"), 1, glm::value_ptr(renderCamera.Position)); // Shader might use viewPos or camPos
+
+        // Directional light
+        glUniform3fv(glGetUniformLocation(shader.ID, "dirLight.ambient"), 1, glm::value_ptr(glm::vec3(0.3f)));
+        glUniform3fv(glGetUniformLocation(shader.ID, "dirLight.diffuse"), 1, glm::value_ptr(glm::vec3(1.0f)));
+        glUniform3fv(glGetUniformLocation(shader.ID, "dirLight.direction"), 1, glm::value_ptr(dirLightDir));
+        glUniform3fv(glGetUniformLocation(shader.ID, "dirLight.specular"), 1, glm::value_ptr(glm::vec3(0.5f))); // Moderate specular
+
+        // SpotLight (camera-based)
+        glUniform3fv(glGetUniformLocation(shader.ID, "spotLight.position"), 1, glm::value_ptr(renderCamera.Position));
+        glUniform3fv(glGetUniformLocation(shader.ID, "spotLight.direction"), 1, glm::value_ptr(renderCamera.Orientation));
+        glUniform3fv(glGetUniformLocation(shader.ID, "spotLight.ambient"), 1, glm::value_ptr(glm::vec3(0.0f)));
+        // Forward variants leave the spotlight out entirely when it is off, the other paths just get a black one
+        glm::vec3 spotColor(renderFlashlight ? 1.0f : 0.0f);
+        glUniform3fv(glGetUniformLocation(shader.ID, "spotLight.diffuse"), 1, glm::value_ptr(spotColor));
+        glUniform3fv(glGetUniformLocation(shader.ID, "spotLight.specular"), 1, glm::value_ptr(spotColor));
+        glUniform1f(glGetUniformLocation(shader.ID, "spotLight.constant"), 1.0f);
+        glUniform1f(glGetUniformLocation(shader.ID, "spotLight.linear"), 0.09f);
+        glUniform1f(glGetUniformLocation(shader.ID, "spotLight.quadratic"), 0.032f);
+        glUniform1f(glGetUniformLocation(shader.ID, "spotLight.cutOff"), glm::cos(glm::radians(12.5f)));
+        glUniform1f(glGetUniformLocation(shader.ID, "spotLight.outerCutOff"), glm::cos(glm::radians(15.0f))); // Slightly wider outer
+		GL_CHECK_ERRORS("set light uniforms");
+    };
+
+    // Each forward variant gets the per-frame uniforms the first time it is used in a frame
+    forwardShaders.frameSetup = [&](Shader& shader) {
+        PROFILE_ZONE("Uniforms: forward frame setup");
+        bindMaterials(shader);
+        setLightUniforms(shader);
+        clusteredLights.Bind(shader, 5, (float) dynamicResolution.renderWidth, (float) dynamicResolution.renderHeight);
+        glUniform1f(glGetUniformLocation(shader.ID, "pointLightLinear"), 0.09f);
+        glUniform1f(glGetUniformLocation(shader.ID, "pointLightQuadratic"), 0.032f);
+        GL_CHECK_ERRORS("set point light uniforms");
+    };
+
+    // glTF winds front faces counter-clockwise; meshes enable back-face culling unless their material is double-sided
+    glDisable(GL_CULL_FACE);
+    glFrontFace(GL_CCW);
+    // Enable depth testing
+    glEnable(GL_DEPTH_TEST);
+
+    // The forward variants are compiled during the first frame, the cache is reported after it
+    bool programCacheReported = false;
+
+    // The render thread owns the GL context from here on. It draws frame packets built by this
+    // thread, which handles input, collision and culling for the next frame meanwhile.
+    std::mutex renderStatsMutex;
+    RenderStats renderStats;
+    std::vector<unsigned int> gpuFirstDraw;
+    bool gpuCullingActive = false;
+    double lastCounterRead = clockSeconds();
+    SceneBenchmark sceneBenchmark;
+    auto renderFrame = [&](const FramePacket& packet) {
+        profiler.BeginGpuFrame();
+        if (packet.benchFrame >= 0) {
+            Mesh::drawCalls = 0;
+            sceneBenchmark.BeginGpuFrame((unsigned int) packet.benchFrame);
+        }
+        PROFILE_GPU_ZONE("Render frame");
+        renderCamera.Position = packet.cameraPosition;
+        renderCamera.Orientation = packet.cameraOrientation;
+        renderCamera.Up = packet.cameraUp;
+        renderCamera.fov = packet.fov;
+        renderCamera.updateMatrix(packet.fov, 0.1f, 100.0f);
+        renderFlashlight = packet.flashlight;
+        jobSystem.ExecuteMainThreadJobs();
+        RenderPath renderPath = (RenderPath) packet.renderPath;
+
+        if (packet.reloadShaders)
+            forwardShaders.Reload();
+
+        // The pyramid is only kept up to date while the GPU path runs
+        if (packet.gpuCulling != gpuCullingActive) {
+            gpuCullingActive = packet.gpuCulling;
+            hiZCuller.hasPyramid = false;
+        }
+
+        // On the GPU path every mesh of the instances the BVH kept is tested again in a compute shader,
+        // which also rejects meshes hidden behind last frame's depth
+        bool gpuCulling = packet.gpuCulling;
+        if (gpuCulling) {
+            PROFILE_GPU_ZONE("HiZ cull");
+            hiZCuller.ClearDraws();
+            gpuFirstDraw.assign(packet.draws.size(), 0);
+            for (unsigned int i = 0; i < packet.draws.size(); i++) {
+                if (packet.draws[i].firstMesh != UINT_MAX)
+                    gpuFirstDraw[i] = packet.draws[i].model->AddGPUCullDraws(hiZCuller, packet.draws[i].matrix);
+            }
+            hiZCuller.Cull(renderCamera.cameraMatrix);
+        }
+        clusteredLights.lights = packet.lights;
+
+        // Render, into the offscreen target at this frame's scale
+        drawStream.BeginFrame();
+        dynamicResolution.enabled = packet.dynamicResolution;
+        dynamicResolution.BeginFrame();
+        deferredRenderer.SetRenderSize(dynamicResolution.renderWidth, dynamicResolution.renderHeight);
+        visibilityBuffer.SetRenderSize(dynamicResolution.renderWidth, dynamicResolution.renderHeight);
+        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // Forward shading lights every fragment while drawing, deferred only fills the G-buffer here
+        // and the visibility buffer only stores which triangle covers each pixel
+        bool deferredShading = renderPath == DeferredPath;
+        bool forwardPrePass = packet.depthPrePass && renderPath == ForwardPath;
+        unsigned int sceneFeatures = packet.sceneFeatures;
+        if (renderPath == VisibilityPath) {
+            visibilityBuffer.BeginRasterPass(renderCamera);
+            bindMaterials(visibilityBuffer.maskedRasterProgram);
+        } else if (deferredShading) {
+            deferredRenderer.BeginGeometryPass();
+            bindMaterials(deferredRenderer.geometryProgram);
+        } else {
+            forwardShaders.BeginFrame();
+        }
+        if (forwardPrePass) {
+            bindMaterials(depthPrePass.program);
+            bindMaterials(depthPrePass.maskedProgram);
+        }
+        // The forward shader and the visibility resolve both read the light clusters
+        if (renderPath != DeferredPath) {
+            PROFILE_ZONE("Light clusters");
+            clusteredLights.Build(renderCamera.GetViewMatrix(), renderCamera.GetProjectionMatrix(), 0.1f, 100.0f);
+            clusteredLights.Upload();
+        }
+        if (renderPath == VisibilityPath) {
+            Shader& resolveShader = visibilityBuffer.resolveProgram;
+            clusteredLights.Bind(resolveShader, 5, (float) dynamicResolution.renderWidth, (float) dynamicResolution.renderHeight);
+            glUniform1f(glGetUniformLocation(resolveShader.ID, "pointLightLinear"), 0.09f);
+            glUniform1f(glGetUniformLocation(resolveShader.ID, "pointLightQuadratic"), 0.032f);
+            GL_CHECK_ERRORS("set point light uniforms");
+        }
+
+        // Draw the meshes that survived culling. The visibility buffer records its draws for the
+        // resolve, so it always uses the CPU culling results.
+        if (renderPath == VisibilityPath) {
+            PROFILE_GPU_ZONE("Visibility raster pass");
+            for (const FramePacket::Draw& draw : packet.draws) {
+                if (draw.firstMesh == UINT_MAX)
+                    continue;
+                draw.model->DrawVisibility(visibilityBuffer, draw.matrix, packet.meshVisible.data() + draw.firstMesh);
+            }
+        } else if (packet.naiveDraw) {
+            // Benchmark baseline: every mesh of every instance in scene order, nothing culled or sorted
+            PROFILE_GPU_ZONE("Color pass");
+            depthPrePass.BeginColorPass();
+            for (const FramePacket::Draw& draw : packet.draws)
+                draw.model->Draw(forwardShaders, sceneFeatures, renderCamera, draw.matrix);
+            depthPrePass.EndColorPass();
+        } else if (gpuCulling) {
+            hiZCuller.BindCommands();
+            if (forwardPrePass) {
+                PROFILE_GPU_ZONE("Depth pre-pass");
+                depthPrePass.BeginPrePass(renderCamera);
+                for (unsigned int i = 0; i < packet.draws.size(); i++) {
+                    if (packet.draws[i].firstMesh != UINT_MAX)
+                        packet.draws[i].model->DrawDepthIndirect(depthPrePass, packet.draws[i].matrix, gpuFirstDraw[i]);
+                }
+                depthPrePass.EndPrePass();
+            }
+            {
+                PROFILE_GPU_ZONE(deferredShading ? "G-buffer pass" : "Color pass");
+                if (!deferredShading)
+                    depthPrePass.BeginColorPass();
+                for (unsigned int i = 0; i < packet.draws.size(); i++) {
+                    const FramePacket::Draw& draw = packet.draws[i];
+                    if (draw.firstMesh == UINT_MAX)
+                        continue;
+                    if (deferredShading)
+                        draw.model->DrawIndirect(deferredRenderer.geometryProgram, renderCamera, draw.matrix, gpuFirstDraw[i]);
+                    else
+                        draw.model->DrawIndirect(forwardShaders, sceneFeatures, renderCamera, draw.matrix, gpuFirstDraw[i]);
+                }
+                if (!deferredShading)
+                    depthPrePass.EndColorPass();
+            }
+            hiZCuller.UnbindCommands();
+        } else {
+            // The sorted draw list groups meshes by shader variant and mesh and draws each group front to back
+            if (forwardPrePass) {
+                PROFILE_GPU_ZONE("Depth pre-pass");
+                depthPrePass.BeginPrePass(renderCamera);
+                for (const FramePipeline::DrawItem& item : packet.drawList)
+                    packet.draws[item.instance].model->DrawMeshDepth(depthPrePass, item.mesh, item.matrix);
+                depthPrePass.EndPrePass();
+            }
+            PROFILE_GPU_ZONE(deferredShading ? "G-buffer pass" : "Color pass");
+            if (!deferredShading)
+                depthPrePass.BeginColorPass();
+            for (const FramePipeline::DrawItem& item : packet.drawList) {
+                Model* model = packet.draws[item.instance].model;
+                if (deferredShading)
+                    model->DrawMesh(deferredRenderer.geometryProgram, renderCamera, item.mesh, item.matrix);
+                else
+                    model->DrawMesh(forwardShaders, sceneFeatures, renderCamera, item.mesh, item.matrix);
+            }
+            if (!deferredShading)
+                depthPrePass.EndColorPass();
+        }
+        // The passes below draw full-screen triangles and light volumes with their own culling
+        Mesh::EndCulling();
+
+        if (renderPath == VisibilityPath) {
+            // Every covered pixel is shaded once, with its surface rebuilt from the mesh buffers
+            PROFILE_GPU_ZONE("Visibility resolve");
+            visibilityBuffer.EndRasterPass();
+            bindMaterials(visibilityBuffer.resolveProgram);
+            setLightUniforms(visibilityBuffer.resolveProgram);
+            glUniformMatrix4fv(glGetUniformLocation(visibilityBuffer.resolveProgram.ID, "view"), 1, GL_FALSE, glm::value_ptr(renderCamera.GetViewMatrix()));
+            visibilityBuffer.Resolve(renderCamera.cameraMatrix, renderCamera.Position);
+        } else if (deferredShading) {
+            // Lighting once per pixel: directional and spot light full-screen, point lights as volumes
+            PROFILE_GPU_ZONE("Deferred lighting");
+            deferredRenderer.EndGeometryPass();
+            setMaterialUniforms(deferredRenderer.lightingProgram);
+            setLightUniforms(deferredRenderer.lightingProgram);
+            deferredRenderer.LightingPass(renderCamera.cameraMatrix, renderCamera.Position);
+            setMaterialUniforms(deferredRenderer.pointLightProgram);
+            deferredRenderer.DrawPointLights(clusteredLights.lights, renderCamera.cameraMatrix, renderCamera.Position, 0.09f, 0.032f);
+        }
+
+        if (gpuCulling) {
+            PROFILE_GPU_ZONE("HiZ depth pyramid");
+            hiZCuller.CaptureDepth(renderCamera.cameraMatrix, dynamicResolution.renderWidth, dynamicResolution.renderHeight);
+        }
+        {
+            PROFILE_GPU_ZONE("Upscale");
+            dynamicResolution.EndFrame();
+        }
+        drawStream.EndFrame();
+
+        GL_CHECK_ERRORS("draw call");
+
+        // Statistics for the window title, which the update thread sets
+        {
+            std::lock_guard<std::mutex> lock(renderStatsMutex);
+            // Reading the counters stalls until the GPU is done, so only do it once a second
+            if (gpuCulling && clockSeconds() - lastCounterRead >= 1.0) {
+                renderStats.gpuCounters = hiZCuller.ReadDebugCounters();
+                lastCounterRead = clockSeconds();
+            }
+            renderStats.maxLightsPerCluster = clusteredLights.maxLightsPerCluster;
+            renderStats.colorPassInvocations = depthPrePass.colorPassInvocations;
+            renderStats.prePassInvocations = depthPrePass.prePassInvocations;
+            renderStats.resolution = dynamicResolution.GetTelemetry();
+        }
+
+        if (packet.benchFrame >= 0)
+            sceneBenchmark.EndGpuFrame((unsigned int) packet.benchFrame, Mesh::drawCalls);
+        {
+            PROFILE_ZONE("Swap buffers");
+            if (window != NULL)
+                glfwSwapBuffers(window);
+            else
+                glFlush();
+        }
+
+        if (!programCacheReported) {
+            programCache.PrintStatistics();
+            programCacheReported = true;
+        }
+    };
+
+    RenderThread renderThread;
+    if (threadedRendering)
+        releaseContext();
+    // The thread holding the context runs the job system's main-thread (GL) jobs
+    renderThread.Start(threadedRendering, [makeContextCurrent]() {
+            makeContextCurrent();
+            jobSystem.SetMainThread();
+            profiler.SetThreadName("Render");
+        }, renderFrame,
+        releaseContext);
+    std::cout << "Rendering on " << (threadedRendering ? "a separate render thread" : "the main thread") << std::endl;
+
+    // C starts and stops a profiler capture; the results are written once the GPU has answered for its last frames
+    bool profileKeyDown = false;
+    bool profileWritePending = false;
+    unsigned int profiledFrames = 0;
+    auto writeProfile = []() {
+        profiler.PrintSummary();
+        if (profiler.WriteChromeTrace("profile_trace.json") && profiler.WriteSummary("profile_summary.csv"))
+            std::cout << "Profiler: wrote profile_trace.json and profile_summary.csv" << std::endl;
+    };
+
+    // Benchmark: the path is flown once with the naive draw path (every mesh through Model::Draw,
+    // no culling or batching) as a baseline, then once with the frame pipeline and the usual
+    // forward path. Dynamic resolution stays off so both render the same pixels.
+    const unsigned int naiveRun = 0;
+    unsigned int benchFrame = 0;
+    const glm::mat4 initialDogModelMatrix3 = dogModelMatrix3;
+    if (benchmarking) {
+        sceneBenchmark.frames = benchFrames;
+        sceneBenchmark.warmupFrames = benchWarmupFrames;
+        if (benchPathFile != NULL && sceneBenchmark.path.Load(benchPathFile)) {
+            sceneBenchmark.pathName = benchPathFile;
+        } else {
+            if (benchPathFile != NULL)
+                std::cout << "Could not load camera path " << benchPathFile << ", orbiting the scene instead" << std::endl;
+            float duration = (benchWarmupFrames + benchFrames) * sceneBenchmark.timeStep;
+            sceneBenchmark.path = CameraPath::Orbit(glm::vec3(0.0f, 1.7f, 0.0f), 6.0f, duration);
+            sceneBenchmark.pathName = "orbit";
+        }
+        sceneBenchmark.AddRun("naive");
+        sceneBenchmark.AddRun("pipeline");
+        dynamicResolutionEnabled = false;
+        sceneBenchmark.loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - loadStart).count();
+        std::cout << "Benchmark: " << sceneBenchmark.runs.size() << " runs of " << benchFrames << " frames along "
+            << sceneBenchmark.pathName << " (" << sceneBenchmark.path.Duration() << " s)" << std::endl;
+    }
+    // Camera keyframes for --record-path, a few per second
+    CameraPath recordedPath;
+    float recordStartTime = 0.0f;
+
+    // Input comes from the window or from a replay, and can be logged on the way. The benchmark has
+    // none: 'input' stays empty.
+    InputFrame input;
+    InputSource* inputSource = NULL;
+    std::unique_ptr<WindowInput> windowInput;
+    InputReplay inputReplay;
+    bool replayingInput = false;
+    std::unique_ptr<InputRecorder> inputRecorder;
+    if (!benchmarking) {
+        windowInput.reset(new WindowInput(window));
+        inputSource = windowInput.get();
+        if (replayInputFile != NULL) {
+            if (inputReplay.Open(replayInputFile)) {
+                inputSource = &inputReplay;
+                replayingInput = true;
+                std::cout << "Replaying " << inputReplay.FrameCount() << " frames of input from " << replayInputFile << std::endl;
+            } else {
+                std::cout << "Could not replay " << replayInputFile << ", using live input" << std::endl;
+            }
+        }
+        if (recordInputFile != NULL) {
+            inputRecorder.reset(new InputRecorder(*inputSource));
+            if (inputRecorder->Open(recordInputFile))
+                inputSource = inputRecorder.get();
+        }
+    }
+    auto keyPressed = [&input](int key) {
+        return input.KeyDown(key);
+    };
+
+    // Main loop
+    while (benchmarking ? benchFrame < sceneBenchmark.TotalFrames() : !glfwWindowShouldClose(window)) {
+        PROFILE_ZONE("Update frame");
+        auto updateStart = std::chrono::high_resolution_clock::now();
+
+        // A replay ends the session when it runs out of frames
+        if (inputSource != NULL && !inputSource->Poll(input))
+            break;
+        // Whatever the driver reported since the last frame
+        glDebug.Drain();
+
+        // Benchmark frames advance by a fixed step, so frame N shows the same view however fast it renders
+        float currentFrame = benchmarking ? sceneBenchmark.TimeOf(benchFrame) : glfwGetTime(); // Get current time
+        bool naiveDraw = benchmarking && sceneBenchmark.RunOf(benchFrame) == naiveRun;
+        if (benchmarking && sceneBenchmark.StartsRun(benchFrame)) {
+            // Every run starts from the same scene
+            dogModelMatrix3 = initialDogModelMatrix3;
+            rotationAngle = 0.0f;
+            lastFrame = currentFrame;
+        }
+        float deltaTime = currentFrame - lastFrame; // Calculate time since last frame
+        lastFrame = currentFrame;
+        // The scene animates with the input's time step, so a replay moves it exactly as recorded
+        if (inputSource != NULL)
+            deltaTime = input.deltaTime;
+		
+
+        float rotationSpeed = 0.0005f; // Adjust this value for faster/slower rotation
+        rotationAngle += rotationSpeed * deltaTime;
+
+        if (rotationAngle > 2.0f * glm::pi<float>()) {
+            rotationAngle -= 2.0f * glm::pi<float>();
+        }
+        /*
+        static float testTimer = 0.0f;
+        testTimer += deltaTime;
+        if (testTimer > 5.0f) { // Test every 5 seconds
+            testTimer = 0.0f;
+            
+        }
+        */
+        // Inside the main loop, add occasional tests :
+        //camera.TestDirectCollision(camera.Position);
+
+        // Inside your rendering loop, before drawing the models:
+
+        // Update the third dog's transformation matrix for animation
+        // Position the third dog
+        // Apply continuous rotation around the Y axis
+        dogModelMatrix3 = glm::rotate(dogModelMatrix3, rotationAngle, glm::vec3(0.0f, 0.0f, 1.0f));
+
+        // Refit the instance hierarchy for every transform that changed this frame
+        {
+            PROFILE_ZONE("Update: BVH refit");
+            for (unsigned int i = 0; i < sceneDraws.size(); i++) {
+                if (camera.collidableInstances[i].transform != *sceneDraws[i].matrix) {
+                    camera.UpdateModelInstance(i, *sceneDraws[i].matrix);
+                }
+            }
+        }
+
+
+        // Rasterize the occluders from last frame's camera while the input is handled
+        if (cpuOcclusion)
+            occlusionCuller.RenderAsync(camera.cameraMatrix);
+
+        // Input
+        if (benchmarking)
+            sceneBenchmark.path.Sample(currentFrame, camera.Position, camera.Orientation);
+        else
+            camera.Inputs(input); // Moves the camera with the keyboard and mouse input
+        // ESC to quit
+        if (keyPressed(GLFW_KEY_ESCAPE))
+            glfwSetWindowShouldClose(window, true);
+        if (recordPathFile != NULL) {
+            if (recordedPath.keyframes.empty())
+                recordStartTime = currentFrame;
+            if (recordedPath.keyframes.empty() || currentFrame - recordStartTime - recordedPath.keyframes.back().time >= 0.25f)
+                recordedPath.AddKeyframe(currentFrame - recordStartTime, camera.Position, camera.Orientation);
+        }
+
+        // Update camera matrix
+        camera.updateMatrix(camera.fov, 0.1f, 100.0f);
+
+        bool gpuCullingKey = keyPressed(GLFW_KEY_G);
+        if (gpuCullingKey && !gpuCullingKeyDown && hiZCuller.supported)
+            gpuCulling = !gpuCulling;
+        gpuCullingKeyDown = gpuCullingKey;
+
+        bool cpuOcclusionKey = keyPressed(GLFW_KEY_O);
+        if (cpuOcclusionKey && !cpuOcclusionKeyDown) {
+            cpuOcclusion = !cpuOcclusion;
+            occlusionCuller.Wait();
+            occlusionCuller.hasDepth = false;
+            occlusionCuller.occludedCount = 0;
+        }
+        cpuOcclusionKeyDown = cpuOcclusionKey;
+
+        bool testLightKey = keyPressed(GLFW_KEY_L);
+        if (testLightKey && !testLightKeyDown) {
+            testLightStep = (testLightStep + 1) % (sizeof(testLightSteps) / sizeof(testLightSteps[0]));
+            testLightCount = testLightSteps[testLightStep];
+        }
+        testLightKeyDown = testLightKey;
+
+        // Shaders are rebuilt on the render thread, which owns the context
+        bool reloadShaders = false;
+        for (const std::string& file : shaderWatcher.Poll()) {
+            if (forwardShaders.UsesFile(file))
+                reloadShaders = true;
+        }
+
+        bool flashlightKey = keyPressed(GLFW_KEY_F);
+        if (flashlightKey && !flashlightKeyDown)
+            flashlight = !flashlight;
+        flashlightKeyDown = flashlightKey;
+
+        bool debugViewKey = keyPressed(GLFW_KEY_V);
+        if (debugViewKey && !debugViewKeyDown)
+            debugView = (debugView + 1) % (sizeof(debugViews) / sizeof(debugViews[0]));
+        debugViewKeyDown = debugViewKey;
+
+        bool renderPathKey = keyPressed(GLFW_KEY_R);
+        if (renderPathKey && !renderPathKeyDown) {
+            renderPath = (RenderPath) ((renderPath + 1) % RenderPathCount);
+            std::cout << "Render path: " << renderPathNames[renderPath] << std::endl;
+        }
+        renderPathKeyDown = renderPathKey;
+
+        bool dynamicResolutionKey = keyPressed(GLFW_KEY_X);
+        if (dynamicResolutionKey && !dynamicResolutionKeyDown) {
+            dynamicResolutionEnabled = !dynamicResolutionEnabled;
+            std::cout << "Dynamic resolution: " << (dynamicResolutionEnabled ? "on" : "off") << std::endl;
+        }
+        dynamicResolutionKeyDown = dynamicResolutionKey;
+
+        bool depthPrePassKey = keyPressed(GLFW_KEY_P);
+        if (depthPrePassKey && !depthPrePassKeyDown) {
+            depthPrePassEnabled = !depthPrePassEnabled;
+            std::cout << "Depth pre-pass: " << (depthPrePassEnabled ? "on" : "off") << std::endl;
+        }
+        depthPrePassKeyDown = depthPrePassKey;
+
+        bool profileKey = keyPressed(GLFW_KEY_C);
+        if (profileKey && !profileKeyDown) {
+            if (profiler.Capturing()) {
+                profiler.StopCapture();
+                profileWritePending = true;
+            } else {
+                profiler.StartCapture();
+                std::cout << "Profiler: capturing, press C again to stop" << std::endl;
+            }
+        }
+        profileKeyDown = profileKey;
+        if (profileFrames > 0 && profiler.Capturing() && ++profiledFrames >= profileFrames) {
+            profiler.StopCapture();
+            profileWritePending = true;
+            profileFrames = 0;
+        }
+        if (profileWritePending && profiler.CaptureComplete()) {
+            writeProfile();
+            profileWritePending = false;
+        }
+
+        // Cells reachable from the camera through the portals
+        // The naive benchmark run culls nothing, it only needs the cells for the room lights
+        {
+            PROFILE_ZONE("Update: portals");
+            portalSystem.Update(camera.Position, camera.cameraMatrix);
+        }
+        if (!naiveDraw) {
+            PROFILE_ZONE("Update: culling");
+            // Cull whole instances through the BVH first, then every mesh of the instances that remain
+            frustumCuller.ExtractPlanes(camera.cameraMatrix);
+            visibleInstances.clear();
+            camera.instanceBVH.QueryFrustum(frustumCuller.planes, visibleInstances);
+            for (unsigned int i = 0; i < sceneDraws.size(); i++) {
+                pipelineInstances[i].matrix = *sceneDraws[i].matrix;
+            }
+            framePipeline.Transform(pipelineInstances, visibleInstances);
+            float projectionScale = (height * 0.5f) / glm::tan(glm::radians(camera.fov) * 0.5f);
+            framePipeline.Cull(camera.Position, projectionScale);
+            portalSystem.Cull(frustumCuller);
+            if (cpuOcclusion) {
+                occlusionCuller.Wait();
+                occlusionCuller.Cull(frustumCuller);
+            }
+        }
+        if (!naiveDraw) {
+            PROFILE_ZONE("Update: draw list");
+            framePipeline.BuildDrawList(camera.Position);
+        }
+
+        // Everything the render thread needs goes into the packet, it never reads the state above
+        FramePacket& packet = renderThread.BeginPacket();
+        packet.cameraPosition = camera.Position;
+        packet.cameraOrientation = camera.Orientation;
+        packet.cameraUp = camera.Up;
+        packet.fov = camera.fov;
+        packet.draws.clear();
+        // The naive path draws every instance whole and never reads the culling results
+        for (unsigned int i = 0; i < sceneDraws.size(); i++)
+            packet.draws.push_back({sceneDraws[i].model, *sceneDraws[i].matrix, naiveDraw ? 0 : framePipeline.firstBounds[i]});
+        packet.meshVisible = frustumCuller.visible;
+        // The pipeline rebuilds its list every frame, so the packet can take it and hand back its old memory
+        packet.drawList.swap(framePipeline.drawList);
+
+        // Point lights: the room lights that can be seen plus the test lights, sorted into clusters
+        // on the render thread
+        packet.lights.clear();
+        visibleRoomLights.clear();
+        for (const glm::vec3& lightPosition : roomLightPositions) {
+            if (portalSystem.IsPointVisible(lightPosition)) {
+                visibleRoomLights.push_back(lightPosition);
+                packet.lights.push_back({lightPosition, 10.0f, glm::vec3(0.8f), 0.0625f});
+            }
+        }
+        for (unsigned int i = 0; i < testLightCount; i++)
+            packet.lights.push_back(testLights[i]);
+
+        // Forward variant features that depend on the scene rather than the material
+        unsigned int sceneFeatures = debugViews[debugView] | textureFeatures;
+        if (flashlight)
+            sceneFeatures |= SHADER_SPOT_LIGHT;
+        if (!packet.lights.empty())
+            sceneFeatures |= SHADER_POINT_LIGHTS;
+        packet.renderPath = renderPath;
+        packet.sceneFeatures = sceneFeatures;
+        packet.flashlight = flashlight;
+        packet.gpuCulling = gpuCulling;
+        packet.depthPrePass = depthPrePassEnabled;
+        packet.dynamicResolution = dynamicResolutionEnabled;
+        packet.reloadShaders = reloadShaders;
+        packet.benchFrame = benchmarking ? (int) benchFrame : -1;
+        packet.naiveDraw = naiveDraw;
+        packet.updateMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - updateStart).count();
+        renderThread.SubmitPacket();
+        // The whole iteration, including the wait for the render thread when it falls behind
+        if (benchmarking) {
+            sceneBenchmark.RecordCpuFrame(benchFrame, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - updateStart).count());
+            benchFrame++;
+        }
+
+		nbFrames++;
+		// Calculate and print FPS every second
+		if (window != NULL && currentFrame - lastTime >= 1.0) { // If a second has passed
+			RenderStats stats;
+			{
+				std::lock_guard<std::mutex> lock(renderStatsMutex);
+				stats = renderStats;
+			}
+			char title[1024];
+			if (gpuCulling) {
+				snprintf(title, sizeof(title), "OpenGL Project - Imported Model (%s) - FPS: %d - Instances visible: %u/%u - GPU culling: %u/%u drawn (frustum: %u, occluded: %u)",
+					renderPathNames[renderPath], nbFrames, (unsigned int) visibleInstances.size(), (unsigned int) sceneDraws.size(), stats.gpuCounters.visible, stats.gpuCounters.tested,
+					stats.gpuCounters.frustumCulled, stats.gpuCounters.occlusionCulled);
+			} else {
+				snprintf(title, sizeof(title), "OpenGL Project - Imported Model (%s) - FPS: %d (%.2f ms) - Instances visible: %u/%u - Meshes visible: %u culled: %u (small: %u, portals: %u, occluded: %u) - Cells visited: %u - Lights: %u/%u + %u test (max %u per cluster)",
+					renderPathNames[renderPath], nbFrames, 1000.0 / nbFrames, (unsigned int) visibleInstances.size(), (unsigned int) sceneDraws.size(), frustumCuller.visibleCount,
+					frustumCuller.frustumCulledCount + frustumCuller.smallCulledCount + portalSystem.meshesRejected + occlusionCuller.occludedCount,
+					frustumCuller.smallCulledCount, portalSystem.meshesRejected, occlusionCuller.occludedCount, portalSystem.cellsVisited,
+					(unsigned int) visibleRoomLights.size(), (unsigned int) roomLightPositions.size(), testLightCount,
+					stats.maxLightsPerCluster);
+			}
+			if (renderPath == ForwardPath && glFeatures.pipelineStatistics) {
+				size_t length = strlen(title);
+				snprintf(title + length, sizeof(title) - length, " - Fragment shader invocations: %llu (pre-pass %s: %llu)",
+					(unsigned long long) stats.colorPassInvocations, depthPrePassEnabled ? "on" : "off",
+					(unsigned long long) stats.prePassInvocations);
+			}
+			// Where the frame time goes on each thread
+			RenderThread::Timings timings = renderThread.GetTimings();
+			size_t length = strlen(title);
+			snprintf(title + length, sizeof(title) - length, " - Update: %.2f ms (waiting %.2f) - Render: %.2f ms (waiting %.2f)",
+				timings.update, timings.updateWait, timings.render, timings.renderWait);
+			// Internal resolution and what the controller is doing
+			const DynamicResolution::Telemetry& resolution = stats.resolution;
+			length = strlen(title);
+			snprintf(title + length, sizeof(title) - length, " - Resolution: %dx%d (%.0f%%, GPU %.2f ms / %.1f, %s)",
+				resolution.renderWidth, resolution.renderHeight, resolution.scale * 100.0f, resolution.gpuMilliseconds,
+				resolution.targetMilliseconds, DynamicResolution::StateName(resolution.state));
+			// Stages of the draw list build and the workers they were spread over
+			const FramePipeline::Timings& stages = framePipeline.timings;
+			length = strlen(title);
+			snprintf(title + length, sizeof(title) - length, " - Pipeline (%u workers): transform %.3f cull %.3f keys %.3f sort %.3f ms",
+				jobSystem.WorkerCount(), stages.transform, stages.cull, stages.keys, stages.sort);
+			glfwSetWindowTitle(window, title);
+			nbFrames = 0; // Reset frame count
+			lastTime += 1.0; // Increment last time by 1 second
+		}
+
+        if (window != NULL)
+            glfwPollEvents();
+    }
+
+    // Let the render thread finish and take the context back for the cleanup
+    renderThread.Stop();
+    if (threadedRendering) {
+        makeContextCurrent();
+        jobSystem.SetMainThread();
+    }
+    jobSystem.ExecuteMainThreadJobs();
+
+    if (benchmarking) {
+        sceneBenchmark.Flush();
+        sceneBenchmark.PrintReport();
+        if (sceneBenchmark.WriteReport(benchReportFile))
+            std::cout << "Benchmark: wrote " << benchReportFile << std::endl;
+        sceneBenchmark.Delete();
+    }
+    // Where the camera ended up, bit for bit, to compare a replay with its recording
+    if (inputRecorder)
+        inputRecorder->Close();
+    if (inputRecorder || replayingInput) {
+        unsigned int frames = replayingInput ? inputReplay.Position() : inputRecorder->frameCount;
+        printf("Input %s: %u frames, camera at (%a, %a, %a) facing (%a, %a, %a)\n", replayingInput ? "replay" : "recording", frames,
+            camera.Position.x, camera.Position.y, camera.Position.z, camera.Orientation.x, camera.Orientation.y, camera.Orientation.z);
+    }
+    if (recordPathFile != NULL && recordedPath.Save(recordPathFile))
+        std::cout << "Camera path: " << recordedPath.keyframes.size() << " keyframes written to " << recordPathFile << std::endl;
+
+    // A capture still running (or waiting for the GPU) is written with whatever the GPU has finished
+    if (profiler.Capturing() || profileWritePending) {
+        profiler.StopCapture();
+        profiler.FlushGpuFrames();
+        writeProfile();
+    }
+
+    glDebug.Drain();
+    glDebug.PrintSummary();
+
+    // Cleanup
+    // Model's resources (VAOs, VBOs, Textures) should be deleted
+    forwardShaders.Delete();
+    shaderCompiler.Stop();
+    programCache.Close();
+    shaderWatcher.Close();
+    if (compileWindow != NULL)
+        glfwDestroyWindow(compileWindow);
+    compileContext.Destroy();
+    hiZCuller.Delete();
+    clusteredLights.Delete();
+    deferredRenderer.Delete();
+    visibilityBuffer.Delete();
+    depthPrePass.Delete();
+    dynamicResolution.Delete();
+    profiler.DeleteGpuQueries();
+    drawStream.Delete();
+    Mesh::DeleteDrawBuffer();
+    textureTable.Delete();
+    materialTable.Delete();
+    jobSystem.Stop();
+    if (window != NULL) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+    headlessContext.Destroy();
+    return 0;
 }
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include"MaterialTable.h"
+
+#include<cstring>
+
+#include"GLDebug.h"
+
+MaterialTable materialTable;
+
+// Float bits for the RGBA32UI buffer, read back with uintBitsToFloat
+static GLuint floatBits(float value) {
+	GLuint bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+MaterialTable::MaterialTable() {
+	materials.push_back(Material());
+}
+
+unsigned int MaterialTable::Add(const Material& material) {
+	materials.push_back(material);
+	return (unsigned int) materials.size() - 1;
+}
+
+void MaterialTable::Upload() {
+	std::vector<glm::uvec4> texels;
+	texels.reserve(materials.size() * texelsPerMaterial);
+	for (const Material& material : materials) {
+		float alphaCutoff = material.alphaMode == Material::Opaque ? -1.0f : material.alphaCutoff;
+		texels.push_back(glm::uvec4(floatBits(material.baseColorFactor.x), floatBits(material.baseColorFactor.y),
+									floatBits(material.baseColorFactor.z), floatBits(material.baseColorFactor.w)));
+		texels.push_back(glm::uvec4(floatBits(material.emissiveFactor.x), floatBits(material.emissiveFactor.y),
+									floatBits(material.emissiveFactor.z), floatBits(alphaCutoff)));
+		texels.push_back(glm::uvec4(floatBits(material.metallicFactor), floatBits(material.roughnessFactor),
+									floatBits(material.specularStrength), floatBits(material.textureBlendFactor)));
+		texels.push_back(glm::uvec4(floatBits(material.diffuseStrength), floatBits(material.ambientStrength), 0, 0));
+		texels.push_back(glm::uvec4(material.baseColorTexture, material.secondBaseColorTexture,
+									material.metallicRoughnessTexture, material.emissiveTexture));
+	}
+
+	if (buffer == 0) {
+		glGenBuffers(1, &buffer);
+		glGenTextures(1, &texture);
+	}
+	glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+	glBufferData(GL_TEXTURE_BUFFER, texels.size() * sizeof(glm::uvec4), texels.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	glBindTexture(GL_TEXTURE_BUFFER, texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, buffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glDebug.Label(GL_BUFFER, buffer, "Material table");
+	GL_CHECK_ERRORS("upload material table");
+}
+
+void MaterialTable::Bind(Shader& shader) {
+	if (texture == 0)
+		return;
+	shader.Activate();
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_BUFFER, texture);
+	glActiveTexture(GL_TEXTURE0);
+	glUniform1i(glGetUniformLocation(shader.ID, "materialData"), unit);
+}
+
+void MaterialTable::Delete() {
+	if (buffer != 0) {
+		glDeleteBuffers(1, &buffer);
+		glDeleteTextures(1, &texture);
+	}
+	buffer = 0;
+	texture = 0;
+}
@@ -0,0 +1,87 @@
+#ifndef MATERIAL_TABLE_CLASS_H
+#define MATERIAL_TABLE_CLASS_H
+
+#include<glad/glad.h>
+#include<glm/glm.hpp>
+#include<vector>
+
+#include"shaderClass.h"
+#include"TextureTable.h"
+
+// Surface description of one glTF material. Textures are textureTable entries.
+struct Material {
+	enum AlphaMode {
+		Opaque,
+		Mask,
+		// Drawn alpha-tested at alphaCutoff, there is no sorted transparent pass yet
+		Blend
+	};
+
+	glm::vec4 baseColorFactor = glm::vec4(1.0f);
+	glm::vec3 emissiveFactor = glm::vec3(0.0f);
+	// The shaders are Blinn-Phong: roughness sets the highlight size and strength, metallic is kept for a PBR path
+	float metallicFactor = 1.0f;
+	float roughnessFactor = 1.0f;
+	AlphaMode alphaMode = Opaque;
+	float alphaCutoff = 0.5f;
+	// Drawn without back-face culling
+	bool doubleSided = false;
+
+	// Lighting terms glTF has no equivalent for
+	float specularStrength = 0.5f;
+	float diffuseStrength = 1.0f;
+	float ambientStrength = 0.2f;
+	// Blend between the two base color textures, with SHADER_BLEND_TEXTURES
+	float textureBlendFactor = 0.0f;
+
+	unsigned int baseColorTexture = TextureTable::whiteEntry;
+	unsigned int secondBaseColorTexture = TextureTable::whiteEntry;
+	// glTF layout: roughness in green, metallic in blue
+	unsigned int metallicRoughnessTexture = TextureTable::whiteEntry;
+	unsigned int emissiveTexture = TextureTable::whiteEntry;
+};
+
+// Every material of the scene in one RGBA32UI texture buffer, uploaded once after loading. A draw
+// passes only its material's index (DrawData::material, a uniform in visbuffer.frag); the fragment
+// shaders read the rest in loadMaterial of material_table.glsl. Texture buffers rather than a shader
+// storage buffer, as those need GL 4.3 and the shaders are GLSL 3.30.
+//
+// Per material, texelsPerMaterial texels (MATERIAL_TEXELS in the shaders, floats as their bits):
+//   baseColorFactor
+//   emissiveFactor, alpha cutoff (-1 for opaque materials)
+//   metallic, roughness, specularStrength, textureBlendFactor
+//   diffuseStrength, ambientStrength, 0, 0
+//   texture entries: base color, second base color, metallic-roughness, emissive
+class MaterialTable {
+public:
+	static const unsigned int texelsPerMaterial = 5;
+	// Texture unit of the buffer, below the texture arrays and free in every scene pass
+	static const GLuint unit = 2;
+	// Material 0: white and rough, for meshes without one
+	static const unsigned int defaultMaterial = 0;
+
+	MaterialTable();
+
+	// Adds a material and returns its index
+	unsigned int Add(const Material& material);
+	const Material& Get(unsigned int index) const {
+		return materials[index < materials.size() ? index : defaultMaterial];
+	}
+	unsigned int Count() const {
+		return (unsigned int) materials.size();
+	}
+	// Uploads the materials into the texture buffer, again after adding more
+	void Upload();
+	// Binds the buffer and sets the sampler of 'shader', once per frame and program
+	void Bind(Shader& shader);
+	void Delete();
+
+private:
+	std::vector<Material> materials;
+	GLuint buffer = 0;
+	GLuint texture = 0;
+};
+
+// Materials of every loaded model
+extern MaterialTable materialTable;
+#endif
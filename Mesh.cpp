@@ -1,116 +1,231 @@
-﻿#include "Mesh.h"
-
-Mesh::Mesh(std::vector <Vertex>& vertices, std::vector <GLuint>& indices, std::vector <Texture>& textures) {
-	Mesh::vertices = vertices;
-	Mesh::indices = indices;
-	Mesh::textures = textures;
-
-	VAO.Bind();
-	// Generates Vertex Buffer Object and links it to vertices
-	VBO VBO(vertices);
-	// Generates Element Buffer Object and links it to indices
-	EBO EBO(indices);
-	// Links VBO attributes such as coordinates and colors to VAO
-	VAO.LinkAttrib(VBO, 0, 3, GL_FLOAT, sizeof(Vertex), (void*) 0);
-	VAO.LinkAttrib(VBO, 1, 3, GL_FLOAT, sizeof(Vertex), (void*) (3 * sizeof(float)));
-	VAO.LinkAttrib(VBO, 2, 3, GL_FLOAT, sizeof(Vertex), (void*) (6 * sizeof(float)));
-	VAO.LinkAttrib(VBO, 3, 2, GL_FLOAT, sizeof(Vertex), (void*) (9 * sizeof(float)));
-	// Unbind all to prevent accidentally modifying them
-	VAO.Unbind();
-	VBO.Unbind();
-	EBO.Unbind();
-}
-
-
-void Mesh::Draw(
-    Shader& shader,
-    Camera& camera,
-    glm::mat4 matrix,
-    glm::vec3 translation,
-    glm::quat rotation,
-    glm::vec3 scale
-) {
-
-    GLuint currentTextureUnit = 0; // Or manage this more robustly if you have many texture types
-    // Bind shader and VAO
-    shader.Activate();
-    VAO.Bind();
-
-    // Track texture slots
-    GLuint diffuseUnit = 0;
-    GLuint specularUnit = 2;  // reserve unit 2 for specular (avoid conflict with 0/1)
-
-    bool diffuse0Set = false;
-    bool diffuse1Set = false;
-
-    // In Mesh::Draw, modify texture binding:
-    for (unsigned int i = 0; i < textures.size(); i++) {
-        std::string type = textures[i].type;
-
-        if (type == "diffuse") {
-            // First, set the unit property of the texture
-            textures[i].unit = 0;  // Explicitly set unit to match what shader expects
-            textures[i].texUnit(shader, "diffuse0", 0);
-            textures[i].Bind();
-        } else if (type == "specular") {
-            textures[i].unit = 1;  // Explicitly set unit to match what shader expects
-            textures[i].texUnit(shader, "specularMap", 1);
-            textures[i].Bind();
-        }
-    }
-
-    // Pass camera position
-    glUniform3f(glGetUniformLocation(shader.ID, "camPos"),
-                camera.Position.x, camera.Position.y, camera.Position.z);
-
-    // Set camera and view matrices
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "view"), 1, GL_FALSE, glm::value_ptr(camera.GetViewMatrix()));
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(camera.GetProjectionMatrix()));
-
-    // Construct transformation matrices
-    glm::mat4 trans = glm::translate(glm::mat4(1.0f), translation);
-    glm::mat4 rot = glm::mat4_cast(rotation);
-    glm::mat4 sca = glm::scale(glm::mat4(1.0f), scale);
-
-    // Send transformation matrices to shader
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "translation"), 1, GL_FALSE, glm::value_ptr(trans));
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "rotation"), 1, GL_FALSE, glm::value_ptr(rot));
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "scale"), 1, GL_FALSE, glm::value_ptr(sca));
-    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "model"), 1, GL_FALSE, glm::value_ptr(matrix));
-
-    // Set default lighting parameters if they're not already set elsewhere
-    glUniform1f(glGetUniformLocation(shader.ID, "shininess"), 32.0f);
-    glUniform1f(glGetUniformLocation(shader.ID, "specularStrength"), 0.5f);
-    glUniform1f(glGetUniformLocation(shader.ID, "diffuseStrength"), 1.0f);
-    glUniform1f(glGetUniformLocation(shader.ID, "ambientStrength"), 0.1f);
-
-    // Set light position/properties for dirLight
-    glUniform3f(glGetUniformLocation(shader.ID, "dirLight.direction"), -0.2f, -1.0f, -0.3f);
-    glUniform3f(glGetUniformLocation(shader.ID, "dirLight.ambient"), 0.2f, 0.2f, 0.2f);
-    glUniform3f(glGetUniformLocation(shader.ID, "dirLight.diffuse"), 0.7f, 0.7f, 0.7f);
-    glUniform3f(glGetUniformLocation(shader.ID, "dirLight.specular"), 1.0f, 1.0f, 1.0f);
-
-    // Add after setting dirLight properties
-    glUniform3f(glGetUniformLocation(shader.ID, "pointLights[0].position"), 0.0f, 5.0f, 0.0f);
-    glUniform1f(glGetUniformLocation(shader.ID, "pointLights[0].constant"), 1.0f);
-    glUniform1f(glGetUniformLocation(shader.ID, "pointLights[0].linear"), 0.09f);
-    glUniform1f(glGetUniformLocation(shader.ID, "pointLights[0].quadratic"), 0.032f);
-    glUniform3f(glGetUniformLocation(shader.ID, "pointLights[0].ambient"), 0.05f, 0.05f, 0.05f);
-    glUniform3f(glGetUniformLocation(shader.ID, "pointLights[0].diffuse"), 0.8f, 0.8f, 0.8f);
-    glUniform3f(glGetUniformLocation(shader.ID, "pointLights[0].specular"), 1.0f, 1.0f, 1.0f);
-
-    // Set default spotlight params to minimize its effect if not used
-    glUniform3f(glGetUniformLocation(shader.ID, "spotLight.position"), 0.0f, 0.0f, 0.0f);
-    glUniform3f(glGetUniformLocation(shader.ID, "spotLight.direction"), 0.0f, -1.0f, 0.0f);
-    glUniform1f(glGetUniformLocation(shader.ID, "spotLight.cutOff"), 0.0f);  // Very narrow cone
-    glUniform1f(glGetUniformLocation(shader.ID, "spotLight.outerCutOff"), 0.0f);
-
-    glUniform1f(glGetUniformLocation(shader.ID, "textureBlendFactor"), 0.0f);  // Use only diffuse0
-
-    // We also need to set the camera position for specular calculations
-    glUniform3f(glGetUniformLocation(shader.ID, "viewPos"),
-                camera.Position.x, camera.Position.y, camera.Position.z);
-
-    // Draw mesh
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-}
+﻿#include "Mesh.h"
+#include "GLExtensions.h"
+#include "GLDebug.h"
+#include<cstring>
+
+unsigned int Mesh::drawCalls = 0;
+
+// Culling state the mesh draws left behind, so draws with the same state skip the calls
+static bool cullingEnabled = false;
+static GLenum frontFace = GL_CCW;
+// DrawData buffer for draws the stream cannot take (see bindDrawData)
+static GLuint fallbackDrawBuffer = 0;
+
+Mesh::Mesh(std::vector <Vertex>& vertices, std::vector <GLuint>& indices, std::vector <Texture>& textures) {
+	Mesh::vertices = vertices;
+	Mesh::indices = indices;
+	Mesh::textures = textures;
+
+	// Calculate local bounds once so culling does not need to touch the vertices every frame
+	minBounds = glm::vec3(FLT_MAX);
+	maxBounds = glm::vec3(-FLT_MAX);
+	for (const Vertex& vertex : vertices) {
+		minBounds = glm::min(minBounds, vertex.position);
+		maxBounds = glm::max(maxBounds, vertex.position);
+	}
+	if (vertices.empty()) {
+		minBounds = glm::vec3(0.0f);
+		maxBounds = glm::vec3(0.0f);
+	}
+
+	// Only materials with a second diffuse map need the blending variant
+	unsigned int diffuseCount = 0;
+	for (const Texture& texture : textures) {
+		if (std::string(texture.type) == "diffuse")
+			diffuseCount++;
+	}
+	if (diffuseCount > 1)
+		shaderFeatures |= SHADER_BLEND_TEXTURES;
+
+	VAO.Bind();
+	// Generates Vertex Buffer Object and links it to vertices
+	VBO VBO(vertices);
+	// Generates Element Buffer Object and links it to indices
+	EBO EBO(indices);
+	// Links VBO attributes such as coordinates and colors to VAO
+	VAO.LinkAttrib(VBO, 0, 3, GL_FLOAT, sizeof(Vertex), (void*) 0);
+	VAO.LinkAttrib(VBO, 1, 3, GL_FLOAT, sizeof(Vertex), (void*) (3 * sizeof(float)));
+	VAO.LinkAttrib(VBO, 2, 3, GL_FLOAT, sizeof(Vertex), (void*) (6 * sizeof(float)));
+	VAO.LinkAttrib(VBO, 3, 2, GL_FLOAT, sizeof(Vertex), (void*) (9 * sizeof(float)));
+	// Unbind all to prevent accidentally modifying them
+	VAO.Unbind();
+	VBO.Unbind();
+	EBO.Unbind();
+	vertexBuffer = VBO.ID;
+	indexBuffer = EBO.ID;
+
+	// Views of the same buffers for shaders that fetch vertices themselves (no copy)
+	glGenTextures(1, &vertexTexture);
+	glBindTexture(GL_TEXTURE_BUFFER, vertexTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_R32F, vertexBuffer);
+	glGenTextures(1, &indexTexture);
+	glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, indexBuffer);
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+	// Separate position stream so depth-only passes do not fetch normals, colors and UVs
+	std::vector<glm::vec3> positions;
+	positions.reserve(vertices.size());
+	for (const Vertex& vertex : vertices)
+		positions.push_back(vertex.position);
+	depthVAO.Bind();
+	class VBO positionVBO(positions);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	depthVAO.LinkAttrib(positionVBO, 0, 3, GL_FLOAT, sizeof(glm::vec3), (void*) 0);
+	depthVAO.Unbind();
+	positionVBO.Unbind();
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	positionBuffer = positionVBO.ID;
+}
+
+void Mesh::SetMaterial(unsigned int index) {
+	material = index;
+	// Only alpha-tested materials pay for the discard, which turns off early depth testing
+	if (materialTable.Get(index).alphaMode != Material::Opaque)
+		shaderFeatures |= SHADER_ALPHA_MASK;
+	else
+		shaderFeatures &= ~SHADER_ALPHA_MASK;
+}
+
+void Mesh::Label(const std::string& name) {
+	glDebug.Label(GL_VERTEX_ARRAY, VAO.ID, name);
+	glDebug.Label(GL_VERTEX_ARRAY, depthVAO.ID, name + " (depth)");
+	glDebug.Label(GL_BUFFER, vertexBuffer, name + " vertices");
+	glDebug.Label(GL_BUFFER, indexBuffer, name + " indices");
+	glDebug.Label(GL_BUFFER, positionBuffer, name + " positions");
+}
+
+
+void Mesh::Draw(Shader& shader, Camera& camera, glm::mat4 matrix) {
+    bindDrawState(shader, camera, matrix);
+
+    // Draw mesh
+    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    drawCalls++;
+}
+
+void Mesh::Draw(ShaderVariants& variants, unsigned int sceneFeatures, Camera& camera, glm::mat4 matrix) {
+    Draw(variants.Get(sceneFeatures | shaderFeatures), camera, matrix);
+}
+
+void Mesh::DrawIndirect(ShaderVariants& variants, unsigned int sceneFeatures, Camera& camera, glm::mat4 matrix, GLintptr commandOffset) {
+    DrawIndirect(variants.Get(sceneFeatures | shaderFeatures), camera, matrix, commandOffset);
+}
+
+void Mesh::DrawIndirect(Shader& shader, Camera& camera, glm::mat4 matrix, GLintptr commandOffset) {
+    bindDrawState(shader, camera, matrix);
+
+    // Count and instance count come from the command buffer written by the culling shader
+    glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*) commandOffset);
+    drawCalls++;
+}
+
+void Mesh::DrawDepth(Shader& shader, glm::mat4 matrix) {
+    // Opaque and alpha-tested meshes use different programs (see DepthPrePass)
+    shader.Activate();
+    bindDrawData(matrix);
+    if (shaderFeatures & SHADER_ALPHA_MASK)
+        VAO.Bind();
+    else
+        depthVAO.Bind();
+    ApplyCulling(matrix);
+    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    drawCalls++;
+}
+
+void Mesh::DrawDepthIndirect(Shader& shader, glm::mat4 matrix, GLintptr commandOffset) {
+    // Opaque and alpha-tested meshes use different programs (see DepthPrePass)
+    shader.Activate();
+    bindDrawData(matrix);
+    if (shaderFeatures & SHADER_ALPHA_MASK)
+        VAO.Bind();
+    else
+        depthVAO.Bind();
+    ApplyCulling(matrix);
+    glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*) commandOffset);
+    drawCalls++;
+}
+
+void Mesh::ApplyCulling(const glm::mat4& matrix) const {
+    bool cull = !materialTable.Get(material).doubleSided;
+    if (cull != cullingEnabled) {
+        if (cull)
+            glEnable(GL_CULL_FACE);
+        else
+            glDisable(GL_CULL_FACE);
+        cullingEnabled = cull;
+    }
+    // glTF front faces are counter-clockwise, a transform with a negative determinant mirrors them
+    GLenum winding = glm::determinant(glm::mat3(matrix)) < 0.0f ? GL_CW : GL_CCW;
+    if (cull && winding != frontFace) {
+        glFrontFace(winding);
+        frontFace = winding;
+    }
+}
+
+void Mesh::EndCulling() {
+    glDisable(GL_CULL_FACE);
+    glFrontFace(GL_CCW);
+    cullingEnabled = false;
+    frontFace = GL_CCW;
+}
+
+void Mesh::bindDrawData(const glm::mat4& matrix) {
+    DrawData drawData;
+    drawData.model = matrix;
+    drawData.normalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(matrix))));
+    drawData.material = material;
+
+    GLintptr offset = 0;
+    void* streamed = drawStream.Ready() ? drawStream.Allocate(sizeof(DrawData), offset) : nullptr;
+    if (streamed != nullptr) {
+        memcpy(streamed, &drawData, sizeof(DrawData));
+        drawStream.Flush(offset, sizeof(DrawData));
+        glBindBufferRange(GL_UNIFORM_BUFFER, 0, drawStream.ID, offset, sizeof(DrawData));
+        return;
+    }
+
+    // Outside a stream frame, or with the frame's region full, the block goes through a small
+    // buffer of its own. Respecifying it every draw lets the driver orphan the storage an
+    // earlier draw still reads, so this is slower than the stream but never wrong.
+    if (fallbackDrawBuffer == 0)
+        glGenBuffers(1, &fallbackDrawBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, fallbackDrawBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(DrawData), &drawData, GL_STREAM_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, 0, fallbackDrawBuffer);
+}
+
+void Mesh::DeleteDrawBuffer() {
+    if (fallbackDrawBuffer != 0)
+        glDeleteBuffers(1, &fallbackDrawBuffer);
+    fallbackDrawBuffer = 0;
+}
+
+void Mesh::bindDrawState(Shader& shader, Camera& camera, glm::mat4 matrix) {
+
+    GLuint currentTextureUnit = 0; // Or manage this more robustly if you have many texture types
+    // Bind shader and VAO
+    shader.Activate();
+    VAO.Bind();
+    ApplyCulling(matrix);
+
+    // The material's textures and factors come from materialTable through the draw data
+
+    // Pass camera position
+    glUniform3f(glGetUniformLocation(shader.ID, "camPos"),
+                camera.Position.x, camera.Position.y, camera.Position.z);
+
+    // Set camera and view matrices
+    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "view"), 1, GL_FALSE, glm::value_ptr(camera.GetViewMatrix()));
+    glUniformMatrix4fv(glGetUniformLocation(shader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(camera.GetProjectionMatrix()));
+
+    // The node transform is already part of 'matrix', so the model and normal matrix are the only
+    // per-draw data
+    bindDrawData(matrix);
+
+    // Material and light uniforms are set once per frame by the caller (Main.cpp), not per draw
+
+    // We also need to set the camera position for specular calculations
+    glUniform3f(glGetUniformLocation(shader.ID, "viewPos"),
+                camera.Position.x, camera.Position.y, camera.Position.z);
+}
@@ -1,33 +1,84 @@
-#ifndef MESH_CLASS_H
-#define MESH_CLASS_H
-
-#include<string>
-
-#include"VAO.h"
-#include"EBO.h"
-#include"Camera.h"
-#include"Texture.h"
-
-class Mesh {
-public:
-	std::vector <Vertex> vertices;
-	std::vector <GLuint> indices;
-	std::vector <Texture> textures;
-	// Store VAO in public so it can be used in the Draw function
-	VAO VAO;
-
-	// Initializes the mesh
-	Mesh(std::vector <Vertex>& vertices, std::vector <GLuint>& indices, std::vector <Texture>& textures);
-
-	// Draws the mesh
-	void Draw
-	(
-		Shader& shader,
-		Camera& camera,
-		glm::mat4 matrix = glm::mat4(1.0f),
-		glm::vec3 translation = glm::vec3(0.0f, 0.0f, 0.0f),
-		glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
-		glm::vec3 scale = glm::vec3(1.0f, 1.0f, 1.0f)
-	);
-};
+#ifndef MESH_CLASS_H
+#define MESH_CLASS_H
+
+#include<string>
+
+#include"VAO.h"
+#include"EBO.h"
+#include"Camera.h"
+#include"Texture.h"
+#include"ShaderVariants.h"
+#include"StreamBuffer.h"
+#include"MaterialTable.h"
+
+// Per-draw block of default.vert and depth_prepass.vert (std140), streamed through drawStream
+struct DrawData {
+	glm::mat4 model;
+	glm::mat4 normalMatrix;
+	// Index into materialTable, padded to the 16 bytes std140 rounds the block to
+	GLuint material;
+	GLuint padding[3];
+};
+
+class Mesh {
+public:
+	std::vector <Vertex> vertices;
+	std::vector <GLuint> indices;
+	std::vector <Texture> textures;
+	// Local-space bounds of the vertices, used for culling
+	glm::vec3 minBounds;
+	glm::vec3 maxBounds;
+	// Store VAO in public so it can be used in the Draw function
+	VAO VAO;
+	// Buffers behind the VAO, and texture buffer views of them so shaders can fetch
+	// vertices (R32F, 11 floats per Vertex) and indices (R32UI) directly
+	GLuint vertexBuffer = 0;
+	GLuint indexBuffer = 0;
+	GLuint vertexTexture = 0;
+	GLuint indexTexture = 0;
+	// Positions only (12 bytes per vertex instead of 44) with the same index buffer, for depth-only passes
+	::VAO depthVAO;
+	GLuint positionBuffer = 0;
+	// ShaderFeature bits this mesh's material needs (e.g. texture blending when it has two diffuse maps)
+	unsigned int shaderFeatures = 0;
+	// Index into materialTable, passed with every draw (see DrawData)
+	unsigned int material = MaterialTable::defaultMaterial;
+
+	// Draw calls issued for meshes (all passes) since the caller last reset it, render thread only
+	static unsigned int drawCalls;
+
+	// Initializes the mesh
+	Mesh(std::vector <Vertex>& vertices, std::vector <GLuint>& indices, std::vector <Texture>& textures);
+	// Sets the materialTable entry, along with the shader features it needs
+	void SetMaterial(unsigned int index);
+
+	// Draws the mesh
+	void Draw(Shader& shader, Camera& camera, glm::mat4 matrix = glm::mat4(1.0f));
+	// Draws the mesh with the variant for 'sceneFeatures' plus the mesh's own shaderFeatures
+	void Draw(ShaderVariants& variants, unsigned int sceneFeatures, Camera& camera, glm::mat4 matrix);
+	// Draws the mesh with the command at 'commandOffset' in the bound GL_DRAW_INDIRECT_BUFFER,
+	// so the GPU decides whether it is drawn (see HiZCuller)
+	void DrawIndirect(Shader& shader, Camera& camera, glm::mat4 matrix, GLintptr commandOffset);
+	void DrawIndirect(ShaderVariants& variants, unsigned int sceneFeatures, Camera& camera, glm::mat4 matrix, GLintptr commandOffset);
+	// Draws only the positions with a depth-only shader whose view and projection are already set (see DepthPrePass).
+	// Alpha-tested materials are drawn from the full vertices, the shader needs their texture coordinates.
+	void DrawDepth(Shader& shader, glm::mat4 matrix);
+	void DrawDepthIndirect(Shader& shader, glm::mat4 matrix, GLintptr commandOffset);
+	// Back-face culling as the material wants it, with the front face winding of 'matrix' (a
+	// mirroring transform turns it around). Every mesh draw does this, see EndCulling.
+	void ApplyCulling(const glm::mat4& matrix) const;
+	// Culling off again after the scene passes, as the full-screen passes expect it
+	static void EndCulling();
+	// Frees the buffer bindDrawData falls back to
+	static void DeleteDrawBuffer();
+	// Names the mesh's vertex arrays and buffers in GPU captures (see GLDebug)
+	void Label(const std::string& name);
+
+private:
+	// Writes the model and normal matrix into drawStream and binds them to the DrawData block,
+	// or into a buffer of their own when no stream frame is active or its region is full
+	void bindDrawData(const glm::mat4& matrix);
+	// Binds the VAO, sets the culling and all per-draw uniforms
+	void bindDrawState(Shader& shader, Camera& camera, glm::mat4 matrix);
+};
 #endif
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include"MicroBenchmark.h"
+
+#include<algorithm>
+#include<cmath>
+#include<cstdio>
+#include<ctime>
+#include<fstream>
+#include<iostream>
+#include<thread>
+#include<json/json.h>
+
+using json = nlohmann::json;
+
+const void* volatile MicroBenchmark::escape = nullptr;
+
+bool MicroBenchmark::State::KeepRunning() {
+	// The first call starts the clock, so setup before the loop is not timed
+	if (!started) {
+		started = true;
+		start = std::chrono::high_resolution_clock::now();
+	}
+	if (remaining > 0) {
+		remaining--;
+		return true;
+	}
+	if (!paused)
+		seconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	return false;
+}
+
+void MicroBenchmark::State::PauseTiming() {
+	seconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	paused = true;
+}
+
+void MicroBenchmark::State::ResumeTiming() {
+	paused = false;
+	start = std::chrono::high_resolution_clock::now();
+}
+
+double MicroBenchmark::runOnce(const Function& function, unsigned long long iterations, State& state) {
+	state.remaining = iterations;
+	state.started = false;
+	state.paused = false;
+	state.seconds = 0.0;
+	function(state);
+	return state.seconds;
+}
+
+void MicroBenchmark::Run(const std::string& name, const Function& function) {
+	if (!filter.empty() && name.find(filter) == std::string::npos)
+		return;
+	if (!headerPrinted) {
+		std::printf("  %-44s %14s %10s %12s %12s\n", "Benchmark", "Time (median)", "CV", "Iterations", "Items/s");
+		headerPrinted = true;
+	}
+
+	// Grow the iteration count until a run is long enough to time, as Google Benchmark does
+	State state;
+	unsigned long long iterations = 1;
+	for (;;) {
+		double seconds = runOnce(function, iterations, state);
+		if (seconds >= minSeconds || iterations >= 1000000000ull)
+			break;
+		double multiplier = seconds > 0.0 ? minSeconds * 1.4 / seconds : 10.0;
+		multiplier = std::min(std::max(multiplier, 2.0), 10.0);
+		iterations = (unsigned long long) (iterations * multiplier);
+	}
+
+	Result result;
+	result.name = name;
+	result.iterations = iterations;
+	for (unsigned int i = 0; i < std::max(repetitions, 1u); i++)
+		result.times.push_back(runOnce(function, iterations, state) * 1.0e9 / iterations);
+	result.itemsPerIteration = state.itemsPerIteration;
+
+	std::vector<double> sorted = result.times;
+	std::sort(sorted.begin(), sorted.end());
+	size_t count = sorted.size();
+	result.median = count % 2 ? sorted[count / 2] : 0.5 * (sorted[count / 2 - 1] + sorted[count / 2]);
+	result.min = sorted[0];
+	for (double time : sorted)
+		result.mean += time / count;
+	for (double time : sorted)
+		result.stddev += (time - result.mean) * (time - result.mean);
+	result.stddev = count > 1 ? std::sqrt(result.stddev / (count - 1)) : 0.0;
+
+	// Pick a unit that keeps the time readable
+	const char* unit = "ns";
+	double shown = result.median;
+	if (shown >= 1.0e6) {
+		shown /= 1.0e6;
+		unit = "ms";
+	} else if (shown >= 1.0e3) {
+		shown /= 1.0e3;
+		unit = "us";
+	}
+	char items[32] = "";
+	if (result.itemsPerIteration > 0.0)
+		std::snprintf(items, sizeof(items), "%.3gM", result.itemsPerIteration * 1.0e3 / result.median);
+	std::printf("  %-44s %11.3f %s %9.1f%% %12llu %12s\n", name.c_str(), shown, unit,
+				result.mean > 0.0 ? 100.0 * result.stddev / result.mean : 0.0, result.iterations, items);
+	results.push_back(result);
+}
+
+bool MicroBenchmark::WriteJson(const char* file) const {
+	json report;
+	char date[64] = "";
+	std::time_t now = std::time(nullptr);
+	std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+	report["context"] = {
+		{"date", date},
+		{"num_cpus", std::thread::hardware_concurrency()},
+#ifdef NDEBUG
+		{"library_build_type", "release"},
+#else
+		{"library_build_type", "debug"},
+#endif
+		{"min_time", minSeconds},
+		{"repetitions", repetitions}
+	};
+
+	// One entry per repetition, then the aggregates, each with real time in ns per iteration
+	json benchmarks = json::array();
+	for (const Result& result : results) {
+		for (unsigned int i = 0; i < result.times.size(); i++) {
+			json entry = {
+				{"name", result.name},
+				{"run_name", result.name},
+				{"run_type", "iteration"},
+				{"repetitions", result.times.size()},
+				{"repetition_index", i},
+				{"iterations", result.iterations},
+				{"real_time", result.times[i]},
+				{"time_unit", "ns"}
+			};
+			if (result.itemsPerIteration > 0.0)
+				entry["items_per_second"] = result.itemsPerIteration * 1.0e9 / result.times[i];
+			benchmarks.push_back(entry);
+		}
+		const std::pair<const char*, double> aggregates[] = {
+			{"mean", result.mean}, {"median", result.median}, {"stddev", result.stddev}, {"min", result.min}
+		};
+		for (const auto& aggregate : aggregates) {
+			benchmarks.push_back({
+				{"name", result.name + "_" + aggregate.first},
+				{"run_name", result.name},
+				{"run_type", "aggregate"},
+				{"aggregate_name", aggregate.first},
+				{"repetitions", result.times.size()},
+				{"iterations", result.iterations},
+				{"real_time", aggregate.second},
+				{"time_unit", "ns"}
+			});
+		}
+	}
+	report["benchmarks"] = benchmarks;
+
+	std::ofstream out(file);
+	if (!out) {
+		std::cout << "MicroBenchmark: could not write " << file << std::endl;
+		return false;
+	}
+	out << report.dump(1) << std::endl;
+	return true;
+}
@@ -0,0 +1,76 @@
+#ifndef MICRO_BENCHMARK_CLASS_H
+#define MICRO_BENCHMARK_CLASS_H
+
+#include<chrono>
+#include<functional>
+#include<string>
+#include<vector>
+
+// Small Google Benchmark style runner for the hot paths under --benchmark micro (see Benchmarks.cpp).
+// A benchmark is a function that does its setup, then loops while state.KeepRunning(); only the loop
+// is timed. Like Google Benchmark the iteration count grows until one run lasts minSeconds, then the
+// run is repeated 'repetitions' times and the median, mean, standard deviation and minimum of the
+// time per iteration are reported.
+//
+// WriteJson writes the results in the layout of Google Benchmark's JSON output (wall clock times
+// only), so runs of two commits can be diffed benchmark by benchmark.
+class MicroBenchmark {
+public:
+	class State {
+	public:
+		bool KeepRunning();
+		// Work done by one iteration (vertices, rays, ...), for the throughput column
+		void SetItemsPerIteration(double items) {
+			itemsPerIteration = items;
+		}
+		// Leaves work inside the loop out of the time, e.g. resetting what the iteration changed
+		void PauseTiming();
+		void ResumeTiming();
+
+	private:
+		friend class MicroBenchmark;
+		unsigned long long remaining = 0;
+		bool started = false;
+		bool paused = false;
+		std::chrono::high_resolution_clock::time_point start;
+		double seconds = 0.0;
+		double itemsPerIteration = 0.0;
+	};
+	typedef std::function<void(State&)> Function;
+
+	struct Result {
+		std::string name;
+		unsigned long long iterations = 0;
+		// Nanoseconds per iteration of each repetition
+		std::vector<double> times;
+		double median = 0.0;
+		double mean = 0.0;
+		double stddev = 0.0;
+		double min = 0.0;
+		double itemsPerIteration = 0.0;
+	};
+
+	double minSeconds = 0.1;
+	unsigned int repetitions = 5;
+	// Only benchmarks whose name contains it run
+	std::string filter;
+	std::vector<Result> results;
+
+	// Runs a benchmark (unless filtered out) and prints its line
+	void Run(const std::string& name, const Function& function);
+	bool WriteJson(const char* file) const;
+
+	// Keeps the compiler from dropping a computation whose result is otherwise unused
+	template<typename T>
+	static void DoNotOptimize(const T& value) {
+		escape = &value;
+	}
+
+private:
+	static const void* volatile escape;
+	bool headerPrinted = false;
+
+	// Runs the function for 'iterations' iterations and returns the timed seconds
+	double runOnce(const Function& function, unsigned long long iterations, State& state);
+};
+#endif
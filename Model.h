@@ -1,75 +1,148 @@
-#ifndef MODEL_CLASS_H
-#define MODEL_CLASS_H
-
-#include<json/json.h>
-#include"Mesh.h"
-
-using json = nlohmann::json;
-
-
-class Model {
-public:
-	glm::vec3 minBounds;
-	glm::vec3 maxBounds;
-	// Loads in a model from a file and stores tha information in 'data', 'JSON', and 'file'
-	Model(const char* file);
-
-	void Draw(Shader& shader, Camera& camera);      
-	void Draw(Shader& shader, Camera& camera, glm::mat4 modelMatrix);
-
-	void CalculateBoundingBox();
-
-	// Check if a ray intersects this model
-	bool RayIntersectsModel(const glm::vec3& rayOrigin, const glm::vec3& rayDirection,
-							float maxDistance, const glm::mat4& modelMatrix) const;
-	bool RayIntersectsAABB(const glm::vec3& rayOrigin, const glm::vec3& rayDirection,
-						   const glm::vec3& boxMin, const glm::vec3& boxMax, float& distance) const;
-	// Getter for meshes to allow access from Camera
-	const std::vector<Mesh>& GetMeshes() const {
-		return meshes;
-	}
-
-private:
-	// Variables for easy access
-	const char* file;
-	std::vector<unsigned char> data;
-	json JSON;
-
-	// All the meshes and transformations
-	std::vector<Mesh> meshes;
-	std::vector<glm::vec3> translationsMeshes;
-	std::vector<glm::quat> rotationsMeshes;
-	std::vector<glm::vec3> scalesMeshes;
-	std::vector<glm::mat4> matricesMeshes;
-
-	// Prevents textures from being loaded twice
-	std::vector<std::string> loadedTexName;
-	std::vector<Texture> loadedTex;
-
-	// Loads a single mesh by its index
-	void loadMesh(unsigned int indMesh);
-
-	// Traverses a node recursively, so it essentially traverses all connected nodes
-	void traverseNode(unsigned int nextNode, glm::mat4 matrix = glm::mat4(1.0f));
-
-	// Gets the binary data from a file
-	std::vector<unsigned char> getData();
-	// Interprets the binary data into floats, indices, and textures
-	std::vector<float> getFloats(json accessor);
-	std::vector<GLuint> getIndices(json accessor);
-	std::vector<Texture> getTextures(unsigned int materialIndex);
-
-	// Assembles all the floats into vertices
-	std::vector<Vertex> assembleVertices
-	(
-		std::vector<glm::vec3> positions,
-		std::vector<glm::vec3> normals,
-		std::vector<glm::vec2> texUVs
-	);
-
-	// Helps with the assembly from above by grouping floats
-	std::vector<glm::vec2> groupFloatsVec2(std::vector<float> floatVec);
-	std::vector<glm::vec3> groupFloatsVec3(std::vector<float> floatVec);
-	std::vector<glm::vec4> groupFloatsVec4(std::vector<float> floatVec);
-};
+#ifndef MODEL_CLASS_H
+#define MODEL_CLASS_H
+
+#include<json/json.h>
+#include<unordered_map>
+#include"Mesh.h"
+#include"FrustumCuller.h"
+#include"FramePipeline.h"
+#include"HiZCuller.h"
+#include"OcclusionCuller.h"
+#include"VisibilityBuffer.h"
+#include"DepthPrePass.h"
+
+using json = nlohmann::json;
+
+class MicroBenchmark;
+
+class Model {
+public:
+	glm::vec3 minBounds;
+	glm::vec3 maxBounds;
+	// Loads in a model from a .gltf or .glb file and stores tha information in 'data', 'JSON', and 'file'
+	Model(const char* file);
+
+	void Draw(Shader& shader, Camera& camera);      
+	void Draw(Shader& shader, Camera& camera, glm::mat4 modelMatrix);
+	// Draws only the meshes whose entry in 'visibleMeshes' is non-zero (one entry per mesh)
+	void Draw(Shader& shader, Camera& camera, glm::mat4 modelMatrix, const unsigned char* visibleMeshes);
+
+	// Same, with each mesh drawn by the variant of its material (see ShaderVariants)
+	void Draw(ShaderVariants& variants, unsigned int sceneFeatures, Camera& camera, glm::mat4 modelMatrix, const unsigned char* visibleMeshes);
+	// Every mesh, nothing culled
+	void Draw(ShaderVariants& variants, unsigned int sceneFeatures, Camera& camera, glm::mat4 modelMatrix);
+
+	// Draws every mesh with the command the GPU culler wrote for it, starting at draw 'firstDraw'
+	void DrawIndirect(Shader& shader, Camera& camera, glm::mat4 modelMatrix, unsigned int firstDraw);
+	void DrawIndirect(ShaderVariants& variants, unsigned int sceneFeatures, Camera& camera, glm::mat4 modelMatrix, unsigned int firstDraw);
+	// Depth-only versions of Draw and DrawIndirect from the position streams, each mesh with the
+	// pre-pass program for its material
+	void DrawDepth(DepthPrePass& prePass, glm::mat4 modelMatrix, const unsigned char* visibleMeshes);
+	void DrawDepthIndirect(DepthPrePass& prePass, glm::mat4 modelMatrix, unsigned int firstDraw);
+	// Draws one mesh with its world matrix (instance matrix times node matrix), for FramePipeline draw lists
+	void DrawMesh(Shader& shader, Camera& camera, unsigned int mesh, const glm::mat4& worldMatrix);
+	void DrawMesh(ShaderVariants& variants, unsigned int sceneFeatures, Camera& camera, unsigned int mesh, const glm::mat4& worldMatrix);
+	void DrawMeshDepth(DepthPrePass& prePass, unsigned int mesh, const glm::mat4& worldMatrix);
+	// Draws the visible meshes into the visibility buffer, which records them for its resolve pass
+	void DrawVisibility(VisibilityBuffer& visibilityBuffer, glm::mat4 modelMatrix, const unsigned char* visibleMeshes);
+
+	// Adds the world bounds of every mesh to the culler and returns the index of the first one
+	unsigned int AddMeshBounds(FrustumCuller& culler, const glm::mat4& modelMatrix) const;
+	// Adds one GPU culled draw per mesh and returns the index of the first one
+	unsigned int AddGPUCullDraws(HiZCuller& culler, const glm::mat4& modelMatrix) const;
+	// Adds every mesh at least 'minSize' across in world space as an occluder and returns how many were added
+	unsigned int AddOccluders(OcclusionCuller& culler, const glm::mat4& modelMatrix, float minSize) const;
+	// World AABB enclosing both the collision bounds and every transformed mesh of an instance
+	void GetWorldBounds(const glm::mat4& modelMatrix, glm::vec3& outMin, glm::vec3& outMax) const;
+
+	void CalculateBoundingBox();
+
+	// Check if a ray intersects this model
+	bool RayIntersectsModel(const glm::vec3& rayOrigin, const glm::vec3& rayDirection,
+							float maxDistance, const glm::mat4& modelMatrix) const;
+	bool RayIntersectsAABB(const glm::vec3& rayOrigin, const glm::vec3& rayDirection,
+						   const glm::vec3& boxMin, const glm::vec3& boxMax, float& distance) const;
+	// Getter for meshes to allow access from Camera
+	const std::vector<Mesh>& GetMeshes() const {
+		return meshes;
+	}
+	// Bounds, node transform and shader features of each mesh (same order as GetMeshes), for FramePipeline
+	const std::vector<FramePipeline::MeshSource>& GetMeshSources() const {
+		return meshSources;
+	}
+	// Getter for the node transform of each mesh (same order as GetMeshes)
+	const std::vector<glm::mat4>& GetMeshMatrices() const {
+		return matricesMeshes;
+	}
+
+private:
+	// The micro-benchmarks time the loader steps on generated data, filled into an empty model
+	friend void RunMicroBenchmarks(MicroBenchmark& benchmark);
+	Model();
+
+	// Variables for easy access
+	const char* file;
+	std::vector<unsigned char> data;
+	json JSON;
+
+	// All the meshes and transformations
+	std::vector<Mesh> meshes;
+	std::vector<glm::vec3> translationsMeshes;
+	std::vector<glm::quat> rotationsMeshes;
+	std::vector<glm::vec3> scalesMeshes;
+	std::vector<glm::mat4> matricesMeshes;
+	std::vector<FramePipeline::MeshSource> meshSources;
+
+	// Prevents textures from being loaded twice
+	std::vector<std::string> loadedTexName;
+	std::vector<Texture> loadedTex;
+	// materialTable index of each glTF material loaded so far
+	std::unordered_map<unsigned int, unsigned int> loadedMaterials;
+
+	// Images decoded by jobs before the meshes are loaded, by path; freed once the textures are uploaded
+	struct DecodedImage {
+		unsigned char* bytes = nullptr;
+		int width = 0;
+		int height = 0;
+		int channels = 0;
+	};
+	std::unordered_map<std::string, DecodedImage> decodedImages;
+
+	// Decodes every image of the file in parallel on the job system
+	void decodeImages();
+	// Texture from the decoded image of 'path', or loaded from the file when it was not decoded
+	Texture loadTexture(const std::string& path, const char* texType, GLuint slot);
+
+	// Loads a single mesh by its index
+	void loadMesh(unsigned int indMesh);
+
+	// Traverses a node recursively, so it essentially traverses all connected nodes
+	void traverseNode(unsigned int nextNode, glm::mat4 matrix = glm::mat4(1.0f));
+
+	// Takes the JSON and BIN chunks of a binary glTF (.glb) file, false if 'contents' is not one
+	bool readBinary(const std::string& contents);
+	// Gets the binary data from a file
+	std::vector<unsigned char> getData();
+	// Interprets the binary data into floats, indices, and textures
+	std::vector<float> getFloats(json accessor);
+	std::vector<GLuint> getIndices(json accessor);
+	std::vector<Texture> getTextures(unsigned int materialIndex);
+	// Adds a glTF material (factors, textures, alpha mode, sidedness) to materialTable once and returns its index
+	unsigned int getMaterial(unsigned int materialIndex);
+	// textureTable entry of a glTF texture, loading it if no material used it yet
+	unsigned int getTextureEntry(const json& textureInfo, const char* texType);
+
+	// Assembles all the floats into vertices
+	std::vector<Vertex> assembleVertices
+	(
+		std::vector<glm::vec3> positions,
+		std::vector<glm::vec3> normals,
+		std::vector<glm::vec2> texUVs
+	);
+
+	// Helps with the assembly from above by grouping floats
+	std::vector<glm::vec2> groupFloatsVec2(std::vector<float> floatVec);
+	std::vector<glm::vec3> groupFloatsVec3(std::vector<float> floatVec);
+	std::vector<glm::vec4> groupFloatsVec4(std::vector<float> floatVec);
+};
 #endif
\ No newline at end of file
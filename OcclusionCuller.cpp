@@ -0,0 +1,363 @@
+#include"OcclusionCuller.h"
+
+#include<algorithm>
+#include<cfloat>
+#include<cmath>
+
+#if defined(__AVX__)
+#include<immintrin.h>
+#define OCCLUSION_CULLER_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include<emmintrin.h>
+#define OCCLUSION_CULLER_SSE
+#endif
+
+static const unsigned int fullCoverage = 0xFFFFFFFFu;
+
+OcclusionCuller::OcclusionCuller(int width, int height, unsigned int workerCount) {
+	// Round up to whole tiles
+	tilesX = (std::max(width, 1) + tileWidth - 1) / tileWidth;
+	tilesY = (std::max(height, 1) + tileHeight - 1) / tileHeight;
+	OcclusionCuller::width = tilesX * tileWidth;
+	OcclusionCuller::height = tilesY * tileHeight;
+	tiles.resize(tilesX * tilesY);
+
+	if (workerCount == 0) {
+		unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+	// More workers than tile rows would leave some without a band
+	workerCount = std::min(workerCount, (unsigned int) tilesY);
+	for (unsigned int i = 0; i < workerCount; i++)
+		workers.push_back(std::thread(&OcclusionCuller::workerLoop, this, i));
+}
+
+OcclusionCuller::~OcclusionCuller() {
+	Wait();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	startCondition.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void OcclusionCuller::ClearOccluders() {
+	Wait();
+	worldPositions.clear();
+	triangleIndices.clear();
+}
+
+void OcclusionCuller::AddOccluder(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices,
+								  const glm::mat4& transform) {
+	Wait();
+	unsigned int first = (unsigned int) worldPositions.size();
+	for (const glm::vec3& position : positions)
+		worldPositions.push_back(glm::vec3(transform * glm::vec4(position, 1.0f)));
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		triangleIndices.push_back(first + indices[i]);
+		triangleIndices.push_back(first + indices[i + 1]);
+		triangleIndices.push_back(first + indices[i + 2]);
+	}
+}
+
+void OcclusionCuller::RenderAsync(const glm::mat4& viewProjection) {
+	Wait();
+	OcclusionCuller::viewProjection = viewProjection;
+	screenPositions.resize(worldPositions.size());
+	occluderTriangleCount = (unsigned int) triangleIndices.size() / 3;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		generation++;
+		workersBusy = (unsigned int) workers.size();
+		phaseArrived = 0;
+		rendering = true;
+	}
+	startCondition.notify_all();
+}
+
+void OcclusionCuller::Wait() {
+	std::unique_lock<std::mutex> lock(mutex);
+	if (!rendering)
+		return;
+	doneCondition.wait(lock, [this] { return workersBusy == 0; });
+	rendering = false;
+	hasDepth = true;
+}
+
+void OcclusionCuller::Render(const glm::mat4& viewProjection) {
+	RenderAsync(viewProjection);
+	Wait();
+}
+
+void OcclusionCuller::workerLoop(unsigned int worker) {
+	unsigned int seenGeneration = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			startCondition.wait(lock, [&] { return stopping || generation != seenGeneration; });
+			if (stopping)
+				return;
+			seenGeneration = generation;
+		}
+
+		renderWorker(worker);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--workersBusy == 0)
+			doneCondition.notify_all();
+	}
+}
+
+void OcclusionCuller::waitForPhase() {
+	std::unique_lock<std::mutex> lock(mutex);
+	unsigned int currentPhase = phaseGeneration;
+	if (++phaseArrived == workers.size()) {
+		phaseArrived = 0;
+		phaseGeneration++;
+		phaseCondition.notify_all();
+		return;
+	}
+	phaseCondition.wait(lock, [&] { return phaseGeneration != currentPhase; });
+}
+
+void OcclusionCuller::renderWorker(unsigned int worker) {
+	unsigned int workerCount = (unsigned int) workers.size();
+
+	// Project this worker's slice of the vertices. w is set to 0 for vertices behind the near plane.
+	size_t vertexCount = worldPositions.size();
+	size_t firstVertex = vertexCount * worker / workerCount;
+	size_t endVertex = vertexCount * (worker + 1) / workerCount;
+	for (size_t i = firstVertex; i < endVertex; i++) {
+		glm::vec4 clip = viewProjection * glm::vec4(worldPositions[i], 1.0f);
+		if (clip.w <= 1e-5f) {
+			screenPositions[i] = glm::vec4(0.0f);
+			continue;
+		}
+		float invW = 1.0f / clip.w;
+		screenPositions[i] = glm::vec4((clip.x * invW * 0.5f + 0.5f) * width, (clip.y * invW * 0.5f + 0.5f) * height,
+									   clip.z * invW * 0.5f + 0.5f, clip.w);
+	}
+
+	// Triangles may use vertices projected by any worker
+	waitForPhase();
+
+	// Clear and rasterize this worker's band of tile rows
+	int firstTileRow = tilesY * worker / workerCount;
+	int endTileRow = tilesY * (worker + 1) / workerCount;
+	for (int i = firstTileRow * tilesX; i < endTileRow * tilesX; i++) {
+		tiles[i].mask = 0;
+		tiles[i].zMax0 = 1.0f;
+		tiles[i].zMax1 = 0.0f;
+	}
+
+	float bandMinY = (float) (firstTileRow * tileHeight);
+	float bandMaxY = (float) (endTileRow * tileHeight);
+	for (size_t i = 0; i + 2 < triangleIndices.size(); i += 3) {
+		const glm::vec4& v0 = screenPositions[triangleIndices[i]];
+		const glm::vec4& v1 = screenPositions[triangleIndices[i + 1]];
+		const glm::vec4& v2 = screenPositions[triangleIndices[i + 2]];
+		// Triangles crossing the near plane are skipped, drawing fewer occluders is always safe
+		if (v0.w <= 0.0f || v1.w <= 0.0f || v2.w <= 0.0f)
+			continue;
+		if (std::max(v0.y, std::max(v1.y, v2.y)) < bandMinY || std::min(v0.y, std::min(v1.y, v2.y)) >= bandMaxY)
+			continue;
+		rasterizeTriangle(v0, v1, v2, firstTileRow, endTileRow);
+	}
+}
+
+void OcclusionCuller::rasterizeTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c, int firstTileRow, int endTileRow) {
+	// Occluders are double sided, counter-clockwise order keeps the edge functions positive inside
+	float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+	if (std::fabs(area) < 1e-6f)
+		return;
+	glm::vec4 v0 = a;
+	glm::vec4 v1 = area > 0.0f ? b : c;
+	glm::vec4 v2 = area > 0.0f ? c : b;
+	area = std::fabs(area);
+
+	// Pixel bounds, clamped to the screen and to this worker's band
+	int minX = std::max(0, (int) std::floor(std::min(v0.x, std::min(v1.x, v2.x))));
+	int maxX = std::min(width - 1, (int) std::floor(std::max(v0.x, std::max(v1.x, v2.x))));
+	int minY = std::max(firstTileRow * tileHeight, (int) std::floor(std::min(v0.y, std::min(v1.y, v2.y))));
+	int maxY = std::min(endTileRow * tileHeight - 1, (int) std::floor(std::max(v0.y, std::max(v1.y, v2.y))));
+	if (minX > maxX || minY > maxY)
+		return;
+
+	// Edge functions A * x + B * y + C, non-negative inside
+	float edgeA[3], edgeB[3], edgeC[3];
+	const glm::vec4* vertices[3] = {&v0, &v1, &v2};
+	for (int e = 0; e < 3; e++) {
+		const glm::vec4& p = *vertices[e];
+		const glm::vec4& q = *vertices[(e + 1) % 3];
+		edgeA[e] = p.y - q.y;
+		edgeB[e] = q.x - p.x;
+		edgeC[e] = p.x * q.y - p.y * q.x;
+	}
+
+	// Depth plane z = z0 + dzdx * (x - x0) + dzdy * (y - y0), clamped to the farthest vertex
+	float dzdx = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) / area;
+	float dzdy = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) / area;
+	float triangleZMax = std::max(v0.z, std::max(v1.z, v2.z));
+
+#if defined(OCCLUSION_CULLER_AVX)
+	const __m256 columnOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+	const __m256 zero = _mm256_setzero_ps();
+#elif defined(OCCLUSION_CULLER_SSE)
+	const __m128 columnOffsetsLow = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 columnOffsetsHigh = _mm_setr_ps(4.5f, 5.5f, 6.5f, 7.5f);
+	const __m128 zero = _mm_setzero_ps();
+#endif
+
+	for (int tileY = minY / tileHeight; tileY <= maxY / tileHeight; tileY++) {
+		for (int tileX = minX / tileWidth; tileX <= maxX / tileWidth; tileX++) {
+			float pixelX = (float) (tileX * tileWidth);
+			float pixelY = (float) (tileY * tileHeight);
+
+			// Edge functions are linear, so their range over the tile's pixel centers is found at its corners
+			bool outside = false;
+			bool covered = true;
+			for (int e = 0; e < 3 && !outside; e++) {
+				float e00 = edgeA[e] * (pixelX + 0.5f) + edgeB[e] * (pixelY + 0.5f) + edgeC[e];
+				float stepX = edgeA[e] * (tileWidth - 1);
+				float stepY = edgeB[e] * (tileHeight - 1);
+				float lowest = e00 + std::min(stepX, 0.0f) + std::min(stepY, 0.0f);
+				float highest = e00 + std::max(stepX, 0.0f) + std::max(stepY, 0.0f);
+				outside = highest < 0.0f;
+				covered = covered && lowest >= 0.0f;
+			}
+			if (outside)
+				continue;
+
+			unsigned int coverage = fullCoverage;
+			if (!covered) {
+				coverage = 0;
+				for (int row = 0; row < tileHeight; row++) {
+					float y = pixelY + row + 0.5f;
+					unsigned int rowMask;
+#if defined(OCCLUSION_CULLER_AVX)
+					__m256 x = _mm256_add_ps(_mm256_set1_ps(pixelX), columnOffsets);
+					__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+					for (int e = 0; e < 3; e++) {
+						__m256 value = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(edgeA[e]), x),
+													 _mm256_set1_ps(edgeB[e] * y + edgeC[e]));
+						inside = _mm256_and_ps(inside, _mm256_cmp_ps(value, zero, _CMP_GE_OQ));
+					}
+					rowMask = (unsigned int) _mm256_movemask_ps(inside);
+#elif defined(OCCLUSION_CULLER_SSE)
+					__m128 xLow = _mm_add_ps(_mm_set1_ps(pixelX), columnOffsetsLow);
+					__m128 xHigh = _mm_add_ps(_mm_set1_ps(pixelX), columnOffsetsHigh);
+					__m128 insideLow = _mm_castsi128_ps(_mm_set1_epi32(-1));
+					__m128 insideHigh = insideLow;
+					for (int e = 0; e < 3; e++) {
+						__m128 a = _mm_set1_ps(edgeA[e]);
+						__m128 rowValue = _mm_set1_ps(edgeB[e] * y + edgeC[e]);
+						insideLow = _mm_and_ps(insideLow, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a, xLow), rowValue), zero));
+						insideHigh = _mm_and_ps(insideHigh, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a, xHigh), rowValue), zero));
+					}
+					rowMask = (unsigned int) (_mm_movemask_ps(insideLow) | (_mm_movemask_ps(insideHigh) << 4));
+#else
+					rowMask = 0;
+					for (int column = 0; column < tileWidth; column++) {
+						float x = pixelX + column + 0.5f;
+						bool inside = true;
+						for (int e = 0; e < 3; e++)
+							inside = inside && edgeA[e] * x + edgeB[e] * y + edgeC[e] >= 0.0f;
+						rowMask |= (inside ? 1u : 0u) << column;
+					}
+#endif
+					coverage |= rowMask << (row * tileWidth);
+				}
+				if (coverage == 0)
+					continue;
+			}
+
+			// Farthest depth the triangle can have inside the tile
+			float z00 = v0.z + dzdx * (pixelX - v0.x) + dzdy * (pixelY - v0.y);
+			float tileZMax = z00 + std::max(dzdx * tileWidth, 0.0f) + std::max(dzdy * tileHeight, 0.0f);
+			updateTile(tiles[tileY * tilesX + tileX], coverage, std::min(tileZMax, triangleZMax));
+		}
+	}
+}
+
+void OcclusionCuller::updateTile(Tile& tile, unsigned int coverage, float depth) {
+	// Behind what already covers the whole tile
+	if (depth >= tile.zMax0)
+		return;
+
+	if (coverage == fullCoverage) {
+		tile.zMax0 = depth;
+		tile.mask = 0;
+		tile.zMax1 = 0.0f;
+		return;
+	}
+
+	// Merge into the working layer, which replaces the reference layer once it covers the whole tile
+	tile.mask |= coverage;
+	tile.zMax1 = std::max(tile.zMax1, depth);
+	if (tile.mask == fullCoverage) {
+		tile.zMax0 = tile.zMax1;
+		tile.mask = 0;
+		tile.zMax1 = 0.0f;
+	}
+}
+
+bool OcclusionCuller::IsVisible(const glm::vec3& minBounds, const glm::vec3& maxBounds) const {
+	if (!hasDepth)
+		return true;
+
+	float minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+	float nearestDepth = FLT_MAX;
+	for (int i = 0; i < 8; i++) {
+		glm::vec3 corner((i & 1) ? maxBounds.x : minBounds.x, (i & 2) ? maxBounds.y : minBounds.y,
+						 (i & 4) ? maxBounds.z : minBounds.z);
+		glm::vec4 clip = viewProjection * glm::vec4(corner, 1.0f);
+		// Bounds crossing the near plane cannot be tested reliably
+		if (clip.w <= 1e-5f)
+			return true;
+		float invW = 1.0f / clip.w;
+		float x = (clip.x * invW * 0.5f + 0.5f) * width;
+		float y = (clip.y * invW * 0.5f + 0.5f) * height;
+		minX = std::min(minX, x);
+		maxX = std::max(maxX, x);
+		minY = std::min(minY, y);
+		maxY = std::max(maxY, y);
+		nearestDepth = std::min(nearestDepth, clip.z * invW * 0.5f + 0.5f);
+	}
+
+	int pixelMinX = std::max(0, (int) std::floor(minX));
+	int pixelMaxX = std::min(width - 1, (int) std::floor(maxX));
+	int pixelMinY = std::max(0, (int) std::floor(minY));
+	int pixelMaxY = std::min(height - 1, (int) std::floor(maxY));
+	// Off screen, that is for the frustum test to decide
+	if (pixelMinX > pixelMaxX || pixelMinY > pixelMaxY)
+		return true;
+
+	for (int tileY = pixelMinY / tileHeight; tileY <= pixelMaxY / tileHeight; tileY++) {
+		for (int tileX = pixelMinX / tileWidth; tileX <= pixelMaxX / tileWidth; tileX++) {
+			if (nearestDepth <= tiles[tileY * tilesX + tileX].zMax0)
+				return true;
+		}
+	}
+	return false;
+}
+
+unsigned int OcclusionCuller::Cull(FrustumCuller& culler) {
+	testedCount = 0;
+	occludedCount = 0;
+	for (unsigned int i = 0; i < culler.visible.size(); i++) {
+		if (!culler.visible[i])
+			continue;
+		glm::vec3 center(culler.centerX[i], culler.centerY[i], culler.centerZ[i]);
+		glm::vec3 extent(culler.extentX[i], culler.extentY[i], culler.extentZ[i]);
+		testedCount++;
+		if (!IsVisible(center - extent, center + extent)) {
+			culler.visible[i] = 0;
+			culler.visibleCount--;
+			occludedCount++;
+		}
+	}
+	return occludedCount;
+}
@@ -0,0 +1,102 @@
+#ifndef OCCLUSION_CULLER_CLASS_H
+#define OCCLUSION_CULLER_CLASS_H
+
+#include<glm/glm.hpp>
+#include<condition_variable>
+#include<mutex>
+#include<thread>
+#include<vector>
+
+#include"FrustumCuller.h"
+
+// Software occlusion culling that works on any driver. A few large occluders are rasterized on worker
+// threads into a low resolution masked depth buffer: every 8x4 pixel tile keeps a conservative far depth
+// for the whole tile plus a coverage mask and depth of the triangles that only cover part of it.
+// Bounds are then tested against the tile depths. Everything is CPU-side, so it also runs headless.
+class OcclusionCuller {
+public:
+	static const int tileWidth = 8;
+	static const int tileHeight = 4;
+
+	struct Tile {
+		// Pixels covered by the working layer, bit (row * tileWidth + column)
+		unsigned int mask;
+		// Farthest depth of the whole tile, what the tests compare against
+		float zMax0;
+		// Farthest depth of the pixels in 'mask', becomes zMax0 once the mask is full
+		float zMax1;
+	};
+
+	// Resolution of the depth buffer, in pixels (a multiple of the tile size)
+	int width;
+	int height;
+	int tilesX;
+	int tilesY;
+	std::vector<Tile> tiles;
+
+	// Camera matrix of the last Render, bounds are tested with the same one
+	glm::mat4 viewProjection;
+	// Whether a depth buffer has been rendered yet, without one everything is visible
+	bool hasDepth = false;
+
+	// Statistics of the last Render / Cull calls
+	unsigned int occluderTriangleCount = 0;
+	unsigned int testedCount = 0;
+	unsigned int occludedCount = 0;
+
+	// workerCount 0 picks one less than the number of hardware threads (at least one)
+	OcclusionCuller(int width = 320, int height = 192, unsigned int workerCount = 0);
+	~OcclusionCuller();
+	OcclusionCuller(const OcclusionCuller&) = delete;
+	OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+	// Removes all occluders
+	void ClearOccluders();
+	// Adds an indexed triangle list transformed by 'transform'. The world positions are stored, so occluders are static.
+	void AddOccluder(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& indices, const glm::mat4& transform);
+
+	// Starts rasterizing the occluders on the worker threads and returns immediately
+	void RenderAsync(const glm::mat4& viewProjection);
+	// Blocks until the rasterization started by RenderAsync has finished
+	void Wait();
+	// RenderAsync followed by Wait
+	void Render(const glm::mat4& viewProjection);
+
+	// Whether a world AABB may be visible. Only call this while no rasterization is running.
+	bool IsVisible(const glm::vec3& minBounds, const glm::vec3& maxBounds) const;
+	// Clears the 'visible' entry of every bounds in the culler that is occluded, returns how many were
+	unsigned int Cull(FrustumCuller& culler);
+
+	unsigned int WorkerCount() const {
+		return (unsigned int) workers.size();
+	}
+
+private:
+	// Occluder geometry in world space
+	std::vector<glm::vec3> worldPositions;
+	std::vector<unsigned int> triangleIndices;
+	// Per-vertex screen position (pixels), depth [0, 1] and clip w of the current Render
+	std::vector<glm::vec4> screenPositions;
+
+	// Worker threads, woken once per Render
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable startCondition;
+	std::condition_variable doneCondition;
+	std::condition_variable phaseCondition;
+	unsigned int generation = 0;
+	unsigned int workersBusy = 0;
+	unsigned int phaseArrived = 0;
+	unsigned int phaseGeneration = 0;
+	bool stopping = false;
+	bool rendering = false;
+
+	void workerLoop(unsigned int worker);
+	// Runs one worker's share of a Render: projecting its slice of the vertices, then its band of tile rows
+	void renderWorker(unsigned int worker);
+	// Waits until every worker has finished projecting
+	void waitForPhase();
+	void rasterizeTriangle(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2, int firstTileRow, int endTileRow);
+	void updateTile(Tile& tile, unsigned int coverage, float depth);
+};
+#endif
@@ -0,0 +1,295 @@
+#include"PortalSystem.h"
+
+#include<algorithm>
+#include<cfloat>
+#include<fstream>
+#include<iostream>
+#include<sstream>
+
+bool PortalSystem::LoadFromGLTF(const char* file) {
+	std::ifstream in(file, std::ios::binary);
+	if (!in)
+		return false;
+	std::stringstream contents;
+	contents << in.rdbuf();
+	json gltf = json::parse(contents.str(), nullptr, false);
+	if (gltf.is_discarded())
+		return false;
+
+	// Authoring tools put custom properties on the scene or on the root object
+	if (gltf.contains("scenes") && !gltf["scenes"].empty() && gltf["scenes"][0].contains("extras") &&
+		LoadFromJSON(gltf["scenes"][0]["extras"]))
+		return true;
+	if (gltf.contains("extras"))
+		return LoadFromJSON(gltf["extras"]);
+	return false;
+}
+
+bool PortalSystem::LoadFromFile(const char* file) {
+	std::ifstream in(file, std::ios::binary);
+	if (!in)
+		return false;
+	std::stringstream contents;
+	contents << in.rdbuf();
+	json data = json::parse(contents.str(), nullptr, false);
+	if (data.is_discarded()) {
+		std::cout << "PortalSystem: could not parse " << file << std::endl;
+		return false;
+	}
+	return LoadFromJSON(data);
+}
+
+static bool isVec3(const json& value) {
+	return value.is_array() && value.size() >= 3 && value[0].is_number() && value[1].is_number() && value[2].is_number();
+}
+
+static glm::vec3 readVec3(const json& value) {
+	return glm::vec3(value[0].get<float>(), value[1].get<float>(), value[2].get<float>());
+}
+
+bool PortalSystem::LoadFromJSON(const json& data) {
+	if (!data.is_object() || !data.contains("cells") || !data["cells"].is_array())
+		return false;
+
+	if (data.contains("portals") && !data["portals"].is_array())
+		return false;
+
+	Clear();
+	for (const json& cell : data["cells"]) {
+		if (!cell.is_object() || !cell.contains("min") || !cell.contains("max") || !isVec3(cell["min"]) || !isVec3(cell["max"]) ||
+			(cell.contains("name") && !cell["name"].is_string())) {
+			std::cout << "PortalSystem: cell " << cells.size() << " needs \"min\" and \"max\" as [x, y, z]" << std::endl;
+			Clear();
+			return false;
+		}
+		std::string name = cell.contains("name") ? cell["name"].get<std::string>() : "cell" + std::to_string(cells.size());
+		AddCell(name, readVec3(cell["min"]), readVec3(cell["max"]));
+	}
+
+	if (data.contains("portals")) {
+		for (const json& portal : data["portals"]) {
+			if (!portal.is_object() || !portal.contains("cells") || !portal["cells"].is_array() || portal["cells"].size() != 2 ||
+				!portal.contains("points") || !portal["points"].is_array() ||
+				!std::all_of(portal["points"].begin(), portal["points"].end(), isVec3)) {
+				std::cout << "PortalSystem: portal " << portals.size() << " needs two \"cells\" and \"points\" as [x, y, z]" << std::endl;
+				Clear();
+				return false;
+			}
+			int connected[2] = {-1, -1};
+			for (int side = 0; side < 2; side++) {
+				const json& reference = portal["cells"][side];
+				if (reference.is_number_integer()) {
+					connected[side] = reference.get<int>();
+				} else if (reference.is_string()) {
+					for (unsigned int i = 0; i < cells.size(); i++) {
+						if (cells[i].name == reference.get<std::string>())
+							connected[side] = (int) i;
+					}
+				}
+			}
+			if (connected[0] < 0 || connected[1] < 0 || connected[0] >= (int) cells.size() || connected[1] >= (int) cells.size()) {
+				std::cout << "PortalSystem: skipping portal with unknown cells" << std::endl;
+				continue;
+			}
+
+			std::vector<glm::vec3> points;
+			for (const json& point : portal["points"])
+				points.push_back(readVec3(point));
+			if (points.size() < 3) {
+				std::cout << "PortalSystem: skipping portal with less than 3 points" << std::endl;
+				continue;
+			}
+			AddPortal((unsigned int) connected[0], (unsigned int) connected[1], points);
+		}
+	}
+
+	std::cout << "PortalSystem: " << cells.size() << " cells, " << portals.size() << " portals" << std::endl;
+	return !cells.empty();
+}
+
+unsigned int PortalSystem::AddCell(const std::string& name, const glm::vec3& minBounds, const glm::vec3& maxBounds) {
+	Cell cell;
+	cell.name = name;
+	cell.minBounds = glm::min(minBounds, maxBounds);
+	cell.maxBounds = glm::max(minBounds, maxBounds);
+	cells.push_back(cell);
+	cellVisible.push_back(1);
+	return (unsigned int) cells.size() - 1;
+}
+
+unsigned int PortalSystem::AddPortal(unsigned int cellA, unsigned int cellB, const std::vector<glm::vec3>& points) {
+	Portal portal;
+	portal.cells[0] = cellA;
+	portal.cells[1] = cellB;
+	portal.points = points;
+	portals.push_back(portal);
+
+	unsigned int index = (unsigned int) portals.size() - 1;
+	cells[cellA].portals.push_back(index);
+	cells[cellB].portals.push_back(index);
+	return index;
+}
+
+void PortalSystem::Clear() {
+	cells.clear();
+	portals.clear();
+	cellVisible.clear();
+	cameraCell = -1;
+}
+
+int PortalSystem::FindCell(const glm::vec3& position) const {
+	// Cells may overlap at their walls, the smallest one containing the point wins
+	int found = -1;
+	float foundVolume = FLT_MAX;
+	for (unsigned int i = 0; i < cells.size(); i++) {
+		const Cell& cell = cells[i];
+		if (glm::all(glm::greaterThanEqual(position, cell.minBounds)) && glm::all(glm::lessThanEqual(position, cell.maxBounds))) {
+			glm::vec3 size = cell.maxBounds - cell.minBounds;
+			float volume = size.x * size.y * size.z;
+			if (volume < foundVolume) {
+				found = (int) i;
+				foundVolume = volume;
+			}
+		}
+	}
+	return found;
+}
+
+void PortalSystem::Update(const glm::vec3& cameraPosition, const glm::mat4& viewProjection) {
+	cellsVisited = 0;
+	portalsTested = 0;
+	cameraCell = FindCell(cameraPosition);
+
+	// Outside every cell the portals say nothing about what is visible
+	if (cameraCell < 0) {
+		std::fill(cellVisible.begin(), cellVisible.end(), 1);
+		return;
+	}
+
+	std::fill(cellVisible.begin(), cellVisible.end(), 0);
+	cellVisits.assign(cells.size(), std::vector<Visit>());
+	std::vector<unsigned char> onPath(cells.size(), 0);
+	visitCell((unsigned int) cameraCell, glm::vec4(-1.0f, -1.0f, 1.0f, 1.0f), viewProjection, 0, onPath);
+}
+
+void PortalSystem::visitCell(unsigned int cell, const glm::vec4& rect, const glm::mat4& viewProjection, unsigned int depth,
+							 std::vector<unsigned char>& onPath) {
+	// Reached before through one rectangle covering this one, on a path no deeper: everything behind
+	// it was already seen. Only a single earlier rectangle counts, several together may leave gaps.
+	for (const Visit& visit : cellVisits[cell]) {
+		if (visit.depth <= depth && rect.x >= visit.rect.x && rect.y >= visit.rect.y && rect.z <= visit.rect.z && rect.w <= visit.rect.w)
+			return;
+	}
+	cellVisits[cell].push_back({rect, depth});
+
+	cellsVisited++;
+	cellVisible[cell] = 1;
+	if (depth >= maxDepth)
+		return;
+
+	// A cell can be reached through several portals, each with its own view rectangle, but never loop back on the same path
+	onPath[cell] = 1;
+	for (unsigned int portalIndex : cells[cell].portals) {
+		const Portal& portal = portals[portalIndex];
+		unsigned int next = portal.cells[0] == cell ? portal.cells[1] : portal.cells[0];
+		if (onPath[next])
+			continue;
+
+		portalsTested++;
+		glm::vec4 portalBounds;
+		if (!portalRect(portal, viewProjection, portalBounds))
+			continue;
+
+		// Whatever is seen through the portal is limited to the part of it seen through the previous ones
+		glm::vec4 narrowed(glm::max(rect.x, portalBounds.x), glm::max(rect.y, portalBounds.y),
+						   glm::min(rect.z, portalBounds.z), glm::min(rect.w, portalBounds.w));
+		if (narrowed.x >= narrowed.z || narrowed.y >= narrowed.w)
+			continue;
+
+		visitCell(next, narrowed, viewProjection, depth + 1, onPath);
+	}
+	onPath[cell] = 0;
+}
+
+bool PortalSystem::portalRect(const Portal& portal, const glm::mat4& viewProjection, glm::vec4& rect) const {
+	const float nearW = 1e-4f;
+
+	std::vector<glm::vec4> clip;
+	for (const glm::vec3& point : portal.points)
+		clip.push_back(viewProjection * glm::vec4(point, 1.0f));
+
+	// Clip the polygon against w = nearW (Sutherland-Hodgman with a single plane)
+	std::vector<glm::vec4> clipped;
+	for (size_t i = 0; i < clip.size(); i++) {
+		const glm::vec4& current = clip[i];
+		const glm::vec4& next = clip[(i + 1) % clip.size()];
+		bool currentInside = current.w >= nearW;
+		bool nextInside = next.w >= nearW;
+		if (currentInside)
+			clipped.push_back(current);
+		if (currentInside != nextInside) {
+			float t = (nearW - current.w) / (next.w - current.w);
+			clipped.push_back(current + (next - current) * t);
+		}
+	}
+	if (clipped.empty())
+		return false;
+
+	rect = glm::vec4(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (const glm::vec4& point : clipped) {
+		glm::vec2 ndc = glm::vec2(point) / point.w;
+		rect.x = glm::min(rect.x, ndc.x);
+		rect.y = glm::min(rect.y, ndc.y);
+		rect.z = glm::max(rect.z, ndc.x);
+		rect.w = glm::max(rect.w, ndc.y);
+	}
+	return true;
+}
+
+bool PortalSystem::IsPointVisible(const glm::vec3& position) const {
+	if (cameraCell < 0)
+		return true;
+	bool inAnyCell = false;
+	for (unsigned int i = 0; i < cells.size(); i++) {
+		if (glm::all(glm::greaterThanEqual(position, cells[i].minBounds)) && glm::all(glm::lessThanEqual(position, cells[i].maxBounds))) {
+			if (cellVisible[i])
+				return true;
+			inAnyCell = true;
+		}
+	}
+	return !inAnyCell;
+}
+
+bool PortalSystem::IsBoxVisible(const glm::vec3& minBounds, const glm::vec3& maxBounds) const {
+	if (cameraCell < 0)
+		return true;
+	bool inAnyCell = false;
+	for (unsigned int i = 0; i < cells.size(); i++) {
+		if (glm::all(glm::lessThanEqual(minBounds, cells[i].maxBounds)) && glm::all(glm::greaterThanEqual(maxBounds, cells[i].minBounds))) {
+			if (cellVisible[i])
+				return true;
+			inAnyCell = true;
+		}
+	}
+	// Geometry outside every cell (e.g. the exterior) is left to the other culling stages
+	return !inAnyCell;
+}
+
+unsigned int PortalSystem::Cull(FrustumCuller& culler) {
+	meshesRejected = 0;
+	if (cameraCell < 0)
+		return 0;
+
+	for (unsigned int i = 0; i < culler.visible.size(); i++) {
+		if (!culler.visible[i])
+			continue;
+		glm::vec3 center(culler.centerX[i], culler.centerY[i], culler.centerZ[i]);
+		glm::vec3 extent(culler.extentX[i], culler.extentY[i], culler.extentZ[i]);
+		if (!IsBoxVisible(center - extent, center + extent)) {
+			culler.visible[i] = 0;
+			culler.visibleCount--;
+			meshesRejected++;
+		}
+	}
+	return meshesRejected;
+}
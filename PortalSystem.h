@@ -0,0 +1,90 @@
+#ifndef PORTAL_SYSTEM_CLASS_H
+#define PORTAL_SYSTEM_CLASS_H
+
+#include<glm/glm.hpp>
+#include<json/json.h>
+#include<string>
+#include<vector>
+
+#include"FrustumCuller.h"
+
+using json = nlohmann::json;
+
+// Cell-and-portal visibility for interiors. Cells are boxes (rooms), portals are convex polygons
+// (doors, windows) connecting two cells. Each frame the cells reachable from the camera's cell through
+// portals that stay on screen are flood-filled; geometry and lights only in other cells can be skipped.
+//
+// Cells and portals are read from "extras" in the glTF (scene or root) or from a standalone file:
+//   { "cells":   [ { "name": "hall", "min": [x, y, z], "max": [x, y, z] }, ... ],
+//     "portals": [ { "cells": ["hall", 1], "points": [[x, y, z], [x, y, z], [x, y, z], ...] }, ... ] }
+// Portal cells can be given by name or index. The data is in world space.
+class PortalSystem {
+public:
+	struct Cell {
+		std::string name;
+		glm::vec3 minBounds;
+		glm::vec3 maxBounds;
+		// Indices into 'portals'
+		std::vector<unsigned int> portals;
+	};
+	struct Portal {
+		unsigned int cells[2];
+		// Convex polygon, in order
+		std::vector<glm::vec3> points;
+	};
+
+	std::vector<Cell> cells;
+	std::vector<Portal> portals;
+
+	// Result of the last Update, one entry per cell (1 = reachable)
+	std::vector<unsigned char> cellVisible;
+	// Cell containing the camera, -1 when it is outside every cell (then nothing is rejected)
+	int cameraCell = -1;
+	// Paths through more portals than this are not followed
+	unsigned int maxDepth = 16;
+
+	// Statistics of the last Update / Cull calls
+	unsigned int cellsVisited = 0;
+	unsigned int portalsTested = 0;
+	unsigned int meshesRejected = 0;
+
+	// Reads cells and portals from the extras of a glTF file, returns false if it has none
+	bool LoadFromGLTF(const char* file);
+	// Reads cells and portals from a standalone JSON file (same layout as the extras), returns false if missing
+	bool LoadFromFile(const char* file);
+	// Reads cells and portals from a JSON object with "cells" and "portals" arrays, false (and no cells) on malformed input
+	bool LoadFromJSON(const json& data);
+
+	unsigned int AddCell(const std::string& name, const glm::vec3& minBounds, const glm::vec3& maxBounds);
+	unsigned int AddPortal(unsigned int cellA, unsigned int cellB, const std::vector<glm::vec3>& points);
+	void Clear();
+	bool Enabled() const {
+		return !cells.empty();
+	}
+
+	// Index of the cell containing 'position', or -1
+	int FindCell(const glm::vec3& position) const;
+	// Flood-fills the visible cells from the camera's cell
+	void Update(const glm::vec3& cameraPosition, const glm::mat4& viewProjection);
+
+	// Whether a point (e.g. a light) is in a reachable cell, or in no cell at all
+	bool IsPointVisible(const glm::vec3& position) const;
+	// Whether a world AABB overlaps a reachable cell, or no cell at all
+	bool IsBoxVisible(const glm::vec3& minBounds, const glm::vec3& maxBounds) const;
+	// Clears the 'visible' entry of every bounds in the culler that is only in unreachable cells, returns how many were
+	unsigned int Cull(FrustumCuller& culler);
+
+private:
+	struct Visit {
+		glm::vec4 rect;
+		unsigned int depth;
+	};
+	// Screen rectangles (and path depths) each cell was visited with during the last Update
+	std::vector<std::vector<Visit>> cellVisits;
+
+	// Screen rectangle (NDC min x, min y, max x, max y) of a portal, false when it is entirely behind the camera
+	bool portalRect(const Portal& portal, const glm::mat4& viewProjection, glm::vec4& rect) const;
+	void visitCell(unsigned int cell, const glm::vec4& rect, const glm::mat4& viewProjection, unsigned int depth,
+				   std::vector<unsigned char>& onPath);
+};
+#endif
@@ -0,0 +1,301 @@
+#include"Profiler.h"
+
+#include<algorithm>
+#include<cmath>
+#include<cstdio>
+#include<iostream>
+#include<map>
+
+Profiler profiler;
+
+static double toMilliseconds(long long nanoseconds) {
+	return nanoseconds / 1.0e6;
+}
+
+// Nearest-rank percentile of sorted values
+static double percentile(const std::vector<long long>& sorted, double fraction) {
+	size_t rank = (size_t) std::ceil(fraction * sorted.size());
+	rank = std::min(std::max(rank, (size_t) 1), sorted.size());
+	return toMilliseconds(sorted[rank - 1]);
+}
+
+// Zone names are code literals, but keep the JSON valid whatever they contain
+static void writeEscaped(FILE* file, const char* text) {
+	for (const char* c = text; *c != 0; c++) {
+		if (*c == '"' || *c == '\\')
+			fputc('\\', file);
+		if ((unsigned char) *c >= 0x20)
+			fputc(*c, file);
+	}
+}
+
+Profiler::Profiler() {
+	epoch = std::chrono::steady_clock::now();
+}
+
+long long Profiler::Now() const {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+Profiler::ThreadBuffer& Profiler::threadBuffer() {
+	// There is only the one profiler, so a thread's buffer can be cached per thread
+	thread_local ThreadBuffer* buffer = nullptr;
+	if (buffer == nullptr) {
+		std::lock_guard<std::mutex> lock(threadsMutex);
+		threads.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer()));
+		threads.back()->name = "Thread " + std::to_string(threads.size());
+		buffer = threads.back().get();
+	}
+	return *buffer;
+}
+
+void Profiler::SetThreadName(const char* name) {
+	ThreadBuffer& buffer = threadBuffer();
+	std::lock_guard<std::mutex> lock(threadsMutex);
+	buffer.name = name;
+}
+
+void Profiler::StartCapture() {
+	{
+		std::lock_guard<std::mutex> lock(threadsMutex);
+		for (std::unique_ptr<ThreadBuffer>& buffer : threads) {
+			std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+			buffer->events.clear();
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(gpuMutex);
+		gpuEvents.clear();
+		gpuZonesDropped = 0;
+	}
+	captureStart = Now();
+	captureIndex++;
+	capturing = true;
+}
+
+void Profiler::StopCapture() {
+	capturing = false;
+}
+
+bool Profiler::CaptureComplete() const {
+	return !capturing && pendingGpuZones.load() == 0;
+}
+
+void Profiler::Record(const char* name, long long start, long long end) {
+	if (!capturing.load(std::memory_order_relaxed))
+		return;
+	ThreadBuffer& buffer = threadBuffer();
+	std::lock_guard<std::mutex> lock(buffer.mutex);
+	buffer.events.push_back({name, start, end - start, 0});
+}
+
+void Profiler::BeginGpuFrame() {
+	// Timestamps of the frame that used this slot gpuFrames - 1 frames ago
+	gpuFrame = (gpuFrame + 1) % gpuFrames;
+	resolveGpuFrame(gpuRing[gpuFrame]);
+
+	// GPU and CPU clocks only differ by an offset (close enough over a capture), taken once per capture
+	unsigned int capture = captureIndex.load();
+	if (capturing && gpuOffsetCapture != capture) {
+		GLint64 gpuNow = 0;
+		glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+		gpuOffset = Now() - (long long) gpuNow;
+		gpuOffsetCapture = capture;
+	}
+}
+
+unsigned int Profiler::BeginGpuZone(const char* name) {
+	if (!capturing.load(std::memory_order_relaxed) || gpuOffsetCapture != captureIndex.load())
+		return UINT_MAX;
+	GpuFrame& frame = gpuRing[gpuFrame];
+	GpuZone zone;
+	zone.name = name;
+	zone.begin = allocateQuery(frame);
+	zone.end = UINT_MAX;
+	glQueryCounter(frame.queries[zone.begin], GL_TIMESTAMP);
+	frame.zones.push_back(zone);
+	pendingGpuZones++;
+	return (unsigned int) frame.zones.size() - 1;
+}
+
+unsigned int Profiler::allocateQuery(GpuFrame& frame) {
+	if (frame.usedQueries == frame.queries.size()) {
+		size_t oldSize = frame.queries.size();
+		frame.queries.resize(std::max<size_t>(64, oldSize * 2));
+		glGenQueries((GLsizei) (frame.queries.size() - oldSize), frame.queries.data() + oldSize);
+	}
+	return frame.usedQueries++;
+}
+
+void Profiler::EndGpuZone(unsigned int zone) {
+	GpuFrame& frame = gpuRing[gpuFrame];
+	if (zone >= frame.zones.size())
+		return;
+	frame.zones[zone].end = allocateQuery(frame);
+	glQueryCounter(frame.queries[frame.zones[zone].end], GL_TIMESTAMP);
+}
+
+void Profiler::resolveGpuFrame(GpuFrame& frame) {
+	if (frame.zones.empty())
+		return;
+
+	// Timestamps complete in order, so once the last one is there all of them are
+	GLuint available = 0;
+	glGetQueryObjectuiv(frame.queries[frame.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (available) {
+		long long start = captureStart.load();
+		std::lock_guard<std::mutex> lock(gpuMutex);
+		for (const GpuZone& zone : frame.zones) {
+			if (zone.end == UINT_MAX)
+				continue;
+			GLuint64 begin = 0;
+			GLuint64 end = 0;
+			glGetQueryObjectui64v(frame.queries[zone.begin], GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(frame.queries[zone.end], GL_QUERY_RESULT, &end);
+			Event event = {zone.name, (long long) begin + gpuOffset, (long long) (end - begin), gpuThread};
+			// Left over from before the current capture started
+			if (event.start >= start)
+				gpuEvents.push_back(event);
+		}
+	} else {
+		std::lock_guard<std::mutex> lock(gpuMutex);
+		gpuZonesDropped += (unsigned int) frame.zones.size();
+	}
+	pendingGpuZones -= (unsigned int) frame.zones.size();
+	frame.zones.clear();
+	frame.usedQueries = 0;
+}
+
+void Profiler::FlushGpuFrames() {
+	glFinish();
+	for (GpuFrame& frame : gpuRing)
+		resolveGpuFrame(frame);
+}
+
+void Profiler::DeleteGpuQueries() {
+	for (GpuFrame& frame : gpuRing) {
+		pendingGpuZones -= (unsigned int) frame.zones.size();
+		if (!frame.queries.empty())
+			glDeleteQueries((GLsizei) frame.queries.size(), frame.queries.data());
+		frame.queries.clear();
+		frame.zones.clear();
+		frame.usedQueries = 0;
+	}
+}
+
+std::vector<Profiler::Event> Profiler::GetEvents() const {
+	std::vector<Event> events;
+	{
+		std::lock_guard<std::mutex> lock(threadsMutex);
+		for (size_t i = 0; i < threads.size(); i++) {
+			std::lock_guard<std::mutex> bufferLock(threads[i]->mutex);
+			for (Event event : threads[i]->events) {
+				event.thread = (unsigned int) i;
+				events.push_back(event);
+			}
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(gpuMutex);
+		events.insert(events.end(), gpuEvents.begin(), gpuEvents.end());
+	}
+	std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+		if ((a.thread == gpuThread) != (b.thread == gpuThread))
+			return b.thread == gpuThread;
+		return a.start < b.start;
+	});
+	return events;
+}
+
+std::vector<Profiler::ZoneSummary> Profiler::Summarize() const {
+	// Durations per zone, CPU and GPU zones of the same name kept apart
+	std::map<std::pair<bool, std::string>, std::vector<long long>> durations;
+	for (const Event& event : GetEvents())
+		durations[std::make_pair(event.thread == gpuThread, std::string(event.name))].push_back(event.duration);
+
+	std::vector<ZoneSummary> summaries;
+	for (auto& entry : durations) {
+		std::vector<long long>& values = entry.second;
+		std::sort(values.begin(), values.end());
+		long long total = 0;
+		for (long long value : values)
+			total += value;
+		ZoneSummary summary;
+		summary.name = entry.first.second;
+		summary.gpu = entry.first.first;
+		summary.count = values.size();
+		summary.total = toMilliseconds(total);
+		summary.mean = summary.total / values.size();
+		summary.p50 = percentile(values, 0.50);
+		summary.p90 = percentile(values, 0.90);
+		summary.p99 = percentile(values, 0.99);
+		summary.max = toMilliseconds(values.back());
+		summaries.push_back(summary);
+	}
+	// Most expensive first
+	std::sort(summaries.begin(), summaries.end(), [](const ZoneSummary& a, const ZoneSummary& b) {
+		return a.total > b.total;
+	});
+	return summaries;
+}
+
+bool Profiler::WriteChromeTrace(const char* file) const {
+	FILE* out = fopen(file, "w");
+	if (out == NULL) {
+		std::cout << "Profiler: could not write " << file << std::endl;
+		return false;
+	}
+
+	// CPU threads in one process, the GPU timeline in another. Times are in microseconds.
+	fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n");
+	fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"tid\":0,\"args\":{\"name\":\"GPU\"}},\n");
+	fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":2,\"tid\":0,\"args\":{\"name\":\"GL queue\"}}");
+	{
+		std::lock_guard<std::mutex> lock(threadsMutex);
+		for (size_t i = 0; i < threads.size(); i++) {
+			fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", (unsigned int) i);
+			writeEscaped(out, threads[i]->name.c_str());
+			fprintf(out, "\"}}");
+		}
+	}
+	long long start = captureStart.load();
+	for (const Event& event : GetEvents()) {
+		bool gpu = event.thread == gpuThread;
+		fprintf(out, ",\n{\"name\":\"");
+		writeEscaped(out, event.name);
+		fprintf(out, "\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", gpu ? "gpu" : "cpu",
+			gpu ? 2 : 1, gpu ? 0 : event.thread, (event.start - start) / 1000.0, event.duration / 1000.0);
+	}
+	fprintf(out, "\n]}\n");
+	fclose(out);
+	return true;
+}
+
+bool Profiler::WriteSummary(const char* file) const {
+	FILE* out = fopen(file, "w");
+	if (out == NULL) {
+		std::cout << "Profiler: could not write " << file << std::endl;
+		return false;
+	}
+	fprintf(out, "zone,timeline,count,total_ms,mean_ms,p50_ms,p90_ms,p99_ms,max_ms\n");
+	for (const ZoneSummary& summary : Summarize()) {
+		fprintf(out, "\"");
+		writeEscaped(out, summary.name.c_str());
+		fprintf(out, "\",%s,%zu,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n", summary.gpu ? "gpu" : "cpu", summary.count, summary.total,
+			summary.mean, summary.p50, summary.p90, summary.p99, summary.max);
+	}
+	fclose(out);
+	return true;
+}
+
+void Profiler::PrintSummary() const {
+	std::vector<ZoneSummary> summaries = Summarize();
+	printf("%-36s %-4s %8s %10s %9s %9s %9s %9s\n", "Zone", "", "Count", "Total ms", "p50 ms", "p90 ms", "p99 ms", "Max ms");
+	for (const ZoneSummary& summary : summaries) {
+		printf("%-36.36s %-4s %8zu %10.2f %9.3f %9.3f %9.3f %9.3f\n", summary.name.c_str(), summary.gpu ? "GPU" : "CPU",
+			summary.count, summary.total, summary.p50, summary.p90, summary.p99, summary.max);
+	}
+	if (gpuZonesDropped > 0)
+		printf("%u GPU zones dropped (results not ready in time)\n", gpuZonesDropped);
+}
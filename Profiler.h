@@ -0,0 +1,189 @@
+#ifndef PROFILER_CLASS_H
+#define PROFILER_CLASS_H
+
+#include<glad/glad.h>
+#include<atomic>
+#include<chrono>
+#include<climits>
+#include<memory>
+#include<mutex>
+#include<string>
+#include<vector>
+
+#include"GLDebug.h"
+
+// Instrumentation for where the frame time goes. Code is marked with scoped zones:
+//   PROFILE_ZONE("Camera::Inputs");      CPU time of the enclosing scope, on any thread
+//   PROFILE_GPU_ZONE("Color pass");      CPU time plus the GPU time of the commands issued in the scope,
+//                                        which also form a debug group in GPU captures (see GLDebug)
+// Zones only record while a capture runs. Outside of one a zone is a relaxed atomic load and a branch;
+// building with PROFILER_DISABLED removes them entirely (GPU zones stay debug groups).
+//
+// CPU zones go into a buffer per thread. GPU zones write GL_TIMESTAMP queries from a ring of
+// gpuFrames frames; a frame's results are read when its slot comes around again, and dropped
+// rather than waited for if the GPU is still behind. A capture can be written as Chrome trace JSON
+// (chrome://tracing, Perfetto) and as a per-zone summary with percentiles.
+class Profiler {
+public:
+	static const int gpuFrames = 4;
+
+	// One finished zone, times in nanoseconds since the profiler was created
+	struct Event {
+		const char* name;
+		long long start;
+		long long duration;
+		// Index of the recording thread, or gpuThread
+		unsigned int thread;
+	};
+	static const unsigned int gpuThread = UINT_MAX;
+
+	// Durations of one zone over a capture, in milliseconds
+	struct ZoneSummary {
+		std::string name;
+		bool gpu;
+		size_t count;
+		double total;
+		double mean;
+		double p50;
+		double p90;
+		double p99;
+		double max;
+	};
+
+	// GPU zones whose results were not available in time during the last capture
+	unsigned int gpuZonesDropped = 0;
+
+	Profiler();
+
+	// Clears the previous capture and starts recording
+	void StartCapture();
+	void StopCapture();
+	bool Capturing() const {
+		return capturing.load(std::memory_order_relaxed);
+	}
+	// Whether a stopped capture has all its GPU results (or gave up on them), so it can be written
+	bool CaptureComplete() const;
+	// Name of the calling thread in the trace
+	void SetThreadName(const char* name);
+
+	// Nanoseconds since the profiler was created
+	long long Now() const;
+	// Adds a finished CPU zone of the calling thread
+	void Record(const char* name, long long start, long long end);
+
+	// Resolves the GPU zones of the frame whose slot is reused and starts a new one. Call once per
+	// frame from the thread owning the GL context, like BeginGpuZone and EndGpuZone.
+	void BeginGpuFrame();
+	// Returns the zone's index for EndGpuZone (in the same frame), or UINT_MAX when not capturing
+	unsigned int BeginGpuZone(const char* name);
+	void EndGpuZone(unsigned int zone);
+	// Waits for the GPU and resolves every frame still in the ring (at shutdown)
+	void FlushGpuFrames();
+	// Deletes the timestamp queries, needs the GL context
+	void DeleteGpuQueries();
+
+	// Every event of the capture, CPU threads first then GPU, sorted by start time
+	std::vector<Event> GetEvents() const;
+	std::vector<ZoneSummary> Summarize() const;
+	bool WriteChromeTrace(const char* file) const;
+	// Summary as CSV, one line per zone
+	bool WriteSummary(const char* file) const;
+	void PrintSummary() const;
+
+private:
+	struct ThreadBuffer {
+		std::mutex mutex;
+		std::vector<Event> events;
+		std::string name;
+	};
+	struct GpuZone {
+		const char* name;
+		// Indices into the frame's queries, end is UINT_MAX while the zone is open
+		unsigned int begin;
+		unsigned int end;
+	};
+	struct GpuFrame {
+		// Grown on demand, reused every time the slot comes around
+		std::vector<GLuint> queries;
+		unsigned int usedQueries = 0;
+		std::vector<GpuZone> zones;
+	};
+
+	std::atomic<bool> capturing{false};
+	std::chrono::steady_clock::time_point epoch;
+
+	// Every thread that recorded or was named, owned here so buffers outlive their threads
+	mutable std::mutex threadsMutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> threads;
+
+	GpuFrame gpuRing[gpuFrames];
+	int gpuFrame = 0;
+	// Now() when the capture started, and a count of captures so the GPU side notices a new one
+	std::atomic<long long> captureStart{0};
+	std::atomic<unsigned int> captureIndex{0};
+	// Added to a GPU timestamp to get Now() time, measured at the first GPU frame of each capture
+	long long gpuOffset = 0;
+	unsigned int gpuOffsetCapture = 0;
+	// GPU zones issued but not resolved yet
+	std::atomic<unsigned int> pendingGpuZones{0};
+	mutable std::mutex gpuMutex;
+	std::vector<Event> gpuEvents;
+
+	// Buffer of the calling thread, created on first use
+	ThreadBuffer& threadBuffer();
+	// Index of a free query of the frame, more are created when it runs out
+	unsigned int allocateQuery(GpuFrame& frame);
+	void resolveGpuFrame(GpuFrame& frame);
+};
+
+// Engine-wide profiler
+extern Profiler profiler;
+
+// Scoped CPU zone, see PROFILE_ZONE
+class ProfileZone {
+public:
+	explicit ProfileZone(const char* name) : name(name) {
+		start = profiler.Capturing() ? profiler.Now() : -1;
+	}
+	~ProfileZone() {
+		if (start >= 0)
+			profiler.Record(name, start, profiler.Now());
+	}
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+	const char* name;
+	long long start;
+};
+
+// Scoped CPU and GPU zone, see PROFILE_GPU_ZONE
+class GpuProfileZone {
+public:
+	explicit GpuProfileZone(const char* name) : debugGroup(name), cpuZone(name) {
+		zone = profiler.Capturing() ? profiler.BeginGpuZone(name) : UINT_MAX;
+	}
+	~GpuProfileZone() {
+		if (zone != UINT_MAX)
+			profiler.EndGpuZone(zone);
+	}
+	GpuProfileZone(const GpuProfileZone&) = delete;
+	GpuProfileZone& operator=(const GpuProfileZone&) = delete;
+
+private:
+	GLDebugGroup debugGroup;
+	ProfileZone cpuZone;
+	unsigned int zone;
+};
+
+// Zone names must be string literals (or otherwise outlive the capture)
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#if defined(PROFILER_DISABLED)
+#define PROFILE_ZONE(name)
+#define PROFILE_GPU_ZONE(name) GLDebugGroup PROFILE_CONCAT(debugGroup, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_GPU_ZONE(name) GpuProfileZone PROFILE_CONCAT(gpuProfileZone, __LINE__)(name)
+#endif
+#endif
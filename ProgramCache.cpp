@@ -0,0 +1,205 @@
+#include"ProgramCache.h"
+#include"GLExtensions.h"
+
+#include<chrono>
+#include<cstring>
+#include<fstream>
+#include<iostream>
+
+ProgramCache programCache;
+
+static const unsigned int entryMagic = 0x31434250; // "PBC1"
+
+// 64-bit FNV-1a
+static unsigned long long hashBytes(const void* data, size_t size, unsigned long long hash = 14695981039346656037ull) {
+	const unsigned char* bytes = (const unsigned char*) data;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static unsigned long long hashString(const char* text, unsigned long long hash) {
+	if (text == NULL)
+		return hash;
+	// Include the terminator so "ab" + "c" and "a" + "bc" differ
+	return hashBytes(text, std::strlen(text) + 1, hash);
+}
+
+bool ProgramCache::Open(const char* file) {
+	ProgramCache::file = file;
+	entries.clear();
+	usedKeys.clear();
+	enabled = glFeatures.programBinary;
+	if (!enabled)
+		return false;
+
+	// Binaries are only valid for the exact driver that made them
+	driverHash = hashString((const char*) glGetString(GL_VENDOR), 14695981039346656037ull);
+	driverHash = hashString((const char*) glGetString(GL_RENDERER), driverHash);
+	driverHash = hashString((const char*) glGetString(GL_VERSION), driverHash);
+	driverHash = hashString((const char*) glGetString(GL_SHADING_LANGUAGE_VERSION), driverHash);
+
+	std::ifstream in(file, std::ios::binary);
+	if (!in)
+		return true;
+
+	unsigned int stale = 0;
+	EntryHeader header;
+	while (in.read((char*) &header, sizeof(header))) {
+		if (header.magic != entryMagic)
+			break;
+		Entry entry;
+		entry.binaryFormat = header.binaryFormat;
+		entry.compileMilliseconds = header.compileMilliseconds;
+		entry.binary.resize(header.length);
+		if (!in.read(entry.binary.data(), header.length))
+			break;
+		if (header.driverHash != driverHash) {
+			stale++;
+			continue;
+		}
+		// A later entry for the same key replaces one the driver rejected earlier
+		if (entries.count(header.key))
+			stale++;
+		entries[header.key] = entry;
+	}
+	in.close();
+
+	if (stale > 0)
+		rewrite();
+	std::cout << "Program cache: " << entries.size() << " entries in " << file;
+	if (stale > 0)
+		std::cout << " (" << stale << " stale dropped)";
+	std::cout << std::endl;
+	return true;
+}
+
+unsigned long long ProgramCache::Key(const std::vector<const std::string*>& sources) const {
+	unsigned long long key = driverHash ^ 0x9E3779B97F4A7C15ull;
+	for (const std::string* source : sources) {
+		key = hashBytes(source->data(), source->size(), key);
+		// Stage separator
+		key = hashBytes("", 1, key);
+	}
+	return key;
+}
+
+GLuint ProgramCache::Load(unsigned long long key) {
+	if (!enabled)
+		return 0;
+	lookups++;
+	auto found = entries.find(key);
+	if (found == entries.end())
+		return 0;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	const Entry& entry = found->second;
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, entry.binaryFormat, entry.binary.data(), (GLsizei) entry.binary.size());
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (linked != GL_TRUE) {
+		// Driver update with the same version string, or a corrupt file: compile from source instead
+		glDeleteProgram(program);
+		entries.erase(found);
+		return 0;
+	}
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	hits++;
+	usedKeys.insert(key);
+	loadMilliseconds += milliseconds;
+	savedCompileMilliseconds += entry.compileMilliseconds;
+	return program;
+}
+
+void ProgramCache::PrepareLink(GLuint program) const {
+	if (enabled)
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+void ProgramCache::Store(GLuint program, unsigned long long key, double compileTime) {
+	compileMilliseconds += compileTime;
+	if (!enabled)
+		return;
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (linked != GL_TRUE || length <= 0)
+		return;
+
+	Entry entry;
+	entry.compileMilliseconds = (float) compileTime;
+	entry.binary.resize(length);
+	GLsizei written = 0;
+	glGetProgramBinary(program, length, &written, &entry.binaryFormat, entry.binary.data());
+	if (written <= 0)
+		return;
+	entry.binary.resize(written);
+
+	EntryHeader header;
+	std::memset(&header, 0, sizeof(header));
+	header.magic = entryMagic;
+	header.binaryFormat = entry.binaryFormat;
+	header.driverHash = driverHash;
+	header.key = key;
+	header.length = (unsigned int) entry.binary.size();
+	header.compileMilliseconds = entry.compileMilliseconds;
+
+	std::ofstream out(file, std::ios::binary | std::ios::app);
+	out.write((const char*) &header, sizeof(header));
+	out.write(entry.binary.data(), entry.binary.size());
+	entries[key] = std::move(entry);
+	usedKeys.insert(key);
+}
+
+void ProgramCache::Close() {
+	if (!enabled)
+		return;
+	unsigned int unused = 0;
+	for (auto item = entries.begin(); item != entries.end();) {
+		if (usedKeys.count(item->first)) {
+			++item;
+		} else {
+			item = entries.erase(item);
+			unused++;
+		}
+	}
+	if (unused > 0) {
+		rewrite();
+		std::cout << "Program cache: " << unused << " entries unused this session dropped, " << entries.size() << " kept" << std::endl;
+	}
+	enabled = false;
+}
+
+void ProgramCache::rewrite() const {
+	std::ofstream out(file, std::ios::binary | std::ios::trunc);
+	for (const auto& item : entries) {
+		EntryHeader header;
+		std::memset(&header, 0, sizeof(header));
+		header.magic = entryMagic;
+		header.binaryFormat = item.second.binaryFormat;
+		header.driverHash = driverHash;
+		header.key = item.first;
+		header.length = (unsigned int) item.second.binary.size();
+		header.compileMilliseconds = item.second.compileMilliseconds;
+		out.write((const char*) &header, sizeof(header));
+		out.write(item.second.binary.data(), item.second.binary.size());
+	}
+}
+
+void ProgramCache::PrintStatistics() const {
+	if (!enabled) {
+		std::cout << "Program cache: disabled (no program binary support), " << compileMilliseconds << " ms compiling" << std::endl;
+		return;
+	}
+	std::cout << "Program cache: " << hits << "/" << lookups << " hits ("
+		<< (lookups > 0 ? 100.0 * hits / lookups : 0.0) << "%), "
+		<< savedCompileMilliseconds - loadMilliseconds << " ms compile time avoided ("
+		<< savedCompileMilliseconds << " ms compile vs " << loadMilliseconds << " ms load), "
+		<< compileMilliseconds << " ms compiling misses" << std::endl;
+}
@@ -0,0 +1,78 @@
+#ifndef PROGRAM_CACHE_CLASS_H
+#define PROGRAM_CACHE_CLASS_H
+
+#include<glad/glad.h>
+#include<string>
+#include<unordered_map>
+#include<unordered_set>
+#include<vector>
+
+// On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary), so shaders and
+// their variants are only compiled from source the first time. Entries are keyed by a hash of the
+// final sources of every stage (defines included) and of the driver's vendor/renderer/version; an
+// entry the driver rejects is dropped and the program is compiled from source again.
+//
+// All entries live in one file: a sequence of EntryHeader + binary. It is read by Open and new
+// entries are appended as they are stored. Close rewrites it with the entries the session used, so
+// the binaries of edited shaders do not pile up across sessions.
+class ProgramCache {
+public:
+	// Statistics since Open
+	unsigned int lookups = 0;
+	unsigned int hits = 0;
+	// Time spent compiling programs that were not in the cache
+	double compileMilliseconds = 0.0;
+	// Time spent loading cached binaries
+	double loadMilliseconds = 0.0;
+	// Compile time the hits would have cost, as measured when they were stored
+	double savedCompileMilliseconds = 0.0;
+
+	// Reads the cache file, needs a current context. Without a successful Open every lookup misses.
+	bool Open(const char* file);
+	bool Enabled() const {
+		return enabled;
+	}
+
+	// Key of a program made of the given stage sources
+	unsigned long long Key(const std::vector<const std::string*>& sources) const;
+	// Creates a program from the cached binary for 'key', returns 0 when there is none or the driver rejects it
+	GLuint Load(unsigned long long key);
+	// Stores the binary of a linked program ('compileTime' is what building it from source took)
+	void Store(GLuint program, unsigned long long key, double compileTime);
+	// Marks a program that is about to be linked as one whose binary will be read back
+	void PrepareLink(GLuint program) const;
+
+	// Drops the entries this session neither loaded nor stored from the file, at shutdown
+	void Close();
+
+	void PrintStatistics() const;
+
+private:
+	struct EntryHeader {
+		unsigned int magic;
+		unsigned int binaryFormat;
+		unsigned long long driverHash;
+		unsigned long long key;
+		unsigned int length;
+		float compileMilliseconds;
+	};
+	struct Entry {
+		GLenum binaryFormat;
+		float compileMilliseconds;
+		std::vector<char> binary;
+	};
+
+	bool enabled = false;
+	std::string file;
+	unsigned long long driverHash = 0;
+	std::unordered_map<unsigned long long, Entry> entries;
+	// Keys loaded or stored since Open
+	std::unordered_set<unsigned long long> usedKeys;
+
+	// Rewrites the file with the current entries (after dropping stale ones)
+	void rewrite() const;
+};
+
+// Shared by every Shader, opened by Main
+extern ProgramCache programCache;
+#endif
@@ -0,0 +1,98 @@
+#include"RenderThread.h"
+#include"Profiler.h"
+
+#include<chrono>
+
+static double millisecondsSince(std::chrono::high_resolution_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void RenderThread::Start(bool threaded, std::function<void()> makeContextCurrent, std::function<void(const FramePacket&)> render,
+						 std::function<void()> releaseContext) {
+	RenderThread::threaded = threaded;
+	RenderThread::render = render;
+	stopping = false;
+	if (threaded)
+		thread = std::thread(&RenderThread::threadLoop, this, makeContextCurrent, releaseContext);
+}
+
+void RenderThread::Stop() {
+	if (!thread.joinable())
+		return;
+	stopping = true;
+	wake();
+	thread.join();
+}
+
+FramePacket& RenderThread::BeginPacket() {
+	return packets[writeIndex];
+}
+
+void RenderThread::wake() {
+	// Taking the lock orders the notification after the waiter's predicate check
+	{
+		std::lock_guard<std::mutex> lock(waitMutex);
+	}
+	waitCondition.notify_all();
+}
+
+void RenderThread::SubmitPacket() {
+	if (!threaded) {
+		auto renderStart = std::chrono::high_resolution_clock::now();
+		render(packets[writeIndex]);
+		std::lock_guard<std::mutex> lock(timingMutex);
+		timings.update = packets[writeIndex].updateMilliseconds;
+		timings.updateWait = 0.0;
+		timings.render = millisecondsSince(renderStart);
+		timings.renderWait = 0.0;
+		return;
+	}
+
+	// Only one packet may be waiting: block while the previous one has not been picked up yet
+	auto waitStart = std::chrono::high_resolution_clock::now();
+	if (middle.load(std::memory_order_acquire) & freshBit) {
+		PROFILE_ZONE("Wait for render thread");
+		std::unique_lock<std::mutex> lock(waitMutex);
+		waitCondition.wait(lock, [this]() { return !(middle.load(std::memory_order_acquire) & freshBit) || stopping; });
+	}
+	double waited = millisecondsSince(waitStart);
+	{
+		std::lock_guard<std::mutex> lock(timingMutex);
+		timings.update = packets[writeIndex].updateMilliseconds;
+		timings.updateWait = waited;
+	}
+
+	writeIndex = middle.exchange(writeIndex | freshBit, std::memory_order_acq_rel) & indexMask;
+	wake();
+}
+
+void RenderThread::threadLoop(std::function<void()> makeContextCurrent, std::function<void()> releaseContext) {
+	makeContextCurrent();
+	while (true) {
+		auto waitStart = std::chrono::high_resolution_clock::now();
+		if (!(middle.load(std::memory_order_acquire) & freshBit)) {
+			PROFILE_ZONE("Wait for frame packet");
+			std::unique_lock<std::mutex> lock(waitMutex);
+			waitCondition.wait(lock, [this]() { return (middle.load(std::memory_order_acquire) & freshBit) || stopping; });
+		}
+		// Draw whatever was submitted before stopping
+		if (!(middle.load(std::memory_order_acquire) & freshBit))
+			break;
+		double waited = millisecondsSince(waitStart);
+
+		readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+		wake();
+
+		auto renderStart = std::chrono::high_resolution_clock::now();
+		render(packets[readIndex]);
+		std::lock_guard<std::mutex> lock(timingMutex);
+		timings.render = millisecondsSince(renderStart);
+		timings.renderWait = waited;
+	}
+	releaseContext();
+}
+
+RenderThread::Timings RenderThread::GetTimings() {
+	std::lock_guard<std::mutex> lock(timingMutex);
+	return timings;
+}
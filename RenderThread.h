@@ -0,0 +1,123 @@
+#ifndef RENDER_THREAD_CLASS_H
+#define RENDER_THREAD_CLASS_H
+
+#include<glm/glm.hpp>
+#include<atomic>
+#include<condition_variable>
+#include<functional>
+#include<mutex>
+#include<thread>
+#include<vector>
+
+#include"ClusteredLights.h"
+#include"FramePipeline.h"
+
+class Model;
+
+// Everything the render side needs to draw one frame, produced by the update side. Once submitted a
+// packet is only read, so the update side can work on the next frame while it is drawn.
+struct FramePacket {
+	struct Draw {
+		Model* model;
+		glm::mat4 matrix;
+		// First entry of the model's meshes in meshVisible, UINT_MAX when the whole instance was culled
+		unsigned int firstMesh;
+	};
+
+	// Camera the frame is rendered from
+	glm::vec3 cameraPosition = glm::vec3(0.0f);
+	glm::vec3 cameraOrientation = glm::vec3(0.0f, 0.0f, -1.0f);
+	glm::vec3 cameraUp = glm::vec3(0.0f, 1.0f, 0.0f);
+	float fov = 45.0f;
+
+	// One entry per scene instance, in scene order
+	std::vector<Draw> draws;
+	// Per mesh culling result of the CPU culling (1 = draw)
+	std::vector<unsigned char> meshVisible;
+	// The same visible meshes in sort key order, 'instance' indexes 'draws'
+	std::vector<FramePipeline::DrawItem> drawList;
+	// Point lights to cluster
+	std::vector<ClusteredLights::Light> lights;
+
+	// Settings toggled by input
+	int renderPath = 0;
+	unsigned int sceneFeatures = 0;
+	bool flashlight = true;
+	bool gpuCulling = false;
+	bool depthPrePass = false;
+	bool dynamicResolution = true;
+	// Set when shader files changed on disk since the last packet
+	bool reloadShaders = false;
+	// Frame index of a --bench run, -1 outside of one
+	int benchFrame = -1;
+	// Bench baseline: every mesh drawn with Model::Draw, no culling or batching
+	bool naiveDraw = false;
+
+	// Time the update side spent producing this packet
+	double updateMilliseconds = 0.0;
+};
+
+// Runs the GL side of the frame loop on its own thread, which owns the context. The update thread
+// fills a packet (BeginPacket), hands it over (SubmitPacket) and goes on with the next frame while
+// the render thread draws it, so CPU work for frame N+1 overlaps the submission of frame N.
+//
+// Packets are exchanged through a lock-free triple buffer: one slot is written by the update side,
+// one is read by the render side and the third holds the newest submitted packet. Swapping is a
+// single atomic exchange; the mutex and condition variable are only used to sleep when one side has
+// to wait for the other. The update side never gets more than one packet ahead.
+//
+// Without a thread (Start with threaded = false) SubmitPacket renders the packet right away.
+class RenderThread {
+public:
+	// Milliseconds of the last frame on each side
+	struct Timings {
+		double update = 0.0;
+		// Update side blocked in SubmitPacket because the render side was still busy
+		double updateWait = 0.0;
+		double render = 0.0;
+		// Render side idle, waiting for a packet
+		double renderWait = 0.0;
+	};
+
+	// Starts rendering. 'makeContextCurrent' runs first on the render thread, 'render' then runs for
+	// every packet there (including the buffer swap) and 'releaseContext' before the thread ends.
+	void Start(bool threaded, std::function<void()> makeContextCurrent, std::function<void(const FramePacket&)> render,
+			   std::function<void()> releaseContext);
+	// Waits for the last packet to be drawn and ends the render thread
+	void Stop();
+	bool Threaded() const {
+		return threaded;
+	}
+
+	// Packet slot owned by the update side, filled before SubmitPacket. Keeps the contents of
+	// an older frame, so vectors keep their capacity.
+	FramePacket& BeginPacket();
+	// Hands the packet to the render side
+	void SubmitPacket();
+
+	Timings GetTimings();
+
+private:
+	static const unsigned int freshBit = 4;
+	static const unsigned int indexMask = 3;
+
+	FramePacket packets[3];
+	unsigned int writeIndex = 0;
+	unsigned int readIndex = 1;
+	// Index of the middle slot, with freshBit set while it holds a packet the render side has not taken
+	std::atomic<unsigned int> middle{2};
+	std::atomic<bool> stopping{false};
+
+	bool threaded = false;
+	std::thread thread;
+	std::function<void(const FramePacket&)> render;
+	std::mutex waitMutex;
+	std::condition_variable waitCondition;
+
+	std::mutex timingMutex;
+	Timings timings;
+
+	void threadLoop(std::function<void()> makeContextCurrent, std::function<void()> releaseContext);
+	void wake();
+};
+#endif
@@ -0,0 +1,416 @@
+#include"SceneBVH.h"
+
+#include<algorithm>
+#include<cfloat>
+
+// Surface area of a box, the SAH cost of hitting it is proportional to this
+static float surfaceArea(const glm::vec3& minBounds, const glm::vec3& maxBounds) {
+	glm::vec3 d = glm::max(maxBounds - minBounds, glm::vec3(0.0f));
+	return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+struct SceneBVH::BuildScratch {
+	std::vector<glm::vec3> centroids;
+	std::vector<unsigned int> binItems;
+	std::vector<glm::vec3> binMin;
+	std::vector<glm::vec3> binMax;
+	std::vector<float> leftArea;
+	std::vector<float> rightArea;
+	std::vector<unsigned int> leftCount;
+	std::vector<unsigned int> rightCount;
+};
+
+void SceneBVH::Clear() {
+	nodes.clear();
+	itemOrder.clear();
+	itemMin.clear();
+	itemMax.clear();
+	itemLeaf.clear();
+}
+
+void SceneBVH::Build(const std::vector<glm::vec3>& minBounds, const std::vector<glm::vec3>& maxBounds) {
+	Clear();
+	itemMin = minBounds;
+	itemMax = maxBounds;
+
+	unsigned int count = (unsigned int) itemMin.size();
+	if (count == 0)
+		return;
+
+	itemOrder.resize(count);
+	itemLeaf.assign(count, -1);
+	BuildScratch scratch;
+	scratch.centroids.resize(count);
+	for (unsigned int i = 0; i < count; i++) {
+		itemOrder[i] = i;
+		scratch.centroids[i] = (itemMin[i] + itemMax[i]) * 0.5f;
+	}
+	scratch.binItems.resize(3 * binCount);
+	scratch.binMin.resize(3 * binCount);
+	scratch.binMax.resize(3 * binCount);
+	scratch.leftArea.resize(binCount);
+	scratch.rightArea.resize(binCount);
+	scratch.leftCount.resize(binCount);
+	scratch.rightCount.resize(binCount);
+
+	// A binary tree with one item per leaf has at most 2n - 1 nodes
+	nodes.reserve(2 * count);
+	Node root;
+	root.leftChild = -1;
+	root.firstItem = 0;
+	root.itemCount = count;
+	root.parent = -1;
+	nodes.push_back(root);
+	updateNodeBounds(0);
+
+	subdivide(0, scratch);
+}
+
+void SceneBVH::subdivide(int nodeIndex, BuildScratch& scratch) {
+	// Copy what we need, pushing new nodes may move the vector
+	unsigned int first = nodes[nodeIndex].firstItem;
+	unsigned int count = nodes[nodeIndex].itemCount;
+	float nodeArea = surfaceArea(nodes[nodeIndex].minBounds, nodes[nodeIndex].maxBounds);
+	const std::vector<glm::vec3>& centroids = scratch.centroids;
+
+	// Bounds of the centroids decide where the bins are placed
+	glm::vec3 centroidMin(FLT_MAX);
+	glm::vec3 centroidMax(-FLT_MAX);
+	for (unsigned int i = first; i < first + count; i++) {
+		centroidMin = glm::min(centroidMin, centroids[itemOrder[i]]);
+		centroidMax = glm::max(centroidMax, centroids[itemOrder[i]]);
+	}
+
+	int bestAxis = -1;
+	unsigned int bestSplit = 0;
+	float bestCost = FLT_MAX;
+	// Small nodes do not need all the bins, sweeping them would cost more than the items themselves
+	unsigned int bins = std::min(binCount, std::max(count + 1, 2u));
+
+	if (count > minLeafSize) {
+		std::vector<unsigned int>& binItems = scratch.binItems;
+		std::vector<glm::vec3>& binMin = scratch.binMin;
+		std::vector<glm::vec3>& binMax = scratch.binMax;
+		std::vector<float>& leftArea = scratch.leftArea;
+		std::vector<float>& rightArea = scratch.rightArea;
+		std::vector<unsigned int>& leftCount = scratch.leftCount;
+		std::vector<unsigned int>& rightCount = scratch.rightCount;
+
+		// Drop every item into a bin along each axis, in a single pass over the items
+		float scale[3];
+		for (int axis = 0; axis < 3; axis++) {
+			float extent = centroidMax[axis] - centroidMin[axis];
+			scale[axis] = extent > 0.0f ? bins / extent : 0.0f;
+		}
+		std::fill(binItems.begin(), binItems.begin() + 3 * bins, 0u);
+		std::fill(binMin.begin(), binMin.begin() + 3 * bins, glm::vec3(FLT_MAX));
+		std::fill(binMax.begin(), binMax.begin() + 3 * bins, glm::vec3(-FLT_MAX));
+		for (unsigned int i = first; i < first + count; i++) {
+			unsigned int item = itemOrder[i];
+			const glm::vec3& centroid = centroids[item];
+			const glm::vec3& boundsMin = itemMin[item];
+			const glm::vec3& boundsMax = itemMax[item];
+			for (int axis = 0; axis < 3; axis++) {
+				unsigned int bin = axis * bins + std::min(bins - 1, (unsigned int) ((centroid[axis] - centroidMin[axis]) * scale[axis]));
+				binItems[bin]++;
+				binMin[bin] = glm::min(binMin[bin], boundsMin);
+				binMax[bin] = glm::max(binMax[bin], boundsMax);
+			}
+		}
+
+		for (int axis = 0; axis < 3; axis++) {
+			if (scale[axis] == 0.0f)
+				continue;
+			const unsigned int* axisItems = &binItems[axis * bins];
+			const glm::vec3* axisMin = &binMin[axis * bins];
+			const glm::vec3* axisMax = &binMax[axis * bins];
+
+			// Sweep from both sides to get the area and item count on each side of every split plane
+			glm::vec3 sweepMin(FLT_MAX), sweepMax(-FLT_MAX);
+			unsigned int sweepCount = 0;
+			for (unsigned int b = 0; b < bins - 1; b++) {
+				sweepCount += axisItems[b];
+				sweepMin = glm::min(sweepMin, axisMin[b]);
+				sweepMax = glm::max(sweepMax, axisMax[b]);
+				leftCount[b] = sweepCount;
+				leftArea[b] = sweepCount > 0 ? surfaceArea(sweepMin, sweepMax) : 0.0f;
+			}
+			sweepMin = glm::vec3(FLT_MAX);
+			sweepMax = glm::vec3(-FLT_MAX);
+			sweepCount = 0;
+			for (unsigned int b = bins - 1; b > 0; b--) {
+				sweepCount += axisItems[b];
+				sweepMin = glm::min(sweepMin, axisMin[b]);
+				sweepMax = glm::max(sweepMax, axisMax[b]);
+				rightCount[b - 1] = sweepCount;
+				rightArea[b - 1] = sweepCount > 0 ? surfaceArea(sweepMin, sweepMax) : 0.0f;
+			}
+
+			for (unsigned int b = 0; b < bins - 1; b++) {
+				if (leftCount[b] == 0 || rightCount[b] == 0)
+					continue;
+				float cost = leftCount[b] * leftArea[b] + rightCount[b] * rightArea[b];
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = b;
+				}
+			}
+		}
+	}
+
+	// Relative SAH cost: one traversal step plus the expected number of child tests
+	float splitCost = nodeArea > 0.0f ? 1.0f + bestCost / nodeArea : FLT_MAX;
+	float leafCost = (float) count;
+
+	unsigned int leftItems = 0;
+	if (bestAxis != -1 && (splitCost < leafCost || count > maxLeafSize)) {
+		float scale = bins / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+		float axisMin = centroidMin[bestAxis];
+		unsigned int splitBin = bestSplit;
+		auto middle = std::partition(itemOrder.begin() + first, itemOrder.begin() + first + count,
+			[&](unsigned int item) {
+				unsigned int bin = std::min(bins - 1, (unsigned int) ((centroids[item][bestAxis] - axisMin) * scale));
+				return bin <= splitBin;
+			});
+		leftItems = (unsigned int) (middle - (itemOrder.begin() + first));
+	} else if (count > maxLeafSize) {
+		// All centroids coincide, so no plane separates them: split the list in half instead
+		leftItems = count / 2;
+	}
+
+	if (leftItems == 0 || leftItems == count) {
+		// Becomes a leaf
+		for (unsigned int i = first; i < first + count; i++)
+			itemLeaf[itemOrder[i]] = nodeIndex;
+		return;
+	}
+
+	int leftIndex = (int) nodes.size();
+	Node left;
+	left.leftChild = -1;
+	left.firstItem = first;
+	left.itemCount = leftItems;
+	left.parent = nodeIndex;
+	Node right = left;
+	right.firstItem = first + leftItems;
+	right.itemCount = count - leftItems;
+	nodes.push_back(left);
+	nodes.push_back(right);
+
+	nodes[nodeIndex].leftChild = leftIndex;
+	nodes[nodeIndex].itemCount = 0;
+
+	updateNodeBounds(leftIndex);
+	updateNodeBounds(leftIndex + 1);
+	subdivide(leftIndex, scratch);
+	subdivide(leftIndex + 1, scratch);
+}
+
+void SceneBVH::updateNodeBounds(int nodeIndex) {
+	Node& node = nodes[nodeIndex];
+	if (node.IsLeaf()) {
+		node.minBounds = glm::vec3(FLT_MAX);
+		node.maxBounds = glm::vec3(-FLT_MAX);
+		for (unsigned int i = node.firstItem; i < node.firstItem + node.itemCount; i++) {
+			node.minBounds = glm::min(node.minBounds, itemMin[itemOrder[i]]);
+			node.maxBounds = glm::max(node.maxBounds, itemMax[itemOrder[i]]);
+		}
+	} else {
+		const Node& left = nodes[node.leftChild];
+		const Node& right = nodes[node.leftChild + 1];
+		node.minBounds = glm::min(left.minBounds, right.minBounds);
+		node.maxBounds = glm::max(left.maxBounds, right.maxBounds);
+	}
+}
+
+void SceneBVH::UpdateItem(unsigned int item, const glm::vec3& minBounds, const glm::vec3& maxBounds) {
+	itemMin[item] = minBounds;
+	itemMax[item] = maxBounds;
+
+	// Walk up from the leaf, stopping once a node's bounds no longer change
+	int nodeIndex = itemLeaf[item];
+	while (nodeIndex != -1) {
+		glm::vec3 oldMin = nodes[nodeIndex].minBounds;
+		glm::vec3 oldMax = nodes[nodeIndex].maxBounds;
+		updateNodeBounds(nodeIndex);
+		if (nodes[nodeIndex].minBounds == oldMin && nodes[nodeIndex].maxBounds == oldMax)
+			break;
+		nodeIndex = nodes[nodeIndex].parent;
+	}
+}
+
+void SceneBVH::Refit() {
+	// Children are always stored after their parent, so a reverse sweep is bottom-up
+	for (int i = (int) nodes.size() - 1; i >= 0; i--)
+		updateNodeBounds(i);
+}
+
+void SceneBVH::collectItems(int nodeIndex, std::vector<unsigned int>& result) const {
+	const Node& node = nodes[nodeIndex];
+	if (node.IsLeaf()) {
+		for (unsigned int i = node.firstItem; i < node.firstItem + node.itemCount; i++)
+			result.push_back(itemOrder[i]);
+	} else {
+		collectItems(node.leftChild, result);
+		collectItems(node.leftChild + 1, result);
+	}
+}
+
+// Classifies a box against the planes still set in 'planeMask'.
+// Returns false if it is outside, and clears the bits of planes it is completely inside of.
+static bool boxInFrustum(const glm::vec4 planes[6], const glm::vec3& minBounds, const glm::vec3& maxBounds, int& planeMask) {
+	glm::vec3 center = (minBounds + maxBounds) * 0.5f;
+	glm::vec3 extent = (maxBounds - minBounds) * 0.5f;
+	for (int p = 0; p < 6; p++) {
+		if (!(planeMask & (1 << p)))
+			continue;
+		float d = glm::dot(glm::vec3(planes[p]), center) + planes[p].w;
+		float r = glm::dot(glm::abs(glm::vec3(planes[p])), extent);
+		if (d + r < 0.0f)
+			return false;
+		if (d - r >= 0.0f)
+			planeMask &= ~(1 << p);
+	}
+	return true;
+}
+
+void SceneBVH::QueryFrustum(const glm::vec4 planes[6], std::vector<unsigned int>& result) const {
+	if (nodes.empty())
+		return;
+
+	struct Entry {
+		int node;
+		int planeMask;
+	};
+	std::vector<Entry> stack;
+	stack.push_back({0, 0x3F});
+
+	while (!stack.empty()) {
+		Entry entry = stack.back();
+		stack.pop_back();
+		const Node& node = nodes[entry.node];
+
+		int planeMask = entry.planeMask;
+		if (!boxInFrustum(planes, node.minBounds, node.maxBounds, planeMask))
+			continue;
+
+		// Completely inside: everything below is visible without further tests
+		if (planeMask == 0) {
+			collectItems(entry.node, result);
+			continue;
+		}
+
+		if (node.IsLeaf()) {
+			for (unsigned int i = node.firstItem; i < node.firstItem + node.itemCount; i++) {
+				unsigned int item = itemOrder[i];
+				int itemMask = planeMask;
+				if (boxInFrustum(planes, itemMin[item], itemMax[item], itemMask))
+					result.push_back(item);
+			}
+		} else {
+			stack.push_back({node.leftChild, planeMask});
+			stack.push_back({node.leftChild + 1, planeMask});
+		}
+	}
+}
+
+bool SceneBVH::rayIntersectsBox(const glm::vec3& origin, const glm::vec3& invDirection, const glm::vec3& boxMin,
+								const glm::vec3& boxMax, float maxDistance, float& tNear) {
+	glm::vec3 tMin = (boxMin - origin) * invDirection;
+	glm::vec3 tMax = (boxMax - origin) * invDirection;
+	glm::vec3 t1 = glm::min(tMin, tMax);
+	glm::vec3 t2 = glm::max(tMin, tMax);
+	tNear = glm::max(glm::max(t1.x, t1.y), glm::max(t1.z, 0.0f));
+	float tFar = glm::min(glm::min(t2.x, t2.y), glm::min(t2.z, maxDistance));
+	return tNear <= tFar;
+}
+
+bool SceneBVH::RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+					   const std::function<bool(unsigned int)>& hit) const {
+	if (nodes.empty())
+		return false;
+
+	// Avoid infinities (and 0 * inf) for axis-aligned rays, such as the horizontal collision rays
+	glm::vec3 invDirection;
+	for (int i = 0; i < 3; i++) {
+		float d = direction[i];
+		if (glm::abs(d) < 1e-20f)
+			d = d < 0.0f ? -1e-20f : 1e-20f;
+		invDirection[i] = 1.0f / d;
+	}
+
+	float t;
+	if (!rayIntersectsBox(origin, invDirection, nodes[0].minBounds, nodes[0].maxBounds, maxDistance, t))
+		return false;
+
+	std::vector<int> stack;
+	stack.push_back(0);
+	while (!stack.empty()) {
+		const Node& node = nodes[stack.back()];
+		stack.pop_back();
+
+		if (node.IsLeaf()) {
+			for (unsigned int i = node.firstItem; i < node.firstItem + node.itemCount; i++) {
+				unsigned int item = itemOrder[i];
+				if (rayIntersectsBox(origin, invDirection, itemMin[item], itemMax[item], maxDistance, t) && hit(item))
+					return true;
+			}
+			continue;
+		}
+
+		// Push the farther child first so the nearer one is visited next
+		float tLeft, tRight;
+		bool hitLeft = rayIntersectsBox(origin, invDirection, nodes[node.leftChild].minBounds,
+										nodes[node.leftChild].maxBounds, maxDistance, tLeft);
+		bool hitRight = rayIntersectsBox(origin, invDirection, nodes[node.leftChild + 1].minBounds,
+										 nodes[node.leftChild + 1].maxBounds, maxDistance, tRight);
+		if (hitLeft && hitRight) {
+			if (tLeft <= tRight) {
+				stack.push_back(node.leftChild + 1);
+				stack.push_back(node.leftChild);
+			} else {
+				stack.push_back(node.leftChild);
+				stack.push_back(node.leftChild + 1);
+			}
+		} else if (hitLeft) {
+			stack.push_back(node.leftChild);
+		} else if (hitRight) {
+			stack.push_back(node.leftChild + 1);
+		}
+	}
+	return false;
+}
+
+// Squared distance from a point to a box (0 if inside)
+static float distanceSquaredToBox(const glm::vec3& point, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+	glm::vec3 closest = glm::clamp(point, boxMin, boxMax);
+	glm::vec3 d = point - closest;
+	return glm::dot(d, d);
+}
+
+void SceneBVH::QueryRadius(const glm::vec3& center, float radius, std::vector<unsigned int>& result) const {
+	if (nodes.empty())
+		return;
+
+	float radius2 = radius * radius;
+	std::vector<int> stack;
+	stack.push_back(0);
+	while (!stack.empty()) {
+		const Node& node = nodes[stack.back()];
+		stack.pop_back();
+		if (distanceSquaredToBox(center, node.minBounds, node.maxBounds) > radius2)
+			continue;
+
+		if (node.IsLeaf()) {
+			for (unsigned int i = node.firstItem; i < node.firstItem + node.itemCount; i++) {
+				unsigned int item = itemOrder[i];
+				if (distanceSquaredToBox(center, itemMin[item], itemMax[item]) <= radius2)
+					result.push_back(item);
+			}
+		} else {
+			stack.push_back(node.leftChild);
+			stack.push_back(node.leftChild + 1);
+		}
+	}
+}
@@ -0,0 +1,77 @@
+#ifndef SCENE_BVH_CLASS_H
+#define SCENE_BVH_CLASS_H
+
+#include<glm/glm.hpp>
+#include<functional>
+#include<vector>
+
+// Bounding volume hierarchy over instance world bounds (one item per model instance)
+class SceneBVH {
+public:
+	struct Node {
+		glm::vec3 minBounds;
+		glm::vec3 maxBounds;
+		// Internal nodes: index of the left child, the right child is always leftChild + 1
+		int leftChild;
+		// Leaves: range inside itemOrder
+		unsigned int firstItem;
+		unsigned int itemCount;
+		int parent;
+
+		bool IsLeaf() const {
+			return itemCount > 0;
+		}
+	};
+
+	std::vector<Node> nodes;
+	// Item indices, grouped so every leaf references a contiguous range
+	std::vector<unsigned int> itemOrder;
+	// World bounds of every item, indexed by item
+	std::vector<glm::vec3> itemMin;
+	std::vector<glm::vec3> itemMax;
+	// Leaf that holds each item, so a changed item can be refit without searching
+	std::vector<int> itemLeaf;
+
+	// Number of SAH bins per axis, and the leaf sizes below which nodes are never split
+	// and above which they are always split
+	unsigned int binCount = 16;
+	unsigned int minLeafSize = 2;
+	unsigned int maxLeafSize = 4;
+
+	// Builds the tree from scratch with a binned surface area heuristic
+	void Build(const std::vector<glm::vec3>& minBounds, const std::vector<glm::vec3>& maxBounds);
+	// Replaces the bounds of one item and refits its ancestors
+	void UpdateItem(unsigned int item, const glm::vec3& minBounds, const glm::vec3& maxBounds);
+	// Recomputes every node's bounds from the items, keeping the topology
+	void Refit();
+	// Removes everything
+	void Clear();
+
+	bool Empty() const {
+		return nodes.empty();
+	}
+
+	// Collects the items whose bounds intersect the frustum. Subtrees fully inside skip further plane tests.
+	void QueryFrustum(const glm::vec4 planes[6], std::vector<unsigned int>& result) const;
+	// Visits items whose bounds are hit by the ray within maxDistance, roughly nearest first.
+	// Traversal stops as soon as 'hit' returns true, and the function then returns true.
+	bool RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance,
+				 const std::function<bool(unsigned int)>& hit) const;
+	// Collects the items whose bounds intersect the sphere
+	void QueryRadius(const glm::vec3& center, float radius, std::vector<unsigned int>& result) const;
+
+private:
+	// Temporary arrays shared by every subdivide call of one build
+	struct BuildScratch;
+
+	// Recursively splits the items in itemOrder[first, first + count) below 'nodeIndex'
+	void subdivide(int nodeIndex, BuildScratch& scratch);
+	// Recomputes a node's bounds from its children or items
+	void updateNodeBounds(int nodeIndex);
+	// Adds every item below a node to 'result'
+	void collectItems(int nodeIndex, std::vector<unsigned int>& result) const;
+	// Slab test, returns the entry distance in 'tNear'
+	static bool rayIntersectsBox(const glm::vec3& origin, const glm::vec3& invDirection, const glm::vec3& boxMin,
+								 const glm::vec3& boxMax, float maxDistance, float& tNear);
+};
+#endif
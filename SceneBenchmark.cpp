@@ -0,0 +1,182 @@
+#include"SceneBenchmark.h"
+
+#include<algorithm>
+#include<cmath>
+#include<cstdio>
+#include<fstream>
+#include<iostream>
+#include<json/json.h>
+
+using json = nlohmann::json;
+
+// Nearest-rank percentile
+template<typename T>
+static double percentile(std::vector<T> values, double fraction) {
+	if (values.empty())
+		return 0.0;
+	std::sort(values.begin(), values.end());
+	size_t rank = (size_t) std::ceil(fraction * values.size());
+	rank = std::min(std::max(rank, (size_t) 1), values.size());
+	return (double) values[rank - 1];
+}
+
+template<typename T>
+static double mean(const std::vector<T>& values) {
+	if (values.empty())
+		return 0.0;
+	double total = 0.0;
+	for (const T& value : values)
+		total += (double) value;
+	return total / values.size();
+}
+
+template<typename T>
+static json distribution(const std::vector<T>& values) {
+	return {
+		{"mean", mean(values)},
+		{"p50", percentile(values, 0.50)},
+		{"p95", percentile(values, 0.95)},
+		{"p99", percentile(values, 0.99)},
+		{"max", values.empty() ? 0.0 : (double) *std::max_element(values.begin(), values.end())}
+	};
+}
+
+void SceneBenchmark::AddRun(const char* name) {
+	Run run;
+	run.name = name;
+	run.cpuMilliseconds.assign(frames, 0.0);
+	run.gpuMilliseconds.assign(frames, 0.0);
+	run.drawCalls.assign(frames, 0);
+	run.triangles.assign(frames, 0);
+	runs.push_back(run);
+}
+
+unsigned int SceneBenchmark::RunOf(unsigned int frame) const {
+	return std::min(frame / (warmupFrames + frames), (unsigned int) runs.size() - 1);
+}
+
+float SceneBenchmark::TimeOf(unsigned int frame) const {
+	return (frame % (warmupFrames + frames)) * timeStep;
+}
+
+bool SceneBenchmark::StartsRun(unsigned int frame) const {
+	return frame % (warmupFrames + frames) == 0;
+}
+
+int SceneBenchmark::sampleOf(unsigned int frame) const {
+	if (frame >= TotalFrames())
+		return -1;
+	unsigned int local = frame % (warmupFrames + frames);
+	return local < warmupFrames ? -1 : (int) (local - warmupFrames);
+}
+
+void SceneBenchmark::RecordCpuFrame(unsigned int frame, double milliseconds) {
+	int sample = sampleOf(frame);
+	if (sample >= 0)
+		runs[RunOf(frame)].cpuMilliseconds[sample] = milliseconds;
+}
+
+void SceneBenchmark::BeginGpuFrame(unsigned int frame) {
+	if (!queriesCreated) {
+		for (GpuFrame& gpuFrame : gpuRing) {
+			glGenQueries(2, gpuFrame.timestamps);
+			glGenQueries(1, &gpuFrame.primitives);
+		}
+		queriesCreated = true;
+	}
+
+	GpuFrame& gpuFrame = gpuRing[frame % gpuFrames];
+	readGpuFrame(gpuFrame);
+	gpuFrame.frame = (int) frame;
+	glQueryCounter(gpuFrame.timestamps[0], GL_TIMESTAMP);
+	glBeginQuery(GL_PRIMITIVES_GENERATED, gpuFrame.primitives);
+}
+
+void SceneBenchmark::EndGpuFrame(unsigned int frame, unsigned int drawCalls) {
+	GpuFrame& gpuFrame = gpuRing[frame % gpuFrames];
+	glEndQuery(GL_PRIMITIVES_GENERATED);
+	glQueryCounter(gpuFrame.timestamps[1], GL_TIMESTAMP);
+	int sample = sampleOf(frame);
+	if (sample >= 0)
+		runs[RunOf(frame)].drawCalls[sample] = drawCalls;
+}
+
+void SceneBenchmark::readGpuFrame(GpuFrame& gpuFrame) {
+	if (gpuFrame.frame < 0)
+		return;
+	// Blocks if the GPU is more than gpuFrames behind, which only costs time the frames after it
+	GLuint64 begin = 0;
+	GLuint64 end = 0;
+	GLuint64 primitives = 0;
+	glGetQueryObjectui64v(gpuFrame.timestamps[0], GL_QUERY_RESULT, &begin);
+	glGetQueryObjectui64v(gpuFrame.timestamps[1], GL_QUERY_RESULT, &end);
+	glGetQueryObjectui64v(gpuFrame.primitives, GL_QUERY_RESULT, &primitives);
+	int sample = sampleOf((unsigned int) gpuFrame.frame);
+	if (sample >= 0) {
+		Run& run = runs[RunOf((unsigned int) gpuFrame.frame)];
+		run.gpuMilliseconds[sample] = (end - begin) / 1.0e6;
+		run.triangles[sample] = primitives;
+	}
+	gpuFrame.frame = -1;
+}
+
+void SceneBenchmark::Flush() {
+	for (GpuFrame& gpuFrame : gpuRing)
+		readGpuFrame(gpuFrame);
+	const char* rendererString = (const char*) glGetString(GL_RENDERER);
+	const char* versionString = (const char*) glGetString(GL_VERSION);
+	renderer = rendererString != NULL ? rendererString : "";
+	version = versionString != NULL ? versionString : "";
+}
+
+void SceneBenchmark::Delete() {
+	if (!queriesCreated)
+		return;
+	for (GpuFrame& gpuFrame : gpuRing) {
+		glDeleteQueries(2, gpuFrame.timestamps);
+		glDeleteQueries(1, &gpuFrame.primitives);
+	}
+	queriesCreated = false;
+}
+
+void SceneBenchmark::PrintReport() const {
+	printf("Scene benchmark: %u frames per run (+%u warm-up) on %s, loaded in %.0f ms\n", frames, warmupFrames,
+		renderer.c_str(), loadMilliseconds);
+	printf("%-10s %27s %27s %10s %12s\n", "Run", "CPU ms (p50 / p95 / p99)", "GPU ms (p50 / p95 / p99)", "Draws", "Triangles");
+	for (const Run& run : runs) {
+		printf("%-10s %8.2f / %7.2f / %7.2f %8.2f / %7.2f / %7.2f %10.0f %12.0f\n", run.name.c_str(),
+			percentile(run.cpuMilliseconds, 0.50), percentile(run.cpuMilliseconds, 0.95), percentile(run.cpuMilliseconds, 0.99),
+			percentile(run.gpuMilliseconds, 0.50), percentile(run.gpuMilliseconds, 0.95), percentile(run.gpuMilliseconds, 0.99),
+			mean(run.drawCalls), mean(run.triangles));
+	}
+}
+
+bool SceneBenchmark::WriteReport(const char* file) const {
+	json report;
+	report["renderer"] = renderer;
+	report["version"] = version;
+	report["path"] = pathName;
+	report["pathDuration"] = path.Duration();
+	report["frames"] = frames;
+	report["warmupFrames"] = warmupFrames;
+	report["timeStep"] = timeStep;
+	report["loadMilliseconds"] = loadMilliseconds;
+	report["runs"] = json::array();
+	for (const Run& run : runs) {
+		report["runs"].push_back({
+			{"name", run.name},
+			{"cpuFrameMilliseconds", distribution(run.cpuMilliseconds)},
+			{"gpuFrameMilliseconds", distribution(run.gpuMilliseconds)},
+			{"drawCalls", distribution(run.drawCalls)},
+			{"triangles", distribution(run.triangles)}
+		});
+	}
+
+	std::ofstream out(file);
+	if (!out) {
+		std::cout << "SceneBenchmark: could not write " << file << std::endl;
+		return false;
+	}
+	out << report.dump(1) << std::endl;
+	return true;
+}
@@ -0,0 +1,81 @@
+#ifndef SCENE_BENCHMARK_CLASS_H
+#define SCENE_BENCHMARK_CLASS_H
+
+#include<glad/glad.h>
+#include<string>
+#include<vector>
+
+#include"CameraPath.h"
+
+// Frame timing of the whole application over a camera path, for --bench (see Main). Every run
+// renders the same path from the start: 'warmupFrames' untimed frames, then 'frames' timed ones,
+// each at a fixed time step so frame N shows the same view no matter how fast it rendered.
+//
+// Per timed frame it keeps the CPU frame time (update loop, main thread), the GPU time between two
+// GL_TIMESTAMP queries around the frame's commands, the scene draw calls and the primitives the GPU
+// assembled (GL_PRIMITIVES_GENERATED). GPU results are read gpuFrames frames later; unlike the
+// profiler it waits for them if needed, so no frame goes missing.
+class SceneBenchmark {
+public:
+	static const int gpuFrames = 4;
+
+	struct Run {
+		std::string name;
+		std::vector<double> cpuMilliseconds;
+		std::vector<double> gpuMilliseconds;
+		std::vector<unsigned int> drawCalls;
+		std::vector<unsigned long long> triangles;
+	};
+
+	CameraPath path;
+	// Where the path came from, for the report
+	std::string pathName;
+	unsigned int warmupFrames = 30;
+	unsigned int frames = 300;
+	float timeStep = 1.0f / 60.0f;
+	// Time from startup to the first frame
+	double loadMilliseconds = 0.0;
+	std::vector<Run> runs;
+
+	// Adds a run, call before the first frame
+	void AddRun(const char* name);
+	unsigned int TotalFrames() const {
+		return (unsigned int) runs.size() * (warmupFrames + frames);
+	}
+	// Run a frame (0..TotalFrames) belongs to, and its time on the path
+	unsigned int RunOf(unsigned int frame) const;
+	float TimeOf(unsigned int frame) const;
+	// Whether the frame starts a run (the scene should be put back to its initial state)
+	bool StartsRun(unsigned int frame) const;
+
+	// CPU time of a whole frame, from the update thread
+	void RecordCpuFrame(unsigned int frame, double milliseconds);
+	// Around the GL commands of a frame, on the thread owning the context
+	void BeginGpuFrame(unsigned int frame);
+	void EndGpuFrame(unsigned int frame, unsigned int drawCalls);
+	// Waits for the GPU results still outstanding, needs the context
+	void Flush();
+	void Delete();
+
+	void PrintReport() const;
+	// JSON report with the percentiles of every run
+	bool WriteReport(const char* file) const;
+
+private:
+	struct GpuFrame {
+		GLuint timestamps[2] = {0, 0};
+		GLuint primitives = 0;
+		// Frame the queries belong to, -1 when they hold nothing
+		int frame = -1;
+	};
+	GpuFrame gpuRing[gpuFrames];
+	bool queriesCreated = false;
+	// Renderer of the context, taken in Flush
+	std::string renderer;
+	std::string version;
+
+	// Sample index of a frame in its run, -1 during warm-up
+	int sampleOf(unsigned int frame) const;
+	void readGpuFrame(GpuFrame& gpuFrame);
+};
+#endif
@@ -0,0 +1,487 @@
+#include"SceneGenerator.h"
+
+#include<algorithm>
+#include<cmath>
+#include<cstdio>
+#include<cstdlib>
+#include<cstring>
+#include<fstream>
+#include<iostream>
+#include<random>
+#include<string>
+#include<vector>
+#include<glm/glm.hpp>
+#include<glm/gtc/constants.hpp>
+#include<json/json.h>
+
+using json = nlohmann::json;
+
+// Uniform float in [0, 1) from the top 24 bits, the same on every standard library
+static float unitFloat(std::mt19937& random) {
+	return (random() >> 8) * (1.0f / 16777216.0f);
+}
+
+static float rangeFloat(std::mt19937& random, float low, float high) {
+	return low + (high - low) * unitFloat(random);
+}
+
+static void appendBytes(std::vector<unsigned char>& buffer, const void* bytes, size_t size) {
+	const unsigned char* begin = (const unsigned char*) bytes;
+	buffer.insert(buffer.end(), begin, begin + size);
+}
+
+// Vertex attributes have to start on 4 byte boundaries
+static void alignBuffer(std::vector<unsigned char>& buffer) {
+	while (buffer.size() % 4 != 0)
+		buffer.push_back(0);
+}
+
+static unsigned int componentSize(unsigned int componentType) {
+	if (componentType == 5121)
+		return 1;
+	if (componentType == 5123)
+		return 2;
+	return 4;
+}
+
+static unsigned int alignedSize(unsigned int size) {
+	return (size + 3) & ~3u;
+}
+
+static void appendTexCoord(std::vector<unsigned char>& buffer, const glm::vec2& texCoord, unsigned int componentType) {
+	if (componentType == 5121) {
+		unsigned char values[2] = {(unsigned char) std::lround(texCoord.x * 255.0f), (unsigned char) std::lround(texCoord.y * 255.0f)};
+		appendBytes(buffer, values, sizeof(values));
+	} else if (componentType == 5123) {
+		unsigned short values[2] = {(unsigned short) std::lround(texCoord.x * 65535.0f), (unsigned short) std::lround(texCoord.y * 65535.0f)};
+		appendBytes(buffer, values, sizeof(values));
+	} else {
+		appendBytes(buffer, &texCoord, sizeof(texCoord));
+	}
+}
+
+static std::string fileName(const std::string& path) {
+	return path.substr(path.find_last_of('/') + 1);
+}
+
+static std::string withoutExtension(const std::string& path) {
+	size_t dot = path.find_last_of('.');
+	return dot != std::string::npos && dot > path.find_last_of('/') + 1 ? path.substr(0, dot) : path;
+}
+
+// PNG writer for the generated textures, storing the image data in uncompressed deflate blocks
+// (stb_image reads them like any other PNG, and nothing here needs small files)
+static unsigned int crc32(const unsigned char* bytes, size_t size, unsigned int crc = 0) {
+	static unsigned int table[256];
+	if (table[1] == 0) {
+		for (unsigned int i = 0; i < 256; i++) {
+			unsigned int value = i;
+			for (int bit = 0; bit < 8; bit++)
+				value = value & 1 ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+			table[i] = value;
+		}
+	}
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+		crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+static void appendBigEndian(std::vector<unsigned char>& buffer, unsigned int value) {
+	unsigned char bytes[4] = {(unsigned char) (value >> 24), (unsigned char) (value >> 16), (unsigned char) (value >> 8), (unsigned char) value};
+	appendBytes(buffer, bytes, sizeof(bytes));
+}
+
+static void appendPngChunk(std::vector<unsigned char>& png, const char* type, const std::vector<unsigned char>& contents) {
+	appendBigEndian(png, (unsigned int) contents.size());
+	size_t typeStart = png.size();
+	appendBytes(png, type, 4);
+	png.insert(png.end(), contents.begin(), contents.end());
+	appendBigEndian(png, crc32(&png[typeStart], png.size() - typeStart));
+}
+
+static bool writePng(const std::string& file, unsigned int width, unsigned int height, const std::vector<unsigned char>& rgb) {
+	// Every row starts with filter type 0 (none)
+	std::vector<unsigned char> rows;
+	rows.reserve((size_t) height * (width * 3 + 1));
+	for (unsigned int y = 0; y < height; y++) {
+		rows.push_back(0);
+		rows.insert(rows.end(), rgb.begin() + (size_t) y * width * 3, rgb.begin() + (size_t) (y + 1) * width * 3);
+	}
+
+	// zlib stream of stored blocks of at most 65535 bytes, then the Adler-32 of the rows
+	std::vector<unsigned char> zlib = {0x78, 0x01};
+	size_t position = 0;
+	do {
+		unsigned int length = (unsigned int) std::min<size_t>(rows.size() - position, 65535);
+		bool last = position + length == rows.size();
+		unsigned char header[5] = {(unsigned char) (last ? 1 : 0), (unsigned char) length, (unsigned char) (length >> 8),
+			(unsigned char) ~length, (unsigned char) (~length >> 8)};
+		appendBytes(zlib, header, sizeof(header));
+		zlib.insert(zlib.end(), rows.begin() + position, rows.begin() + position + length);
+		position += length;
+	} while (position < rows.size());
+	unsigned int a = 1;
+	unsigned int b = 0;
+	for (unsigned char byte : rows) {
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+	appendBigEndian(zlib, (b << 16) | a);
+
+	std::vector<unsigned char> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+	std::vector<unsigned char> header;
+	appendBigEndian(header, width);
+	appendBigEndian(header, height);
+	// 8 bit RGB, deflate, adaptive filtering, no interlace
+	unsigned char format[5] = {8, 2, 0, 0, 0};
+	appendBytes(header, format, sizeof(format));
+	appendPngChunk(png, "IHDR", header);
+	appendPngChunk(png, "IDAT", zlib);
+	appendPngChunk(png, "IEND", std::vector<unsigned char>());
+
+	std::ofstream out(file, std::ios::binary | std::ios::trunc);
+	if (!out)
+		return false;
+	out.write((const char*) png.data(), png.size());
+	return (bool) out;
+}
+
+bool SceneGenerator::Write(const char* file) {
+	std::mt19937 random(seed);
+	std::string path = file;
+	std::string stem = withoutExtension(path);
+	bool binary = path.size() > 4 && path.compare(path.size() - 4, 4, ".glb") == 0;
+	nodeDepth = std::min(nodeDepth, maxNodeDepth);
+	trianglesPerMesh = std::max(trianglesPerMesh, 12u);
+	textureSize = std::max(textureSize, 1u);
+	triangleCount = 0;
+	vertexCount = 0;
+
+	json scene;
+	scene["asset"] = {
+		{"version", "2.0"},
+		{"generator", "SceneGenerator"},
+		{"extras", {
+			{"seed", seed}, {"meshes", meshCount}, {"trianglesPerMesh", trianglesPerMesh},
+			{"instancesPerMesh", instancesPerMesh}, {"nodeDepth", nodeDepth}, {"textures", textureCount},
+			{"textureSize", textureSize}, {"interleaved", interleaved}, {"indexComponentType", indexComponentType},
+			{"texCoordComponentType", texCoordComponentType}
+		}}
+	};
+	scene["scene"] = 0;
+	scene["scenes"] = json::array({{{"nodes", {0}}}});
+	json& accessors = scene["accessors"] = json::array();
+	json& bufferViews = scene["bufferViews"] = json::array();
+	json& meshes = scene["meshes"] = json::array();
+	std::vector<unsigned char> buffer;
+
+	auto addBufferView = [&](size_t offset, size_t length, unsigned int stride, unsigned int target) {
+		json bufferView = {{"buffer", 0}, {"byteOffset", offset}, {"byteLength", length}, {"target", target}};
+		if (stride != 0)
+			bufferView["byteStride"] = stride;
+		bufferViews.push_back(bufferView);
+		return (unsigned int) bufferViews.size() - 1;
+	};
+	auto addAccessor = [&](unsigned int bufferView, size_t offset, unsigned int componentType, size_t count, const char* type) {
+		accessors.push_back({{"bufferView", bufferView}, {"byteOffset", offset}, {"componentType", componentType},
+			{"count", count}, {"type", type}});
+		return (unsigned int) accessors.size() - 1;
+	};
+
+	// Materials share the textures out, the meshes share the materials out
+	unsigned int materialCount = std::max(textureCount, 1u);
+	unsigned int texCoordSize = 2 * componentSize(texCoordComponentType);
+	for (unsigned int m = 0; m < meshCount; m++) {
+		// A sphere of rings x segments quads, bumped along its normals (which are left as the sphere's)
+		unsigned int segments = std::max((unsigned int) std::sqrt((float) trianglesPerMesh), 3u);
+		unsigned int rings = std::max(trianglesPerMesh / (2 * segments), 2u);
+		unsigned int vertices = (rings + 1) * (segments + 1);
+		float radius = rangeFloat(random, 0.5f, 1.5f);
+		float amplitude = rangeFloat(random, 0.0f, 0.3f);
+		float thetaFrequency = (float) (1 + random() % 6);
+		float phiFrequency = (float) (1 + random() % 6);
+		float thetaPhase = rangeFloat(random, 0.0f, 2.0f * glm::pi<float>());
+		float phiPhase = rangeFloat(random, 0.0f, 2.0f * glm::pi<float>());
+
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec3> normals;
+		std::vector<glm::vec2> texCoords;
+		positions.reserve(vertices);
+		normals.reserve(vertices);
+		texCoords.reserve(vertices);
+		glm::vec3 minPosition(INFINITY);
+		glm::vec3 maxPosition(-INFINITY);
+		for (unsigned int r = 0; r <= rings; r++) {
+			float theta = glm::pi<float>() * r / rings;
+			for (unsigned int s = 0; s <= segments; s++) {
+				float phi = 2.0f * glm::pi<float>() * s / segments;
+				glm::vec3 direction(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+				// Zero at the poles and equal at both ends of the seam, so the surface stays closed
+				float bump = 1.0f + amplitude * std::sin(theta) * std::sin(thetaFrequency * theta + thetaPhase) * std::sin(phiFrequency * phi + phiPhase);
+				// Resting on the ground
+				glm::vec3 position = radius * bump * direction + glm::vec3(0.0f, radius, 0.0f);
+				positions.push_back(position);
+				normals.push_back(direction);
+				texCoords.push_back(glm::vec2((float) s / segments, (float) r / rings));
+				minPosition = glm::min(minPosition, position);
+				maxPosition = glm::max(maxPosition, position);
+			}
+		}
+		std::vector<unsigned int> indices;
+		indices.reserve(6 * rings * segments);
+		for (unsigned int r = 0; r < rings; r++) {
+			for (unsigned int s = 0; s < segments; s++) {
+				unsigned int a = r * (segments + 1) + s;
+				unsigned int b = a + segments + 1;
+				unsigned int quad[6] = {a, a + 1, b, a + 1, b + 1, b};
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+		}
+
+		json attributes;
+		if (interleaved) {
+			unsigned int stride = 24 + alignedSize(texCoordSize);
+			alignBuffer(buffer);
+			size_t start = buffer.size();
+			for (unsigned int i = 0; i < vertices; i++) {
+				appendBytes(buffer, &positions[i], sizeof(glm::vec3));
+				appendBytes(buffer, &normals[i], sizeof(glm::vec3));
+				appendTexCoord(buffer, texCoords[i], texCoordComponentType);
+				alignBuffer(buffer);
+			}
+			unsigned int view = addBufferView(start, buffer.size() - start, stride, 34962);
+			attributes["POSITION"] = addAccessor(view, 0, 5126, vertices, "VEC3");
+			attributes["NORMAL"] = addAccessor(view, 12, 5126, vertices, "VEC3");
+			attributes["TEXCOORD_0"] = addAccessor(view, 24, texCoordComponentType, vertices, "VEC2");
+		} else {
+			alignBuffer(buffer);
+			size_t start = buffer.size();
+			appendBytes(buffer, positions.data(), positions.size() * sizeof(glm::vec3));
+			attributes["POSITION"] = addAccessor(addBufferView(start, buffer.size() - start, 0, 34962), 0, 5126, vertices, "VEC3");
+			start = buffer.size();
+			appendBytes(buffer, normals.data(), normals.size() * sizeof(glm::vec3));
+			attributes["NORMAL"] = addAccessor(addBufferView(start, buffer.size() - start, 0, 34962), 0, 5126, vertices, "VEC3");
+			// Small texture coordinates are padded to 4 bytes each, which needs an explicit stride
+			start = buffer.size();
+			for (unsigned int i = 0; i < vertices; i++) {
+				appendTexCoord(buffer, texCoords[i], texCoordComponentType);
+				alignBuffer(buffer);
+			}
+			unsigned int stride = texCoordSize % 4 != 0 ? alignedSize(texCoordSize) : 0;
+			attributes["TEXCOORD_0"] = addAccessor(addBufferView(start, buffer.size() - start, stride, 34962), 0, texCoordComponentType, vertices, "VEC2");
+		}
+		json& position = accessors[attributes["POSITION"].get<unsigned int>()];
+		position["min"] = {minPosition.x, minPosition.y, minPosition.z};
+		position["max"] = {maxPosition.x, maxPosition.y, maxPosition.z};
+		if (texCoordComponentType != 5126)
+			accessors[attributes["TEXCOORD_0"].get<unsigned int>()]["normalized"] = true;
+
+		unsigned int indexType = indexComponentType;
+		if (indexType == 5121 && vertices > 255)
+			indexType = 5123;
+		if (indexType == 5123 && vertices > 65535)
+			indexType = 5125;
+		alignBuffer(buffer);
+		size_t start = buffer.size();
+		for (unsigned int index : indices) {
+			if (indexType == 5121) {
+				buffer.push_back((unsigned char) index);
+			} else if (indexType == 5123) {
+				unsigned short value = (unsigned short) index;
+				appendBytes(buffer, &value, sizeof(value));
+			} else {
+				appendBytes(buffer, &index, sizeof(index));
+			}
+		}
+		unsigned int indexAccessor = addAccessor(addBufferView(start, buffer.size() - start, 0, 34963), 0, indexType, indices.size(), "SCALAR");
+
+		meshes.push_back({{"primitives", {{
+			{"attributes", attributes},
+			{"indices", indexAccessor},
+			{"material", m % materialCount}
+		}}}});
+		triangleCount += (unsigned long long) (indices.size() / 3) * instancesPerMesh;
+		vertexCount += (unsigned long long) vertices * instancesPerMesh;
+	}
+	alignBuffer(buffer);
+	bufferBytes = buffer.size();
+
+	json& materials = scene["materials"] = json::array();
+	for (unsigned int i = 0; i < materialCount; i++) {
+		json material = {{"baseColorFactor", {rangeFloat(random, 0.5f, 1.0f), rangeFloat(random, 0.5f, 1.0f), rangeFloat(random, 0.5f, 1.0f), 1.0f}},
+			{"metallicFactor", 0.0f}, {"roughnessFactor", rangeFloat(random, 0.3f, 1.0f)}};
+		if (textureCount > 0)
+			material["baseColorTexture"] = {{"index", i}};
+		materials.push_back({{"name", "material" + std::to_string(i)}, {"pbrMetallicRoughness", material}});
+	}
+	if (textureCount > 0) {
+		// Linear magnification, trilinear minification, repeat
+		scene["samplers"] = json::array({{{"magFilter", 9729}, {"minFilter", 9987}, {"wrapS", 10497}, {"wrapT", 10497}}});
+		scene["textures"] = json::array();
+		scene["images"] = json::array();
+		std::vector<unsigned char> rgb((size_t) textureSize * textureSize * 3);
+		for (unsigned int i = 0; i < textureCount; i++) {
+			// A checkerboard of two random colors, darkened towards one corner
+			unsigned char colors[2][3];
+			for (int c = 0; c < 2; c++)
+				for (int channel = 0; channel < 3; channel++)
+					colors[c][channel] = (unsigned char) (64 + random() % 192);
+			unsigned int cell = std::max(textureSize / 8, 1u);
+			for (unsigned int y = 0; y < textureSize; y++) {
+				for (unsigned int x = 0; x < textureSize; x++) {
+					const unsigned char* color = colors[(x / cell + y / cell) % 2];
+					float shade = 0.75f + 0.25f * (float) (x + y) / (2 * textureSize);
+					for (int channel = 0; channel < 3; channel++)
+						rgb[((size_t) y * textureSize + x) * 3 + channel] = (unsigned char) (color[channel] * shade);
+				}
+			}
+			std::string image = stem + "_texture" + std::to_string(i) + ".png";
+			if (!writePng(image, textureSize, textureSize, rgb)) {
+				std::cout << "SceneGenerator: could not write " << image << std::endl;
+				return false;
+			}
+			scene["textures"].push_back({{"sampler", 0}, {"source", i}});
+			scene["images"].push_back({{"uri", fileName(image)}});
+		}
+	}
+
+	// Quadtree of group nodes under the root, each child moved to the center of its quarter
+	json& nodes = scene["nodes"] = json::array();
+	nodes.push_back({{"name", "root"}});
+	struct Leaf {
+		unsigned int node;
+		float halfSize;
+	};
+	std::vector<Leaf> leaves = {{0, extent}};
+	for (unsigned int level = 0; level < nodeDepth; level++) {
+		std::vector<Leaf> children;
+		for (const Leaf& parent : leaves) {
+			float half = parent.halfSize * 0.5f;
+			for (int quarter = 0; quarter < 4; quarter++) {
+				nodes.push_back({{"translation", {quarter & 1 ? half : -half, 0.0f, quarter & 2 ? half : -half}}});
+				nodes[parent.node]["children"].push_back(nodes.size() - 1);
+				children.push_back({(unsigned int) nodes.size() - 1, half});
+			}
+		}
+		leaves.swap(children);
+	}
+	// Instances spread at random over the leaves, turned about the vertical and scaled
+	for (unsigned int m = 0; m < meshCount; m++) {
+		for (unsigned int i = 0; i < instancesPerMesh; i++) {
+			const Leaf& leaf = leaves[random() % leaves.size()];
+			float angle = rangeFloat(random, 0.0f, 2.0f * glm::pi<float>());
+			float scale = rangeFloat(random, 0.5f, 1.5f);
+			nodes.push_back({
+				{"mesh", m},
+				{"translation", {rangeFloat(random, -leaf.halfSize, leaf.halfSize), 0.0f, rangeFloat(random, -leaf.halfSize, leaf.halfSize)}},
+				{"rotation", {0.0f, std::sin(angle * 0.5f), 0.0f, std::cos(angle * 0.5f)}},
+				{"scale", {scale, scale, scale}}
+			});
+			nodes[leaf.node]["children"].push_back(nodes.size() - 1);
+		}
+	}
+	nodeCount = (unsigned int) nodes.size();
+
+	if (binary) {
+		scene["buffers"] = json::array({{{"byteLength", buffer.size()}}});
+		std::string text = scene.dump();
+		// The JSON chunk is padded with spaces, the BIN chunk is already 4 byte aligned
+		while (text.size() % 4 != 0)
+			text.push_back(' ');
+		unsigned int header[3] = {0x46546C67, 2, (unsigned int) (12 + 8 + text.size() + 8 + buffer.size())};
+		unsigned int jsonChunk[2] = {(unsigned int) text.size(), 0x4E4F534A};
+		unsigned int binChunk[2] = {(unsigned int) buffer.size(), 0x004E4942};
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		out.write((const char*) header, sizeof(header));
+		out.write((const char*) jsonChunk, sizeof(jsonChunk));
+		out.write(text.data(), text.size());
+		out.write((const char*) binChunk, sizeof(binChunk));
+		out.write((const char*) buffer.data(), buffer.size());
+		if (!out) {
+			std::cout << "SceneGenerator: could not write " << path << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	std::string binaryFile = stem + ".bin";
+	scene["buffers"] = json::array({{{"byteLength", buffer.size()}, {"uri", fileName(binaryFile)}}});
+	std::ofstream binaryOut(binaryFile, std::ios::binary | std::ios::trunc);
+	binaryOut.write((const char*) buffer.data(), buffer.size());
+	std::ofstream out(path, std::ios::trunc);
+	out << scene.dump(1) << std::endl;
+	if (!binaryOut || !out) {
+		std::cout << "SceneGenerator: could not write " << path << " or " << binaryFile << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void SceneGenerator::PrintSummary() const {
+	printf("Scene: %u meshes x %u instances, %llu triangles, %llu vertices, %u nodes (depth %u), %u textures of %u x %u, %.1f MB of buffer\n",
+		meshCount, instancesPerMesh, triangleCount, vertexCount, nodeCount, nodeDepth, textureCount, textureSize, textureSize,
+		bufferBytes / (1024.0 * 1024.0));
+}
+
+static unsigned int parseComponentType(const char* name, unsigned int fallback) {
+	if (std::strcmp(name, "u8") == 0)
+		return 5121;
+	if (std::strcmp(name, "u16") == 0)
+		return 5123;
+	if (std::strcmp(name, "u32") == 0)
+		return 5125;
+	if (std::strcmp(name, "f32") == 0)
+		return 5126;
+	std::cout << "SceneGenerator: unknown component type " << name << std::endl;
+	return fallback;
+}
+
+int RunSceneGenerator(int argc, char** argv) {
+	if (argc < 3) {
+		std::cout << "Usage: --generate-scene <file.gltf|file.glb> [--seed n] [--meshes n] [--triangles n] [--instances n] "
+			"[--depth n] [--textures n] [--texture-size n] [--interleaved] [--index-type u8|u16|u32] [--texcoord-type f32|u16|u8]" << std::endl;
+		return 1;
+	}
+	SceneGenerator generator;
+	for (int i = 3; i < argc; i++) {
+		std::string option = argv[i];
+		if (option == "--interleaved") {
+			generator.interleaved = true;
+			continue;
+		}
+		if (i + 1 >= argc)
+			break;
+		const char* value = argv[++i];
+		unsigned int number = (unsigned int) std::max(std::atoi(value), 0);
+		if (option == "--seed")
+			generator.seed = (unsigned int) std::strtoul(value, NULL, 10);
+		else if (option == "--meshes")
+			generator.meshCount = number;
+		else if (option == "--triangles")
+			generator.trianglesPerMesh = number;
+		else if (option == "--instances")
+			generator.instancesPerMesh = std::max(number, 1u);
+		else if (option == "--depth")
+			generator.nodeDepth = number;
+		else if (option == "--textures")
+			generator.textureCount = number;
+		else if (option == "--texture-size")
+			generator.textureSize = number;
+		else if (option == "--index-type")
+			generator.indexComponentType = parseComponentType(value, generator.indexComponentType);
+		else if (option == "--texcoord-type")
+			generator.texCoordComponentType = parseComponentType(value, generator.texCoordComponentType);
+		else
+			std::cout << "SceneGenerator: unknown option " << option << std::endl;
+	}
+	if (generator.indexComponentType == 5126)
+		generator.indexComponentType = 5125;
+	if (generator.texCoordComponentType == 5125)
+		generator.texCoordComponentType = 5126;
+
+	if (!generator.Write(argv[2]))
+		return 1;
+	generator.PrintSummary();
+	return 0;
+}
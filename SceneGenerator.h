@@ -0,0 +1,57 @@
+#ifndef SCENE_GENERATOR_CLASS_H
+#define SCENE_GENERATOR_CLASS_H
+
+// Writes synthetic glTF 2.0 scenes for scaling tests, with --generate-scene (see RunSceneGenerator).
+// Everything comes from one std::mt19937 seeded with 'seed' and is turned into numbers without the
+// standard distributions (whose output differs between standard libraries). The structure of the
+// scene (counts, nodes, indices, materials) is therefore the same for a seed on every platform. Vertex
+// positions, normals and rotations go through std::sin / std::cos, whose last bit differs between math
+// libraries, so byte-identical files are only guaranteed with the same standard library and libm.
+//
+// The scene has meshCount meshes: bumpy spheres of about trianglesPerMesh triangles each. Node 0 is
+// the only root, under it a quadtree of group nodes nodeDepth levels deep splits the ground square
+// (2 * extent across), and each leaf holds some of the instancesPerMesh nodes per mesh. The loader
+// makes one Mesh per mesh node, so the instancing ratio multiplies the GPU memory as well as the draws.
+//
+// A file ending in .glb is written as one binary glTF, anything else as .gltf with the buffer in a
+// .bin next to it. Textures are always separate PNG files next to the scene, as the loader reads
+// images by uri.
+class SceneGenerator {
+public:
+	unsigned int seed = 1;
+	unsigned int meshCount = 16;
+	unsigned int trianglesPerMesh = 2048;
+	unsigned int instancesPerMesh = 4;
+	// Levels of group nodes between the root and the instances, at most maxNodeDepth
+	unsigned int nodeDepth = 2;
+	// Base color textures, shared out over the materials; 0 leaves the materials untextured
+	unsigned int textureCount = 4;
+	unsigned int textureSize = 256;
+	// One bufferView with a byteStride per mesh instead of one per attribute
+	bool interleaved = false;
+	// 5121, 5123 or 5125 (GL_UNSIGNED_BYTE/SHORT/INT). A mesh with too many vertices for it gets
+	// the next wider type, as the largest value of a type is reserved for primitive restart.
+	unsigned int indexComponentType = 5125;
+	// 5126 (float), or 5123 / 5121 stored normalized
+	unsigned int texCoordComponentType = 5126;
+	float extent = 50.0f;
+
+	static const unsigned int maxNodeDepth = 8;
+
+	// Totals of the last Write
+	unsigned long long triangleCount = 0;
+	unsigned long long vertexCount = 0;
+	unsigned int nodeCount = 0;
+	unsigned long long bufferBytes = 0;
+
+	// Writes the scene, false if a file could not be written
+	bool Write(const char* file);
+	void PrintSummary() const;
+};
+
+// --generate-scene <file.gltf|file.glb> [--seed n] [--meshes n] [--triangles n] [--instances n]
+// [--depth n] [--textures n] [--texture-size n] [--interleaved] [--index-type u8|u16|u32]
+// [--texcoord-type f32|u16|u8]
+int RunSceneGenerator(int argc, char** argv);
+
+#endif
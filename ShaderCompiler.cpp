@@ -0,0 +1,178 @@
+#include"ShaderCompiler.h"
+#include"GLExtensions.h"
+#include"ProgramCache.h"
+
+#include<iostream>
+
+ShaderCompiler shaderCompiler;
+
+void ShaderCompiler::Start(std::function<void()> makeWorkerContextCurrent) {
+	if (glFeatures.parallelShaderCompile) {
+		// Let the driver pick how many threads it uses
+		glMaxShaderCompilerThreads(0xFFFFFFFFu);
+		mode = ParallelExtension;
+	} else if (makeWorkerContextCurrent) {
+		mode = WorkerContext;
+		stopping = false;
+		worker = std::thread(&ShaderCompiler::workerLoop, this, makeWorkerContextCurrent);
+	} else {
+		mode = Synchronous;
+	}
+	const char* modeNames[] = {"synchronous", "parallel compile extension", "worker context"};
+	std::cout << "Shader compiler: " << modeNames[mode] << std::endl;
+}
+
+void ShaderCompiler::Stop() {
+	if (worker.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		worker.join();
+	}
+	mode = Synchronous;
+}
+
+void ShaderCompiler::startBuild(Job& job) {
+	const char* vertexSource = job.vertexCode.c_str();
+	const char* fragmentSource = job.fragmentCode.c_str();
+	job.vertexShader = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(job.vertexShader, 1, &vertexSource, NULL);
+	glCompileShader(job.vertexShader);
+	job.fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(job.fragmentShader, 1, &fragmentSource, NULL);
+	glCompileShader(job.fragmentShader);
+
+	// Linking right away is fine, a failed compile just makes the link fail too
+	job.program = glCreateProgram();
+	glAttachShader(job.program, job.vertexShader);
+	glAttachShader(job.program, job.fragmentShader);
+	programCache.PrepareLink(job.program);
+	glLinkProgram(job.program);
+}
+
+bool ShaderCompiler::finishBuild(Job& job) {
+	GLint status = GL_FALSE;
+	char infoLog[1024];
+	const GLuint shaders[2] = {job.vertexShader, job.fragmentShader};
+	const char* types[2] = {"VERTEX", "FRAGMENT"};
+	for (int i = 0; i < 2; i++) {
+		glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &status);
+		if (status == GL_FALSE) {
+			glGetShaderInfoLog(shaders[i], 1024, NULL, infoLog);
+			std::cout << "SHADER_COMPILATION_ERROR for:" << types[i] << " (" << job.name << ")\n" << infoLog << std::endl;
+		}
+	}
+	glGetProgramiv(job.program, GL_LINK_STATUS, &status);
+	bool linked = status == GL_TRUE;
+	if (!linked) {
+		glGetProgramInfoLog(job.program, 1024, NULL, infoLog);
+		std::cout << "SHADER_LINKING_ERROR for:PROGRAM (" << job.name << ")\n" << infoLog << std::endl;
+	}
+	glDeleteShader(job.vertexShader);
+	glDeleteShader(job.fragmentShader);
+	job.vertexShader = 0;
+	job.fragmentShader = 0;
+	return linked;
+}
+
+unsigned int ShaderCompiler::Submit(const std::string& vertexCode, const std::string& fragmentCode, const std::string& name) {
+	Job job;
+	job.vertexCode = vertexCode;
+	job.fragmentCode = fragmentCode;
+	job.name = name;
+	job.start = std::chrono::high_resolution_clock::now();
+	job.cacheKey = programCache.Key({&job.vertexCode, &job.fragmentCode});
+	job.program = programCache.Load(job.cacheKey);
+	if (job.program != 0) {
+		job.done = true;
+		job.fromCache = true;
+	} else if (mode != WorkerContext) {
+		// The extension makes these calls return immediately, without it they block here
+		startBuild(job);
+		job.done = mode == Synchronous;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	unsigned int handle = nextJob++;
+	bool queued = !job.done && mode == WorkerContext;
+	jobs.emplace(handle, std::move(job));
+	if (queued) {
+		queue.push_back(handle);
+		wake.notify_one();
+	}
+	return handle;
+}
+
+bool ShaderCompiler::Poll(unsigned int handle, GLuint& program) {
+	program = 0;
+	Job job;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto found = jobs.find(handle);
+		if (found == jobs.end())
+			return true;
+		Job& pending = found->second;
+		if (!pending.done && mode == ParallelExtension) {
+			GLint completed = GL_FALSE;
+			glGetProgramiv(pending.program, GL_COMPLETION_STATUS_KHR, &completed);
+			pending.done = completed == GL_TRUE;
+		}
+		if (!pending.done)
+			return false;
+		job = std::move(pending);
+		jobs.erase(found);
+	}
+
+	if (job.fromCache) {
+		program = job.program;
+		return true;
+	}
+	// The worker already checked the results in its own context
+	bool linked = mode == WorkerContext ? job.program != 0 : finishBuild(job);
+	if (!linked) {
+		if (job.program != 0)
+			glDeleteProgram(job.program);
+		return true;
+	}
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - job.start).count();
+	programCache.Store(job.program, job.cacheKey, milliseconds);
+	program = job.program;
+	return true;
+}
+
+unsigned int ShaderCompiler::PendingCount() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return (unsigned int) jobs.size();
+}
+
+void ShaderCompiler::workerLoop(std::function<void()> makeWorkerContextCurrent) {
+	makeWorkerContextCurrent();
+	while (true) {
+		unsigned int handle;
+		Job* job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this] { return stopping || !queue.empty(); });
+			if (stopping)
+				return;
+			handle = queue.front();
+			queue.pop_front();
+			// unordered_map nodes stay put while other jobs are added or removed
+			job = &jobs[handle];
+		}
+
+		startBuild(*job);
+		bool linked = finishBuild(*job);
+		if (!linked) {
+			glDeleteProgram(job->program);
+			job->program = 0;
+		}
+		// The program is used from the main context next, so it has to be complete there
+		glFinish();
+
+		std::lock_guard<std::mutex> lock(mutex);
+		job->done = true;
+	}
+}
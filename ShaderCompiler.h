@@ -0,0 +1,73 @@
+#ifndef SHADER_COMPILER_CLASS_H
+#define SHADER_COMPILER_CLASS_H
+
+#include<glad/glad.h>
+#include<chrono>
+#include<condition_variable>
+#include<deque>
+#include<functional>
+#include<mutex>
+#include<string>
+#include<thread>
+#include<unordered_map>
+
+// Builds programs without blocking the frame loop. Submit starts a build and Poll reports when the
+// program can be used, so callers keep drawing with what they have until then. Three modes:
+//   ParallelExtension  KHR/ARB_parallel_shader_compile, the driver compiles in its own threads and
+//                      GL_COMPLETION_STATUS_KHR is polled
+//   WorkerContext      a thread with its own context (shared with the main one) compiles and links
+//   Synchronous        no way to do it in the background, Submit builds the program right away
+// Finished programs are stored in the program cache, and cached ones complete immediately.
+class ShaderCompiler {
+public:
+	enum Mode { Synchronous, ParallelExtension, WorkerContext };
+	Mode mode = Synchronous;
+
+	// Picks the mode for the current context. 'makeWorkerContextCurrent' is only used when the parallel
+	// compile extension is missing: it runs on the worker thread and must make a context current there
+	// that shares objects with the main one.
+	void Start(std::function<void()> makeWorkerContextCurrent);
+	void Stop();
+
+	// Starts building a program from the final sources of both stages, returns a job handle (never 0)
+	unsigned int Submit(const std::string& vertexCode, const std::string& fragmentCode, const std::string& name);
+	// Returns true once the job is finished; 'program' is then the linked program, or 0 if building failed.
+	// A finished job is released, polling it again returns true with program 0.
+	bool Poll(unsigned int job, GLuint& program);
+	// Number of submitted jobs that have not been polled as finished yet
+	unsigned int PendingCount();
+
+private:
+	struct Job {
+		std::string vertexCode;
+		std::string fragmentCode;
+		std::string name;
+		unsigned long long cacheKey = 0;
+		GLuint program = 0;
+		GLuint vertexShader = 0;
+		GLuint fragmentShader = 0;
+		std::chrono::high_resolution_clock::time_point start;
+		// Set by whoever finished the job (worker thread or Submit)
+		bool done = false;
+		bool fromCache = false;
+	};
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::unordered_map<unsigned int, Job> jobs;
+	// Jobs waiting for the worker context
+	std::deque<unsigned int> queue;
+	std::thread worker;
+	bool stopping = false;
+	unsigned int nextJob = 1;
+
+	void workerLoop(std::function<void()> makeWorkerContextCurrent);
+	// glCompileShader/glLinkProgram for a job, without waiting for the result
+	void startBuild(Job& job);
+	// Reads the results of a completed build, prints the errors and frees the shader objects
+	bool finishBuild(Job& job);
+};
+
+// Shared by the shader variants, started by Main
+extern ShaderCompiler shaderCompiler;
+#endif
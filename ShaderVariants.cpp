@@ -0,0 +1,154 @@
+#include"ShaderVariants.h"
+#include"ShaderCompiler.h"
+
+// Same order as the ShaderFeature bits
+static const char* featureDefines[SHADER_FEATURE_COUNT] = {
+	"BLEND_TEXTURES",
+	"SPOT_LIGHT",
+	"POINT_LIGHTS",
+	"DEBUG_NORMALS",
+	"DEBUG_TEXCOORDS",
+	"DEBUG_ALBEDO",
+	"TEXTURE_HANDLES",
+	"ALPHA_MASK"
+};
+
+// File name without the directory
+static std::string fileName(const std::string& path) {
+	size_t slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+ShaderVariants::ShaderVariants(const char* vertexFile, const char* fragmentFile, unsigned int fallbackFeatures) {
+	ShaderVariants::vertexFile = vertexFile;
+	ShaderVariants::fragmentFile = fragmentFile;
+	ShaderVariants::fallbackFeatures = fallbackFeatures;
+
+	// Something has to draw while the other variants are built
+	Variant fallback = {Shader(vertexFile, fragmentFile, Defines(fallbackFeatures)), 0, 0};
+	variants.emplace(fallbackFeatures, fallback);
+}
+
+void ShaderVariants::BeginFrame() {
+	frame++;
+
+	for (size_t i = 0; i < abandonedJobs.size();) {
+		GLuint program;
+		if (shaderCompiler.Poll(abandonedJobs[i], program)) {
+			if (program != 0)
+				glDeleteProgram(program);
+			abandonedJobs[i] = abandonedJobs.back();
+			abandonedJobs.pop_back();
+		} else {
+			i++;
+		}
+	}
+}
+
+std::string ShaderVariants::Defines(unsigned int features) {
+	std::string defines;
+	for (unsigned int i = 0; i < SHADER_FEATURE_COUNT; i++) {
+		if (features & (1u << i))
+			defines += std::string("#define ") + featureDefines[i] + "\n";
+	}
+	return defines;
+}
+
+unsigned int ShaderVariants::submit(unsigned int features) const {
+	std::string vertexCode, fragmentCode;
+	try {
+		vertexCode = insert_shader_includes(get_file_contents(vertexFile.c_str()));
+		fragmentCode = insert_shader_includes(get_file_contents(fragmentFile.c_str()));
+	} catch (int) {
+		// Editors can briefly remove a file while saving it
+		std::cout << "Could not read " << fragmentFile << " variant sources, keeping the old program" << std::endl;
+		return 0;
+	}
+	std::string defines = Defines(features);
+	char name[64];
+	snprintf(name, sizeof(name), " variant 0x%x", features);
+	return shaderCompiler.Submit(insert_shader_defines(vertexCode, defines), insert_shader_defines(fragmentCode, defines),
+								 fragmentFile + name);
+}
+
+void ShaderVariants::poll(Variant& variant) {
+	if (variant.job == 0)
+		return;
+	GLuint program;
+	if (!shaderCompiler.Poll(variant.job, program))
+		return;
+	variant.job = 0;
+	if (program == 0)
+		return;
+	if (variant.shader.ID != 0)
+		variant.shader.Delete();
+	variant.shader.ID = program;
+	// A new program has none of the uniforms yet
+	variant.setupFrame = 0;
+}
+
+Shader& ShaderVariants::Get(unsigned int features) {
+	auto found = variants.find(features);
+	if (found == variants.end()) {
+		std::cout << "Compiling " << fragmentFile << " variant 0x" << std::hex << features << std::dec << std::endl;
+		Variant variant = {Shader((GLuint) 0), 0, submit(features)};
+		found = variants.emplace(features, variant).first;
+	}
+	poll(found->second);
+
+	Variant& variant = found->second.shader.ID != 0 ? found->second : variants.at(fallbackFeatures);
+	poll(variant);
+	if (variant.setupFrame != frame) {
+		variant.setupFrame = frame;
+		if (frameSetup)
+			frameSetup(variant.shader);
+	}
+	variant.shader.Activate();
+	return variant.shader;
+}
+
+void ShaderVariants::Reload() {
+	std::cout << "Reloading " << vertexFile << " / " << fragmentFile << " (" << variants.size() << " variants)" << std::endl;
+	for (auto& entry : variants) {
+		if (entry.second.job != 0)
+			abandonedJobs.push_back(entry.second.job);
+		entry.second.job = submit(entry.first);
+	}
+}
+
+bool ShaderVariants::UsesFile(const std::string& file) const {
+	std::string name = fileName(file);
+	if (name == fileName(vertexFile) || name == fileName(fragmentFile))
+		return true;
+	// The files the stages include, read again as the #include lines may have changed
+	for (const std::string& stageFile : {vertexFile, fragmentFile}) {
+		try {
+			for (const std::string& include : shader_include_files(get_file_contents(stageFile.c_str()))) {
+				if (fileName(include) == name)
+					return true;
+			}
+		} catch (int) {
+			// A stage that is being saved reports its own change
+		}
+	}
+	return false;
+}
+
+unsigned int ShaderVariants::PendingCount() const {
+	unsigned int pending = 0;
+	for (const auto& entry : variants) {
+		if (entry.second.job != 0)
+			pending++;
+	}
+	return pending;
+}
+
+void ShaderVariants::Delete() {
+	for (auto& entry : variants) {
+		if (entry.second.shader.ID != 0)
+			entry.second.shader.Delete();
+		if (entry.second.job != 0)
+			abandonedJobs.push_back(entry.second.job);
+	}
+	variants.clear();
+}
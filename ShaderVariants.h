@@ -0,0 +1,79 @@
+#ifndef SHADER_VARIANTS_CLASS_H
+#define SHADER_VARIANTS_CLASS_H
+
+#include<functional>
+#include<string>
+#include<unordered_map>
+#include<vector>
+
+#include"shaderClass.h"
+
+// Feature bits of a shader variant, each one becomes a #define in both stages (see default.frag)
+enum ShaderFeature : unsigned int {
+	SHADER_BLEND_TEXTURES = 1u << 0,
+	SHADER_SPOT_LIGHT = 1u << 1,
+	SHADER_POINT_LIGHTS = 1u << 2,
+	SHADER_DEBUG_NORMALS = 1u << 3,
+	SHADER_DEBUG_TEXCOORDS = 1u << 4,
+	SHADER_DEBUG_ALBEDO = 1u << 5,
+	SHADER_TEXTURE_HANDLES = 1u << 6,
+	SHADER_ALPHA_MASK = 1u << 7,
+	SHADER_FEATURE_COUNT = 8
+};
+
+// Permutations of one vertex/fragment pair. A variant is compiled the first time its feature set is
+// asked for and kept by its feature bits, so every material only pays for the features it uses.
+//
+// Variants are built in the background by shaderCompiler; until one is ready Get returns the fallback
+// variant, which is built right away in the constructor. Reload rebuilds every variant from the files
+// the same way, each one keeps drawing with its old program until the new one has linked (a program
+// that fails to build is never swapped in).
+//
+// Uniforms are per program, so every variant needs the per-frame uniforms too: 'frameSetup' runs on
+// a variant the first time it is used after BeginFrame.
+class ShaderVariants {
+public:
+	std::function<void(Shader&)> frameSetup;
+
+	ShaderVariants(const char* vertexFile, const char* fragmentFile, unsigned int fallbackFeatures = 0);
+
+	// Starts a new frame, variants run 'frameSetup' again on their next use
+	void BeginFrame();
+	// Returns the variant for 'features' (or the fallback while it is being built) and activates it
+	Shader& Get(unsigned int features);
+	// Rebuilds every variant from the current contents of the files
+	void Reload();
+	// Whether 'file' (a path or just the file name) is one of the two stages or a file they include
+	bool UsesFile(const std::string& file) const;
+	// Shader defines of a feature set
+	static std::string Defines(unsigned int features);
+
+	unsigned int VariantCount() const {
+		return (unsigned int) variants.size();
+	}
+	// Variants still waiting for their first or reloaded program
+	unsigned int PendingCount() const;
+	void Delete();
+
+private:
+	struct Variant {
+		Shader shader;
+		unsigned int setupFrame;
+		// ShaderCompiler job building the next program, 0 if none
+		unsigned int job;
+	};
+
+	std::string vertexFile;
+	std::string fragmentFile;
+	unsigned int fallbackFeatures;
+	std::unordered_map<unsigned int, Variant> variants;
+	// Jobs of variants reloaded again before they finished, their programs are thrown away
+	std::vector<unsigned int> abandonedJobs;
+	unsigned int frame = 1;
+
+	// Submits a build of 'features' with the current file contents, returns the job or 0 if a file cannot be read
+	unsigned int submit(unsigned int features) const;
+	// Swaps in the variant's new program once its job is done
+	void poll(Variant& variant);
+};
+#endif
@@ -0,0 +1,63 @@
+#include"ShaderWatcher.h"
+
+#include<algorithm>
+#include<iostream>
+
+#ifdef __linux__
+#include<sys/inotify.h>
+#include<unistd.h>
+#endif
+
+bool ShaderWatcher::Watch(const char* directory) {
+#ifdef __linux__
+	Close();
+	descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (descriptor < 0)
+		return false;
+	watch = inotify_add_watch(descriptor, directory, IN_CLOSE_WRITE | IN_MOVED_TO);
+	if (watch < 0) {
+		Close();
+		return false;
+	}
+	std::cout << "Watching " << directory << " for shader changes" << std::endl;
+	return true;
+#else
+	(void) directory;
+	return false;
+#endif
+}
+
+std::vector<std::string> ShaderWatcher::Poll() {
+	std::vector<std::string> changed;
+#ifdef __linux__
+	if (descriptor < 0)
+		return changed;
+
+	alignas(inotify_event) char buffer[4096];
+	while (true) {
+		ssize_t length = read(descriptor, buffer, sizeof(buffer));
+		if (length <= 0)
+			break;
+		for (char* position = buffer; position < buffer + length;) {
+			const inotify_event* event = (const inotify_event*) position;
+			if (event->len > 0) {
+				std::string name(event->name);
+				// One save can produce several events
+				if (std::find(changed.begin(), changed.end(), name) == changed.end())
+					changed.push_back(name);
+			}
+			position += sizeof(inotify_event) + event->len;
+		}
+	}
+#endif
+	return changed;
+}
+
+void ShaderWatcher::Close() {
+#ifdef __linux__
+	if (descriptor >= 0)
+		close(descriptor);
+#endif
+	descriptor = -1;
+	watch = -1;
+}
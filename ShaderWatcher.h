@@ -0,0 +1,21 @@
+#ifndef SHADER_WATCHER_CLASS_H
+#define SHADER_WATCHER_CLASS_H
+
+#include<string>
+#include<vector>
+
+// Reports shader files that were saved, for hot reloading. Uses inotify on the directory (so editors
+// that save through a temporary file and a rename are seen too); on other platforms it reports nothing.
+class ShaderWatcher {
+public:
+	// Starts watching the files directly in 'directory', returns false if watching is not possible
+	bool Watch(const char* directory);
+	// Names of the files written since the last call, without blocking
+	std::vector<std::string> Poll();
+	void Close();
+
+private:
+	int descriptor = -1;
+	int watch = -1;
+};
+#endif
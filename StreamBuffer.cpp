@@ -0,0 +1,115 @@
+#include"StreamBuffer.h"
+#include"GLExtensions.h"
+
+#include<algorithm>
+#include<iostream>
+
+StreamBuffer drawStream;
+
+void StreamBuffer::Create(GLenum target, GLsizeiptr frameSize) {
+	StreamBuffer::target = target;
+	StreamBuffer::frameSize = frameSize;
+	if (target == GL_UNIFORM_BUFFER)
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	else if (target == GL_SHADER_STORAGE_BUFFER)
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	else
+		alignment = 16;
+	persistent = glFeatures.bufferStorage;
+	allocateStorage();
+	std::cout << "Stream buffer: " << frameCount << " x " << frameSize / 1024 << " KB, "
+		<< (persistent ? "persistently mapped" : "glBufferSubData uploads") << std::endl;
+}
+
+void StreamBuffer::allocateStorage() {
+	GLsizeiptr totalSize = frameSize * frameCount;
+	glGenBuffers(1, &ID);
+	glBindBuffer(target, ID);
+	if (persistent) {
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(target, totalSize, NULL, flags);
+		mapping = (char*) glMapBufferRange(target, 0, totalSize, flags);
+	} else {
+		glBufferData(target, totalSize, NULL, GL_STREAM_DRAW);
+		staging.resize(totalSize);
+		mapping = staging.data();
+	}
+	glBindBuffer(target, 0);
+}
+
+void StreamBuffer::waitForFence(int region) {
+	if (fences[region] == 0)
+		return;
+	GLenum result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	if (result == GL_TIMEOUT_EXPIRED) {
+		stalls++;
+		do {
+			result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		} while (result == GL_TIMEOUT_EXPIRED);
+	}
+	glDeleteSync(fences[region]);
+	fences[region] = 0;
+}
+
+void StreamBuffer::BeginFrame() {
+	if (overflowed) {
+		// Every region may still be in use, so wait for all of them before replacing the buffer
+		for (int region = 0; region < frameCount; region++)
+			waitForFence(region);
+		Delete();
+		frameSize *= 2;
+		allocateStorage();
+		std::cout << "Stream buffer: grown to " << frameCount << " x " << frameSize / 1024 << " KB" << std::endl;
+		overflowed = false;
+	}
+
+	waitForFence(frame);
+	used = 0;
+	inFrame = true;
+}
+
+void* StreamBuffer::Allocate(GLsizeiptr size, GLintptr& offset) {
+	GLsizeiptr alignedSize = (size + alignment - 1) / alignment * alignment;
+	GLsizeiptr start = used.fetch_add(alignedSize);
+	if (start + size > frameSize) {
+		overflowed = true;
+		return nullptr;
+	}
+	offset = frame * frameSize + start;
+	return mapping + offset;
+}
+
+void StreamBuffer::Flush(GLintptr offset, GLsizeiptr size) {
+	if (persistent)
+		return;
+	glBindBuffer(target, ID);
+	glBufferSubData(target, offset, size, mapping + offset);
+	glBindBuffer(target, 0);
+}
+
+void StreamBuffer::EndFrame() {
+	if (!inFrame)
+		return;
+	fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	usedBytes = std::min((GLsizeiptr) used, frameSize);
+	frame = (frame + 1) % frameCount;
+	inFrame = false;
+}
+
+void StreamBuffer::Delete() {
+	if (ID == 0)
+		return;
+	for (int region = 0; region < frameCount; region++) {
+		if (fences[region] != 0)
+			glDeleteSync(fences[region]);
+		fences[region] = 0;
+	}
+	if (persistent) {
+		glBindBuffer(target, ID);
+		glUnmapBuffer(target);
+		glBindBuffer(target, 0);
+	}
+	glDeleteBuffers(1, &ID);
+	ID = 0;
+	mapping = nullptr;
+}
@@ -0,0 +1,71 @@
+#ifndef STREAM_BUFFER_CLASS_H
+#define STREAM_BUFFER_CLASS_H
+
+#include<glad/glad.h>
+#include<atomic>
+#include<vector>
+
+// Ring buffer for data that changes every frame (per-draw transforms). The buffer holds frameCount
+// regions; each frame writes its data linearly into the next region and a fence placed at EndFrame
+// tells when the GPU is done reading it, so a region is only rewritten once its fence has signaled.
+//
+// With GL 4.4 or ARB_buffer_storage the whole buffer is mapped once, persistently and coherently:
+// Allocate hands out pointers straight into GPU visible memory, which any thread may fill. Without
+// it Allocate returns CPU memory and Flush copies it into the buffer with glBufferSubData.
+class StreamBuffer {
+public:
+	static const int frameCount = 3;
+
+	GLuint ID = 0;
+	GLenum target = GL_UNIFORM_BUFFER;
+	// Bytes available to each frame
+	GLsizeiptr frameSize = 0;
+
+	// Statistics of the last finished frame
+	GLsizeiptr usedBytes = 0;
+	// Frames that had to wait for the GPU to release their region
+	unsigned int stalls = 0;
+
+	// Allocates the buffer, offsets are aligned for glBindBufferRange on 'target'. Needs a current context.
+	void Create(GLenum target, GLsizeiptr frameSize);
+	// Whether Allocate can be used, i.e. between BeginFrame and EndFrame
+	bool Ready() const {
+		return inFrame;
+	}
+	bool Persistent() const {
+		return persistent;
+	}
+
+	// Waits until the GPU is done with the next region and starts writing into it. Grows the buffer
+	// first if the last frame ran out of space.
+	void BeginFrame();
+	// Reserves 'size' bytes and returns where to write them, or nullptr when the region is full.
+	// 'offset' is the position in the buffer for glBindBufferRange. Thread safe.
+	void* Allocate(GLsizeiptr size, GLintptr& offset);
+	// Makes the bytes written at 'offset' visible to the GPU (only copies without a persistent mapping)
+	void Flush(GLintptr offset, GLsizeiptr size);
+	// Fences the region of this frame
+	void EndFrame();
+
+	void Delete();
+
+private:
+	bool persistent = false;
+	bool inFrame = false;
+	bool overflowed = false;
+	GLint alignment = 256;
+	int frame = 0;
+	std::atomic<GLsizeiptr> used{0};
+	// Persistent mapping of the whole buffer, or the CPU copy without buffer storage
+	char* mapping = nullptr;
+	std::vector<char> staging;
+	GLsync fences[frameCount] = {};
+
+	void allocateStorage();
+	void waitForFence(int region);
+};
+
+// Per-draw data of the scene shaders (the DrawData block in default.vert and depth_prepass.vert),
+// created by Main and written by Mesh
+extern StreamBuffer drawStream;
+#endif
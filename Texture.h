@@ -1,26 +1,32 @@
-#ifndef TEXTURE_CLASS_H
-#define TEXTURE_CLASS_H
-
-#include<glad/glad.h>
-#include<stb/stb_image.h>
-
-#include"shaderClass.h"
-
-class Texture {
-public:
-	GLuint ID;
-	const char* type;
-	GLuint unit;
-
-	Texture(const char* image, const char* texType, GLuint slot);
-
-	// Assigns a texture unit to a texture
-	void texUnit(Shader& shader, const char* uniform, GLuint unit);
-	// Binds a texture
-	void Bind();
-	// Unbinds a texture
-	void Unbind();
-	// Deletes a texture
-	void Delete();
-};
+#ifndef TEXTURE_CLASS_H
+#define TEXTURE_CLASS_H
+
+#include<glad/glad.h>
+#include<stb/stb_image.h>
+
+#include"shaderClass.h"
+
+class Texture {
+public:
+	GLuint ID;
+	const char* type;
+	GLuint unit;
+
+	Texture(const char* image, const char* texType, GLuint slot);
+	// Uploads pixels that were already decoded (e.g. by a loading job), NULL gives the error texture
+	Texture(const unsigned char* bytes, int width, int height, int channels, const char* name, const char* texType, GLuint slot);
+
+	// Assigns a texture unit to a texture
+	void texUnit(Shader& shader, const char* uniform, GLuint unit);
+	// Binds a texture
+	void Bind();
+	// Unbinds a texture
+	void Unbind();
+	// Deletes a texture
+	void Delete();
+
+private:
+	// Creates the GL texture with mipmaps from 8-bit pixels
+	void upload(const unsigned char* bytes, int widthImg, int heightImg, int numColCh, const char* name);
+};
 #endif
\ No newline at end of file
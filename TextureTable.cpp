@@ -0,0 +1,250 @@
+#include"TextureTable.h"
+
+#include<algorithm>
+#include<iostream>
+#include<map>
+#include<string>
+#include<tuple>
+
+#include"GLDebug.h"
+
+TextureTable textureTable;
+
+TextureTable::TextureTable() {
+	// Filled with the white texture by Build
+	textures.push_back(0);
+}
+
+unsigned int TextureTable::Add(GLuint texture) {
+	if (texture == 0)
+		return whiteEntry;
+	auto found = entryOfTexture.find(texture);
+	if (found != entryOfTexture.end())
+		return found->second;
+	if (textures.size() >= maxEntries) {
+		if (textures.size() == maxEntries)
+			std::cerr << "Texture table: more than " << maxEntries << " textures, the rest are drawn white" << std::endl;
+		textures.push_back(0);
+		return whiteEntry;
+	}
+	unsigned int entry = (unsigned int) textures.size();
+	textures.push_back(texture);
+	entryOfTexture[texture] = entry;
+	return entry;
+}
+
+void TextureTable::Build() {
+	release();
+
+	if (whiteTexture == 0) {
+		unsigned char whitePixel[4] = {255, 255, 255, 255};
+		glGenTextures(1, &whiteTexture);
+		glBindTexture(GL_TEXTURE_2D, whiteTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, whitePixel);
+		// Level 0 only, the default mipmapped filter would leave it incomplete (and without a handle)
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glDebug.Label(GL_TEXTURE, whiteTexture, "Texture table white");
+	}
+	textures[whiteEntry] = whiteTexture;
+	unsigned int entryCount = (unsigned int) std::min(textures.size(), (size_t) maxEntries);
+
+	// Four words per entry: array and layer, or the 64-bit handle in the last two
+	std::vector<GLuint> entries(maxEntries * 4, 0);
+	if (UsesHandles()) {
+		GLuint64 whiteHandle = 0;
+		for (unsigned int i = 0; i < entryCount; i++) {
+			// 0 for incomplete textures, those are drawn white (entry 0 comes first)
+			GLuint64 handle = glGetTextureHandleARB(textures[i]);
+			if (handle == 0) {
+				std::cerr << "Texture table: no handle for texture " << textures[i] << ", it is drawn white" << std::endl;
+				handle = whiteHandle;
+			} else {
+				glMakeTextureHandleResidentARB(handle);
+				residentHandles.push_back(handle);
+			}
+			if (i == whiteEntry)
+				whiteHandle = handle;
+			entries[i * 4 + 2] = (GLuint) (handle & 0xFFFFFFFFu);
+			entries[i * 4 + 3] = (GLuint) (handle >> 32);
+		}
+	} else {
+		buildArrays(entries);
+	}
+
+	if (tableBuffer == 0)
+		glGenBuffers(1, &tableBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, tableBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, entries.size() * sizeof(GLuint), entries.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glDebug.Label(GL_BUFFER, tableBuffer, "Texture table");
+	built = true;
+	GL_CHECK_ERRORS("build texture table");
+}
+
+void TextureTable::buildArrays(std::vector<GLuint>& entries) {
+	struct Source {
+		unsigned int entry;
+		GLint width;
+		GLint height;
+	};
+	// Textures of one size and format, split further when they exceed the layer limit
+	struct Group {
+		GLint width;
+		GLint height;
+		GLint format;
+		std::vector<Source> sources;
+	};
+
+	GLint maxLayers = 256;
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+	unsigned int entryCount = (unsigned int) std::min(textures.size(), (size_t) maxEntries);
+
+	std::map<std::tuple<GLint, GLint, GLint>, std::vector<Source>> bySize;
+	for (unsigned int i = 0; i < entryCount; i++) {
+		GLint width = 0, height = 0, format = 0;
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+		bySize[std::make_tuple(width, height, format)].push_back({i, width, height});
+	}
+	std::vector<Group> groups;
+	for (auto& size : bySize) {
+		std::vector<Source>& sources = size.second;
+		for (size_t first = 0; first < sources.size(); first += (size_t) maxLayers) {
+			Group group = {std::get<0>(size.first), std::get<1>(size.first), std::get<2>(size.first), {}};
+			group.sources.assign(sources.begin() + first, sources.begin() + std::min(sources.size(), first + (size_t) maxLayers));
+			groups.push_back(group);
+		}
+	}
+
+	// The most used sizes keep their own array, the rest share the last unit at the largest of their sizes
+	std::stable_sort(groups.begin(), groups.end(), [](const Group& a, const Group& b) {
+		return a.sources.size() > b.sources.size();
+	});
+	std::vector<unsigned int> dropped;
+	if (groups.size() > maxArrays) {
+		Group spill = {1, 1, GL_RGBA8, {}};
+		for (size_t i = maxArrays - 1; i < groups.size(); i++) {
+			spill.width = std::max(spill.width, groups[i].width);
+			spill.height = std::max(spill.height, groups[i].height);
+			spill.sources.insert(spill.sources.end(), groups[i].sources.begin(), groups[i].sources.end());
+		}
+		if (spill.sources.size() > (size_t) maxLayers) {
+			std::cerr << "Texture table: " << spill.sources.size() - maxLayers << " textures do not fit any array, they are drawn white" << std::endl;
+			// The white texture must keep its layer, the dropped entries point at it
+			std::stable_partition(spill.sources.begin(), spill.sources.end(), [](const Source& source) {
+				return source.entry == whiteEntry;
+			});
+			for (size_t i = (size_t) maxLayers; i < spill.sources.size(); i++)
+				dropped.push_back(spill.sources[i].entry);
+			spill.sources.resize(maxLayers);
+		}
+		groups.resize(maxArrays - 1);
+		groups.push_back(spill);
+	}
+
+	std::vector<unsigned char> pixels;
+	std::vector<unsigned char> resampled;
+	for (unsigned int array = 0; array < groups.size(); array++) {
+		const Group& group = groups[array];
+		glGenTextures(1, &arrays[array]);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, arrays[array]);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, group.format, group.width, group.height, (GLsizei) group.sources.size(), 0,
+					 GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		for (unsigned int layer = 0; layer < group.sources.size(); layer++) {
+			const Source& source = group.sources[layer];
+			// Read back as RGBA bytes whatever the format, GL converts both ways
+			pixels.resize((size_t) source.width * source.height * 4);
+			glBindTexture(GL_TEXTURE_2D, textures[source.entry]);
+			glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+			const unsigned char* layerPixels = pixels.data();
+			if (source.width != group.width || source.height != group.height) {
+				// Nearest texel, the mipmaps of the array smooth the rest
+				resampled.resize((size_t) group.width * group.height * 4);
+				for (GLint y = 0; y < group.height; y++) {
+					GLint sourceY = (GLint) (((long long) y * 2 + 1) * source.height / (group.height * 2));
+					for (GLint x = 0; x < group.width; x++) {
+						GLint sourceX = (GLint) (((long long) x * 2 + 1) * source.width / (group.width * 2));
+						std::copy_n(&pixels[((size_t) sourceY * source.width + sourceX) * 4], 4, &resampled[((size_t) y * group.width + x) * 4]);
+					}
+				}
+				layerPixels = resampled.data();
+				resampledTextures++;
+			}
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, group.width, group.height, 1, GL_RGBA, GL_UNSIGNED_BYTE, layerPixels);
+			entries[source.entry * 4] = array;
+			entries[source.entry * 4 + 1] = layer;
+		}
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glDebug.Label(GL_TEXTURE, arrays[array], "Texture array " + std::to_string(group.width) + "x" + std::to_string(group.height));
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	arrayCount = (unsigned int) groups.size();
+
+	for (unsigned int entry : dropped) {
+		entries[entry * 4] = entries[whiteEntry * 4];
+		entries[entry * 4 + 1] = entries[whiteEntry * 4 + 1];
+	}
+}
+
+void TextureTable::Bind(Shader& shader) {
+	if (!built)
+		return;
+	shader.Activate();
+	GLuint blockIndex = glGetUniformBlockIndex(shader.ID, "TextureTable");
+	if (blockIndex != GL_INVALID_INDEX)
+		glUniformBlockBinding(shader.ID, blockIndex, blockBinding);
+	glBindBufferBase(GL_UNIFORM_BUFFER, blockBinding, tableBuffer);
+	if (UsesHandles())
+		return;
+
+	GLint units[maxArrays];
+	for (unsigned int i = 0; i < maxArrays; i++) {
+		units[i] = (GLint) (firstUnit + i);
+		glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, arrays[i]);
+	}
+	glActiveTexture(GL_TEXTURE0);
+	glUniform1iv(glGetUniformLocation(shader.ID, "textureArrays"), maxArrays, units);
+}
+
+void TextureTable::PrintSummary() const {
+	unsigned int textureCount = (unsigned int) textures.size() - 1;
+	if (UsesHandles())
+		std::cout << "Texture table: " << textureCount << " textures as bindless handles" << std::endl;
+	else
+		std::cout << "Texture table: " << textureCount << " textures in " << arrayCount << " texture arrays ("
+			<< resampledTextures << " resampled to share one)" << std::endl;
+}
+
+void TextureTable::release() {
+	for (GLuint64 handle : residentHandles)
+		glMakeTextureHandleNonResidentARB(handle);
+	residentHandles.clear();
+	for (unsigned int i = 0; i < maxArrays; i++) {
+		if (arrays[i] != 0)
+			glDeleteTextures(1, &arrays[i]);
+		arrays[i] = 0;
+	}
+	arrayCount = 0;
+	resampledTextures = 0;
+	built = false;
+}
+
+void TextureTable::Delete() {
+	release();
+	if (whiteTexture != 0)
+		glDeleteTextures(1, &whiteTexture);
+	if (tableBuffer != 0)
+		glDeleteBuffers(1, &tableBuffer);
+	whiteTexture = 0;
+	tableBuffer = 0;
+}
@@ -0,0 +1,80 @@
+#ifndef TEXTURE_TABLE_CLASS_H
+#define TEXTURE_TABLE_CLASS_H
+
+#include<glad/glad.h>
+#include<unordered_map>
+#include<vector>
+
+#include"GLExtensions.h"
+#include"shaderClass.h"
+
+// Every material texture of the scene behind one table, so drawing a mesh does not bind its textures.
+// Meshes register their textures with Add and store the entries in their materialTable entry; the
+// draw passes its material (DrawData::material) and the shader looks the entries up in the
+// TextureTable uniform block.
+//
+// With ARB_bindless_texture an entry holds a resident handle of the texture itself. Without it the
+// textures are copied into GL_TEXTURE_2D_ARRAYs, one per size and format, bound once per frame to
+// units firstUnit and up, and an entry holds the array and layer. When there are more sizes than
+// array units, the textures of the rarest sizes are resampled to the size of the largest array.
+// The original textures stay alive either way, handles point at them and Build can run again.
+//
+// default.frag, gbuffer.frag and the alpha-tested depth and visibility passes read the table in
+// sampleTexture of material_table.glsl; TEXTURE_HANDLES (the SHADER_TEXTURE_HANDLES feature) switches them to handles.
+class TextureTable {
+public:
+	// Array units the shaders declare, starting at firstUnit (below it: meshes and light clusters)
+	static const unsigned int maxArrays = 8;
+	static const GLuint firstUnit = 8;
+	// Entries of the uniform block, 16 bytes each (the 16 KiB every GL 3.3 driver allows)
+	static const unsigned int maxEntries = 1024;
+	// Uniform block binding of the table, DrawData uses 0
+	static const GLuint blockBinding = 1;
+	// Entry 0: the 1x1 white texture used for missing maps
+	static const unsigned int whiteEntry = 0;
+
+	// Use handles when the driver has them, set before the shaders are built
+	bool allowHandles = true;
+
+	// Statistics of the last Build
+	unsigned int arrayCount = 0;
+	unsigned int resampledTextures = 0;
+
+	TextureTable();
+
+	// Whether entries are bindless handles (decided before Build, so shaders can be built early)
+	bool UsesHandles() const {
+		return allowHandles && glFeatures.bindlessTextures;
+	}
+	// Entry of a GL_TEXTURE_2D, the same one for every mesh sharing it. 0 gives whiteEntry.
+	unsigned int Add(GLuint texture);
+	// Builds the arrays or makes the handles resident and uploads the table. Call after loading,
+	// again after adding textures later.
+	void Build();
+	// Whether Build ran, i.e. meshes may skip their per-draw texture binds
+	bool Ready() const {
+		return built;
+	}
+	// Binds the arrays and the table for 'shader', once per frame and program
+	void Bind(Shader& shader);
+	void PrintSummary() const;
+	void Delete();
+
+private:
+	// Added textures by entry, textures[whiteEntry] is created by Build
+	std::vector<GLuint> textures;
+	std::unordered_map<GLuint, unsigned int> entryOfTexture;
+	GLuint whiteTexture = 0;
+	GLuint tableBuffer = 0;
+	GLuint arrays[maxArrays] = {};
+	std::vector<GLuint64> residentHandles;
+	bool built = false;
+
+	// Copies every texture into a layer of the array for its size and format, returns the table contents
+	void buildArrays(std::vector<GLuint>& entries);
+	void release();
+};
+
+// Material textures of every loaded model
+extern TextureTable textureTable;
+#endif
@@ -1,23 +1,30 @@
-#include"VBO.h"
-
-// Constructor that generates a Vertex Buffer Object and links it to vertices
-VBO::VBO(std::vector<Vertex>& vertices) {
-	glGenBuffers(1, &ID);
-	glBindBuffer(GL_ARRAY_BUFFER, ID);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-}
-
-// Binds the VBO
-void VBO::Bind() {
-	glBindBuffer(GL_ARRAY_BUFFER, ID);
-}
-
-// Unbinds the VBO
-void VBO::Unbind() {
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-}
-
-// Deletes the VBO
-void VBO::Delete() {
-	glDeleteBuffers(1, &ID);
+#include"VBO.h"
+
+// Constructor that generates a Vertex Buffer Object and links it to vertices
+VBO::VBO(std::vector<Vertex>& vertices) {
+	glGenBuffers(1, &ID);
+	glBindBuffer(GL_ARRAY_BUFFER, ID);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+}
+
+// Same, for a tightly packed position-only stream
+VBO::VBO(std::vector<glm::vec3>& positions) {
+	glGenBuffers(1, &ID);
+	glBindBuffer(GL_ARRAY_BUFFER, ID);
+	glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+}
+
+// Binds the VBO
+void VBO::Bind() {
+	glBindBuffer(GL_ARRAY_BUFFER, ID);
+}
+
+// Unbinds the VBO
+void VBO::Unbind() {
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Deletes the VBO
+void VBO::Delete() {
+	glDeleteBuffers(1, &ID);
 }
\ No newline at end of file
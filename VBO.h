@@ -1,33 +1,37 @@
-#ifndef VBO_CLASS_H
-#define VBO_CLASS_H
-
-#include<glm/glm.hpp>
-#include<glad/glad.h>
-#include<vector>
-
-// Structure to standardize the vertices used in the meshes
-struct Vertex {
-	glm::vec3 position;
-	glm::vec3 normal;
-	glm::vec3 color;
-	glm::vec2 texUV;
-};
-
-
-
-class VBO {
-public:
-	// Reference ID of the Vertex Buffer Object
-	GLuint ID;
-	// Constructor that generates a Vertex Buffer Object and links it to vertices
-	VBO(std::vector<Vertex>& vertices);
-
-	// Binds the VBO
-	void Bind();
-	// Unbinds the VBO
-	void Unbind();
-	// Deletes the VBO
-	void Delete();
-};
-
+#ifndef VBO_CLASS_H
+#define VBO_CLASS_H
+
+#include<glm/glm.hpp>
+#include<glad/glad.h>
+#include<vector>
+
+// Structure to standardize the vertices used in the meshes.
+// Tightly packed 11 floats, the visibility buffer resolve (visbuffer_resolve.frag) fetches them with this layout.
+struct Vertex {
+	glm::vec3 position;
+	glm::vec3 normal;
+	glm::vec3 color;
+	glm::vec2 texUV;
+};
+static_assert(sizeof(Vertex) == 11 * sizeof(float), "Vertex must stay tightly packed for shader fetches");
+
+
+
+class VBO {
+public:
+	// Reference ID of the Vertex Buffer Object
+	GLuint ID;
+	// Constructor that generates a Vertex Buffer Object and links it to vertices
+	VBO(std::vector<Vertex>& vertices);
+	// Same, for a tightly packed position-only stream
+	VBO(std::vector<glm::vec3>& positions);
+
+	// Binds the VBO
+	void Bind();
+	// Unbinds the VBO
+	void Unbind();
+	// Deletes the VBO
+	void Delete();
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include"VisibilityBuffer.h"
+#include"GLDebug.h"
+#include"TextureTable.h"
+
+#include<glm/gtc/type_ptr.hpp>
+#include<algorithm>
+#include<cfloat>
+#include<cmath>
+#include<iostream>
+
+VisibilityBuffer::VisibilityBuffer(int width, int height)
+	: rasterProgram("visbuffer.vert", "visbuffer.frag"),
+	  maskedRasterProgram("visbuffer.vert", "visbuffer.frag",
+						  ShaderVariants::Defines(SHADER_ALPHA_MASK | (textureTable.UsesHandles() ? (unsigned int) SHADER_TEXTURE_HANDLES : 0u))),
+	  resolveProgram("deferred.vert", "visbuffer_resolve.frag",
+					 ShaderVariants::Defines(textureTable.UsesHandles() ? (unsigned int) SHADER_TEXTURE_HANDLES : 0u)) {
+	VisibilityBuffer::width = width;
+	VisibilityBuffer::height = height;
+	renderWidth = width;
+	renderHeight = height;
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+	// x = draw ID + 1 (0 = nothing drawn), y = triangle ID within the draw
+	glGenTextures(1, &visibilityTexture);
+	glBindTexture(GL_TEXTURE_2D, visibilityTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32UI, width, height, 0, GL_RG_INTEGER, GL_UNSIGNED_INT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, visibilityTexture, 0);
+
+	// Same format as the usual default framebuffer, so the depth can be blitted over
+	glGenTextures(1, &depthTexture);
+	glBindTexture(GL_TEXTURE_2D, depthTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+
+	glDebug.Label(GL_FRAMEBUFFER, framebuffer, "Visibility buffer");
+	glDebug.Label(GL_TEXTURE, visibilityTexture, "Visibility buffer IDs");
+	glDebug.Label(GL_TEXTURE, depthTexture, "Visibility buffer depth");
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "VisibilityBuffer: framebuffer is incomplete" << std::endl;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenVertexArrays(1, &screenVAO);
+}
+
+void VisibilityBuffer::SetRenderSize(int renderWidth, int renderHeight) {
+	VisibilityBuffer::renderWidth = renderWidth;
+	VisibilityBuffer::renderHeight = renderHeight;
+}
+
+void VisibilityBuffer::BeginRasterPass(Camera& camera) {
+	draws.clear();
+	drawCount = 0;
+	resolvedDraws = 0;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	const GLuint clearID[4] = {0, 0, 0, 0};
+	glClearBufferuiv(GL_COLOR, 0, clearID);
+	glClear(GL_DEPTH_BUFFER_BIT);
+
+	Shader* programs[] = {&maskedRasterProgram, &rasterProgram};
+	for (Shader* shader : programs) {
+		shader->Activate();
+		glUniformMatrix4fv(glGetUniformLocation(shader->ID, "view"), 1, GL_FALSE, glm::value_ptr(camera.GetViewMatrix()));
+		glUniformMatrix4fv(glGetUniformLocation(shader->ID, "projection"), 1, GL_FALSE, glm::value_ptr(camera.GetProjectionMatrix()));
+	}
+}
+
+void VisibilityBuffer::Draw(Mesh& mesh, const glm::mat4& matrix) {
+	DrawRecord draw;
+	draw.mesh = &mesh;
+	draw.matrix = matrix;
+	draws.push_back(draw);
+	drawCount = (unsigned int) draws.size();
+
+	// Only the position is used (and the base color alpha of alpha-tested materials), textures and
+	// lights are not touched until the resolve
+	Shader& program = (mesh.shaderFeatures & SHADER_ALPHA_MASK) ? maskedRasterProgram : rasterProgram;
+	program.Activate();
+	glUniform1ui(glGetUniformLocation(program.ID, "drawID"), drawCount);
+	glUniformMatrix4fv(glGetUniformLocation(program.ID, "model"), 1, GL_FALSE, glm::value_ptr(matrix));
+	if (&program == &maskedRasterProgram)
+		glUniform1ui(glGetUniformLocation(program.ID, "drawMaterial"), mesh.material);
+	mesh.VAO.Bind();
+	mesh.ApplyCulling(matrix);
+	glDrawElements(GL_TRIANGLES, (GLsizei) mesh.indices.size(), GL_UNSIGNED_INT, 0);
+	Mesh::drawCalls++;
+}
+
+void VisibilityBuffer::EndRasterPass() {
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, outputFramebuffer);
+	glBlitFramebuffer(0, 0, renderWidth, renderHeight, 0, 0, renderWidth, renderHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, outputFramebuffer);
+	glBindVertexArray(0);
+}
+
+bool VisibilityBuffer::screenRect(const DrawRecord& draw, const glm::mat4& viewProjection, GLint rect[4]) const {
+	glm::mat4 toClip = viewProjection * draw.matrix;
+	glm::vec2 ndcMin(FLT_MAX);
+	glm::vec2 ndcMax(-FLT_MAX);
+	for (int corner = 0; corner < 8; corner++) {
+		glm::vec3 local((corner & 1) ? draw.mesh->maxBounds.x : draw.mesh->minBounds.x,
+						(corner & 2) ? draw.mesh->maxBounds.y : draw.mesh->minBounds.y,
+						(corner & 4) ? draw.mesh->maxBounds.z : draw.mesh->minBounds.z);
+		glm::vec4 clip = toClip * glm::vec4(local, 1.0f);
+		// Bounds crossing the camera plane can cover any part of the screen
+		if (clip.w <= 0.0001f) {
+			rect[0] = 0;
+			rect[1] = 0;
+			rect[2] = renderWidth;
+			rect[3] = renderHeight;
+			return true;
+		}
+		glm::vec2 ndc = glm::vec2(clip) / clip.w;
+		ndcMin = glm::min(ndcMin, ndc);
+		ndcMax = glm::max(ndcMax, ndc);
+	}
+	if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f)
+		return false;
+
+	int minX = std::max(0, (int) std::floor((ndcMin.x * 0.5f + 0.5f) * renderWidth));
+	int minY = std::max(0, (int) std::floor((ndcMin.y * 0.5f + 0.5f) * renderHeight));
+	int maxX = std::min(renderWidth, (int) std::ceil((ndcMax.x * 0.5f + 0.5f) * renderWidth));
+	int maxY = std::min(renderHeight, (int) std::ceil((ndcMax.y * 0.5f + 0.5f) * renderHeight));
+	rect[0] = minX;
+	rect[1] = minY;
+	rect[2] = maxX - minX;
+	rect[3] = maxY - minY;
+	return rect[2] > 0 && rect[3] > 0;
+}
+
+void VisibilityBuffer::Resolve(const glm::mat4& viewProjection, const glm::vec3& cameraPosition) {
+	resolveProgram.Activate();
+	// Unit 2 is the material table, 5-7 the light clusters (ClusteredLights::Bind) and 8 and up the
+	// texture arrays (TextureTable::firstUnit)
+	glActiveTexture(GL_TEXTURE3);
+	glBindTexture(GL_TEXTURE_2D, visibilityTexture);
+	glUniform1i(glGetUniformLocation(resolveProgram.ID, "visibility"), 3);
+	glUniform1i(glGetUniformLocation(resolveProgram.ID, "meshVertices"), 4);
+	glUniform1i(glGetUniformLocation(resolveProgram.ID, "meshIndices"), 1);
+	glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+	glUniformMatrix4fv(glGetUniformLocation(resolveProgram.ID, "inverseViewProjection"), 1, GL_FALSE, glm::value_ptr(inverseViewProjection));
+	glUniform3fv(glGetUniformLocation(resolveProgram.ID, "viewPos"), 1, glm::value_ptr(cameraPosition));
+	glUniform2f(glGetUniformLocation(resolveProgram.ID, "screenSize"), (float) renderWidth, (float) renderHeight);
+	GLint drawIDLocation = glGetUniformLocation(resolveProgram.ID, "drawID");
+	GLint modelLocation = glGetUniformLocation(resolveProgram.ID, "model");
+	GLint materialLocation = glGetUniformLocation(resolveProgram.ID, "drawMaterial");
+
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_SCISSOR_TEST);
+	glBindVertexArray(screenVAO);
+	for (unsigned int i = 0; i < draws.size(); i++) {
+		GLint rect[4];
+		if (!screenRect(draws[i], viewProjection, rect))
+			continue;
+		Mesh& mesh = *draws[i].mesh;
+
+		glScissor(rect[0], rect[1], rect[2], rect[3]);
+		glActiveTexture(GL_TEXTURE4);
+		glBindTexture(GL_TEXTURE_BUFFER, mesh.vertexTexture);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_BUFFER, mesh.indexTexture);
+		glActiveTexture(GL_TEXTURE0);
+		glUniform1ui(drawIDLocation, i + 1);
+		glUniform1ui(materialLocation, mesh.material);
+		glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(draws[i].matrix));
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		resolvedDraws++;
+	}
+	glBindVertexArray(0);
+	glDisable(GL_SCISSOR_TEST);
+	glEnable(GL_DEPTH_TEST);
+}
+
+void VisibilityBuffer::Delete() {
+	rasterProgram.Delete();
+	maskedRasterProgram.Delete();
+	resolveProgram.Delete();
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteTextures(1, &visibilityTexture);
+	glDeleteTextures(1, &depthTexture);
+	glDeleteVertexArrays(1, &screenVAO);
+}
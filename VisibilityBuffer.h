@@ -0,0 +1,78 @@
+#ifndef VISIBILITY_BUFFER_CLASS_H
+#define VISIBILITY_BUFFER_CLASS_H
+
+#include<glad/glad.h>
+#include<glm/glm.hpp>
+#include<vector>
+
+#include"Mesh.h"
+#include"ShaderVariants.h"
+#include"shaderClass.h"
+
+// Visibility buffer path. The raster pass writes only (draw ID, triangle ID) per pixel into an RG32UI
+// target (8 bytes per pixel plus depth). The resolve pass then fetches the triangle's vertices straight
+// from the mesh buffers (Mesh::vertexTexture / indexTexture), interpolates them with ray barycentrics and
+// shades each covered pixel once with the same lights as default.frag.
+//
+// The mesh buffers, model matrix and material are set per draw, so the resolve runs once per recorded
+// draw, scissored to the draw's screen rectangle; pixels belonging to other draws are rejected after a
+// single fetch. The material terms come from textureTable and materialTable like in default.frag.
+//
+// Meshes with alpha-tested materials (SHADER_ALPHA_MASK) are rasterized with maskedRasterProgram, which
+// discards their cut-out texels; the opaque program keeps early depth testing.
+class VisibilityBuffer {
+public:
+	// Size of the buffers
+	int width;
+	int height;
+	// Region actually rendered (lower left), smaller than the buffers under dynamic resolution
+	int renderWidth;
+	int renderHeight;
+	// Where EndRasterPass copies the depth to, the resolve draws into it
+	GLuint outputFramebuffer = 0;
+
+	GLuint framebuffer = 0;
+	GLuint visibilityTexture = 0;
+	GLuint depthTexture = 0;
+
+	// visbuffer.vert + visbuffer.frag, drawn through Draw between Begin/EndRasterPass, and the same
+	// with ALPHA_MASK, which reads textureTable and materialTable (bind them once per frame)
+	Shader rasterProgram;
+	Shader maskedRasterProgram;
+	// Resolve and shading, takes the same light, cluster and material table uniforms as default.frag
+	Shader resolveProgram;
+
+	// Statistics of the last frame
+	unsigned int drawCount = 0;
+	unsigned int resolvedDraws = 0;
+
+	VisibilityBuffer(int width, int height);
+
+	// Sets the rendered region for the next frames, at most width x height
+	void SetRenderSize(int renderWidth, int renderHeight);
+
+	// Binds and clears the visibility buffer and forgets the draws of the last frame
+	void BeginRasterPass(Camera& camera);
+	// Draws a mesh into the visibility buffer and records it for the resolve
+	void Draw(Mesh& mesh, const glm::mat4& matrix);
+	// Copies the depth into the output framebuffer and binds it
+	void EndRasterPass();
+	// Shades every covered pixel once, into the currently bound framebuffer
+	void Resolve(const glm::mat4& viewProjection, const glm::vec3& cameraPosition);
+
+	void Delete();
+
+private:
+	struct DrawRecord {
+		Mesh* mesh;
+		glm::mat4 matrix;
+	};
+	std::vector<DrawRecord> draws;
+
+	// Empty VAO for the full-screen triangle
+	GLuint screenVAO = 0;
+
+	// Pixel rectangle (x, y, width, height) covered by a mesh's bounds, false when it is off screen
+	bool screenRect(const DrawRecord& draw, const glm::mat4& viewProjection, GLint rect[4]) const;
+};
+#endif
@@ -0,0 +1,39 @@
+#include"WindowInput.h"
+
+WindowInput::WindowInput(GLFWwindow* window) : window(window) {
+	// Hide the cursor for FPS-style mouse look
+	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	glfwSetWindowUserPointer(window, this);
+	glfwSetScrollCallback(window, [](GLFWwindow* w, double xoffset, double yoffset) {
+		WindowInput* input = static_cast<WindowInput*>(glfwGetWindowUserPointer(w));
+		if (input != NULL)
+			input->scroll += yoffset;
+	});
+}
+
+bool WindowInput::Poll(InputFrame& frame) {
+	double time = glfwGetTime();
+	double mouseX, mouseY;
+	glfwGetCursorPos(window, &mouseX, &mouseY);
+	// Nothing has moved before the first frame
+	if (firstPoll) {
+		lastTime = time;
+		lastX = mouseX;
+		lastY = mouseY;
+		firstPoll = false;
+	}
+
+	frame.deltaTime = (float) (time - lastTime);
+	frame.mouseDeltaX = (float) (mouseX - lastX);
+	frame.mouseDeltaY = (float) (mouseY - lastY);
+	frame.scroll = (float) scroll;
+	frame.keys = 0;
+	for (unsigned int i = 0; i < InputFrame::trackedKeyCount; i++)
+		frame.SetKey(InputFrame::trackedKeys[i], glfwGetKey(window, InputFrame::trackedKeys[i]) == GLFW_PRESS);
+
+	lastTime = time;
+	lastX = mouseX;
+	lastY = mouseY;
+	scroll = 0.0;
+	return true;
+}
@@ -0,0 +1,24 @@
+#ifndef WINDOW_INPUT_CLASS_H
+#define WINDOW_INPUT_CLASS_H
+
+#include<GLFW/glfw3.h>
+
+#include"InputSource.h"
+
+// Live input from a GLFW window: the tracked keys, cursor movement (the cursor is captured for
+// mouse look), the scroll wheel and the time since the last Poll from glfwGetTime.
+class WindowInput : public InputSource {
+public:
+	WindowInput(GLFWwindow* window);
+	bool Poll(InputFrame& frame) override;
+
+private:
+	GLFWwindow* window;
+	bool firstPoll = true;
+	double lastTime = 0.0;
+	double lastX = 0.0;
+	double lastY = 0.0;
+	// Summed up by the scroll callback between polls
+	double scroll = 0.0;
+};
+#endif
@@ -1,35 +1,51 @@
-#version 330 core
-
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
-layout (location = 2) in vec3 aColor;
-layout (location = 3) in vec2 aTex;
-
-out vec3 FragPos_WorldSpace;
-out vec3 Normal_WorldSpace;
-out vec3 VertexColor;
-out vec2 TexCoords;
-
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-
-void main()
-{
-    // Calculate fragment position in world space (for lighting calculations)
-    FragPos_WorldSpace = vec3(model * vec4(aPos, 1.0));
-    
-    // Calculate normal in world space
-    // Using transpose(inverse(model)) handles non-uniform scaling properly
-    Normal_WorldSpace = mat3(transpose(inverse(model))) * aNormal;
-    
-    // Pass color and texture coordinates to fragment shader
-    VertexColor = aColor;
-    TexCoords = aTex;
-    
-    // Calculate final position in clip space
-    gl_Position = projection * view * vec4(FragPos_WorldSpace, 1.0);
-}
-
-
-
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec3 aColor;
+layout (location = 3) in vec2 aTex;
+
+out vec3 FragPos_WorldSpace;
+out vec3 Normal_WorldSpace;
+out vec3 VertexColor;
+out vec2 TexCoords;
+flat out uint DrawMaterial;
+
+// Per-draw data, written by Mesh into the stream buffer and bound with glBindBufferRange.
+// Bound to point 0, the TextureTable block of the fragment shader uses point 1.
+layout (std140) uniform DrawData
+{
+    mat4 model;
+    // transpose(inverse(model)), computed once per draw on the CPU
+    mat4 normalMatrix;
+    // Index into the material table (see MaterialTable.h)
+    uint material;
+};
+uniform mat4 view;
+uniform mat4 projection;
+
+// The color pass after a depth pre-pass tests with GL_EQUAL, so the position must come out
+// bit-identical to depth_prepass.vert
+invariant gl_Position;
+
+void main()
+{
+    // Calculate fragment position in world space (for lighting calculations)
+    vec4 worldPosition = model * vec4(aPos, 1.0);
+    FragPos_WorldSpace = vec3(worldPosition);
+    
+    // Calculate normal in world space
+    // The normal matrix handles non-uniform scaling properly
+    Normal_WorldSpace = mat3(normalMatrix) * aNormal;
+    
+    // Pass color and texture coordinates to fragment shader
+    VertexColor = aColor;
+    TexCoords = aTex;
+    DrawMaterial = material;
+    
+    // Calculate final position in clip space
+    gl_Position = projection * view * worldPosition;
+}
+
+
+
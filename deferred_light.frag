@@ -0,0 +1,98 @@
+#version 330 core
+
+// Full-screen lighting pass of the deferred path: directional and spot light, once per pixel
+out vec4 FragColor;
+
+uniform sampler2D gAlbedoSpecular;
+uniform sampler2D gNormalShininess;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+uniform vec2 screenSize; // G-buffer texture size
+uniform vec2 renderSize; // Part of it the frame was rendered into (dynamic resolution)
+uniform vec3 viewPos;
+
+// Only the scalar part of default.frag's material, the textures are already in the G-buffer
+struct Material {
+    float diffuseStrength;
+    float ambientStrength;
+};
+uniform Material material;
+
+struct DirLight {
+    vec3 direction;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+uniform DirLight dirLight;
+
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+    float cutOff;
+    float outerCutOff;
+    float constant;
+    float linear;
+    float quadratic;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+uniform SpotLight spotLight;
+
+vec3 octahedralDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+        n.xy = (1.0 - abs(n.yx)) * signs;
+    }
+    return normalize(n);
+}
+
+// Same terms as calculateLight in default.frag
+vec3 shade(vec3 albedo, float specularMask, float shininess, vec3 norm, vec3 viewDir, vec3 lightDir,
+           vec3 lightAmbient, vec3 lightDiffuse, vec3 lightSpecular, float attenuation, float spotFactor)
+{
+    vec3 ambient = lightAmbient * material.ambientStrength * albedo;
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = lightDiffuse * material.diffuseStrength * diff * albedo;
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    vec3 specular = lightSpecular * spec * specularMask;
+    return ambient + attenuation * spotFactor * (diffuse + specular);
+}
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy / screenSize;
+    float depth = texture(gDepth, uv).r;
+    if (depth >= 1.0)
+        discard;
+
+    vec4 albedoSpecular = texture(gAlbedoSpecular, uv);
+    vec4 normalShininess = texture(gNormalShininess, uv);
+    vec3 norm = octahedralDecode(normalShininess.xy * 2.0 - 1.0);
+    float shininess = normalShininess.z * 256.0;
+
+    vec4 world = inverseViewProjection * vec4(gl_FragCoord.xy / renderSize * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec3 fragPos = world.xyz / world.w;
+    vec3 viewDir = normalize(viewPos - fragPos);
+
+    vec3 totalLighting = shade(albedoSpecular.rgb, albedoSpecular.a, shininess, norm, viewDir, normalize(-dirLight.direction),
+                               dirLight.ambient, dirLight.diffuse, dirLight.specular, 1.0, 1.0);
+
+    vec3 toSpot = spotLight.position - fragPos;
+    float spotDist = length(toSpot);
+    float spotAttenuation = 1.0 / (spotLight.constant + spotLight.linear * spotDist + spotLight.quadratic * (spotDist * spotDist));
+    float theta = dot(-toSpot / max(spotDist, 0.0001), normalize(spotLight.direction));
+    float spotEffect = 0.0;
+    if (theta > spotLight.outerCutOff) {
+        float epsilon = max(spotLight.cutOff - spotLight.outerCutOff, 0.001);
+        spotEffect = clamp((theta - spotLight.outerCutOff) / epsilon, 0.0, 1.0);
+    }
+    totalLighting += shade(albedoSpecular.rgb, albedoSpecular.a, shininess, norm, viewDir, toSpot / max(spotDist, 0.0001),
+                           spotLight.ambient, spotLight.diffuse, spotLight.specular, spotAttenuation, spotEffect);
+
+    FragColor = vec4(totalLighting, 1.0);
+}
@@ -0,0 +1,65 @@
+#version 330 core
+
+// Adds one point light to the pixels covered by its volume
+out vec4 FragColor;
+
+flat in vec4 PositionRadius;
+flat in vec4 ColorAmbient;
+
+uniform sampler2D gAlbedoSpecular;
+uniform sampler2D gNormalShininess;
+uniform sampler2D gDepth;
+uniform mat4 inverseViewProjection;
+uniform vec2 screenSize; // G-buffer texture size
+uniform vec2 renderSize; // Part of it the frame was rendered into (dynamic resolution)
+uniform vec3 viewPos;
+uniform float pointLightLinear;
+uniform float pointLightQuadratic;
+
+struct Material {
+    float diffuseStrength;
+    float ambientStrength;
+};
+uniform Material material;
+
+vec3 octahedralDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+        n.xy = (1.0 - abs(n.yx)) * signs;
+    }
+    return normalize(n);
+}
+
+void main()
+{
+    vec2 uv = gl_FragCoord.xy / screenSize;
+    float depth = texture(gDepth, uv).r;
+    vec4 world = inverseViewProjection * vec4(gl_FragCoord.xy / renderSize * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);
+    vec3 fragPos = world.xyz / world.w;
+
+    vec3 toLight = PositionRadius.xyz - fragPos;
+    float dist = length(toLight);
+    if (dist >= PositionRadius.w)
+        discard;
+
+    vec4 albedoSpecular = texture(gAlbedoSpecular, uv);
+    vec4 normalShininess = texture(gNormalShininess, uv);
+    vec3 norm = octahedralDecode(normalShininess.xy * 2.0 - 1.0);
+    vec3 lightDir = toLight / max(dist, 0.0001);
+    vec3 viewDir = normalize(viewPos - fragPos);
+
+    // Same windowed falloff as the clustered lights in default.frag
+    float window = clamp(1.0 - pow(dist / PositionRadius.w, 4.0), 0.0, 1.0);
+    window *= window;
+    float attenuation = window / (1.0 + pointLightLinear * dist + pointLightQuadratic * (dist * dist));
+
+    vec3 ambient = ColorAmbient.rgb * ColorAmbient.a * window * material.ambientStrength * albedoSpecular.rgb;
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = ColorAmbient.rgb * material.diffuseStrength * diff * albedoSpecular.rgb;
+    float spec = pow(max(dot(viewDir, reflect(-lightDir, norm)), 0.0), normalShininess.z * 256.0);
+    vec3 specular = ColorAmbient.rgb * spec * albedoSpecular.a;
+
+    FragColor = vec4(ambient + attenuation * (diffuse + specular), 0.0);
+}
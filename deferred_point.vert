@@ -0,0 +1,18 @@
+#version 330 core
+
+// Point light volume: a unit sphere mesh moved and scaled per instance
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec4 aPositionRadius;
+layout (location = 2) in vec4 aColorAmbient;
+
+flat out vec4 PositionRadius;
+flat out vec4 ColorAmbient;
+
+uniform mat4 viewProjection;
+
+void main()
+{
+    PositionRadius = aPositionRadius;
+    ColorAmbient = aColorAmbient;
+    gl_Position = viewProjection * vec4(aPositionRadius.xyz + aPos * aPositionRadius.w, 1.0);
+}
@@ -0,0 +1,23 @@
+#version 330 core
+
+// Depth only, color writes are masked off during the pre-pass. With ALPHA_MASK the base color alpha
+// is tested like default.frag, so cut-out texels do not occlude what is behind them.
+#ifdef ALPHA_MASK
+#ifdef TEXTURE_HANDLES
+#extension GL_ARB_bindless_texture : require
+#endif
+in vec2 TexCoords;
+
+#include "material_table.glsl"
+flat in uint DrawMaterial;
+#endif
+
+void main()
+{
+#ifdef ALPHA_MASK
+    Material material = loadMaterial(DrawMaterial);
+    float alpha = sampleTexture(material.textures.x, TexCoords).a * material.baseColorFactor.a;
+    if (alpha < material.alphaCutoff)
+        discard;
+#endif
+}
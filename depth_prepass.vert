@@ -0,0 +1,34 @@
+#version 330 core
+
+// Depth pre-pass, reads the position-only stream of each mesh. With ALPHA_MASK it reads the full
+// vertices instead, the fragment shader alpha-tests the base color like default.frag.
+layout (location = 0) in vec3 aPos;
+#ifdef ALPHA_MASK
+layout (location = 3) in vec2 aTex;
+out vec2 TexCoords;
+flat out uint DrawMaterial;
+#endif
+
+// Same per-draw block as default.vert
+layout (std140) uniform DrawData
+{
+    mat4 model;
+    // transpose(inverse(model)), computed once per draw on the CPU
+    mat4 normalMatrix;
+    uint material;
+};
+uniform mat4 view;
+uniform mat4 projection;
+
+// Same expression as default.vert, the color pass depends on matching depths
+invariant gl_Position;
+
+void main()
+{
+    vec4 worldPosition = model * vec4(aPos, 1.0);
+    gl_Position = projection * view * worldPosition;
+#ifdef ALPHA_MASK
+    TexCoords = aTex;
+    DrawMaterial = material;
+#endif
+}
@@ -0,0 +1,51 @@
+#version 330 core
+
+// Geometry pass of the deferred path (see DeferredRenderer.h for the layout)
+#ifdef TEXTURE_HANDLES
+#extension GL_ARB_bindless_texture : require
+#endif
+layout(location = 0) out vec4 gAlbedoSpecular;
+layout(location = 1) out vec4 gNormalShininess;
+
+in vec3 FragPos_WorldSpace;
+in vec3 Normal_WorldSpace;
+in vec3 VertexColor;
+in vec2 TexCoords;
+
+#include "material_table.glsl"
+flat in uint DrawMaterial;
+
+// Blinn-Phong exponent giving about the highlight of a GGX roughness (alpha = roughness^2)
+float roughnessToShininess(float roughness)
+{
+    float alpha = max(roughness * roughness, 0.01);
+    return clamp(2.0 / (alpha * alpha) - 2.0, 1.0, 256.0);
+}
+
+// Octahedral mapping of a unit vector to [-1, 1]^2
+vec2 octahedralEncode(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * signs;
+}
+
+void main()
+{
+    // Same material terms as default.frag. The geometry pass is one program for every mesh, so
+    // the alpha test is not a variant here: opaque materials have a cutoff of -1 and never discard.
+    Material material = loadMaterial(DrawMaterial);
+    vec4 baseColor = sampleTexture(material.textures.x, TexCoords) * material.baseColorFactor;
+    if (baseColor.a < material.alphaCutoff)
+        discard;
+    vec3 albedo = baseColor.rgb;
+    if (material.textureBlendFactor > 0.001) {
+        vec3 secondAlbedo = sampleTexture(material.textures.y, TexCoords).rgb * material.baseColorFactor.rgb;
+        albedo = material.textureBlendFactor >= 0.999 ? secondAlbedo : mix(albedo, secondAlbedo, material.textureBlendFactor);
+    }
+    float roughness = material.roughness * sampleTexture(material.textures.z, TexCoords).g;
+    float specular = material.specularStrength * (1.0 - roughness);
+
+    gAlbedoSpecular = vec4(albedo, specular);
+    gNormalShininess = vec4(octahedralEncode(normalize(Normal_WorldSpace)) * 0.5 + 0.5, roughnessToShininess(roughness) / 256.0, 0.0);
+}
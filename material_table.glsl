@@ -0,0 +1,80 @@
+// Texture and material tables of the fragment shaders, pulled in with #include "material_table.glsl"
+// (see insert_shader_includes in shaderClass.cpp). Needs GL_ARB_bindless_texture enabled by the
+// including shader when TEXTURE_HANDLES is defined. MATERIAL_TEXELS is MaterialTable::texelsPerMaterial.
+
+// --- Material textures (see TextureTable.h) ---
+// Per entry: array unit and layer, or a bindless handle in zw
+layout (std140) uniform TextureTable
+{
+    uvec4 textureEntries[1024];
+};
+#ifndef TEXTURE_HANDLES
+uniform sampler2DArray textureArrays[8];
+#endif
+
+// With the UV gradients given, for passes where the neighbouring pixels can be other surfaces
+vec4 sampleTextureGrad(uint entry, vec2 uv, vec2 dx, vec2 dy)
+{
+    uvec4 location = textureEntries[entry];
+#ifdef TEXTURE_HANDLES
+    return textureGrad(sampler2D(location.zw), uv, dx, dy);
+#else
+    // GLSL 3.30 only indexes sampler arrays with constants
+    vec3 coords = vec3(uv, float(location.y));
+    switch (location.x) {
+    case 0u: return textureGrad(textureArrays[0], coords, dx, dy);
+    case 1u: return textureGrad(textureArrays[1], coords, dx, dy);
+    case 2u: return textureGrad(textureArrays[2], coords, dx, dy);
+    case 3u: return textureGrad(textureArrays[3], coords, dx, dy);
+    case 4u: return textureGrad(textureArrays[4], coords, dx, dy);
+    case 5u: return textureGrad(textureArrays[5], coords, dx, dy);
+    case 6u: return textureGrad(textureArrays[6], coords, dx, dy);
+    default: return textureGrad(textureArrays[7], coords, dx, dy);
+    }
+#endif
+}
+
+vec4 sampleTexture(uint entry, vec2 uv)
+{
+#ifdef TEXTURE_HANDLES
+    return texture(sampler2D(textureEntries[entry].zw), uv);
+#else
+    // The gradients are taken here, as derivatives inside the non-uniform switch are undefined
+    return sampleTextureGrad(entry, uv, dFdx(uv), dFdy(uv));
+#endif
+}
+
+// --- Material (see MaterialTable.h) ---
+struct Material {
+    vec4 baseColorFactor;
+    vec3 emissiveFactor;
+    float alphaCutoff;        // Fragments with less alpha are discarded, -1 for opaque materials
+    float metallic;           // Not used by the Blinn-Phong lighting
+    float roughness;
+    float specularStrength;   // Specular intensity multiplier
+    float textureBlendFactor; // Blending between the two base color textures
+    float diffuseStrength;    // Diffuse intensity multiplier
+    float ambientStrength;    // Ambient intensity multiplier
+    uvec4 textures;           // TextureTable entries: base color, second base color, metallic-roughness, emissive
+};
+uniform usamplerBuffer materialData; // MATERIAL_TEXELS texels per material, floats as their bits
+
+Material loadMaterial(uint index)
+{
+    int texel = int(index) * MATERIAL_TEXELS;
+    uvec4 emissiveCutoff = texelFetch(materialData, texel + 1);
+    uvec4 surface = texelFetch(materialData, texel + 2);
+    uvec4 lighting = texelFetch(materialData, texel + 3);
+    Material material;
+    material.baseColorFactor = uintBitsToFloat(texelFetch(materialData, texel));
+    material.emissiveFactor = uintBitsToFloat(emissiveCutoff.xyz);
+    material.alphaCutoff = uintBitsToFloat(emissiveCutoff.w);
+    material.metallic = uintBitsToFloat(surface.x);
+    material.roughness = uintBitsToFloat(surface.y);
+    material.specularStrength = uintBitsToFloat(surface.z);
+    material.textureBlendFactor = uintBitsToFloat(surface.w);
+    material.diffuseStrength = uintBitsToFloat(lighting.x);
+    material.ambientStrength = uintBitsToFloat(lighting.y);
+    material.textures = texelFetch(materialData, texel + 4);
+    return material;
+}
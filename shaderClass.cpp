@@ -1,91 +1,230 @@
-#include"shaderClass.h"
-
-// Reads a text file and outputs a string with everything in the text file
-std::string get_file_contents(const char* filename) {
-	std::ifstream in(filename, std::ios::binary);
-	if (in) {
-		std::string contents;
-		in.seekg(0, std::ios::end);
-		contents.resize(in.tellg());
-		in.seekg(0, std::ios::beg);
-		in.read(&contents[0], contents.size());
-		in.close();
-		return(contents);
-	}
-	throw(errno);
-}
-
-// Constructor that build the Shader Program from 2 different shaders
-Shader::Shader(const char* vertexFile, const char* fragmentFile) {
-	// Read vertexFile and fragmentFile and store the strings
-	std::string vertexCode = get_file_contents(vertexFile);
-	std::string fragmentCode = get_file_contents(fragmentFile);
-
-	// Convert the shader source strings into character arrays
-	const char* vertexSource = vertexCode.c_str();
-	const char* fragmentSource = fragmentCode.c_str();
-
-	// Create Vertex Shader Object and get its reference
-	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	// Attach Vertex Shader source to the Vertex Shader Object
-	glShaderSource(vertexShader, 1, &vertexSource, NULL);
-	// Compile the Vertex Shader into machine code
-	glCompileShader(vertexShader);
-	// Checks if Shader compiled succesfully
-	compileErrors(vertexShader, "VERTEX");
-
-	// Create Fragment Shader Object and get its reference
-	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	// Attach Fragment Shader source to the Fragment Shader Object
-	glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
-	// Compile the Vertex Shader into machine code
-	glCompileShader(fragmentShader);
-	// Checks if Shader compiled succesfully
-	compileErrors(fragmentShader, "FRAGMENT");
-
-	// Create Shader Program Object and get its reference
-	ID = glCreateProgram();
-	// Attach the Vertex and Fragment Shaders to the Shader Program
-	glAttachShader(ID, vertexShader);
-	glAttachShader(ID, fragmentShader);
-	// Wrap-up/Link all the shaders together into the Shader Program
-	glLinkProgram(ID);
-	// Checks if Shaders linked succesfully
-	compileErrors(ID, "PROGRAM");
-
-	// Delete the now useless Vertex and Fragment Shader objects
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
-
-}
-
-// Activates the Shader Program
-void Shader::Activate() {
-	glUseProgram(ID);
-}
-
-// Deletes the Shader Program
-void Shader::Delete() {
-	glDeleteProgram(ID);
-}
-
-// Checks if the different Shaders have compiled properly
-void Shader::compileErrors(unsigned int shader, const char* type) {
-	// Stores status of compilation
-	GLint hasCompiled;
-	// Character array to store error message in
-	char infoLog[1024];
-	if (type != "PROGRAM") {
-		glGetShaderiv(shader, GL_COMPILE_STATUS, &hasCompiled);
-		if (hasCompiled == GL_FALSE) {
-			glGetShaderInfoLog(shader, 1024, NULL, infoLog);
-			std::cout << "SHADER_COMPILATION_ERROR for:" << type << "\n" << infoLog << std::endl;
-		}
-	} else {
-		glGetProgramiv(shader, GL_LINK_STATUS, &hasCompiled);
-		if (hasCompiled == GL_FALSE) {
-			glGetProgramInfoLog(shader, 1024, NULL, infoLog);
-			std::cout << "SHADER_LINKING_ERROR for:" << type << "\n" << infoLog << std::endl;
-		}
-	}
+#include"shaderClass.h"
+#include"GLExtensions.h"
+#include"ProgramCache.h"
+#include"GLDebug.h"
+#include"MaterialTable.h"
+
+#include<algorithm>
+#include<chrono>
+
+// Reads a text file and outputs a string with everything in the text file
+std::string get_file_contents(const char* filename) {
+	std::ifstream in(filename, std::ios::binary);
+	if (in) {
+		std::string contents;
+		in.seekg(0, std::ios::end);
+		contents.resize(in.tellg());
+		in.seekg(0, std::ios::beg);
+		in.read(&contents[0], contents.size());
+		in.close();
+		return(contents);
+	}
+	throw(errno);
+}
+
+// Inserts 'defines' after the #version line of a shader source
+std::string insert_shader_defines(const std::string& source, const std::string& defines) {
+	if (defines.empty())
+		return source;
+	// #version has to stay the first statement, so the defines go on the line after it
+	size_t position = 0;
+	size_t version = source.find("#version");
+	if (version != std::string::npos) {
+		position = source.find('\n', version);
+		position = position == std::string::npos ? source.size() : position + 1;
+	}
+	std::string result = source.substr(0, position);
+	if (!result.empty() && result.back() != '\n')
+		result += '\n';
+	result += defines;
+	if (result.back() != '\n')
+		result += '\n';
+	// Keep the error line numbers of the original file
+	result += "#line " + std::to_string(version == std::string::npos ? 1 : std::count(source.begin(), source.begin() + position, '\n') + 1) + "\n";
+	result += source.substr(position);
+	return result;
+}
+
+// File name of an #include line, empty for any other line
+static std::string include_file(const std::string& source, size_t lineStart, size_t lineEnd) {
+	size_t directive = source.find_first_not_of(" \t", lineStart);
+	if (directive >= lineEnd || source.compare(directive, 8, "#include") != 0)
+		return "";
+	size_t open = source.find('"', directive + 8);
+	size_t close = open < lineEnd ? source.find('"', open + 1) : std::string::npos;
+	if (close >= lineEnd)
+		return "";
+	return source.substr(open + 1, close - open - 1);
+}
+
+// Inserts the included files, GLSL has no #include of its own
+std::string insert_shader_includes(const std::string& source) {
+	std::string result;
+	unsigned int line = 1;
+	for (size_t lineStart = 0; lineStart < source.size(); line++) {
+		size_t lineEnd = source.find('\n', lineStart);
+		lineEnd = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+		std::string file = include_file(source, lineStart, lineEnd);
+		if (file.empty()) {
+			result.append(source, lineStart, lineEnd - lineStart);
+		} else {
+			// Constants the snippets share with the C++ side
+			result += "#define MATERIAL_TEXELS " + std::to_string(MaterialTable::texelsPerMaterial) + "\n";
+			// Errors in the included file are reported as source string 1, the lines after it keep their numbers
+			std::string contents = get_file_contents(file.c_str());
+			result += "#line 1 1\n" + contents;
+			if (!contents.empty() && contents.back() != '\n')
+				result += '\n';
+			result += "#line " + std::to_string(line + 1) + " 0\n";
+		}
+		lineStart = lineEnd;
+	}
+	return result;
+}
+
+std::vector<std::string> shader_include_files(const std::string& source) {
+	std::vector<std::string> files;
+	for (size_t lineStart = 0; lineStart < source.size();) {
+		size_t lineEnd = source.find('\n', lineStart);
+		lineEnd = lineEnd == std::string::npos ? source.size() : lineEnd + 1;
+		std::string file = include_file(source, lineStart, lineEnd);
+		if (!file.empty())
+			files.push_back(file);
+		lineStart = lineEnd;
+	}
+	return files;
+}
+
+// Constructor that build the Shader Program from 2 different shaders
+Shader::Shader(const char* vertexFile, const char* fragmentFile) {
+	// Read vertexFile and fragmentFile and store the strings
+	build(insert_shader_includes(get_file_contents(vertexFile)), insert_shader_includes(get_file_contents(fragmentFile)));
+	glDebug.Label(GL_PROGRAM, ID, std::string(vertexFile) + " + " + fragmentFile);
+}
+
+// Constructor that builds a variant of the Shader Program with extra #defines
+Shader::Shader(const char* vertexFile, const char* fragmentFile, const std::string& defines) {
+	build(insert_shader_defines(insert_shader_includes(get_file_contents(vertexFile)), defines),
+		  insert_shader_defines(insert_shader_includes(get_file_contents(fragmentFile)), defines));
+	glDebug.Label(GL_PROGRAM, ID, std::string(vertexFile) + " + " + fragmentFile + " (variant)");
+}
+
+// Wraps an already linked program
+Shader::Shader(GLuint program) {
+	ID = program;
+}
+
+void Shader::build(const std::string& vertexCode, const std::string& fragmentCode) {
+	// Reuse the linked binary from an earlier run when the sources and driver are unchanged
+	unsigned long long cacheKey = programCache.Key({&vertexCode, &fragmentCode});
+	ID = programCache.Load(cacheKey);
+	if (ID != 0)
+		return;
+	auto compileStart = std::chrono::high_resolution_clock::now();
+
+	// Convert the shader source strings into character arrays
+	const char* vertexSource = vertexCode.c_str();
+	const char* fragmentSource = fragmentCode.c_str();
+
+	// Create Vertex Shader Object and get its reference
+	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
+	// Attach Vertex Shader source to the Vertex Shader Object
+	glShaderSource(vertexShader, 1, &vertexSource, NULL);
+	// Compile the Vertex Shader into machine code
+	glCompileShader(vertexShader);
+	// Checks if Shader compiled succesfully
+	compileErrors(vertexShader, "VERTEX");
+
+	// Create Fragment Shader Object and get its reference
+	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+	// Attach Fragment Shader source to the Fragment Shader Object
+	glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
+	// Compile the Vertex Shader into machine code
+	glCompileShader(fragmentShader);
+	// Checks if Shader compiled succesfully
+	compileErrors(fragmentShader, "FRAGMENT");
+
+	// Create Shader Program Object and get its reference
+	ID = glCreateProgram();
+	// Attach the Vertex and Fragment Shaders to the Shader Program
+	glAttachShader(ID, vertexShader);
+	glAttachShader(ID, fragmentShader);
+	// Wrap-up/Link all the shaders together into the Shader Program
+	programCache.PrepareLink(ID);
+	glLinkProgram(ID);
+	// Checks if Shaders linked succesfully
+	compileErrors(ID, "PROGRAM");
+
+	// Delete the now useless Vertex and Fragment Shader objects
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+
+	programCache.Store(ID, cacheKey, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - compileStart).count());
+
+}
+
+// Constructor that builds a compute Shader Program
+Shader::Shader(const char* computeFile) {
+	// Read computeFile and store the string
+	std::string computeCode = get_file_contents(computeFile);
+	unsigned long long cacheKey = programCache.Key({&computeCode});
+	ID = programCache.Load(cacheKey);
+	if (ID != 0) {
+		glDebug.Label(GL_PROGRAM, ID, computeFile);
+		return;
+	}
+	auto compileStart = std::chrono::high_resolution_clock::now();
+	const char* computeSource = computeCode.c_str();
+
+	// Create Compute Shader Object, attach its source and compile it
+	GLuint computeShader = glCreateShader(GL_COMPUTE_SHADER);
+	glShaderSource(computeShader, 1, &computeSource, NULL);
+	glCompileShader(computeShader);
+	// Checks if Shader compiled succesfully
+	compileErrors(computeShader, "COMPUTE");
+
+	// Create Shader Program Object and link the compute shader into it
+	ID = glCreateProgram();
+	glAttachShader(ID, computeShader);
+	programCache.PrepareLink(ID);
+	glLinkProgram(ID);
+	// Checks if Shaders linked succesfully
+	compileErrors(ID, "PROGRAM");
+
+	// Delete the now useless Compute Shader object
+	glDeleteShader(computeShader);
+	glDebug.Label(GL_PROGRAM, ID, computeFile);
+
+	programCache.Store(ID, cacheKey, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - compileStart).count());
+}
+
+// Activates the Shader Program
+void Shader::Activate() {
+	glUseProgram(ID);
+}
+
+// Deletes the Shader Program
+void Shader::Delete() {
+	glDeleteProgram(ID);
+}
+
+// Checks if the different Shaders have compiled properly
+void Shader::compileErrors(unsigned int shader, const char* type) {
+	// Stores status of compilation
+	GLint hasCompiled;
+	// Character array to store error message in
+	char infoLog[1024];
+	if (type != "PROGRAM") {
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &hasCompiled);
+		if (hasCompiled == GL_FALSE) {
+			glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+			std::cout << "SHADER_COMPILATION_ERROR for:" << type << "\n" << infoLog << std::endl;
+		}
+	} else {
+		glGetProgramiv(shader, GL_LINK_STATUS, &hasCompiled);
+		if (hasCompiled == GL_FALSE) {
+			glGetProgramInfoLog(shader, 1024, NULL, infoLog);
+			std::cout << "SHADER_LINKING_ERROR for:" << type << "\n" << infoLog << std::endl;
+		}
+	}
 }
\ No newline at end of file
@@ -1,30 +1,45 @@
-#ifndef SHADER_CLASS_H
-#define SHADER_CLASS_H
-
-#include<glad/glad.h>
-#include<string>
-#include<fstream>
-#include<sstream>
-#include<iostream>
-#include<cerrno>
-
-std::string get_file_contents(const char* filename);
-
-class Shader {
-public:
-	// Reference ID of the Shader Program
-	GLuint ID;
-	// Constructor that build the Shader Program from 2 different shaders
-	Shader(const char* vertexFile, const char* fragmentFile);
-
-	// Activates the Shader Program
-	void Activate();
-	// Deletes the Shader Program
-	void Delete();
-private:
-	// Checks if the different Shaders have compiled properly
-	void compileErrors(unsigned int shader, const char* type);
-};
-
-
+#ifndef SHADER_CLASS_H
+#define SHADER_CLASS_H
+
+#include<glad/glad.h>
+#include<string>
+#include<vector>
+#include<fstream>
+#include<sstream>
+#include<iostream>
+#include<cerrno>
+
+std::string get_file_contents(const char* filename);
+// Inserts 'defines' after the #version line of a shader source (at the start if it has none)
+std::string insert_shader_defines(const std::string& source, const std::string& defines);
+// Replaces each '#include "file"' line of a shader source with the contents of the file
+std::string insert_shader_includes(const std::string& source);
+// Files named by the #include lines of a shader source
+std::vector<std::string> shader_include_files(const std::string& source);
+
+class Shader {
+public:
+	// Reference ID of the Shader Program
+	GLuint ID;
+	// Constructor that build the Shader Program from 2 different shaders
+	Shader(const char* vertexFile, const char* fragmentFile);
+	// Same, with 'defines' (lines of "#define NAME VALUE") inserted after the #version line of both stages
+	Shader(const char* vertexFile, const char* fragmentFile, const std::string& defines);
+	// Wraps a program that was built elsewhere (see ShaderCompiler), 0 for none yet
+	explicit Shader(GLuint program);
+	// Constructor that builds a compute Shader Program (needs GL 4.3, see GLExtensions.h)
+	Shader(const char* computeFile);
+
+	// Activates the Shader Program
+	void Activate();
+	// Deletes the Shader Program
+	void Delete();
+private:
+	// Compiles and links the two stages into ID
+	void build(const std::string& vertexCode, const std::string& fragmentCode);
+	// Checks if the different Shaders have compiled properly
+	void compileErrors(unsigned int shader, const char* type);
+};
+
+
 #endif
\ No newline at end of file
@@ -0,0 +1,30 @@
+#version 330 core
+
+// Draw ID (1-based, 0 = nothing drawn) and triangle ID, everything else is rebuilt in the resolve.
+// With ALPHA_MASK cut-out texels are discarded first, as in depth_prepass.frag.
+#ifdef ALPHA_MASK
+#ifdef TEXTURE_HANDLES
+#extension GL_ARB_bindless_texture : require
+#endif
+#endif
+layout(location = 0) out uvec2 Visibility;
+
+uniform uint drawID;
+
+#ifdef ALPHA_MASK
+in vec2 TexCoords;
+
+#include "material_table.glsl"
+uniform uint drawMaterial; // Material of the draw, set with drawID
+#endif
+
+void main()
+{
+#ifdef ALPHA_MASK
+    Material material = loadMaterial(drawMaterial);
+    float alpha = sampleTexture(material.textures.x, TexCoords).a * material.baseColorFactor.a;
+    if (alpha < material.alphaCutoff)
+        discard;
+#endif
+    Visibility = uvec2(drawID, uint(gl_PrimitiveID));
+}
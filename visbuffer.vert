@@ -0,0 +1,21 @@
+#version 330 core
+
+// Raster pass of the visibility buffer, only the position is needed. With ALPHA_MASK the texture
+// coordinates as well, visbuffer.frag alpha-tests the base color like default.frag.
+layout (location = 0) in vec3 aPos;
+#ifdef ALPHA_MASK
+layout (location = 3) in vec2 aTex;
+out vec2 TexCoords;
+#endif
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+#ifdef ALPHA_MASK
+    TexCoords = aTex;
+#endif
+}
@@ -0,0 +1,215 @@
+#version 330 core
+
+// Resolve pass of the visibility buffer: rebuilds the surface of one draw from its triangle
+// and shades it like default.frag. Runs once per draw over the draw's screen rectangle.
+#ifdef TEXTURE_HANDLES
+#extension GL_ARB_bindless_texture : require
+#endif
+out vec4 FragColor;
+
+uniform usampler2D visibility;
+uniform samplerBuffer meshVertices;   // Mesh::vertexTexture, 11 floats per vertex (see Vertex)
+uniform usamplerBuffer meshIndices;   // Mesh::indexTexture
+uniform uint drawID;
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 inverseViewProjection;
+uniform vec3 viewPos;
+
+#include "material_table.glsl"
+uniform uint drawMaterial; // Material of the draw, set with drawID
+
+// Blinn-Phong exponent giving about the highlight of a GGX roughness (alpha = roughness^2)
+float roughnessToShininess(float roughness)
+{
+    float alpha = max(roughness * roughness, 0.01);
+    return clamp(2.0 / (alpha * alpha) - 2.0, 1.0, 256.0);
+}
+
+struct DirLight {
+    vec3 direction;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+uniform DirLight dirLight;
+
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+    float cutOff;
+    float outerCutOff;
+    float constant;
+    float linear;
+    float quadratic;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+uniform SpotLight spotLight;
+
+// Clustered point lights, same uniforms as default.frag
+uniform samplerBuffer lightData;
+uniform usamplerBuffer clusterGrid;
+uniform usamplerBuffer clusterLightIndices;
+uniform ivec3 clusterCount;
+uniform vec2 screenSize;
+uniform float clusterNear;
+uniform float clusterFar;
+uniform float pointLightLinear;
+uniform float pointLightQuadratic;
+
+// Surface of the pixel, rebuilt from the triangle
+struct Surface {
+    vec3 position;
+    vec3 normal;
+    vec2 texCoords;
+    vec2 texCoordsDx;
+    vec2 texCoordsDy;
+    // Material terms, as in default.frag
+    vec3 ambient;
+    vec3 diffuse;
+    float specular;
+    float shininess;
+};
+
+float vertexFloat(uint index, int component)
+{
+    return texelFetch(meshVertices, int(index) * 11 + component).r;
+}
+
+// World-space ray through a pixel position (in pixels), from the near to the far plane
+void pixelRay(vec2 pixel, out vec3 origin, out vec3 direction)
+{
+    vec2 ndc = pixel / screenSize * 2.0 - 1.0;
+    vec4 nearPoint = inverseViewProjection * vec4(ndc, -1.0, 1.0);
+    vec4 farPoint = inverseViewProjection * vec4(ndc, 1.0, 1.0);
+    origin = nearPoint.xyz / nearPoint.w;
+    direction = farPoint.xyz / farPoint.w - origin;
+}
+
+// Barycentrics of the point where the ray meets the triangle's plane (Moller-Trumbore without the range tests)
+vec3 rayBarycentrics(vec3 origin, vec3 direction, vec3 p0, vec3 p1, vec3 p2)
+{
+    vec3 edge1 = p1 - p0;
+    vec3 edge2 = p2 - p0;
+    vec3 pvec = cross(direction, edge2);
+    float inverseDet = 1.0 / dot(edge1, pvec);
+    vec3 tvec = origin - p0;
+    vec3 qvec = cross(tvec, edge1);
+    float u = dot(tvec, pvec) * inverseDet;
+    float v = dot(direction, qvec) * inverseDet;
+    return vec3(1.0 - u - v, u, v);
+}
+
+vec3 calculateLight(Surface surface, vec3 lightDirection_normalized,
+                    vec3 lightAmbientColor, vec3 lightDiffuseColor, vec3 lightSpecularColor,
+                    float attenuation, float spotIntensityFactor)
+{
+    vec3 norm = normalize(surface.normal);
+    vec3 viewDir = normalize(viewPos - surface.position);
+
+    vec3 ambient = lightAmbientColor * surface.ambient;
+    float diff = max(dot(norm, lightDirection_normalized), 0.0);
+    vec3 diffuse = lightDiffuseColor * diff * surface.diffuse;
+    vec3 reflectDir = reflect(-lightDirection_normalized, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), surface.shininess);
+    vec3 specular = lightSpecularColor * spec * surface.specular;
+
+    return ambient + attenuation * spotIntensityFactor * (diffuse + specular);
+}
+
+void main()
+{
+    uvec2 visible = texelFetch(visibility, ivec2(gl_FragCoord.xy), 0).xy;
+    if (visible.x != drawID)
+        discard;
+
+    // Fetch the triangle
+    int firstIndex = int(visible.y) * 3;
+    uint i0 = texelFetch(meshIndices, firstIndex).r;
+    uint i1 = texelFetch(meshIndices, firstIndex + 1).r;
+    uint i2 = texelFetch(meshIndices, firstIndex + 2).r;
+    vec3 p0 = vec3(model * vec4(vertexFloat(i0, 0), vertexFloat(i0, 1), vertexFloat(i0, 2), 1.0));
+    vec3 p1 = vec3(model * vec4(vertexFloat(i1, 0), vertexFloat(i1, 1), vertexFloat(i1, 2), 1.0));
+    vec3 p2 = vec3(model * vec4(vertexFloat(i2, 0), vertexFloat(i2, 1), vertexFloat(i2, 2), 1.0));
+    vec3 n0 = vec3(vertexFloat(i0, 3), vertexFloat(i0, 4), vertexFloat(i0, 5));
+    vec3 n1 = vec3(vertexFloat(i1, 3), vertexFloat(i1, 4), vertexFloat(i1, 5));
+    vec3 n2 = vec3(vertexFloat(i2, 3), vertexFloat(i2, 4), vertexFloat(i2, 5));
+    vec2 uv0 = vec2(vertexFloat(i0, 9), vertexFloat(i0, 10));
+    vec2 uv1 = vec2(vertexFloat(i1, 9), vertexFloat(i1, 10));
+    vec2 uv2 = vec2(vertexFloat(i2, 9), vertexFloat(i2, 10));
+
+    // Interpolate at the pixel center and one pixel to the right and up for the texture gradients
+    vec3 origin, direction;
+    pixelRay(gl_FragCoord.xy, origin, direction);
+    vec3 weights = rayBarycentrics(origin, direction, p0, p1, p2);
+    pixelRay(gl_FragCoord.xy + vec2(1.0, 0.0), origin, direction);
+    vec3 weightsX = rayBarycentrics(origin, direction, p0, p1, p2);
+    pixelRay(gl_FragCoord.xy + vec2(0.0, 1.0), origin, direction);
+    vec3 weightsY = rayBarycentrics(origin, direction, p0, p1, p2);
+
+    Surface surface;
+    surface.position = weights.x * p0 + weights.y * p1 + weights.z * p2;
+    surface.normal = mat3(transpose(inverse(model))) * (weights.x * n0 + weights.y * n1 + weights.z * n2);
+    surface.texCoords = weights.x * uv0 + weights.y * uv1 + weights.z * uv2;
+    surface.texCoordsDx = weightsX.x * uv0 + weightsX.y * uv1 + weightsX.z * uv2 - surface.texCoords;
+    surface.texCoordsDy = weightsY.x * uv0 + weightsY.y * uv1 + weightsY.z * uv2 - surface.texCoords;
+
+    // Same material terms as default.frag. Neighbouring pixels can belong to other draws, so the
+    // gradients come from the triangle. Cut-out texels were already discarded by the raster pass.
+    Material material = loadMaterial(drawMaterial);
+    vec3 albedo = sampleTextureGrad(material.textures.x, surface.texCoords, surface.texCoordsDx, surface.texCoordsDy).rgb * material.baseColorFactor.rgb;
+    if (material.textureBlendFactor > 0.001) {
+        vec3 secondAlbedo = sampleTextureGrad(material.textures.y, surface.texCoords, surface.texCoordsDx, surface.texCoordsDy).rgb * material.baseColorFactor.rgb;
+        albedo = material.textureBlendFactor < 0.999 ? mix(albedo, secondAlbedo, material.textureBlendFactor) : secondAlbedo;
+    }
+    float roughness = material.roughness * sampleTextureGrad(material.textures.z, surface.texCoords, surface.texCoordsDx, surface.texCoordsDy).g;
+    surface.shininess = roughnessToShininess(roughness);
+    surface.specular = material.specularStrength * (1.0 - roughness);
+    surface.ambient = material.ambientStrength * albedo;
+    surface.diffuse = material.diffuseStrength * albedo;
+
+    vec3 totalLighting = vec3(0.0);
+    if (any(greaterThan(material.emissiveFactor, vec3(0.0))))
+        totalLighting += material.emissiveFactor * sampleTextureGrad(material.textures.w, surface.texCoords, surface.texCoordsDx, surface.texCoordsDy).rgb;
+
+    // Same lights as default.frag
+    totalLighting += calculateLight(surface, normalize(-dirLight.direction),
+                                        dirLight.ambient, dirLight.diffuse, dirLight.specular, 1.0, 1.0);
+
+    float viewDepth = -(view * vec4(surface.position, 1.0)).z;
+    int slice = int(log(max(viewDepth, clusterNear) / clusterNear) / log(clusterFar / clusterNear) * float(clusterCount.z));
+    slice = clamp(slice, 0, clusterCount.z - 1);
+    ivec2 tile = clamp(ivec2(gl_FragCoord.xy / screenSize * vec2(clusterCount.xy)), ivec2(0), clusterCount.xy - 1);
+    uvec2 cluster = texelFetch(clusterGrid, (slice * clusterCount.y + tile.y) * clusterCount.x + tile.x).xy;
+    for (uint i = 0u; i < cluster.y; i++) {
+        int lightIndex = int(texelFetch(clusterLightIndices, int(cluster.x + i)).r);
+        vec4 positionRadius = texelFetch(lightData, lightIndex * 2);
+        vec4 colorAmbient = texelFetch(lightData, lightIndex * 2 + 1);
+
+        vec3 toLight = positionRadius.xyz - surface.position;
+        float dist = length(toLight);
+        float window = clamp(1.0 - pow(dist / positionRadius.w, 4.0), 0.0, 1.0);
+        window *= window;
+        float attenuation = window / (1.0 + pointLightLinear * dist + pointLightQuadratic * (dist * dist));
+        totalLighting += calculateLight(surface, toLight / max(dist, 0.0001),
+                                        colorAmbient.rgb * colorAmbient.a * window, colorAmbient.rgb, colorAmbient.rgb,
+                                        attenuation, 1.0);
+    }
+
+    vec3 toSpot = spotLight.position - surface.position;
+    float spotDist = length(toSpot);
+    float spotAttenuation = 1.0 / (spotLight.constant + spotLight.linear * spotDist + spotLight.quadratic * (spotDist * spotDist));
+    float theta = dot(-toSpot / max(spotDist, 0.0001), normalize(spotLight.direction));
+    float spotEffect = 0.0;
+    if (theta > spotLight.outerCutOff) {
+        float epsilon = max(spotLight.cutOff - spotLight.outerCutOff, 0.001);
+        spotEffect = clamp((theta - spotLight.outerCutOff) / epsilon, 0.0, 1.0);
+    }
+    totalLighting += calculateLight(surface, toSpot / max(spotDist, 0.0001),
+                                    spotLight.ambient, spotLight.diffuse, spotLight.specular,
+                                    spotAttenuation, spotEffect);
+
+    FragColor = vec4(totalLighting, 1.0);
+}